@@ -46,6 +46,7 @@
 #ifdef _WIN32
 #  include <windows.h>
 #  include <tchar.h>
+#  include <io.h>
 #  undef MOUSE_EVENT
 #  undef KEY_EVENT
 #  undef MOUSE_MOVED
@@ -112,25 +113,90 @@ static void setConsoleProperties();
 void startupMainDontRunMain(int argc, char** argv);
 //static void abortAllConsoleIO();
 
+/*
+ * Size of the console input/output buffers.  Can be overridden at build time
+ * (e.g. DEFINES += SPL_CONSOLE_BUFFER_SIZE=65536) for programs that produce
+ * large amounts of output.
+ */
+#ifndef SPL_CONSOLE_BUFFER_SIZE
+#define SPL_CONSOLE_BUFFER_SIZE 4096
+#endif // SPL_CONSOLE_BUFFER_SIZE
+
+static bool isInteractiveOutput();
+
 class ConsoleStreambuf : public std::streambuf {
 private:
     /* Constants */
-    static const int BUFFER_SIZE = 4096;
+    static const int BUFFER_SIZE = SPL_CONSOLE_BUFFER_SIZE;
 
     /* Instance variables */
     char inBuffer[BUFFER_SIZE];
     char outBuffer[BUFFER_SIZE];
     int blocked;
 
+    /*
+     * In bulk mode the whole buffered block is handed to the console in one
+     * write, and sync() (std::endl, std::flush) does not force a write;
+     * output is written when the buffer fills, before input is read, before
+     * any stderr output and at program exit.  Bulk mode is used when nobody
+     * watches the output as it is written (see isInteractiveOutput), or
+     * always if SPL_CONSOLE_BULK_OUTPUT is defined.
+     */
+    bool bulk;
+
+    /* Buffer whose pending output is written at exit (bulk mode only) */
+    static ConsoleStreambuf* bulkInstance;
+
+    static void flushAtExit() {
+        if (bulkInstance != NULL) {
+            bulkInstance->overflow(EOF);
+        }
+    }
+
+    /*
+     * Writes a block of text to the console, in one write in bulk mode,
+     * otherwise line by line.
+     */
+    void writeConsole(const char* start, const char* end, bool isStderr) {
+        if (start == end) {
+            return;
+        }
+        if (bulk) {
+            putConsole(std::string(start, end), isStderr);
+            return;
+        }
+        for (const char* cp = start; cp < end; cp++) {
+            if (*cp == '\n') {
+                putConsole(std::string(start, cp), isStderr);
+                endLineConsole(isStderr);
+                start = cp + 1;
+            }
+        }
+        if (start < end) {
+            putConsole(std::string(start, end), isStderr);
+        }
+    }
+
 public:
     ConsoleStreambuf() {
         setg(inBuffer, inBuffer, inBuffer);
         setp(outBuffer, outBuffer + BUFFER_SIZE);
         blocked = 0;
+#ifdef SPL_CONSOLE_BULK_OUTPUT
+        bulk = true;
+#else
+        bulk = !isInteractiveOutput();
+#endif // SPL_CONSOLE_BULK_OUTPUT
+        if (bulk && bulkInstance == NULL) {
+            bulkInstance = this;
+            std::atexit(flushAtExit);
+        }
     }
 
     ~ConsoleStreambuf() {
-        /* Empty */
+        if (bulkInstance == this) {
+            bulkInstance = NULL;
+        }
     }
 
     bool isBlocked() {
@@ -138,6 +204,11 @@ public:
     }
 
     virtual int underflow() {
+        // pending output (e.g. a prompt) must be visible before we block
+        if (pptr() > pbase()) {
+            overflow(EOF);
+        }
+
         // Allow long strings at some point
         blocked++;
         std::string line = getLineConsole();
@@ -156,23 +227,7 @@ public:
     }
 
     virtual int overflow(int ch = EOF) {
-        return overflow(ch, false);
-    }
-        
-    virtual int overflow(int ch, bool isStderr) {
-        std::string line = "";
-        for (char *cp = pbase(); cp < pptr(); cp++) {
-            if (*cp == '\n') {
-                putConsole(line, isStderr);
-                endLineConsole(isStderr);
-                line = "";
-            } else {
-                line += *cp;
-            }
-        }
-        if (line != "") {
-            putConsole(line, isStderr);
-        }
+        writeConsole(pbase(), pptr(), false);
         setp(outBuffer, outBuffer + BUFFER_SIZE);
         if (ch != EOF) {
             outBuffer[0] = ch;
@@ -180,29 +235,56 @@ public:
         }
         return ch != EOF;
     }
-    
+
     virtual int sync() {
-        return overflow();
+        if (bulk) {
+            return 0;
+        }
+        return overflow(EOF);
     }
-    
-    virtual int sync(bool isStderr) {
-        return overflow(EOF, isStderr);
+
+    /*
+     * Writes a block of stderr text, which has its own buffer (see
+     * ForwardingStreambuf).  Pending stdout text is written first, as
+     * stdout, so the two streams keep their order.
+     */
+    void writeStderr(const char* start, const char* end) {
+        if (pptr() > pbase()) {
+            overflow(EOF);
+        }
+        writeConsole(start, end, true);
     }
 };
 
+ConsoleStreambuf* ConsoleStreambuf::bulkInstance = NULL;
+
 /*
  * A stream buffer that just "wraps" another stream buffer.
  * This is used here to distinguish cout (black text) from cerr (red text).
+ * The stderr text is kept in a buffer of its own, so it is never mixed
+ * with the pending stdout text of the delegate; cerr is unit-buffered, so
+ * the buffer is written after every output operation.
  */
 class ForwardingStreambuf : public std::streambuf {
 private:
+    /* Constants */
+    static const int BUFFER_SIZE = 4096;
+
     ConsoleStreambuf& delegate;
     bool isStderr;
-    
+    char outBuffer[BUFFER_SIZE];
+
+    void writeBuffer() {
+        delegate.writeStderr(pbase(), pptr());
+        setp(outBuffer, outBuffer + BUFFER_SIZE);
+    }
+
 public:
     ForwardingStreambuf(ConsoleStreambuf& del, bool err = false)
             : delegate(del), isStderr(err) {
-        // empty
+        if (isStderr) {
+            setp(outBuffer, outBuffer + BUFFER_SIZE);
+        }
     }
     
     virtual int underflow() {
@@ -210,11 +292,23 @@ public:
     }
     
     virtual int overflow(int ch = EOF) {
-        return delegate.overflow(ch, isStderr);
+        if (!isStderr) {
+            return delegate.overflow(ch);
+        }
+        writeBuffer();
+        if (ch != EOF) {
+            outBuffer[0] = ch;
+            pbump(1);
+        }
+        return ch != EOF;
     }
     
     virtual int sync() {
-        return delegate.sync(isStderr);
+        if (!isStderr) {
+            return delegate.sync();
+        }
+        writeBuffer();
+        return 0;
     }
     
     // functions below are overridden for completeness,
@@ -248,11 +342,11 @@ public:
     }
     
     int sputc(char c) {
-        return delegate.sputc(c);
+        return isStderr ? std::streambuf::sputc(c) : delegate.sputc(c);
     }
     
     std::streamsize sputn(const char* s, std::streamsize n) {
-        return delegate.sputn(s, n);
+        return isStderr ? std::streambuf::sputn(s, n) : delegate.sputn(s, n);
     }
 };
 
@@ -2906,6 +3000,20 @@ static void echoConsole(const std::string&, bool) {
 }
 #endif // _console_h
 
+/*
+ * Returns true if the console output is watched as it is written, that is
+ * if stdout is a terminal.  When stdout is redirected to a file or a pipe,
+ * the output is written in whole blocks; the graphical console window then
+ * shows it when a block fills and before the program reads input.
+ */
+static bool isInteractiveOutput() {
+#if defined(_WIN32)
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return isatty(STDOUT_FILENO) != 0;
+#endif // _WIN32
+}
+
 static void endLineConsole(bool isStderr) {
     putPipe("JBEConsole.println()");
     echoConsole("\n", isStderr);
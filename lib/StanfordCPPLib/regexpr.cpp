@@ -15,16 +15,805 @@
  */
 
 #include "regexpr.h"
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <vector>
+#include "error.h"
 #include "platform.h"
 
+/*
+ * Implementation notes: native regex engine
+ * -----------------------------------------
+ * Patterns are parsed into a small syntax tree and compiled into the
+ * instruction list of a Thompson NFA.  Matching simulates the NFA with the
+ * Pike VM, which keeps one thread per NFA state and therefore runs in
+ * O(pattern * text) time.  Thread priority follows the leftmost-first rules
+ * used by java.util.regex, so the same substrings and groups are reported.
+ *
+ * Constructs that cannot be expressed as an NFA (back-references,
+ * lookaround, flags, possessive quantifiers, ...) make compilation fail;
+ * such patterns keep being sent to the Java back-end as before.
+ */
+
+namespace {
+
+enum OpCode {
+    OP_CHAR,        // match one given character
+    OP_ANY,         // match any character except a line terminator
+    OP_CLASS,       // match a character in (or not in) a set
+    OP_SPLIT,       // fork; x has priority over y
+    OP_JMP,         // jump to x
+    OP_SAVE,        // record current position in capture slot n
+    OP_BOL,         // assert beginning of input
+    OP_EOL,         // assert end of input (or before a final line terminator)
+    OP_WORDB,       // assert word boundary
+    OP_NWORDB,      // assert non-word boundary
+    OP_MATCH        // report a match
+};
+
+struct Inst {
+    OpCode op;
+    int x;
+    int y;
+    int n;
+    unsigned char c;
+    int set;        // index into RegexProgram::sets for OP_CLASS
+};
+
+struct CharSet {
+    bool bits[256];
+};
+
+struct RegexProgram {
+    std::vector<Inst> code;
+    std::vector<CharSet> sets;
+    int nsub;       // number of capture groups, including group 0
+};
+
+enum NodeType {
+    N_CHAR, N_ANY, N_CLASS, N_BOL, N_EOL, N_WORDB, N_NWORDB,
+    N_CAT, N_ALT, N_GROUP, N_REPEAT, N_EMPTY
+};
+
+struct Node {
+    NodeType type;
+    unsigned char c;
+    int set;
+    int group;                  // capture index, or -1 for (?:...)
+    int min;
+    int max;                    // -1 means unbounded
+    bool greedy;
+    std::vector<Node*> kids;
+};
+
+/* Limit on the size of a compiled program (guards {n,m} expansion) */
+const int MAX_PROGRAM_SIZE = 20000;
+
+/* Limit on the number of compiled patterns kept in the cache */
+const size_t MAX_CACHE_SIZE = 256;
+
+class RegexCompiler {
+public:
+    RegexCompiler(const std::string& pattern, RegexProgram& prog)
+            : pattern(pattern), pos(0), failed(false), prog(prog) {
+        prog.nsub = 1;
+    }
+
+    ~RegexCompiler() {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            delete nodes[i];
+        }
+    }
+
+    bool compile() {
+        Node* root = parseAlternation();
+        if (failed || pos != (int) pattern.length()) {
+            return false;
+        }
+        emit(OP_SAVE, 0, 0, 0);
+        generate(root);
+        emit(OP_SAVE, 0, 0, 1);
+        emit(OP_MATCH, 0, 0, 0);
+        return !failed;
+    }
+
+private:
+    std::string pattern;
+    int pos;
+    bool failed;
+    RegexProgram& prog;
+    std::vector<Node*> nodes;
+
+    Node* newNode(NodeType type) {
+        Node* node = new Node();
+        node->type = type;
+        node->c = 0;
+        node->set = -1;
+        node->group = -1;
+        node->min = 0;
+        node->max = 0;
+        node->greedy = true;
+        nodes.push_back(node);
+        return node;
+    }
+
+    bool atEnd() const {
+        return pos >= (int) pattern.length();
+    }
+
+    Node* parseAlternation() {
+        Node* left = parseConcatenation();
+        while (!failed && !atEnd() && pattern[pos] == '|') {
+            pos++;
+            Node* alt = newNode(N_ALT);
+            alt->kids.push_back(left);
+            alt->kids.push_back(parseConcatenation());
+            left = alt;
+        }
+        return left;
+    }
+
+    Node* parseConcatenation() {
+        Node* cat = newNode(N_CAT);
+        while (!failed && !atEnd() && pattern[pos] != '|' && pattern[pos] != ')') {
+            cat->kids.push_back(parseRepeat());
+        }
+        return cat;
+    }
+
+    Node* parseRepeat() {
+        Node* atom = parseAtom();
+        while (!failed && !atEnd()) {
+            int min, max;
+            char ch = pattern[pos];
+            if (ch == '*') {
+                min = 0; max = -1; pos++;
+            } else if (ch == '+') {
+                min = 1; max = -1; pos++;
+            } else if (ch == '?') {
+                min = 0; max = 1; pos++;
+            } else if (ch == '{' && parseCount(min, max)) {
+                // pos already advanced by parseCount
+            } else {
+                break;
+            }
+            Node* rep = newNode(N_REPEAT);
+            rep->min = min;
+            rep->max = max;
+            if (!atEnd() && pattern[pos] == '?') {
+                rep->greedy = false;
+                pos++;
+            } else if (!atEnd() && pattern[pos] == '+') {
+                failed = true;          // possessive quantifier
+            }
+            rep->kids.push_back(atom);
+            atom = rep;
+        }
+        return atom;
+    }
+
+    bool parseCount(int& min, int& max) {
+        int p = pos + 1;
+        int n = pattern.length();
+        if (p >= n || !isdigit(pattern[p])) return false;
+        min = 0;
+        while (p < n && isdigit(pattern[p])) {
+            min = min * 10 + (pattern[p++] - '0');
+            if (min > MAX_PROGRAM_SIZE) return failRepeat();
+        }
+        max = min;
+        if (p < n && pattern[p] == ',') {
+            p++;
+            max = -1;
+            if (p < n && isdigit(pattern[p])) {
+                max = 0;
+                while (p < n && isdigit(pattern[p])) {
+                    max = max * 10 + (pattern[p++] - '0');
+                    if (max > MAX_PROGRAM_SIZE) return failRepeat();
+                }
+            }
+        }
+        if (p >= n || pattern[p] != '}' || (max >= 0 && max < min)) {
+            return failRepeat();
+        }
+        pos = p + 1;
+        return true;
+    }
+
+    bool failRepeat() {
+        failed = true;
+        return false;
+    }
+
+    Node* parseAtom() {
+        char ch = pattern[pos++];
+        switch (ch) {
+        case '(': {
+            Node* group = newNode(N_GROUP);
+            if (!atEnd() && pattern[pos] == '?') {
+                if (pos + 1 < (int) pattern.length() && pattern[pos + 1] == ':') {
+                    pos += 2;
+                } else {
+                    failed = true;      // lookaround, flags, named groups
+                    return group;
+                }
+            } else {
+                group->group = prog.nsub++;
+            }
+            group->kids.push_back(parseAlternation());
+            if (atEnd() || pattern[pos] != ')') {
+                failed = true;
+            } else {
+                pos++;
+            }
+            return group;
+        }
+        case '.':
+            return newNode(N_ANY);
+        case '^':
+            return newNode(N_BOL);
+        case '$':
+            return newNode(N_EOL);
+        case '[':
+            return parseClass();
+        case '\\':
+            return parseEscape();
+        case '*': case '+': case '?': case '{': case ')':
+            failed = true;              // dangling meta-character
+            return newNode(N_EMPTY);
+        default: {
+            Node* node = newNode(N_CHAR);
+            node->c = (unsigned char) ch;
+            return node;
+        }
+        }
+    }
+
+    Node* parseEscape() {
+        if (atEnd()) {
+            failed = true;
+            return newNode(N_EMPTY);
+        }
+        char ch = pattern[pos++];
+        if (ch == 'b') return newNode(N_WORDB);
+        if (ch == 'B') return newNode(N_NWORDB);
+        CharSet set;
+        clearSet(set);
+        if (addClassEscape(ch, set)) {
+            Node* node = newNode(N_CLASS);
+            node->set = addSet(set);
+            return node;
+        }
+        int lit = literalEscape(ch);
+        if (lit < 0) {
+            failed = true;
+            return newNode(N_EMPTY);
+        }
+        Node* node = newNode(N_CHAR);
+        node->c = (unsigned char) lit;
+        return node;
+    }
+
+    Node* parseClass() {
+        CharSet set;
+        clearSet(set);
+        bool negate = false;
+        if (!atEnd() && pattern[pos] == '^') {
+            negate = true;
+            pos++;
+        }
+        bool first = true;
+        while (!atEnd() && (pattern[pos] != ']' || first)) {
+            first = false;
+            int lo = classChar(set);
+            if (failed) break;
+            if (lo < 0) continue;       // a \d-style escape was added
+            if (pos + 1 < (int) pattern.length() && pattern[pos] == '-'
+                    && pattern[pos + 1] != ']') {
+                pos++;
+                int hi = classChar(set);
+                if (failed || hi < 0 || hi < lo) {
+                    failed = true;
+                    break;
+                }
+                for (int c = lo; c <= hi; c++) set.bits[c] = true;
+            } else {
+                set.bits[lo] = true;
+            }
+        }
+        if (atEnd()) {
+            failed = true;
+        } else {
+            pos++;                      // skip ']'
+        }
+        if (negate) {
+            for (int c = 0; c < 256; c++) set.bits[c] = !set.bits[c];
+        }
+        Node* node = newNode(N_CLASS);
+        node->set = addSet(set);
+        return node;
+    }
+
+    /*
+     * Reads one class member; returns its character code, or -1 if it was
+     * a predefined class escape that has already been added to the set.
+     */
+    int classChar(CharSet& set) {
+        char ch = pattern[pos++];
+        if (ch == '[' || (ch == '&' && !atEnd() && pattern[pos] == '&')) {
+            failed = true;              // nested classes and intersections
+            return -1;
+        }
+        if (ch != '\\') return (unsigned char) ch;
+        if (atEnd()) {
+            failed = true;
+            return -1;
+        }
+        ch = pattern[pos++];
+        if (addClassEscape(ch, set)) return -1;
+        int lit = literalEscape(ch);
+        if (lit < 0) failed = true;
+        return lit;
+    }
+
+    static void clearSet(CharSet& set) {
+        for (int c = 0; c < 256; c++) set.bits[c] = false;
+    }
+
+    static bool isWordChar(int c) {
+        return isalnum(c) || c == '_';
+    }
+
+    static bool isSpaceChar(int c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\x0B'
+                || c == '\f' || c == '\r';
+    }
+
+    static bool addClassEscape(char ch, CharSet& set) {
+        for (int c = 0; c < 256; c++) {
+            bool in;
+            switch (ch) {
+            case 'd': in = c >= '0' && c <= '9'; break;
+            case 'D': in = !(c >= '0' && c <= '9'); break;
+            case 'w': in = c < 128 && isWordChar(c); break;
+            case 'W': in = !(c < 128 && isWordChar(c)); break;
+            case 's': in = isSpaceChar(c); break;
+            case 'S': in = !isSpaceChar(c); break;
+            default: return false;
+            }
+            if (in) set.bits[c] = true;
+        }
+        return true;
+    }
+
+    static int literalEscape(char ch) {
+        switch (ch) {
+        case 't': return '\t';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'a': return '\a';
+        case 'e': return '\x1B';
+        default:
+            // escaped punctuation stands for itself; letters and digits
+            // are reserved (back-references, \p{...}, \x.., etc.)
+            return isalnum((unsigned char) ch) ? -1 : (unsigned char) ch;
+        }
+    }
+
+    int addSet(const CharSet& set) {
+        prog.sets.push_back(set);
+        return prog.sets.size() - 1;
+    }
+
+    int emit(OpCode op, int x, int y, int n) {
+        Inst inst;
+        inst.op = op;
+        inst.x = x;
+        inst.y = y;
+        inst.n = n;
+        inst.c = 0;
+        inst.set = -1;
+        prog.code.push_back(inst);
+        if ((int) prog.code.size() > MAX_PROGRAM_SIZE) failed = true;
+        return prog.code.size() - 1;
+    }
+
+    void generate(Node* node) {
+        if (failed) return;
+        switch (node->type) {
+        case N_CHAR: {
+            int pc = emit(OP_CHAR, 0, 0, 0);
+            prog.code[pc].c = node->c;
+            break;
+        }
+        case N_CLASS: {
+            int pc = emit(OP_CLASS, 0, 0, 0);
+            prog.code[pc].set = node->set;
+            break;
+        }
+        case N_ANY: emit(OP_ANY, 0, 0, 0); break;
+        case N_BOL: emit(OP_BOL, 0, 0, 0); break;
+        case N_EOL: emit(OP_EOL, 0, 0, 0); break;
+        case N_WORDB: emit(OP_WORDB, 0, 0, 0); break;
+        case N_NWORDB: emit(OP_NWORDB, 0, 0, 0); break;
+        case N_EMPTY: break;
+        case N_CAT:
+            for (size_t i = 0; i < node->kids.size(); i++) {
+                generate(node->kids[i]);
+            }
+            break;
+        case N_ALT: {
+            int split = emit(OP_SPLIT, 0, 0, 0);
+            prog.code[split].x = prog.code.size();
+            generate(node->kids[0]);
+            int jmp = emit(OP_JMP, 0, 0, 0);
+            prog.code[split].y = prog.code.size();
+            generate(node->kids[1]);
+            prog.code[jmp].x = prog.code.size();
+            break;
+        }
+        case N_GROUP:
+            if (node->group >= 0) emit(OP_SAVE, 0, 0, 2 * node->group);
+            generate(node->kids[0]);
+            if (node->group >= 0) emit(OP_SAVE, 0, 0, 2 * node->group + 1);
+            break;
+        case N_REPEAT:
+            generateRepeat(node);
+            break;
+        }
+    }
+
+    void generateRepeat(Node* node) {
+        Node* body = node->kids[0];
+        for (int i = 0; i < node->min && !failed; i++) {
+            generate(body);
+        }
+        if (node->max < 0) {
+            // x* : L1: split L2, L3; L2: body; jmp L1; L3:
+            int split = emit(OP_SPLIT, 0, 0, 0);
+            generate(body);
+            emit(OP_JMP, split, 0, 0);
+            setSplit(split, split + 1, prog.code.size(), node->greedy);
+        } else {
+            // x? repeated (max - min) times, each one nested in the previous
+            std::vector<int> splits;
+            for (int i = node->min; i < node->max && !failed; i++) {
+                splits.push_back(emit(OP_SPLIT, 0, 0, 0));
+                generate(body);
+            }
+            for (size_t i = 0; i < splits.size() && !failed; i++) {
+                setSplit(splits[i], splits[i] + 1, prog.code.size(), node->greedy);
+            }
+        }
+    }
+
+    void setSplit(int pc, int body, int exit, bool greedy) {
+        if (failed) return;
+        prog.code[pc].x = greedy ? body : exit;
+        prog.code[pc].y = greedy ? exit : body;
+    }
+};
+
+/*
+ * Simulates a compiled program with the Pike VM.  Thread lists are kept in
+ * priority order; each thread owns a slice of a flat capture buffer.  The
+ * buffers only grow, so a machine reused through reset() does not allocate
+ * once it has seen the largest program.
+ */
+class PikeVM {
+public:
+    PikeVM() : prog(NULL), s(NULL), ncap(0), generation(0) {
+        lists[0].count = 0;
+        lists[1].count = 0;
+    }
+
+    /*
+     * Prepares the machine to run 'prog' over 's', keeping the buffers of
+     * earlier runs.
+     */
+    void reset(const RegexProgram& prog, const std::string& s) {
+        this->prog = &prog;
+        this->s = &s;
+        ncap = 2 * prog.nsub;
+        size_t size = prog.code.size();
+        for (int k = 0; k < 2; k++) {
+            if (lists[k].pcs.size() < size) lists[k].pcs.resize(size);
+            if (lists[k].caps.size() < size * ncap) lists[k].caps.resize(size * ncap);
+            lists[k].count = 0;
+        }
+        if (mark.size() < size) mark.resize(size);
+        if (scratch.size() < (size_t) ncap) scratch.resize(ncap);
+        // marks of earlier runs are older than any generation of this one
+        std::fill(mark.begin(), mark.begin() + size, -1);
+        generation = 0;
+    }
+
+    /*
+     * Finds the leftmost match starting at or after 'start'.  On success,
+     * fills 'caps' with 2 * nsub positions (-1 for unset groups).
+     */
+    bool search(int start, std::vector<int>& caps) {
+        int n = s->length();
+        bool matched = false;
+        ThreadList* clist = &lists[0];
+        ThreadList* nlist = &lists[1];
+        clist->count = 0;
+        nextGeneration();
+        for (int i = start; ; i++) {
+            if (!matched) {
+                for (int k = 0; k < ncap; k++) scratch[k] = -1;
+                addThread(*clist, 0, i, &scratch[0]);
+            }
+            if (clist->count == 0) {
+                if (matched || i >= n) break;
+                nextGeneration();
+                continue;               // no live threads; try next start
+            }
+            nlist->count = 0;
+            nextGeneration();
+            for (int t = 0; t < clist->count; t++) {
+                int pc = clist->pcs[t];
+                int* tcaps = &clist->caps[t * ncap];
+                const Inst& inst = prog->code[pc];
+                if (inst.op == OP_MATCH) {
+                    matched = true;
+                    caps.assign(tcaps, tcaps + ncap);
+                    break;              // lower-priority threads are cut off
+                }
+                if (i < n && consumes(inst, (unsigned char) (*s)[i])) {
+                    for (int k = 0; k < ncap; k++) scratch[k] = tcaps[k];
+                    addThread(*nlist, pc + 1, i + 1, &scratch[0]);
+                }
+            }
+            ThreadList* tmp = clist;
+            clist = nlist;
+            nlist = tmp;
+            if (i >= n) break;
+        }
+        return matched;
+    }
+
+private:
+    struct ThreadList {
+        std::vector<int> pcs;
+        std::vector<int> caps;
+        int count;
+    };
+
+    const RegexProgram* prog;
+    const std::string* s;
+    int ncap;
+    ThreadList lists[2];
+    std::vector<int> mark;
+    std::vector<int> scratch;
+    int generation;
+
+    void nextGeneration() {
+        generation++;
+    }
+
+    bool consumes(const Inst& inst, unsigned char ch) const {
+        switch (inst.op) {
+        case OP_CHAR: return inst.c == ch;
+        case OP_ANY: return ch != '\n' && ch != '\r';
+        case OP_CLASS: return prog->sets[inst.set].bits[ch];
+        default: return false;
+        }
+    }
+
+    bool isWordAt(int i) const {
+        if (i < 0 || i >= (int) s->length()) return false;
+        unsigned char ch = (*s)[i];
+        return ch < 128 && (isalnum(ch) || ch == '_');
+    }
+
+    void addThread(ThreadList& list, int pc, int i, int* caps) {
+        if (mark[pc] == generation) return;
+        mark[pc] = generation;
+        const Inst& inst = prog->code[pc];
+        int n = s->length();
+        switch (inst.op) {
+        case OP_JMP:
+            addThread(list, inst.x, i, caps);
+            return;
+        case OP_SPLIT:
+            addThread(list, inst.x, i, caps);
+            addThread(list, inst.y, i, caps);
+            return;
+        case OP_SAVE: {
+            int old = caps[inst.n];
+            caps[inst.n] = i;
+            addThread(list, pc + 1, i, caps);
+            caps[inst.n] = old;
+            return;
+        }
+        case OP_BOL:
+            if (i == 0) addThread(list, pc + 1, i, caps);
+            return;
+        case OP_EOL:
+            if (i == n || (i == n - 1 && (*s)[i] == '\n')) {
+                addThread(list, pc + 1, i, caps);
+            }
+            return;
+        case OP_WORDB:
+        case OP_NWORDB: {
+            bool boundary = isWordAt(i - 1) != isWordAt(i);
+            if (boundary == (inst.op == OP_WORDB)) {
+                addThread(list, pc + 1, i, caps);
+            }
+            return;
+        }
+        default:
+            break;
+        }
+        int t = list.count++;
+        list.pcs[t] = pc;
+        for (int k = 0; k < ncap; k++) list.caps[t * ncap + k] = caps[k];
+    }
+};
+
+/*
+ * Compiled programs of one thread by pattern text, NULL for patterns the
+ * native engine does not handle.  Each thread has its own cache, like
+ * its own machine, so no lock is taken and a program is never freed
+ * while another thread runs it.
+ */
+class RegexCache {
+public:
+    ~RegexCache() {
+        clear();
+    }
+
+    const RegexProgram* get(const std::string& regexp) {
+        std::map<std::string, RegexProgram*>::iterator it = programs.find(regexp);
+        if (it != programs.end()) {
+            return it->second;
+        }
+        if (programs.size() >= MAX_CACHE_SIZE) {
+            clear();
+        }
+        RegexProgram* prog = new RegexProgram();
+        RegexCompiler compiler(regexp, *prog);
+        if (!compiler.compile()) {
+            delete prog;
+            prog = NULL;
+        }
+        programs[regexp] = prog;
+        return prog;
+    }
+
+private:
+    std::map<std::string, RegexProgram*> programs;
+
+    void clear() {
+        std::map<std::string, RegexProgram*>::iterator it;
+        for (it = programs.begin(); it != programs.end(); ++it) {
+            delete it->second;
+        }
+        programs.clear();
+    }
+};
+
+/*
+ * Returns the compiled program for the pattern, or NULL if the pattern
+ * uses syntax the native engine does not handle.  Results (including
+ * failures) are cached by pattern text for the calling thread.
+ */
+const RegexProgram* getCompiledRegex(const std::string& regexp) {
+    static thread_local RegexCache cache;
+    return cache.get(regexp);
+}
+
+/*
+ * Appends the replacement text to 'out', expanding $n group references
+ * and \-escapes the way java.util.regex.Matcher.appendReplacement does.
+ */
+void appendReplacement(std::string& out, const std::string& s,
+                       const std::string& replacement,
+                       const std::vector<int>& caps, int nsub) {
+    int len = replacement.length();
+    for (int i = 0; i < len; i++) {
+        char ch = replacement[i];
+        if (ch == '\\' && i + 1 < len) {
+            out += replacement[++i];
+        } else if (ch == '$' && i + 1 < len && isdigit(replacement[i + 1])) {
+            int group = replacement[++i] - '0';
+            while (i + 1 < len && isdigit(replacement[i + 1])
+                   && group * 10 + (replacement[i + 1] - '0') < nsub) {
+                group = group * 10 + (replacement[++i] - '0');
+            }
+            if (group < nsub && caps[2 * group] >= 0) {
+                out += s.substr(caps[2 * group], caps[2 * group + 1] - caps[2 * group]);
+            }
+        } else {
+            out += ch;
+        }
+    }
+}
+
+/*
+ * Returns true if the replacement text can be expanded natively
+ * (named group references are left to the Java back-end).
+ */
+bool isSimpleReplacement(const std::string& replacement) {
+    for (size_t i = 0; i + 1 < replacement.length(); i++) {
+        if (replacement[i] == '\\') {
+            i++;
+        } else if (replacement[i] == '$' && !isdigit(replacement[i + 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Returns the machine of the calling thread, whose buffers are reused by
+ * every search it makes.
+ */
+PikeVM& threadMachine() {
+    static thread_local PikeVM vm;
+    return vm;
+}
+
+} // namespace
+
 bool regexMatch(std::string s, std::string regexp) {
-    return getPlatform()->regex_match(s, regexp);
+    const RegexProgram* prog = getCompiledRegex(regexp);
+    if (prog == NULL) {
+        return getPlatform()->regex_match(s, regexp);
+    }
+    std::vector<int> caps;
+    PikeVM& vm = threadMachine();
+    vm.reset(*prog, s);
+    return vm.search(0, caps);
 }
 
 int regexMatchCount(std::string s, std::string regexp) {
-    return getPlatform()->regex_matchCount(s, regexp);
+    const RegexProgram* prog = getCompiledRegex(regexp);
+    if (prog == NULL) {
+        return getPlatform()->regex_matchCount(s, regexp);
+    }
+    std::vector<int> caps;
+    PikeVM& vm = threadMachine();
+    vm.reset(*prog, s);
+    int count = 0;
+    int start = 0;
+    int n = s.length();
+    while (start <= n && vm.search(start, caps)) {
+        count++;
+        // after an empty match, resume one character further (as Java does)
+        start = (caps[1] == caps[0]) ? caps[1] + 1 : caps[1];
+    }
+    return count;
 }
 
 std::string regexReplace(std::string s, std::string regexp, std::string replacement, int limit) {
-    return getPlatform()->regex_replace(s, regexp, replacement, limit);
+    const RegexProgram* prog = getCompiledRegex(regexp);
+    if (prog == NULL || !isSimpleReplacement(replacement)) {
+        // the Java back-end always replaces every match
+        if (limit >= 0) {
+            error("regexReplace: a limit needs a pattern and replacement "
+                  "without back-references, lookaround, flags or named groups");
+        }
+        return getPlatform()->regex_replace(s, regexp, replacement);
+    }
+    std::vector<int> caps;
+    PikeVM& vm = threadMachine();
+    vm.reset(*prog, s);
+    std::string result;
+    int start = 0;
+    int copied = 0;
+    int n = s.length();
+    int count = 0;
+    while (start <= n && (limit < 0 || count < limit) && vm.search(start, caps)) {
+        result.append(s, copied, caps[0] - copied);
+        appendReplacement(result, s, replacement, caps, prog->nsub);
+        copied = caps[1];
+        count++;
+        start = (caps[1] == caps[0]) ? caps[1] + 1 : caps[1];
+    }
+    result.append(s, copied, std::string::npos);
+    return result;
 }
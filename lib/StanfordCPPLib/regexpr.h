@@ -6,10 +6,13 @@
  * is widely available, but as of this writing the regex library is not
  * supported on gcc and other major C++ compilers.
  * 
- * The regular expression functions are implemented by sending the strings and
- * regexes to the Java Back-End to run the operations in Java.  This is a bit
- * kludgy but we don't want to write our own regex parser from scratch.
- * Using Java's is a compromise for now.
+ * The regular expression functions are implemented by an in-process engine
+ * that follows java.util.regex semantics for the common subset of the syntax
+ * (literals, classes, \d \w \s, anchors, groups, alternation, greedy and
+ * lazy quantifiers).  Compiled patterns are cached for each thread, so
+ * repeated calls with the same regex do not re-parse it.  Patterns using
+ * other features are sent to the Java Back-End to run the operations in
+ * Java, as before.
  *
  * @author Marty Stepp
  * @version 2014/10/14
@@ -38,7 +41,9 @@ int regexMatchCount(std::string s, std::string regexp);
  * Replaces all occurrences of the given regular expression in s with the given
  * replacement text, and returns the resulting string.
  * If 'limit' >= 0 is passed, replaces that many occurrences of the regex rather
- * than replacing all occurrences.
+ * than replacing all occurrences.  A limit is only supported for the syntax of
+ * the in-process engine; with other patterns it signals an error, since the
+ * Java Back-End always replaces every occurrence.
  */
 std::string regexReplace(std::string s, std::string regexp,
                          std::string replacement, int limit = -1);
@@ -0,0 +1,113 @@
+/* File: accumulator.cpp
+ * -----------------------------------
+ *
+ * Implementation of the ReproducibleSum class.
+ */
+
+#include "accumulator.h"
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+/* Low 32 bits of a bin */
+static const long long BIN_MASK = 0xFFFFFFFFLL;
+
+/* Exponent of the lowest bit of bin 0: the exponent of the smallest
+ * subnormal double */
+static const int LOWEST_EXPONENT = -1074;
+
+ReproducibleSum::ReproducibleSum(){
+    for (int i = 0; i < BIN_COUNT; i++) bins[i] = 0;
+    pendingAdds = 0;
+    hasNaN = false;
+    hasPositiveInfinity = false;
+    hasNegativeInfinity = false;
+}
+
+void ReproducibleSum::add(double value){
+    unsigned long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+    int exponentField = (int) ((bits >> 52) & 0x7FF);
+    unsigned long long mantissa = bits & ((1ULL << 52) - 1);
+    if (exponentField == 0x7FF){
+        if (mantissa != 0){
+            hasNaN = true;
+        } else if (value > 0){
+            hasPositiveInfinity = true;
+        } else {
+            hasNegativeInfinity = true;
+        }
+        return;
+    }
+    if (exponentField == 0 && mantissa == 0) return;
+    // value = +-mantissa * 2^(shift + LOWEST_EXPONENT); subnormals have
+    // no hidden bit and the exponent of the smallest normal numbers
+    int shift = 0;
+    if (exponentField != 0){
+        mantissa |= 1ULL << 52;
+        shift = exponentField - 1;
+    }
+    int bin = shift / BIN_BITS;
+    int bit = shift % BIN_BITS;
+    // both halves of the mantissa fit in 64 bits after the shift
+    unsigned long long low = (mantissa & BIN_MASK) << bit;
+    unsigned long long high = (mantissa >> BIN_BITS) << bit;
+    long long parts[3] = { (long long) (low & BIN_MASK),
+                           (long long) ((low >> BIN_BITS) + (high & BIN_MASK)),
+                           (long long) (high >> BIN_BITS) };
+    if (bits >> 63){
+        for (int k = 0; k < 3; k++) bins[bin + k] -= parts[k];
+    } else {
+        for (int k = 0; k < 3; k++) bins[bin + k] += parts[k];
+    }
+    if (++pendingAdds >= MAX_PENDING_ADDS) normalize();
+}
+
+void ReproducibleSum::add(const double * values, int count){
+    for (int i = 0; i < count; i++) add(values[i]);
+}
+
+void ReproducibleSum::merge(const ReproducibleSum & other){
+    ReproducibleSum normalized = other;
+    normalized.normalize();
+    normalize();
+    for (int i = 0; i < BIN_COUNT; i++) bins[i] += normalized.bins[i];
+    pendingAdds = 1;
+    hasNaN |= other.hasNaN;
+    hasPositiveInfinity |= other.hasPositiveInfinity;
+    hasNegativeInfinity |= other.hasNegativeInfinity;
+}
+
+double ReproducibleSum::result() const {
+    if (hasNaN || (hasPositiveInfinity && hasNegativeInfinity)) return NAN;
+    if (hasPositiveInfinity) return HUGE_VAL;
+    if (hasNegativeInfinity) return -HUGE_VAL;
+    ReproducibleSum sum = *this;
+    sum.normalize();
+    double sign = 1;
+    if (sum.bins[BIN_COUNT - 1] < 0){
+        sign = -1;
+        for (int i = 0; i < BIN_COUNT; i++) sum.bins[i] = -sum.bins[i];
+        sum.normalize();
+    }
+    // all bins are now non-negative digits; adding them from the lowest
+    // up rounds only where the partial sum is far below the next digit
+    double res = 0;
+    for (int i = 0; i < BIN_COUNT; i++){
+        if (sum.bins[i] != 0){
+            res += ldexp((double) sum.bins[i], i * BIN_BITS + LOWEST_EXPONENT);
+        }
+    }
+    return sign * res;
+}
+
+void ReproducibleSum::normalize(){
+    for (int i = 0; i + 1 < BIN_COUNT; i++){
+        long long digit = bins[i] & BIN_MASK;
+        // exact division: the difference is a multiple of 2^32
+        bins[i + 1] += (bins[i] - digit) / (BIN_MASK + 1);
+        bins[i] = digit;
+    }
+    pendingAdds = 0;
+}
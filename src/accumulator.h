@@ -0,0 +1,87 @@
+/* File: accumulator.h
+ * -----------------------------------
+ *
+ * This file exports an exact accumulator for sums of doubles whose
+ * result does not depend on the order of the additions.
+ */
+
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+/* Class ReproducibleSum
+ * --------------------------------
+ * This class adds doubles without rounding. Every double is an integer
+ * times a power of two; the accumulator keeps the sum as a long binary
+ * fixed-point number covering the whole range of doubles, split into
+ * bins of 32 bits held in 64-bit integers, so a value is added to at
+ * most three bins with integer additions and the spare bits absorb the
+ * carries until the next normalization. Since integer addition is
+ * exact, the sum is the same for any order of the values and any split
+ * of them between accumulators that are merged afterwards: parallel
+ * reductions built on it give bit-identical results for any number of
+ * threads. Only the final conversion rounds, to within one unit in the
+ * last place of the exact sum.
+ */
+class ReproducibleSum {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: ReproducibleSum
+     * Usage: ReproducibleSum sum;
+     * -----------------------------------------------------
+     * Initializes a sum of zero
+     */
+    ReproducibleSum();
+
+    /* Method: add
+     * Usage: sum.add(value);
+     *        sum.add(values, count);
+     * -----------------------------------------------------
+     * Adds one value or an array of values
+     */
+    void add(double value);
+    void add(const double * values, int count);
+
+    /* Method: merge
+     * Usage: sum.merge(partialSum);
+     * -----------------------------------------------------
+     * Adds the values of another accumulator
+     */
+    void merge(const ReproducibleSum & other);
+
+    /* Method: result
+     * Usage: double value = sum.result();
+     * -----------------------------------------------------
+     * Returns the sum rounded to a double; infinities and NaN among
+     * the values give the result of adding them in doubles
+     */
+    double result() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Bits of a bin and number of bins: 2098 bits of the double range
+     * plus room for carries of up to 2^64 values */
+    static const int BIN_BITS = 32;
+    static const int BIN_COUNT = 68;
+
+    /* Additions a bin can take before its spare bits may overflow */
+    static const int MAX_PENDING_ADDS = 1 << 29;
+
+    long long bins[BIN_COUNT];
+    int pendingAdds;
+    bool hasNaN;
+    bool hasPositiveInfinity;
+    bool hasNegativeInfinity;
+
+    /* Method: normalize
+     * Usage: normalize();
+     * ------------------------------------------------
+     * Moves the carries up, leaving 0..2^32-1 in every bin but the
+     * last, which holds the sign
+     */
+    void normalize();
+};
+
+#endif // ACCUMULATOR_H
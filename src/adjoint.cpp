@@ -0,0 +1,208 @@
+/* File: adjoint.cpp
+ * -----------------------------------
+ *
+ * Implementation of the ReverseGradient class.
+ */
+
+#include "adjoint.h"
+#include <cmath>
+#include <vector>
+#include "builtins.h"
+
+using namespace std;
+
+ReverseGradient::ReverseGradient(const Expression & expr) : expr(expr){
+    nodeCount = 0;
+    rowValues.resize(expr.variableCount() + 1);
+    rowDerivatives.resize(expr.variableCount() + 1);
+}
+
+double ReverseGradient::evaluate(const double * values, double * derivatives){
+    EvaluationBudget::charge(expr.size());
+    arena.reset();
+    int variables = expr.variableCount();
+    // nodes 0..variables-1 are the variables, one more node per operation
+    // and one per argument of a built-in
+    int capacity = variables + expr.size();
+    for (int i = 0; i < expr.size(); i++){
+        if (expr.instruction(i).op == BUILTIN) capacity += builtinArgumentCount(expr.instruction(i).operand);
+    }
+    TapeNode * tape = arena.allocate<TapeNode>(capacity);
+    double * stack = arena.allocate<double>(expr.stackDepth());
+    int * ids = arena.allocate<int>(expr.stackDepth());
+    double * temporaries = arena.allocate<double>(expr.tempCount());
+    int * tempIds = arena.allocate<int>(expr.tempCount());
+    int count = variables;
+    int top = 0;
+
+    for (int i = 0; i < expr.size(); i++){
+        const Instruction & ins = expr.instruction(i);
+        if (ins.op == PUSH_CONSTANT){
+            stack[top] = expr.constant(ins.operand);
+            ids[top++] = -1;
+            continue;
+        }
+        if (ins.op == PUSH_VARIABLE){
+            stack[top] = values[ins.operand];
+            ids[top++] = ins.operand;
+            continue;
+        }
+        if (ins.op == STORE_TEMP){
+            temporaries[ins.operand] = stack[top - 1];
+            tempIds[ins.operand] = ids[top - 1];
+            continue;
+        }
+        if (ins.op == LOAD_TEMP){
+            // a shared value keeps its node, so its adjoints add up
+            stack[top] = temporaries[ins.operand];
+            ids[top++] = tempIds[ins.operand];
+            continue;
+        }
+        if (ins.op == CALL){
+            error("The gradient mode does not support calls of functions that are not inlined");
+        }
+        if (ins.op == BUILTIN){
+            // a chain of nodes, each adding the partial by one more argument
+            int arguments = builtinArgumentCount(ins.operand);
+            top -= arguments - 1;
+            const double * args = stack + top - 1;
+            const int * argIds = ids + top - 1;
+            double res = evaluateBuiltin(ins.operand, args);
+            for (int k = 0; k < arguments; k++){
+                double partial = argIds[k] >= 0 ? BuiltinRegistry::shared().partial(ins.operand, k).evaluate(args) : 0;
+                if (k == 0){
+                    tape[count].parentA = argIds[0];
+                    tape[count].partialA = partial;
+                    tape[count].parentB = -1;
+                    tape[count].partialB = 0;
+                } else if (k == 1){
+                    tape[count].parentB = argIds[1];
+                    tape[count].partialB = partial;
+                } else {
+                    count++;
+                    tape[count].parentA = count - 1;
+                    tape[count].partialA = 1;
+                    tape[count].parentB = argIds[k];
+                    tape[count].partialB = partial;
+                }
+            }
+            stack[top - 1] = res;
+            ids[top - 1] = count++;
+            continue;
+        }
+        if (Expression::isComparison(ins.op)){
+            // a comparison is constant where it is differentiable
+            top--;
+            stack[top - 1] = Expression::compare(ins.op, stack[top - 1], stack[top]) ? 1 : 0;
+            ids[top - 1] = -1;
+            continue;
+        }
+        if (ins.op == JUMP){
+            i += ins.operand - 1;
+            continue;
+        }
+        if (ins.op == JUMP_IF_FALSE || ins.op == JUMP_IF_TRUE){
+            // only the branch taken gets on the tape
+            top--;
+            if ((stack[top] != 0) == (ins.op == JUMP_IF_TRUE)) i += ins.operand - 1;
+            continue;
+        }
+        TapeNode & node = tape[count];
+        node.partialB = 0;
+        node.parentB = -1;
+        double res;
+        if (ins.op <= POWER){
+            top--;
+            double a = stack[top - 1];
+            double b = stack[top];
+            node.parentA = ids[top - 1];
+            node.parentB = ids[top];
+            switch (ins.op){
+            case ADD:
+                res = a + b;
+                node.partialA = 1;
+                node.partialB = 1;
+                break;
+            case SUBTRACT:
+                res = a - b;
+                node.partialA = 1;
+                node.partialB = -1;
+                break;
+            case MULTIPLY:
+                res = a * b;
+                node.partialA = b;
+                node.partialB = a;
+                break;
+            case DIVIDE:
+                res = a / b;
+                node.partialA = 1 / b;
+                node.partialB = -res / b;
+                break;
+            default:
+                res = pow(a, b);
+                node.partialA = b * pow(a, b - 1);
+                // ln(a) is only needed for a variable exponent
+                node.partialB = node.parentB >= 0 ? res * log(a) : 0;
+                break;
+            }
+        } else {
+            double a = stack[top - 1];
+            node.parentA = ids[top - 1];
+            switch (ins.op){
+            case SIN:
+                res = sin(a);
+                node.partialA = cos(a);
+                break;
+            case COS:
+                res = cos(a);
+                node.partialA = -sin(a);
+                break;
+            case SQRT:
+                res = sqrt(a);
+                node.partialA = 0.5 / res;
+                break;
+            case TAN:
+                res = tan(a);
+                node.partialA = 1 + res * res;
+                break;
+            default:
+                res = log(a);
+                node.partialA = 1 / a;
+                break;
+            }
+        }
+        stack[top - 1] = res;
+        ids[top - 1] = count++;
+    }
+    nodeCount = count - variables;
+
+    // backward sweep: push each adjoint to the operands of its node
+    double * adjoints = arena.allocate<double>(count);
+    for (int k = 0; k < count; k++) adjoints[k] = 0;
+    if (ids[0] >= 0) adjoints[ids[0]] = 1;
+    for (int k = count - 1; k >= variables; k--){
+        double adjoint = adjoints[k];
+        if (adjoint == 0) continue;
+        const TapeNode & node = tape[k];
+        if (node.parentA >= 0) adjoints[node.parentA] += adjoint * node.partialA;
+        if (node.parentB >= 0) adjoints[node.parentB] += adjoint * node.partialB;
+    }
+    for (int v = 0; v < variables; v++){
+        derivatives[v] = adjoints[v];
+    }
+    return stack[0];
+}
+
+void ReverseGradient::evaluateBatch(const double * const * columns, int rows,
+                                    double * results, double * const * gradients){
+    int variables = expr.variableCount();
+    for (int r = 0; r < rows; r++){
+        for (int v = 0; v < variables; v++) rowValues[v] = columns[v][r];
+        results[r] = evaluate(&rowValues[0], &rowDerivatives[0]);
+        for (int v = 0; v < variables; v++) gradients[v][r] = rowDerivatives[v];
+    }
+}
+
+int ReverseGradient::tapeSize() const {
+    return nodeCount;
+}
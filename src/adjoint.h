@@ -0,0 +1,82 @@
+/* File: adjoint.h
+ * -----------------------------------
+ *
+ * This file exports reverse-mode automatic differentiation of
+ * compiled expressions.
+ */
+
+#ifndef ADJOINT_H
+#define ADJOINT_H
+
+#include <vector>
+#include "arena.h"
+#include "expression.h"
+
+/* Class ReverseGradient
+ * --------------------------------
+ * This class computes the gradient of an expression in reverse mode:
+ * the evaluation records a tape with the local partial derivatives of
+ * every operation, then one backward sweep over the tape accumulates
+ * the adjoints. The cost does not depend on the number of variables,
+ * unlike forward mode, which carries one derivative per variable.
+ * The tape lives in an arena owned by the object, so repeated
+ * evaluations reuse the same memory and do not allocate.
+ */
+class ReverseGradient {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: ReverseGradient
+     * Usage: ReverseGradient gradient(expr);
+     * -----------------------------------------------------
+     * Prepares the evaluation of the expression's gradient
+     */
+    explicit ReverseGradient(const Expression & expr);
+
+    /* Method: evaluate
+     * Usage: double value = gradient.evaluate(values, derivatives);
+     * -----------------------------------------------------
+     * Evaluates the expression with the given variable values and stores
+     * the derivative by each variable in derivatives
+     */
+    double evaluate(const double * values, double * derivatives);
+
+    /* Method: evaluateBatch
+     * Usage: gradient.evaluateBatch(columns, rows, results, gradients);
+     * -----------------------------------------------------
+     * Evaluates every row; columns[v][row] is the value of variable v
+     * and gradients[v][row] receives the derivative by variable v
+     */
+    void evaluateBatch(const double * const * columns, int rows,
+                       double * results, double * const * gradients);
+
+    /* Method: tapeSize
+     * Usage: int nodes = gradient.tapeSize();
+     * -----------------------------------------------------
+     * Returns the number of operations recorded by the last evaluation
+     */
+    int tapeSize() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* One recorded operation: the result depends on up to two earlier
+     * nodes (-1 for a constant) with the given partial derivatives */
+    struct TapeNode {
+        double partialA;
+        double partialB;
+        int parentA;
+        int parentB;
+    };
+
+    Expression expr;
+    Arena arena;
+    int nodeCount;
+
+    /* Values and derivatives of one row of a batch */
+    std::vector<double> rowValues;
+    std::vector<double> rowDerivatives;
+};
+
+#endif // ADJOINT_H
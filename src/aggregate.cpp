@@ -0,0 +1,262 @@
+/* File: aggregate.cpp
+ * -----------------------------------
+ *
+ * Implementation of the aggregates of columns.
+ */
+
+#include "aggregate.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "columnfile.h"
+#include "csv.h"
+#include "expression.h"
+#include "threadpool.h"
+
+using namespace std;
+
+/* Rows of a columnar file aggregated by one task */
+static const long long ROWS_PER_TASK = 65536;
+
+/* Rows evaluated at a time before they are aggregated */
+static const int EVALUATION_ROWS = 4096;
+
+ColumnAggregate::ColumnAggregate(){
+    values = 0;
+    minimum = INFINITY;
+    maximum = -INFINITY;
+    average = 0;
+    squares = 0;
+}
+
+void ColumnAggregate::add(const double * data, int count){
+    double kept[KEPT_VALUES];
+    for (int start = 0; start < count; start += KEPT_VALUES){
+        int n = std::min((int) KEPT_VALUES, count - start);
+        // drop the NaN values without branches
+        int k = 0;
+        for (int r = 0; r < n; r++){
+            double value = data[start + r];
+            kept[k] = value;
+            k += value == value;
+        }
+        if (k == 0) continue;
+        double low[LANES], high[LANES], partial[LANES];
+        for (int l = 0; l < LANES; l++){
+            low[l] = INFINITY;
+            high[l] = -INFINITY;
+            partial[l] = 0;
+        }
+        int end = k / LANES * LANES;
+        for (int r = 0; r < end; r += LANES){
+            for (int l = 0; l < LANES; l++){
+                double value = kept[r + l];
+                low[l] = value < low[l] ? value : low[l];
+                high[l] = value > high[l] ? value : high[l];
+                partial[l] += value;
+            }
+        }
+        for (int r = end; r < k; r++){
+            low[0] = kept[r] < low[0] ? kept[r] : low[0];
+            high[0] = kept[r] > high[0] ? kept[r] : high[0];
+            partial[0] += kept[r];
+        }
+        double blockMean = ((partial[0] + partial[1]) + (partial[2] + partial[3])) / k;
+        for (int l = 0; l < LANES; l++){
+            minimum = low[l] < minimum ? low[l] : minimum;
+            maximum = high[l] > maximum ? high[l] : maximum;
+            partial[l] = 0;
+        }
+        // the block is in the cache: a second pass gives the deviations
+        for (int r = 0; r < end; r += LANES){
+            for (int l = 0; l < LANES; l++){
+                double deviation = kept[r + l] - blockMean;
+                partial[l] += deviation * deviation;
+            }
+        }
+        for (int r = end; r < k; r++){
+            partial[0] += (kept[r] - blockMean) * (kept[r] - blockMean);
+        }
+        total.add(kept, k);
+        // combine the variances as in merge
+        long long before = values;
+        values += k;
+        double delta = blockMean - average;
+        average += delta * k / values;
+        squares += (partial[0] + partial[1]) + (partial[2] + partial[3])
+                + delta * delta * ((double) before * k / values);
+    }
+}
+
+void ColumnAggregate::merge(const ColumnAggregate & other){
+    if (other.values == 0) return;
+    total.merge(other.total);
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+    long long before = values;
+    values += other.values;
+    double delta = other.average - average;
+    average += delta * other.values / values;
+    squares += other.squares + delta * delta * ((double) before * other.values / values);
+}
+
+long long ColumnAggregate::count() const {
+    return values;
+}
+
+double ColumnAggregate::sum() const {
+    return total.result();
+}
+
+double ColumnAggregate::mean() const {
+    return values > 0 ? total.result() / values : NAN;
+}
+
+double ColumnAggregate::min() const {
+    return values > 0 ? minimum : NAN;
+}
+
+double ColumnAggregate::max() const {
+    return values > 0 ? maximum : NAN;
+}
+
+double ColumnAggregate::variance() const {
+    return values > 1 ? squares / (values - 1) : NAN;
+}
+
+bool isAggregateName(const string & name){
+    return name == "sum" || name == "mean" || name == "min" || name == "max"
+            || name == "variance" || name == "count";
+}
+
+/*
+ * Function: aggregateRows
+ * Usage: aggregateRows(expr, columns, constants, rows, aggregate);
+ * ______________________________________________________
+ *
+ * Adds the results of an equation for some rows to an aggregate; the
+ * variables with a NULL column are constant
+ */
+static void aggregateRows(const Expression & expr, const vector<const double *> & columns,
+                          const vector<double> & constants, int rows, ColumnAggregate & aggregate){
+    if (expr.size() == 1 && expr.instruction(0).op == PUSH_VARIABLE
+            && columns[expr.instruction(0).operand] != NULL){
+        aggregate.add(columns[expr.instruction(0).operand], rows);
+        return;
+    }
+    int variableCount = expr.variableCount();
+    int blockRows = min(rows, EVALUATION_ROWS);
+    vector<vector<double> > constantColumns(variableCount);
+    vector<const double *> pointers(variableCount + 1);
+    for (int v = 0; v < variableCount; v++){
+        if (columns[v] == NULL){
+            constantColumns[v].assign(blockRows, constants[v]);
+            pointers[v] = &constantColumns[v][0];
+        }
+    }
+    vector<double> results(blockRows);
+    for (int start = 0; start < rows; start += blockRows){
+        int n = min(blockRows, rows - start);
+        for (int v = 0; v < variableCount; v++){
+            if (columns[v] != NULL) pointers[v] = columns[v] + start;
+        }
+        expr.evaluateBatch(&pointers[0], n, &results[0]);
+        aggregate.add(&results[0], n);
+    }
+}
+
+/*
+ * Function: aggregateColumnFile / aggregateCsvFile
+ * Usage: ColumnAggregate aggregate = aggregateColumnFile(path, equation, variables);
+ * ______________________________________________________
+ *
+ * Aggregate an equation over a file of one format; the partial
+ * aggregates are merged in the order of the rows
+ */
+static ColumnAggregate aggregateColumnFile(const string & path, const string & equation,
+                                           const VariableTable & variables){
+    ColumnFile file(path);
+    vector<string> columnNames;
+    for (int c = 0; c < file.columnCount(); c++){
+        columnNames.push_back(file.columnName(c));
+    }
+    vector<int> sources;
+    vector<double> constants;
+    Expression expr = compileColumnEquation(columnNames, equation, variables, sources, constants);
+    long long rows = file.rowCount();
+    vector<ColumnAggregate> partials((rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK);
+    ThreadPool & pool = ThreadPool::shared();
+    for (size_t task = 0; task < partials.size(); task++){
+        pool.submit([&, task]{
+            long long start = task * ROWS_PER_TASK;
+            vector<const double *> columns(sources.size());
+            for (size_t v = 0; v < sources.size(); v++){
+                columns[v] = sources[v] >= 0 ? file.column(sources[v]) + start : NULL;
+            }
+            aggregateRows(expr, columns, constants, min(ROWS_PER_TASK, rows - start), partials[task]);
+        });
+    }
+    pool.wait();
+    ColumnAggregate aggregate;
+    for (size_t task = 0; task < partials.size(); task++){
+        aggregate.merge(partials[task]);
+    }
+    return aggregate;
+}
+
+static ColumnAggregate aggregateCsvFile(const string & path, const string & equation,
+                                        const VariableTable & variables, long long & invalid){
+    CsvFile file(path);
+    vector<string> columnNames;
+    for (int c = 0; c < file.columnCount(); c++){
+        columnNames.push_back(file.columnName(c));
+    }
+    vector<int> sources;
+    vector<double> constants;
+    Expression expr = compileColumnEquation(columnNames, equation, variables, sources, constants);
+    int variableCount = expr.variableCount();
+
+    // only the columns the equation uses are parsed
+    vector<int> slots(variableCount, -1);
+    vector<int> used;
+    for (int i = 0; i < expr.size(); i++){
+        const Instruction & ins = expr.instruction(i);
+        if (ins.op == PUSH_VARIABLE && sources[ins.operand] >= 0 && slots[ins.operand] < 0){
+            slots[ins.operand] = used.size();
+            used.push_back(sources[ins.operand]);
+        }
+    }
+
+    vector<ColumnAggregate> partials(file.chunkCount());
+    vector<long long> chunkInvalid(file.chunkCount(), 0);
+    ThreadPool & pool = ThreadPool::shared();
+    for (int chunk = 0; chunk < file.chunkCount(); chunk++){
+        pool.submit([&, chunk]{
+            vector<vector<double> > values;
+            int n = file.readChunk(chunk, used, values, chunkInvalid[chunk]);
+            if (n == 0) return;
+            vector<const double *> columns(variableCount, (const double *) NULL);
+            for (int v = 0; v < variableCount; v++){
+                if (slots[v] >= 0) columns[v] = &values[slots[v]][0];
+            }
+            aggregateRows(expr, columns, constants, n, partials[chunk]);
+        });
+    }
+    pool.wait();
+    ColumnAggregate aggregate;
+    invalid = 0;
+    for (int chunk = 0; chunk < file.chunkCount(); chunk++){
+        aggregate.merge(partials[chunk]);
+        invalid += chunkInvalid[chunk];
+    }
+    return aggregate;
+}
+
+ColumnAggregate aggregateFile(const string & path, const string & equation,
+                              const VariableTable & variables, long long & invalid){
+    invalid = 0;
+    if (isColumnFile(path)){
+        return aggregateColumnFile(path, equation, variables);
+    }
+    return aggregateCsvFile(path, equation, variables, invalid);
+}
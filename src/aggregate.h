@@ -0,0 +1,116 @@
+/* File: aggregate.h
+ * -----------------------------------
+ *
+ * This file exports the aggregates of a column: count, sum, mean,
+ * minimum, maximum and variance, of a column of a CSV or columnar file
+ * or of an equation calculated for every row of the file.
+ */
+
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <string>
+#include "accumulator.h"
+#include "variables.h"
+
+/* Class ColumnAggregate
+ * --------------------------------
+ * This class accumulates the aggregates of a sequence of values; NaN
+ * values (missing fields) are skipped. Values are taken by arrays and
+ * reduced with several independent accumulators, so the loops are
+ * vectorized. The sum is exact (see ReproducibleSum) and the variance
+ * is combined from the means and squared deviations of the arrays, so
+ * merging partial aggregates in a fixed order gives the same result for
+ * any number of threads.
+ */
+class ColumnAggregate {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: ColumnAggregate
+     * Usage: ColumnAggregate aggregate;
+     * -----------------------------------------------------
+     * Initializes the aggregates of no values
+     */
+    ColumnAggregate();
+
+    /* Method: add
+     * Usage: aggregate.add(values, count);
+     * -----------------------------------------------------
+     * Adds an array of values
+     */
+    void add(const double * values, int count);
+
+    /* Method: merge
+     * Usage: aggregate.merge(partial);
+     * -----------------------------------------------------
+     * Adds the values of another aggregate, which come after the values
+     * of this one
+     */
+    void merge(const ColumnAggregate & other);
+
+    /* Method: count / sum / mean / min / max / variance
+     * Usage: double mean = aggregate.mean();
+     * -----------------------------------------------------
+     * Return the aggregates of the values that are not NaN. The variance
+     * is the sample variance, with count - 1 in the denominator. Without
+     * values, or with one value for the variance, they are NaN.
+     */
+    long long count() const;
+    double sum() const;
+    double mean() const;
+    double min() const;
+    double max() const;
+    double variance() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Independent accumulators of the reduction loops */
+    static const int LANES = 4;
+
+    /* Values kept from one array at a time */
+    static const int KEPT_VALUES = 256;
+
+    long long values;
+    ReproducibleSum total;
+    double minimum;
+    double maximum;
+
+    /* Mean and sum of squared deviations from it, for the variance */
+    double average;
+    double squares;
+};
+
+/*
+ * Function: isAggregateName
+ * Usage: if (isAggregateName(name))...
+ * ______________________________________________________
+ *
+ * Returns true for sum, mean, min, max, variance and count
+ */
+bool isAggregateName(const std::string & name);
+
+/*
+ * Function: aggregateFile
+ * Usage: ColumnAggregate aggregate = aggregateFile(path, equation, variables, invalid);
+ * ______________________________________________________
+ *
+ * Calculates the aggregates of an equation over the rows of a CSV or
+ * columnar file, with the column names as variables and the declared
+ * variables as constants. Blocks of rows are calculated in parallel and
+ * each block is evaluated a few thousand rows at a time straight into
+ * its aggregate, so the column of results is never stored; a column
+ * alone is aggregated without evaluation.
+ *
+ * @param path - path of the CSV or columnar file
+ * @param equation - equation without spaces, in lower case
+ * @param variables - declared variables
+ * @param invalid - receives the number of missing or non-numeric CSV fields
+ * @return - the aggregates of the results
+ */
+ColumnAggregate aggregateFile(const std::string & path, const std::string & equation,
+                              const VariableTable & variables, long long & invalid);
+
+#endif // AGGREGATE_H
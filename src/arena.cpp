@@ -0,0 +1,71 @@
+/* File: arena.cpp
+ * -----------------------------------
+ *
+ * Implementation of the Arena class.
+ */
+
+#include "arena.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+Arena::Arena(){
+    current = NULL;
+    remaining = 0;
+}
+
+Arena::~Arena(){
+    for (size_t i = 0; i < blocks.size(); i++){
+        free(blocks[i]);
+    }
+}
+
+void Arena::reset(){
+    if (blocks.size() > 1){
+        // merge into one block, so the same work fits without growing
+        size_t total = capacity();
+        for (size_t i = 0; i < blocks.size(); i++){
+            free(blocks[i]);
+        }
+        blocks.clear();
+        blockSizes.clear();
+        addBlock(total);
+    } else if (!blocks.empty()){
+        current = blocks[0];
+        remaining = blockSizes[0];
+    }
+}
+
+size_t Arena::capacity() const {
+    size_t total = 0;
+    for (size_t i = 0; i < blockSizes.size(); i++){
+        total += blockSizes[i];
+    }
+    return total;
+}
+
+void * Arena::allocateBytes(size_t bytes){
+    bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (bytes > remaining){
+        addBlock(max(bytes, max(capacity(), (size_t) MIN_BLOCK_SIZE)));
+    }
+    void * res = current;
+    current += bytes;
+    remaining -= bytes;
+    return res;
+}
+
+void Arena::addBlock(size_t bytes){
+    // over-allocate so the start of the block can be aligned
+    char * block = static_cast<char *>(malloc(bytes + ALIGNMENT));
+    if (block == NULL){
+        throw bad_alloc();
+    }
+    blocks.push_back(block);
+    blockSizes.push_back(bytes);
+    size_t misalignment = reinterpret_cast<size_t>(block) % ALIGNMENT;
+    current = block + (misalignment == 0 ? 0 : ALIGNMENT - misalignment);
+    remaining = bytes;
+}
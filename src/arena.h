@@ -0,0 +1,97 @@
+/* File: arena.h
+ * -----------------------------------
+ *
+ * This file exports a bump-pointer memory arena for short-lived
+ * arrays that are rebuilt on every evaluation.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+/* Class Arena
+ * --------------------------------
+ * This class hands out memory by advancing a pointer inside a large
+ * block and frees everything at once with reset. When a block is
+ * exhausted a new one is added; the next reset replaces all blocks by
+ * a single block of their total size, so once the arena has seen the
+ * largest request pattern it never touches the heap again.
+ * The arena only suits types without destructors.
+ */
+class Arena {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: Arena
+     * Usage: Arena arena;
+     * -----------------------------------------------------
+     * Initializes an empty arena; memory is taken on first use
+     */
+    Arena();
+
+    /* Destructor: ~Arena
+     * -----------------------------------------------------
+     * Frees all blocks of the arena
+     */
+    ~Arena();
+
+    /* Method: allocate
+     * Usage: double * values = arena.allocate<double>(count);
+     * -----------------------------------------------------
+     * Returns uninitialized memory for count values, aligned for SIMD loads
+     */
+    template <typename ValueType>
+    ValueType * allocate(int count);
+
+    /* Method: reset
+     * Usage: arena.reset();
+     * -----------------------------------------------------
+     * Releases everything allocated since the last reset
+     */
+    void reset();
+
+    /* Method: capacity
+     * Usage: size_t bytes = arena.capacity();
+     * -----------------------------------------------------
+     * Returns the total size of the blocks held by the arena
+     */
+    size_t capacity() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Alignment of every allocation */
+    static const size_t ALIGNMENT = 32;
+
+    /* Size of the first block */
+    static const size_t MIN_BLOCK_SIZE = 4096;
+
+    std::vector<char *> blocks;
+    std::vector<size_t> blockSizes;
+
+    /* Free space of the last block */
+    char * current;
+    size_t remaining;
+
+    /* Method: allocateBytes / addBlock
+     * Usage: void * memory = allocateBytes(bytes);
+     * ------------------------------------------------
+     * Take memory from the current block, adding a block when it is full
+     */
+    void * allocateBytes(size_t bytes);
+    void addBlock(size_t bytes);
+
+    /* The arena owns its blocks and cannot be copied */
+    Arena(const Arena & src);
+    Arena & operator=(const Arena & src);
+};
+
+template <typename ValueType>
+ValueType * Arena::allocate(int count){
+    return static_cast<ValueType *>(allocateBytes(count * sizeof(ValueType)));
+}
+
+#endif // ARENA_H
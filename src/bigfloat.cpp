@@ -0,0 +1,683 @@
+/* File: bigfloat.cpp
+ * -----------------------------------
+ *
+ * Implementation of the BigFloat class.
+ */
+
+#include "bigfloat.h"
+#include <algorithm>
+#include <cmath>
+#include "budget.h"
+#include "error.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* Default number of significant digits */
+int BigFloat::precisionDigits = 50;
+
+/* Largest argument (in limbs above the point) accepted by sin/cos/tan */
+static const long long MAX_ANGLE_LIMBS = 10000;
+
+BigFloat::BigFloat(){
+    negative = false;
+    exponent = 0;
+}
+
+BigFloat::BigFloat(long long value){
+    negative = value < 0;
+    mantissa = BigInt(value).abs();
+    exponent = 0;
+    round(mantissa.limbCount());
+}
+
+BigFloat::BigFloat(const BigInt & value){
+    negative = value.isNegative();
+    mantissa = value.abs();
+    exponent = 0;
+    round(mantissa.limbCount());
+}
+
+BigFloat::BigFloat(const string & str){
+    negative = false;
+    exponent = 0;
+    int i = 0;
+    int len = str.length();
+    if (i < len && (str[i] == '-' || str[i] == '+')){
+        negative = str[i] == '-';
+        i++;
+    }
+    string digits;
+    long long decimalExponent = 0;
+    bool seenPoint = false;
+    for (; i < len; i++){
+        char ch = str[i];
+        if (ch >= '0' && ch <= '9'){
+            digits += ch;
+            if (seenPoint) decimalExponent--;
+        } else if (ch == '.' && !seenPoint){
+            seenPoint = true;
+        } else if ((ch == 'e' || ch == 'E') && !digits.empty() && i + 1 < len){
+            decimalExponent += BigInt(str.substr(i + 1)).toLongLong();
+            break;
+        } else {
+            error("BigFloat: illegal number format \"" + str + "\"");
+        }
+    }
+    if (digits.empty()){
+        error("BigFloat: illegal number format \"" + str + "\"");
+    }
+    // align the decimal exponent to a whole number of limbs
+    int pad = ((decimalExponent % BigInt::BASE_DIGITS) + BigInt::BASE_DIGITS) % BigInt::BASE_DIGITS;
+    digits.append(pad, '0');
+    decimalExponent -= pad;
+    mantissa = BigInt(digits);
+    exponent = decimalExponent / BigInt::BASE_DIGITS;
+    round(workingLimbs());
+}
+
+void BigFloat::setPrecision(int digits){
+    if (digits < 1){
+        error("BigFloat: precision must be positive");
+    }
+    if (digits > MAX_PRECISION){
+        error("BigFloat: precision must be at most " + integerToString(MAX_PRECISION) + " digits");
+    }
+    precisionDigits = digits;
+}
+
+int BigFloat::getPrecision(){
+    return precisionDigits;
+}
+
+bool BigFloat::isZero() const {
+    return mantissa.isZero();
+}
+
+bool BigFloat::isNegative() const {
+    return negative;
+}
+
+bool BigFloat::isInteger() const {
+    return exponent >= 0;
+}
+
+double BigFloat::toDouble() const {
+    if (mantissa.isZero()) return 0;
+    int n = mantissa.limbCount();
+    int low = max(0, n - 3);
+    double res = 0;
+    for (int i = n - 1; i >= low; i--){
+        res = res * BigInt::BASE + mantissa.limb(i);
+    }
+    res *= pow(10.0, (double) BigInt::BASE_DIGITS * (exponent + low));
+    return negative ? -res : res;
+}
+
+BigInt BigFloat::toInteger() const {
+    BigInt res = mantissa;
+    if (exponent >= 0){
+        res.shiftLimbs(exponent);
+    } else if (-exponent > mantissa.limbCount()){
+        return BigInt();
+    } else {
+        int drop = -exponent;
+        bool up = mantissa.limb(drop - 1) >= BigInt::BASE / 2;
+        res.shiftLimbs(-drop);
+        if (up) res += BigInt(1);
+    }
+    if (negative) res.negate();
+    return res;
+}
+
+BigInt BigFloat::getMantissa() const {
+    return negative ? -mantissa : mantissa;
+}
+
+long long BigFloat::getExponent() const {
+    return exponent;
+}
+
+string BigFloat::toString() const {
+    if (mantissa.isZero()) return "0";
+    string digits = mantissa.toString();
+    long long pointPos = (long long) digits.length() + BigInt::BASE_DIGITS * exponent;
+    int prec = precisionDigits;
+    if ((int) digits.length() > prec){
+        bool up = digits[prec] >= '5';
+        digits = digits.substr(0, prec);
+        if (up){
+            int i = prec - 1;
+            while (i >= 0 && digits[i] == '9'){
+                digits[i--] = '0';
+            }
+            if (i < 0){
+                digits = "1" + digits;
+                pointPos++;
+            } else {
+                digits[i]++;
+            }
+        }
+    }
+    while (digits.length() > 1 && digits[digits.length() - 1] == '0'){
+        digits.erase(digits.length() - 1);
+    }
+    string res = negative ? "-" : "";
+    long long len = digits.length();
+    if (pointPos > prec || pointPos < -20){
+        res += digits[0];
+        if (len > 1) res += "." + digits.substr(1);
+        res += "e" + string(pointPos > 0 ? "+" : "") + to_string(pointPos - 1);
+    } else if (pointPos <= 0){
+        res += "0." + string(-pointPos, '0') + digits;
+    } else if (pointPos >= len){
+        res += digits + string(pointPos - len, '0');
+    } else {
+        res += digits.substr(0, pointPos) + "." + digits.substr(pointPos);
+    }
+    return res;
+}
+
+int BigFloat::compare(const BigFloat & a, const BigFloat & b){
+    if (a.negative != b.negative){
+        return a.negative ? -1 : 1;
+    }
+    int cmp = 0;
+    if (a.isZero() || b.isZero()){
+        cmp = (a.isZero() ? 0 : 1) - (b.isZero() ? 0 : 1);
+    } else if (a.topExponent() != b.topExponent()){
+        cmp = a.topExponent() < b.topExponent() ? -1 : 1;
+    } else {
+        int na = a.mantissa.limbCount();
+        int nb = b.mantissa.limbCount();
+        for (int i = 1; i <= max(na, nb) && cmp == 0; i++){
+            unsigned int la = a.mantissa.limb(na - i);
+            unsigned int lb = b.mantissa.limb(nb - i);
+            if (la != lb) cmp = la < lb ? -1 : 1;
+        }
+    }
+    return a.negative ? -cmp : cmp;
+}
+
+BigFloat BigFloat::pi(){
+    BigFloat res = piWithPrecision(workingLimbs());
+    return res;
+}
+
+BigFloat BigFloat::operator-() const {
+    BigFloat res = *this;
+    if (!res.isZero()) res.negative = !res.negative;
+    return res;
+}
+
+BigFloat operator+(const BigFloat & a, const BigFloat & b){
+    return BigFloat::add(a, b, BigFloat::workingLimbs());
+}
+
+BigFloat operator-(const BigFloat & a, const BigFloat & b){
+    return BigFloat::add(a, -b, BigFloat::workingLimbs());
+}
+
+BigFloat operator*(const BigFloat & a, const BigFloat & b){
+    return BigFloat::multiply(a, b, BigFloat::workingLimbs());
+}
+
+BigFloat operator/(const BigFloat & a, const BigFloat & b){
+    if (b.isZero()){
+        error("Division by zero");
+    }
+    int limbs = BigFloat::workingLimbs();
+    return BigFloat::multiply(a, BigFloat::reciprocal(b, limbs + 1), limbs);
+}
+
+BigFloat sqrt(const BigFloat & x){
+    if (x.isNegative()){
+        error("sqrt: negative argument");
+    }
+    if (x.isZero()) return x;
+    int limbs = BigFloat::workingLimbs();
+    return BigFloat::multiply(x, BigFloat::inverseSqrt(x, limbs + 1), limbs);
+}
+
+BigFloat pow(const BigFloat & base, const BigFloat & exponent){
+    int limbs = BigFloat::workingLimbs();
+    if (exponent.isZero()) return BigFloat(1);
+    if (base.isZero()){
+        if (exponent.isNegative()){
+            error("Division by zero");
+        }
+        return base;
+    }
+    if (exponent.isInteger() && exponent.topExponent() <= 2){
+        // integer power by repeated squaring
+        long long n = exponent.toInteger().toLongLong();
+        unsigned long long k = n < 0 ? -n : n;
+        int bits = 0;
+        while ((k >> bits) > 0) bits++;
+        int prec = limbs + 1 + bits / 30;
+        BigFloat res(1);
+        BigFloat factor = base;
+        factor.round(prec);
+        while (k > 0){
+            if (k & 1) res = BigFloat::multiply(res, factor, prec);
+            k >>= 1;
+            if (k > 0) factor = BigFloat::multiply(factor, factor, prec);
+        }
+        if (n < 0) res = BigFloat::reciprocal(res, prec);
+        res.round(limbs);
+        return res;
+    }
+    if (base.isNegative()){
+        error("pow: negative base with a fractional exponent");
+    }
+    // x^y = exp(y * ln x); the error of ln x is scaled by |y ln x|
+    double scale = fabs(exponent.toDouble() * log(fabs(base.toDouble())));
+    int prec = limbs + 1 + (scale > 1 ? (int) (log10(scale) / BigInt::BASE_DIGITS) + 1 : 0);
+    BigFloat res = BigFloat::exponential(BigFloat::multiply(exponent, BigFloat::logarithm(base, prec), prec), prec);
+    res.round(limbs);
+    return res;
+}
+
+BigFloat exp(const BigFloat & x){
+    int limbs = BigFloat::workingLimbs();
+    BigFloat res = BigFloat::exponential(x, limbs + 1);
+    res.round(limbs);
+    return res;
+}
+
+BigFloat log(const BigFloat & x){
+    int limbs = BigFloat::workingLimbs();
+    BigFloat res = BigFloat::logarithm(x, limbs + 1);
+    res.round(limbs);
+    return res;
+}
+
+BigFloat sin(const BigFloat & x){
+    if (x.isZero()) return x;
+    int limbs = BigFloat::workingLimbs();
+    BigFloat reduced;
+    int quadrant;
+    BigFloat::reduceAngle(x, limbs + 1, reduced, quadrant);
+    BigFloat res = (quadrant % 2 == 0) ? BigFloat::sinSeries(reduced, limbs + 1)
+                                       : BigFloat::cosSeries(reduced, limbs + 1);
+    if (quadrant >= 2) res = -res;
+    res.round(limbs);
+    return res;
+}
+
+BigFloat cos(const BigFloat & x){
+    if (x.isZero()) return BigFloat(1);
+    int limbs = BigFloat::workingLimbs();
+    BigFloat reduced;
+    int quadrant;
+    BigFloat::reduceAngle(x, limbs + 1, reduced, quadrant);
+    BigFloat res = (quadrant % 2 == 0) ? BigFloat::cosSeries(reduced, limbs + 1)
+                                       : BigFloat::sinSeries(reduced, limbs + 1);
+    if (quadrant == 1 || quadrant == 2) res = -res;
+    res.round(limbs);
+    return res;
+}
+
+BigFloat tan(const BigFloat & x){
+    if (x.isZero()) return x;
+    int limbs = BigFloat::workingLimbs();
+    BigFloat reduced;
+    int quadrant;
+    BigFloat::reduceAngle(x, limbs + 1, reduced, quadrant);
+    BigFloat s = BigFloat::sinSeries(reduced, limbs + 1);
+    BigFloat c = BigFloat::cosSeries(reduced, limbs + 1);
+    // tan has period pi: odd quadrants give -cos/sin
+    BigFloat num = (quadrant % 2 == 0) ? s : c;
+    BigFloat den = (quadrant % 2 == 0) ? c : -s;
+    if (den.isZero()){
+        error("tan: argument is a pole");
+    }
+    return BigFloat::multiply(num, BigFloat::reciprocal(den, limbs + 1), limbs);
+}
+
+bool operator==(const BigFloat & a, const BigFloat & b){
+    return BigFloat::compare(a, b) == 0;
+}
+
+bool operator!=(const BigFloat & a, const BigFloat & b){
+    return BigFloat::compare(a, b) != 0;
+}
+
+bool operator<(const BigFloat & a, const BigFloat & b){
+    return BigFloat::compare(a, b) < 0;
+}
+
+bool operator<=(const BigFloat & a, const BigFloat & b){
+    return BigFloat::compare(a, b) <= 0;
+}
+
+bool operator>(const BigFloat & a, const BigFloat & b){
+    return BigFloat::compare(a, b) > 0;
+}
+
+bool operator>=(const BigFloat & a, const BigFloat & b){
+    return BigFloat::compare(a, b) >= 0;
+}
+
+ostream & operator<<(ostream & os, const BigFloat & x){
+    return os << x.toString();
+}
+
+/* Implementation of the private methods */
+
+int BigFloat::workingLimbs(){
+    return (precisionDigits + BigInt::BASE_DIGITS - 1) / BigInt::BASE_DIGITS + 2;
+}
+
+long long BigFloat::topExponent() const {
+    return exponent + mantissa.limbCount();
+}
+
+void BigFloat::round(int limbs){
+    if (mantissa.isZero()){
+        negative = false;
+        exponent = 0;
+        return;
+    }
+    int n = mantissa.limbCount();
+    if (n > limbs){
+        int drop = n - limbs;
+        bool up = mantissa.limb(drop - 1) >= BigInt::BASE / 2;
+        mantissa.shiftLimbs(-drop);
+        exponent += drop;
+        if (up) mantissa += BigInt(1);
+    }
+    int zeros = mantissa.countTrailingZeroLimbs();
+    if (zeros > 0){
+        mantissa.shiftLimbs(-zeros);
+        exponent += zeros;
+    }
+}
+
+double BigFloat::leadingDouble(long long & limbExponent) const {
+    int n = mantissa.limbCount();
+    if (n == 1){
+        limbExponent = exponent;
+        return mantissa.limb(0);
+    }
+    limbExponent = exponent + n - 2;
+    return (double) mantissa.limb(n - 1) * BigInt::BASE + mantissa.limb(n - 2);
+}
+
+BigFloat BigFloat::add(const BigFloat & a, const BigFloat & b, int limbs){
+    BigFloat res;
+    if (a.isZero() || b.isZero()){
+        res = a.isZero() ? b : a;
+        res.round(limbs);
+        return res;
+    }
+    long long topA = a.topExponent();
+    long long topB = b.topExponent();
+    if (topA - topB > limbs + 1 || topB - topA > limbs + 1){
+        // the smaller operand lies entirely below the kept precision
+        res = topA > topB ? a : b;
+        res.round(limbs);
+        return res;
+    }
+    long long low = min(a.exponent, b.exponent);
+    BigInt ma = a.mantissa;
+    BigInt mb = b.mantissa;
+    ma.shiftLimbs(a.exponent - low);
+    mb.shiftLimbs(b.exponent - low);
+    if (a.negative) ma.negate();
+    if (b.negative) mb.negate();
+    BigInt sum = ma + mb;
+    res.negative = sum.isNegative();
+    res.mantissa = sum.abs();
+    res.exponent = low;
+    res.round(limbs);
+    return res;
+}
+
+BigFloat BigFloat::multiply(const BigFloat & a, const BigFloat & b, int limbs){
+    BigFloat res;
+    if (a.isZero() || b.isZero()) return res;
+    if (a.mantissa.limbCount() > limbs + 1 || b.mantissa.limbCount() > limbs + 1){
+        BigFloat ra = a, rb = b;
+        ra.round(limbs + 1);
+        rb.round(limbs + 1);
+        return multiply(ra, rb, limbs);
+    }
+    res.negative = a.negative != b.negative;
+    res.mantissa = a.mantissa * b.mantissa;
+    res.exponent = a.exponent + b.exponent;
+    res.round(limbs);
+    return res;
+}
+
+BigFloat BigFloat::multiplySmall(const BigFloat & a, unsigned int factor, int limbs){
+    BigFloat res = a;
+    res.mantissa.multiplySmall(factor);
+    res.round(limbs);
+    return res;
+}
+
+/* Divides by n * m, in one step when the product fits in a limb */
+BigFloat BigFloat::divideSmall(const BigFloat & a, unsigned long long n, unsigned long long m, int limbs){
+    if (n * m < BigInt::BASE){
+        return divideSmall(a, n * m, limbs);
+    }
+    return divideSmall(divideSmall(a, n, limbs), m, limbs);
+}
+
+BigFloat BigFloat::divideSmall(const BigFloat & a, unsigned int divisor, int limbs){
+    BigFloat res = a;
+    int extend = limbs + 1 - res.mantissa.limbCount();
+    if (extend > 0){
+        res.mantissa.shiftLimbs(extend);
+        res.exponent -= extend;
+    }
+    res.mantissa.divideSmall(divisor);
+    res.round(limbs);
+    return res;
+}
+
+BigFloat BigFloat::approximate(double value, long long limbExponent){
+    BigFloat res;
+    if (value == 0) return res;
+    res.negative = value < 0;
+    value = fabs(value);
+    while (value >= 1e18){
+        value /= BigInt::BASE;
+        limbExponent++;
+    }
+    while (value < 1e9){
+        value *= BigInt::BASE;
+        limbExponent--;
+    }
+    res.mantissa = BigInt((long long) (value + 0.5));
+    res.exponent = limbExponent;
+    res.round(2);
+    return res;
+}
+
+/*
+ * Newton iteration y <- y + y * (1 - x * y) doubles the number of
+ * correct limbs per step, so the working precision is doubled too and
+ * only the last step runs at full precision.
+ */
+BigFloat BigFloat::reciprocal(const BigFloat & x, int limbs){
+    long long limbExponent;
+    double lead = x.leadingDouble(limbExponent);
+    BigFloat y = approximate(1.0 / lead, -limbExponent);
+    y.negative = x.negative;
+    BigFloat one(1);
+    int correct = 1;
+    while (correct < limbs + 1){
+        correct = min(2 * correct, limbs + 1);
+        int prec = correct + 2;
+        EvaluationBudget::poll(prec);
+        BigFloat err = add(one, -multiply(x, y, prec), prec);
+        y = add(y, multiply(y, err, prec), prec);
+    }
+    y.round(limbs);
+    return y;
+}
+
+/* Newton iteration y <- y + y * (1 - x * y^2) / 2 for 1 / sqrt(x) */
+BigFloat BigFloat::inverseSqrt(const BigFloat & x, int limbs){
+    long long limbExponent;
+    double lead = x.leadingDouble(limbExponent);
+    if (limbExponent % 2 != 0){
+        lead *= BigInt::BASE;
+        limbExponent--;
+    }
+    BigFloat y = approximate(1.0 / std::sqrt(lead), -limbExponent / 2);
+    BigFloat one(1);
+    int correct = 1;
+    while (correct < limbs + 1){
+        correct = min(2 * correct, limbs + 1);
+        int prec = correct + 2;
+        EvaluationBudget::poll(prec);
+        BigFloat err = add(one, -multiply(x, multiply(y, y, prec), prec), prec);
+        y = add(y, divideSmall(multiply(y, err, prec), 2, prec), prec);
+    }
+    y.round(limbs);
+    return y;
+}
+
+/*
+ * exp(x) = exp(x / 2^s)^(2^s): the series converges quickly for the
+ * reduced argument, and each squaring loses about one bit, which the
+ * extra guard limbs absorb.
+ */
+BigFloat BigFloat::exponential(const BigFloat & x, int limbs){
+    if (x.isZero()) return BigFloat(1);
+    double magnitude = fabs(x.toDouble());
+    if (magnitude > 1e15){
+        error("exp: argument too large");
+    }
+    int squarings = (int) std::sqrt(limbs * 30.0) / 2;
+    if (magnitude > 1) squarings += ilogb(magnitude) + 1;
+    int prec = limbs + 1 + squarings / 30;
+    BigFloat reduced = x;
+    reduced.round(prec);
+    for (int done = 0; done < squarings; ){
+        int step = min(squarings - done, 29);
+        reduced = divideSmall(reduced, 1u << step, prec);
+        done += step;
+    }
+    BigFloat res = expSeries(reduced, prec);
+    for (int i = 0; i < squarings; i++){
+        EvaluationBudget::poll(prec);
+        res = multiply(res, res, prec);
+    }
+    res.round(limbs);
+    return res;
+}
+
+/* Halley iteration y <- y + 2 * (x - e^y) / (x + e^y) for ln(x) */
+BigFloat BigFloat::logarithm(const BigFloat & x, int limbs){
+    if (x.isNegative() || x.isZero()){
+        error("log: argument must be positive");
+    }
+    long long limbExponent;
+    double lead = x.leadingDouble(limbExponent);
+    double guess = std::log(lead) + limbExponent * std::log((double) BigInt::BASE);
+    BigFloat y = approximate(guess, 0);
+    int prec = limbs + 1;
+    for (int iteration = 0; iteration < 64; iteration++){
+        EvaluationBudget::poll(prec);
+        BigFloat ey = exponential(y, prec);
+        BigFloat num = multiplySmall(add(x, -ey, prec), 2, prec);
+        BigFloat delta = multiply(num, reciprocal(add(x, ey, prec), prec), prec);
+        y = add(y, delta, prec);
+        if (delta.isZero() || delta.topExponent() < y.topExponent() - limbs){
+            break;
+        }
+    }
+    y.round(limbs);
+    return y;
+}
+
+BigFloat BigFloat::expSeries(const BigFloat & x, int limbs){
+    BigFloat sum(1);
+    BigFloat term(1);
+    for (unsigned int n = 1; ; n++){
+        EvaluationBudget::poll(limbs);
+        term = divideSmall(multiply(term, x, limbs), n, limbs);
+        if (term.isZero() || term.topExponent() < sum.topExponent() - limbs - 1) break;
+        sum = add(sum, term, limbs);
+    }
+    return sum;
+}
+
+BigFloat BigFloat::sinSeries(const BigFloat & x, int limbs){
+    BigFloat square = multiply(x, x, limbs);
+    BigFloat sum = x;
+    BigFloat term = x;
+    for (unsigned long long n = 2; !term.isZero(); n += 2){
+        EvaluationBudget::poll(limbs);
+        term = -divideSmall(multiply(term, square, limbs), n, n + 1, limbs);
+        if (term.isZero() || term.topExponent() < sum.topExponent() - limbs - 1) break;
+        sum = add(sum, term, limbs);
+    }
+    return sum;
+}
+
+BigFloat BigFloat::cosSeries(const BigFloat & x, int limbs){
+    BigFloat square = multiply(x, x, limbs);
+    BigFloat sum(1);
+    BigFloat term(1);
+    for (unsigned long long n = 1; !square.isZero(); n += 2){
+        EvaluationBudget::poll(limbs);
+        term = -divideSmall(multiply(term, square, limbs), n, n + 1, limbs);
+        if (term.isZero() || term.topExponent() < sum.topExponent() - limbs - 1) break;
+        sum = add(sum, term, limbs);
+    }
+    return sum;
+}
+
+/* atan(1/k) = sum (-1)^n / ((2n + 1) k^(2n + 1)) */
+BigFloat BigFloat::atanInverse(unsigned int k, int limbs){
+    BigFloat power = divideSmall(BigFloat(1), k, limbs);
+    BigFloat sum = power;
+    for (unsigned int n = 1; ; n++){
+        EvaluationBudget::poll(limbs);
+        power = divideSmall(power, k * k, limbs);
+        BigFloat term = divideSmall(power, 2 * n + 1, limbs);
+        if (term.isZero() || term.topExponent() < sum.topExponent() - limbs - 1) break;
+        sum = add(sum, (n % 2 == 1) ? -term : term, limbs);
+    }
+    return sum;
+}
+
+/* Machin's formula pi = 16 atan(1/5) - 4 atan(1/239), cached by precision */
+BigFloat BigFloat::piWithPrecision(int limbs){
+    static BigFloat cached;
+    static int cachedLimbs = 0;
+    if (cachedLimbs < limbs){
+        int prec = limbs + 1;
+        BigFloat a = multiplySmall(atanInverse(5, prec), 16, prec);
+        BigFloat b = multiplySmall(atanInverse(239, prec), 4, prec);
+        cached = add(a, -b, prec);
+        cachedLimbs = limbs;
+    }
+    BigFloat res = cached;
+    res.round(limbs);
+    return res;
+}
+
+/*
+ * Writes x = k * pi/2 + reduced with |reduced| <= pi/4 and quadrant = k mod 4.
+ * Pi is taken with as many extra limbs as x has above the point, so the
+ * reduction does not lose precision for large arguments.
+ */
+void BigFloat::reduceAngle(const BigFloat & x, int limbs, BigFloat & reduced, int & quadrant){
+    long long top = x.topExponent();
+    if (top > MAX_ANGLE_LIMBS){
+        error("Trigonometric argument too large");
+    }
+    int prec = limbs + 1 + (int) max(0LL, top);
+    BigFloat halfPi = divideSmall(piWithPrecision(prec), 2, prec);
+    BigInt k = multiply(x, reciprocal(halfPi, prec), prec).toInteger();
+    reduced = add(x, -multiply(BigFloat(k), halfPi, prec), prec);
+    reduced.round(limbs);
+    long long q = (k % BigInt(4)).toLongLong();
+    quadrant = (int) ((q + 4) % 4);
+}
@@ -0,0 +1,198 @@
+/* File: bigfloat.h
+ * -----------------------------------
+ *
+ * This file exports an arbitrary-precision decimal floating-point
+ * number used by the big number calculation mode.
+ */
+
+#ifndef BIGFLOAT_H
+#define BIGFLOAT_H
+
+#include <iostream>
+#include <string>
+#include "bigint.h"
+
+/* Class BigFloat
+ * --------------------------------
+ * This class implements a decimal floating-point number whose value is
+ * mantissa * 10^(9 * exponent). Every result is rounded to the precision
+ * selected with setPrecision (in significant decimal digits). Division and
+ * square root use Newton iteration with doubling working precision, so
+ * they cost a small multiple of one full-precision multiplication.
+ */
+class BigFloat {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: BigFloat
+     * Usage: BigFloat zero;
+     *        BigFloat x(42);
+     *        BigFloat x("-0.125");
+     * -----------------------------------------------------
+     * Initializes a new number from an integer or a decimal string
+     */
+    BigFloat();
+    BigFloat(long long value);
+    explicit BigFloat(const BigInt & value);
+    explicit BigFloat(const std::string & str);
+
+    /* Largest precision setPrecision accepts, in decimal digits */
+    static const int MAX_PRECISION = 1000000;
+
+    /* Method: setPrecision / getPrecision
+     * Usage: BigFloat::setPrecision(60);
+     * -----------------------------------------------------
+     * Sets or returns the number of significant decimal digits
+     * kept by all operations (50 by default); setPrecision signals an
+     * error for a precision below 1 or above MAX_PRECISION
+     */
+    static void setPrecision(int digits);
+    static int getPrecision();
+
+    /* Method: isZero / isNegative / isInteger
+     * Usage: if (x.isInteger())...
+     * -----------------------------------------------------
+     * Simple predicates on the value
+     */
+    bool isZero() const;
+    bool isNegative() const;
+    bool isInteger() const;
+
+    /* Method: toDouble
+     * Usage: double value = x.toDouble();
+     * -----------------------------------------------------
+     * Returns the nearest double
+     */
+    double toDouble() const;
+
+    /* Method: toInteger
+     * Usage: BigInt n = x.toInteger();
+     * -----------------------------------------------------
+     * Returns the value rounded to the nearest integer
+     * (halves are rounded away from zero)
+     */
+    BigInt toInteger() const;
+
+    /* Method: getMantissa / getExponent
+     * Usage: BigInt m = x.getMantissa();
+     * -----------------------------------------------------
+     * Return the exact representation of the value, which
+     * equals getMantissa() * 10^(9 * getExponent())
+     */
+    BigInt getMantissa() const;
+    long long getExponent() const;
+
+    /* Method: toString
+     * Usage: string str = x.toString();
+     * -----------------------------------------------------
+     * Returns the value rounded to the current precision, in plain
+     * notation or, for very large or small values, as d.ddde+N
+     */
+    std::string toString() const;
+
+    /* Method: compare
+     * Usage: int cmp = BigFloat::compare(a, b);
+     * -----------------------------------------------------
+     * Returns a negative number, zero or a positive number
+     * as a is less than, equal to or greater than b
+     */
+    static int compare(const BigFloat & a, const BigFloat & b);
+
+    /* Method: pi
+     * Usage: BigFloat p = BigFloat::pi();
+     * -----------------------------------------------------
+     * Returns pi at the current precision (cached between calls)
+     */
+    static BigFloat pi();
+
+    BigFloat operator-() const;
+    friend BigFloat operator+(const BigFloat & a, const BigFloat & b);
+    friend BigFloat operator-(const BigFloat & a, const BigFloat & b);
+    friend BigFloat operator*(const BigFloat & a, const BigFloat & b);
+    friend BigFloat operator/(const BigFloat & a, const BigFloat & b);
+
+    friend BigFloat sqrt(const BigFloat & x);
+    friend BigFloat pow(const BigFloat & base, const BigFloat & exponent);
+    friend BigFloat exp(const BigFloat & x);
+    friend BigFloat log(const BigFloat & x);
+    friend BigFloat sin(const BigFloat & x);
+    friend BigFloat cos(const BigFloat & x);
+    friend BigFloat tan(const BigFloat & x);
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Number of significant decimal digits of every result */
+    static int precisionDigits;
+
+    /* Sign of the number; zero is never negative */
+    bool negative;
+
+    /* Magnitude of the mantissa, without trailing zero limbs */
+    BigInt mantissa;
+
+    /* Power of 10^9 the mantissa is scaled by */
+    long long exponent;
+
+    /* Method: workingLimbs
+     * Usage: int limbs = workingLimbs();
+     * ------------------------------------------------
+     * Returns the mantissa size (in limbs) that holds the current
+     * precision plus guard digits
+     */
+    static int workingLimbs();
+
+    /* Method: topExponent
+     * Usage: long long top = x.topExponent();
+     * ------------------------------------------------
+     * Returns the exponent just above the most significant limb,
+     * so |x| lies in [10^(9 * (top - 1)), 10^(9 * top))
+     */
+    long long topExponent() const;
+
+    /* Method: round
+     * Usage: x.round(limbs);
+     * ------------------------------------------------
+     * Rounds the mantissa to the given number of limbs and strips
+     * trailing zero limbs
+     */
+    void round(int limbs);
+
+    /* Method: leadingDouble
+     * Usage: double d = x.leadingDouble(limbExponent);
+     * ------------------------------------------------
+     * Returns the top two limbs as a double d, with |x| ~ d * 10^(9 * limbExponent);
+     * used to seed the Newton iterations
+     */
+    double leadingDouble(long long & limbExponent) const;
+
+    /* Precision-explicit arithmetic used by the Newton iterations
+     * and the series expansions; 'limbs' is the mantissa size to keep */
+    static BigFloat add(const BigFloat & a, const BigFloat & b, int limbs);
+    static BigFloat multiply(const BigFloat & a, const BigFloat & b, int limbs);
+    static BigFloat multiplySmall(const BigFloat & a, unsigned int factor, int limbs);
+    static BigFloat divideSmall(const BigFloat & a, unsigned int divisor, int limbs);
+    static BigFloat divideSmall(const BigFloat & a, unsigned long long n, unsigned long long m, int limbs);
+    static BigFloat reciprocal(const BigFloat & x, int limbs);
+    static BigFloat inverseSqrt(const BigFloat & x, int limbs);
+    static BigFloat exponential(const BigFloat & x, int limbs);
+    static BigFloat logarithm(const BigFloat & x, int limbs);
+    static BigFloat expSeries(const BigFloat & x, int limbs);
+    static BigFloat sinSeries(const BigFloat & x, int limbs);
+    static BigFloat cosSeries(const BigFloat & x, int limbs);
+    static BigFloat atanInverse(unsigned int k, int limbs);
+    static BigFloat piWithPrecision(int limbs);
+    static BigFloat approximate(double value, long long limbExponent);
+    static void reduceAngle(const BigFloat & x, int limbs, BigFloat & reduced, int & quadrant);
+};
+
+bool operator==(const BigFloat & a, const BigFloat & b);
+bool operator!=(const BigFloat & a, const BigFloat & b);
+bool operator<(const BigFloat & a, const BigFloat & b);
+bool operator<=(const BigFloat & a, const BigFloat & b);
+bool operator>(const BigFloat & a, const BigFloat & b);
+bool operator>=(const BigFloat & a, const BigFloat & b);
+std::ostream & operator<<(std::ostream & os, const BigFloat & x);
+
+#endif // BIGFLOAT_H
@@ -0,0 +1,622 @@
+/* File: bigint.cpp
+ * -----------------------------------
+ *
+ * Implementation of the BigInt class.
+ */
+
+#include "bigint.h"
+#include <cmath>
+#include "budget.h"
+#include "error.h"
+
+using namespace std;
+
+typedef vector<unsigned int> Limbs;
+typedef unsigned long long ull;
+
+/* Operand sizes (in limbs) at which the faster multiplication kicks in */
+static const int KARATSUBA_THRESHOLD = 32;
+static const int NTT_THRESHOLD = 1024;
+
+/* Primes for the number-theoretic transform; 3 is a primitive root of both */
+static const ull NTT_MOD_1 = 998244353;
+static const ull NTT_MOD_2 = 469762049;
+static const ull NTT_ROOT = 3;
+
+/* The NTT works on base 1000 digits, three per limb */
+static const unsigned int NTT_DIGIT_BASE = 1000;
+
+/* Longest transform: NTT_MOD_1 - 1 = 119 * 2^23 has roots of unity of
+ * order up to 2^23 only */
+static const int NTT_MAX_SIZE = 1 << 23;
+
+// magnitude helpers
+static int compareLimbs(const Limbs & a, const Limbs & b);
+static void trimLimbs(Limbs & a);
+static Limbs addLimbs(const Limbs & a, const Limbs & b);
+static Limbs subtractLimbs(const Limbs & a, const Limbs & b);
+static Limbs multiplyLimbs(const Limbs & a, const Limbs & b);
+static Limbs multiplySchoolbook(const Limbs & a, const Limbs & b);
+static Limbs multiplyKaratsuba(const Limbs & a, const Limbs & b);
+static Limbs multiplyNTT(const Limbs & a, const Limbs & b);
+static void divideLimbs(const Limbs & a, const Limbs & b, Limbs & quotient, Limbs & remainder);
+static void multiplySmallLimbs(Limbs & a, unsigned int factor);
+static unsigned int divideSmallLimbs(Limbs & a, unsigned int divisor);
+
+BigInt::BigInt(){
+    negative = false;
+}
+
+BigInt::BigInt(long long value){
+    negative = value < 0;
+    ull magnitude = negative ? (ull) 0 - (ull) value : (ull) value;
+    while (magnitude > 0){
+        limbs.push_back(magnitude % BASE);
+        magnitude /= BASE;
+    }
+}
+
+BigInt::BigInt(const string & str){
+    negative = false;
+    int start = 0;
+    if (!str.empty() && (str[0] == '-' || str[0] == '+')){
+        negative = str[0] == '-';
+        start = 1;
+    }
+    if (start == (int) str.length()){
+        error("BigInt: illegal integer format \"" + str + "\"");
+    }
+    for (int end = str.length(); end > start; end -= BASE_DIGITS){
+        int begin = max(start, end - BASE_DIGITS);
+        unsigned int limb = 0;
+        for (int i = begin; i < end; i++){
+            if (str[i] < '0' || str[i] > '9'){
+                error("BigInt: illegal integer format \"" + str + "\"");
+            }
+            limb = limb * 10 + (str[i] - '0');
+        }
+        limbs.push_back(limb);
+    }
+    trim();
+}
+
+bool BigInt::isZero() const {
+    return limbs.empty();
+}
+
+bool BigInt::isNegative() const {
+    return negative;
+}
+
+bool BigInt::isEven() const {
+    return limbs.empty() || limbs[0] % 2 == 0;
+}
+
+bool BigInt::fitsLongLong() const {
+    if (limbs.size() < 3) return true;
+    if (limbs.size() > 3 || limbs[2] > 9) return false;
+    ull magnitude = limbs[2] * 1000000000000000000ULL + (ull) limbs[1] * BASE + limbs[0];
+    return magnitude <= (negative ? 9223372036854775808ULL : 9223372036854775807ULL);
+}
+
+long long BigInt::toLongLong() const {
+    ull magnitude = 0;
+    for (int i = limbs.size() - 1; i >= 0; i--){
+        magnitude = magnitude * BASE + limbs[i];
+    }
+    return negative ? (long long) ((ull) 0 - magnitude) : (long long) magnitude;
+}
+
+double BigInt::toDouble() const {
+    if (limbs.empty()) return 0;
+    int top = limbs.size() - 1;
+    int low = max(0, top - 2);
+    double res = 0;
+    for (int i = top; i >= low; i--){
+        res = res * BASE + limbs[i];
+    }
+    res *= pow((double) BASE, low);
+    return negative ? -res : res;
+}
+
+string BigInt::toString() const {
+    if (limbs.empty()) return "0";
+    string res = negative ? "-" : "";
+    res += to_string(limbs.back());
+    for (int i = limbs.size() - 2; i >= 0; i--){
+        string digits = to_string(limbs[i]);
+        res += string(BASE_DIGITS - digits.length(), '0') + digits;
+    }
+    return res;
+}
+
+int BigInt::limbCount() const {
+    return limbs.size();
+}
+
+unsigned int BigInt::limb(int index) const {
+    return (index >= 0 && index < (int) limbs.size()) ? limbs[index] : 0;
+}
+
+void BigInt::shiftLimbs(int count){
+    if (limbs.empty() || count == 0) return;
+    if (count > 0){
+        limbs.insert(limbs.begin(), count, 0);
+    } else if (-count >= (int) limbs.size()){
+        limbs.clear();
+    } else {
+        limbs.erase(limbs.begin(), limbs.begin() - count);
+    }
+    trim();
+}
+
+int BigInt::countTrailingZeroLimbs() const {
+    int count = 0;
+    while (count < (int) limbs.size() && limbs[count] == 0){
+        count++;
+    }
+    return count;
+}
+
+void BigInt::multiplySmall(unsigned int factor){
+    multiplySmallLimbs(limbs, factor);
+    trim();
+}
+
+unsigned int BigInt::divideSmall(unsigned int divisor){
+    if (divisor == 0){
+        error("BigInt: division by zero");
+    }
+    unsigned int rem = divideSmallLimbs(limbs, divisor);
+    trim();
+    return rem;
+}
+
+void BigInt::negate(){
+    if (!limbs.empty()){
+        negative = !negative;
+    }
+}
+
+BigInt BigInt::abs() const {
+    BigInt res = *this;
+    res.negative = false;
+    return res;
+}
+
+void BigInt::trim(){
+    trimLimbs(limbs);
+    if (limbs.empty()){
+        negative = false;
+    }
+}
+
+void BigInt::divMod(const BigInt & a, const BigInt & b, BigInt & quotient, BigInt & remainder){
+    if (b.isZero()){
+        error("BigInt: division by zero");
+    }
+    Limbs q, r;
+    divideLimbs(a.limbs, b.limbs, q, r);
+    quotient.limbs = q;
+    quotient.negative = a.negative != b.negative;
+    quotient.trim();
+    remainder.limbs = r;
+    remainder.negative = a.negative;
+    remainder.trim();
+}
+
+int BigInt::compare(const BigInt & a, const BigInt & b){
+    if (a.negative != b.negative){
+        return a.negative ? -1 : 1;
+    }
+    int cmp = compareLimbs(a.limbs, b.limbs);
+    return a.negative ? -cmp : cmp;
+}
+
+BigInt BigInt::operator-() const {
+    BigInt res = *this;
+    res.negate();
+    return res;
+}
+
+BigInt & BigInt::operator+=(const BigInt & other){
+    if (negative == other.negative){
+        limbs = addLimbs(limbs, other.limbs);
+    } else if (compareLimbs(limbs, other.limbs) >= 0){
+        limbs = subtractLimbs(limbs, other.limbs);
+    } else {
+        limbs = subtractLimbs(other.limbs, limbs);
+        negative = other.negative;
+    }
+    trim();
+    return *this;
+}
+
+BigInt & BigInt::operator-=(const BigInt & other){
+    return *this += -other;
+}
+
+BigInt & BigInt::operator*=(const BigInt & other){
+    negative = negative != other.negative;
+    limbs = multiplyLimbs(limbs, other.limbs);
+    trim();
+    return *this;
+}
+
+BigInt operator+(const BigInt & a, const BigInt & b){
+    BigInt res = a;
+    return res += b;
+}
+
+BigInt operator-(const BigInt & a, const BigInt & b){
+    BigInt res = a;
+    return res -= b;
+}
+
+BigInt operator*(const BigInt & a, const BigInt & b){
+    BigInt res = a;
+    return res *= b;
+}
+
+BigInt operator/(const BigInt & a, const BigInt & b){
+    BigInt q, r;
+    BigInt::divMod(a, b, q, r);
+    return q;
+}
+
+BigInt operator%(const BigInt & a, const BigInt & b){
+    BigInt q, r;
+    BigInt::divMod(a, b, q, r);
+    return r;
+}
+
+bool operator==(const BigInt & a, const BigInt & b){
+    return BigInt::compare(a, b) == 0;
+}
+
+bool operator!=(const BigInt & a, const BigInt & b){
+    return BigInt::compare(a, b) != 0;
+}
+
+bool operator<(const BigInt & a, const BigInt & b){
+    return BigInt::compare(a, b) < 0;
+}
+
+bool operator<=(const BigInt & a, const BigInt & b){
+    return BigInt::compare(a, b) <= 0;
+}
+
+bool operator>(const BigInt & a, const BigInt & b){
+    return BigInt::compare(a, b) > 0;
+}
+
+bool operator>=(const BigInt & a, const BigInt & b){
+    return BigInt::compare(a, b) >= 0;
+}
+
+ostream & operator<<(ostream & os, const BigInt & n){
+    return os << n.toString();
+}
+
+/* Implementation of the magnitude helpers */
+
+static int compareLimbs(const Limbs & a, const Limbs & b){
+    if (a.size() != b.size()){
+        return a.size() < b.size() ? -1 : 1;
+    }
+    for (int i = a.size() - 1; i >= 0; i--){
+        if (a[i] != b[i]){
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static void trimLimbs(Limbs & a){
+    while (!a.empty() && a.back() == 0){
+        a.pop_back();
+    }
+}
+
+static void multiplySmallLimbs(Limbs & a, unsigned int factor){
+    ull carry = 0;
+    for (int i = 0; i < (int) a.size(); i++){
+        ull cur = (ull) a[i] * factor + carry;
+        a[i] = cur % BigInt::BASE;
+        carry = cur / BigInt::BASE;
+    }
+    while (carry > 0){
+        a.push_back(carry % BigInt::BASE);
+        carry /= BigInt::BASE;
+    }
+    trimLimbs(a);
+}
+
+static unsigned int divideSmallLimbs(Limbs & a, unsigned int divisor){
+    ull rem = 0;
+    for (int i = a.size() - 1; i >= 0; i--){
+        ull cur = a[i] + rem * BigInt::BASE;
+        a[i] = cur / divisor;
+        rem = cur % divisor;
+    }
+    trimLimbs(a);
+    return rem;
+}
+
+static Limbs addLimbs(const Limbs & a, const Limbs & b){
+    const Limbs & longer = a.size() >= b.size() ? a : b;
+    const Limbs & shorter = a.size() >= b.size() ? b : a;
+    Limbs res(longer.size() + 1);
+    unsigned int carry = 0;
+    for (int i = 0; i < (int) longer.size(); i++){
+        unsigned int cur = longer[i] + carry + (i < (int) shorter.size() ? shorter[i] : 0);
+        carry = cur >= BigInt::BASE;
+        res[i] = carry ? cur - BigInt::BASE : cur;
+    }
+    res[longer.size()] = carry;
+    trimLimbs(res);
+    return res;
+}
+
+/* Requires a >= b */
+static Limbs subtractLimbs(const Limbs & a, const Limbs & b){
+    Limbs res(a.size());
+    int borrow = 0;
+    for (int i = 0; i < (int) a.size(); i++){
+        long long cur = (long long) a[i] - borrow - (i < (int) b.size() ? b[i] : 0);
+        borrow = cur < 0;
+        res[i] = borrow ? cur + BigInt::BASE : cur;
+    }
+    trimLimbs(res);
+    return res;
+}
+
+static Limbs multiplyLimbs(const Limbs & a, const Limbs & b){
+    if (a.empty() || b.empty()) return Limbs();
+    int smaller = min(a.size(), b.size());
+    if (smaller < KARATSUBA_THRESHOLD){
+        return multiplySchoolbook(a, b);
+    } else if (smaller < NTT_THRESHOLD || 3 * (a.size() + b.size()) > (size_t) NTT_MAX_SIZE){
+        // products too long for one transform are split by Karatsuba
+        // until their parts fit
+        return multiplyKaratsuba(a, b);
+    }
+    return multiplyNTT(a, b);
+}
+
+static Limbs multiplySchoolbook(const Limbs & a, const Limbs & b){
+    Limbs res(a.size() + b.size());
+    for (int i = 0; i < (int) a.size(); i++){
+        EvaluationBudget::poll(b.size());
+        ull carry = 0;
+        for (int j = 0; j < (int) b.size() || carry > 0; j++){
+            ull cur = res[i + j] + carry + (j < (int) b.size() ? (ull) a[i] * b[j] : 0);
+            res[i + j] = cur % BigInt::BASE;
+            carry = cur / BigInt::BASE;
+        }
+    }
+    trimLimbs(res);
+    return res;
+}
+
+/* Adds src * BASE^offset to dst in place */
+static void addShifted(Limbs & dst, const Limbs & src, int offset){
+    if (dst.size() < src.size() + offset + 1){
+        dst.resize(src.size() + offset + 1, 0);
+    }
+    unsigned int carry = 0;
+    int i = 0;
+    for (; i < (int) src.size() || carry > 0; i++){
+        unsigned int cur = dst[i + offset] + carry + (i < (int) src.size() ? src[i] : 0);
+        carry = cur >= BigInt::BASE;
+        dst[i + offset] = carry ? cur - BigInt::BASE : cur;
+        if (i + offset + 1 == (int) dst.size() && carry > 0){
+            dst.push_back(0);
+        }
+    }
+}
+
+static Limbs multiplyKaratsuba(const Limbs & a, const Limbs & b){
+    int smaller = min(a.size(), b.size());
+    if (smaller < KARATSUBA_THRESHOLD){
+        return multiplySchoolbook(a, b);
+    }
+    int half = max(a.size(), b.size()) / 2;
+    if (smaller <= half){
+        // unbalanced: split only the longer operand
+        const Limbs & longer = a.size() > b.size() ? a : b;
+        const Limbs & shorter = a.size() > b.size() ? b : a;
+        Limbs low(longer.begin(), longer.begin() + half);
+        Limbs high(longer.begin() + half, longer.end());
+        trimLimbs(low);
+        Limbs res = multiplyLimbs(low, shorter);
+        addShifted(res, multiplyLimbs(high, shorter), half);
+        trimLimbs(res);
+        return res;
+    }
+    Limbs a0(a.begin(), a.begin() + half), a1(a.begin() + half, a.end());
+    Limbs b0(b.begin(), b.begin() + half), b1(b.begin() + half, b.end());
+    trimLimbs(a0);
+    trimLimbs(b0);
+    Limbs z0 = multiplyLimbs(a0, b0);
+    Limbs z2 = multiplyLimbs(a1, b1);
+    Limbs z1 = multiplyLimbs(addLimbs(a0, a1), addLimbs(b0, b1));
+    z1 = subtractLimbs(subtractLimbs(z1, z0), z2);
+    Limbs res = z0;
+    addShifted(res, z1, half);
+    addShifted(res, z2, 2 * half);
+    trimLimbs(res);
+    return res;
+}
+
+static ull powMod(ull base, ull exp, ull mod){
+    ull res = 1;
+    base %= mod;
+    while (exp > 0){
+        if (exp & 1) res = res * base % mod;
+        base = base * base % mod;
+        exp >>= 1;
+    }
+    return res;
+}
+
+static void transform(vector<ull> & values, bool invert, ull mod){
+    int n = values.size();
+    for (int i = 1, j = 0; i < n; i++){
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1){
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) swap(values[i], values[j]);
+    }
+    for (int len = 2; len <= n; len <<= 1){
+        EvaluationBudget::poll(n);
+        ull step = powMod(NTT_ROOT, (mod - 1) / len, mod);
+        if (invert) step = powMod(step, mod - 2, mod);
+        for (int i = 0; i < n; i += len){
+            ull w = 1;
+            for (int j = 0; j < len / 2; j++){
+                ull u = values[i + j];
+                ull v = values[i + j + len / 2] * w % mod;
+                values[i + j] = u + v < mod ? u + v : u + v - mod;
+                values[i + j + len / 2] = u >= v ? u - v : u + mod - v;
+                w = w * step % mod;
+            }
+        }
+    }
+    if (invert){
+        ull inverseN = powMod(n, mod - 2, mod);
+        for (int i = 0; i < n; i++){
+            values[i] = values[i] * inverseN % mod;
+        }
+    }
+}
+
+/* Convolution of base 1000 digits modulo one NTT prime */
+static vector<ull> convolve(const vector<ull> & a, const vector<ull> & b, int size, ull mod){
+    vector<ull> fa(a), fb(b);
+    fa.resize(size, 0);
+    fb.resize(size, 0);
+    transform(fa, false, mod);
+    transform(fb, false, mod);
+    for (int i = 0; i < size; i++){
+        fa[i] = fa[i] * fb[i] % mod;
+    }
+    transform(fa, true, mod);
+    return fa;
+}
+
+static vector<ull> toDigits(const Limbs & a){
+    vector<ull> digits(a.size() * 3);
+    for (int i = 0; i < (int) a.size(); i++){
+        digits[3 * i] = a[i] % NTT_DIGIT_BASE;
+        digits[3 * i + 1] = a[i] / NTT_DIGIT_BASE % NTT_DIGIT_BASE;
+        digits[3 * i + 2] = a[i] / (NTT_DIGIT_BASE * NTT_DIGIT_BASE);
+    }
+    return digits;
+}
+
+/*
+ * Each product coefficient is below 1000^2 * length, far less than
+ * NTT_MOD_1 * NTT_MOD_2, so it is recovered exactly by the Chinese
+ * remainder theorem from the two modular convolutions.
+ */
+static Limbs multiplyNTT(const Limbs & a, const Limbs & b){
+    vector<ull> da = toDigits(a), db = toDigits(b);
+    int size = 1;
+    while (size < (int) (da.size() + db.size())){
+        size <<= 1;
+    }
+    vector<ull> r1 = convolve(da, db, size, NTT_MOD_1);
+    vector<ull> r2 = convolve(da, db, size, NTT_MOD_2);
+    ull inverse = powMod(NTT_MOD_1 % NTT_MOD_2, NTT_MOD_2 - 2, NTT_MOD_2);
+
+    Limbs res((size + 2) / 3 + 2, 0);
+    ull carry = 0;
+    for (int i = 0; i < size || carry > 0; i++){
+        ull value = carry;
+        if (i < size){
+            ull diff = (r2[i] + NTT_MOD_2 - r1[i] % NTT_MOD_2) % NTT_MOD_2;
+            value += r1[i] + NTT_MOD_1 * (diff * inverse % NTT_MOD_2);
+        }
+        ull digit = value % NTT_DIGIT_BASE;
+        carry = value / NTT_DIGIT_BASE;
+        if (i / 3 >= (int) res.size()) res.push_back(0);
+        static const unsigned int SCALE[3] = {1, NTT_DIGIT_BASE, NTT_DIGIT_BASE * NTT_DIGIT_BASE};
+        res[i / 3] += digit * SCALE[i % 3];
+    }
+    trimLimbs(res);
+    return res;
+}
+
+/*
+ * Long division in base 10^9 (Knuth, algorithm D). Both operands are
+ * scaled so the divisor's top limb is at least BASE / 2, which keeps each
+ * estimated quotient limb at most two above the true one.
+ */
+static void divideLimbs(const Limbs & a, const Limbs & b, Limbs & quotient, Limbs & remainder){
+    if (compareLimbs(a, b) < 0){
+        quotient.clear();
+        remainder = a;
+        return;
+    }
+    if (b.size() == 1){
+        quotient = a;
+        unsigned int rem = divideSmallLimbs(quotient, b[0]);
+        remainder.clear();
+        if (rem > 0) remainder.push_back(rem);
+        return;
+    }
+    unsigned int scale = BigInt::BASE / (b.back() + 1);
+    Limbs r = a;
+    Limbs d = b;
+    multiplySmallLimbs(r, scale);
+    multiplySmallLimbs(d, scale);
+    int m = d.size();
+    int n = r.size() - m;
+    r.push_back(0);
+    quotient.assign(n + 1, 0);
+    for (int j = n; j >= 0; j--){
+        EvaluationBudget::poll(m);
+        ull num = (ull) r[j + m] * BigInt::BASE + r[j + m - 1];
+        ull qhat = num / d[m - 1];
+        ull rhat = num % d[m - 1];
+        if (qhat >= BigInt::BASE){
+            qhat = BigInt::BASE - 1;
+            rhat = num - qhat * d[m - 1];
+        }
+        while (rhat < BigInt::BASE && qhat * d[m - 2] > rhat * BigInt::BASE + r[j + m - 2]){
+            qhat--;
+            rhat += d[m - 1];
+        }
+        ull carry = 0;
+        long long borrow = 0;
+        for (int i = 0; i < m; i++){
+            ull product = qhat * d[i] + carry;
+            carry = product / BigInt::BASE;
+            long long cur = (long long) r[i + j] - (long long) (product % BigInt::BASE) - borrow;
+            borrow = cur < 0;
+            r[i + j] = borrow ? cur + BigInt::BASE : cur;
+        }
+        long long top = (long long) r[j + m] - (long long) carry - borrow;
+        if (top < 0){
+            // estimate was one too large: add the divisor back
+            qhat--;
+            unsigned int addCarry = 0;
+            for (int i = 0; i < m; i++){
+                unsigned int cur = r[i + j] + d[i] + addCarry;
+                addCarry = cur >= BigInt::BASE;
+                r[i + j] = addCarry ? cur - BigInt::BASE : cur;
+            }
+            top += addCarry;
+        }
+        r[j + m] = top;
+        quotient[j] = qhat;
+    }
+    trimLimbs(quotient);
+    r.resize(m);
+    trimLimbs(r);
+    divideSmallLimbs(r, scale);
+    remainder = r;
+}
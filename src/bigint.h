@@ -0,0 +1,198 @@
+/* File: bigint.h
+ * -----------------------------------
+ *
+ * This file exports an arbitrary-precision signed integer
+ * used by the big number and rational calculation modes.
+ */
+
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+/* Class BigInt
+ * --------------------------------
+ * This class implements a signed integer of unlimited size.
+ * The magnitude is stored as little-endian limbs in base 10^9,
+ * so conversion to and from decimal strings is linear.
+ * Multiplication switches from the schoolbook method to Karatsuba
+ * and then to a number-theoretic transform as the operands grow.
+ */
+class BigInt {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Base of one limb and number of decimal digits in it */
+    static const unsigned int BASE = 1000000000;
+    static const int BASE_DIGITS = 9;
+
+    /* Constructor: BigInt
+     * Usage: BigInt zero;
+     *        BigInt n(42);
+     *        BigInt n("-12345678901234567890");
+     * -----------------------------------------------------
+     * Initializes a new integer from a machine integer or from a
+     * string of decimal digits with an optional leading sign.
+     */
+    BigInt();
+    BigInt(long long value);
+    explicit BigInt(const std::string & str);
+
+    /* Method: isZero
+     * Usage: if (n.isZero())...
+     * -----------------------------------------------------
+     * Returns true if this integer is zero
+     */
+    bool isZero() const;
+
+    /* Method: isNegative
+     * Usage: if (n.isNegative())...
+     * -----------------------------------------------------
+     * Returns true if this integer is less than zero
+     */
+    bool isNegative() const;
+
+    /* Method: isEven
+     * Usage: if (n.isEven())...
+     * -----------------------------------------------------
+     * Returns true if this integer is divisible by two
+     */
+    bool isEven() const;
+
+    /* Method: fitsLongLong
+     * Usage: if (n.fitsLongLong()) value = n.toLongLong();
+     * -----------------------------------------------------
+     * Returns true if this integer can be represented as a long long
+     */
+    bool fitsLongLong() const;
+
+    /* Method: toLongLong
+     * Usage: long long value = n.toLongLong();
+     * -----------------------------------------------------
+     * Returns the value as a long long; requires fitsLongLong()
+     */
+    long long toLongLong() const;
+
+    /* Method: toDouble
+     * Usage: double value = n.toDouble();
+     * -----------------------------------------------------
+     * Returns the nearest double (infinity if out of range)
+     */
+    double toDouble() const;
+
+    /* Method: toString
+     * Usage: string str = n.toString();
+     * -----------------------------------------------------
+     * Returns the decimal representation of this integer
+     */
+    std::string toString() const;
+
+    /* Method: limbCount
+     * Usage: int n = value.limbCount();
+     * -----------------------------------------------------
+     * Returns the number of base 10^9 limbs of the magnitude
+     * (zero has no limbs)
+     */
+    int limbCount() const;
+
+    /* Method: limb
+     * Usage: unsigned int digit = value.limb(index);
+     * -----------------------------------------------------
+     * Returns the limb at the index (0 is least significant),
+     * or 0 if the index is past the most significant limb
+     */
+    unsigned int limb(int index) const;
+
+    /* Method: shiftLimbs
+     * Usage: n.shiftLimbs(count);
+     * -----------------------------------------------------
+     * Multiplies the magnitude by BASE^count when count is positive,
+     * or drops the -count lowest limbs (truncating) when negative
+     */
+    void shiftLimbs(int count);
+
+    /* Method: countTrailingZeroLimbs
+     * Usage: int zeros = n.countTrailingZeroLimbs();
+     * -----------------------------------------------------
+     * Returns the number of low limbs that are zero
+     */
+    int countTrailingZeroLimbs() const;
+
+    /* Method: multiplySmall / divideSmall
+     * Usage: n.multiplySmall(10);
+     *        unsigned int rem = n.divideSmall(7);
+     * -----------------------------------------------------
+     * Multiplies or divides the magnitude in place by a value below BASE;
+     * divideSmall returns the remainder of the magnitude
+     */
+    void multiplySmall(unsigned int factor);
+    unsigned int divideSmall(unsigned int divisor);
+
+    /* Method: negate / abs
+     * Usage: BigInt m = n.abs();
+     * -----------------------------------------------------
+     * Flips the sign in place, or returns the absolute value
+     */
+    void negate();
+    BigInt abs() const;
+
+    /* Method: divMod
+     * Usage: BigInt::divMod(a, b, quotient, remainder);
+     * -----------------------------------------------------
+     * Divides a by b truncating toward zero; the remainder
+     * has the sign of a. Signals an error if b is zero.
+     */
+    static void divMod(const BigInt & a, const BigInt & b,
+                       BigInt & quotient, BigInt & remainder);
+
+    /* Method: compare
+     * Usage: int cmp = BigInt::compare(a, b);
+     * -----------------------------------------------------
+     * Returns a negative number, zero or a positive number
+     * as a is less than, equal to or greater than b
+     */
+    static int compare(const BigInt & a, const BigInt & b);
+
+    /* Operators: + - * / % and comparisons */
+    BigInt operator-() const;
+    BigInt & operator+=(const BigInt & other);
+    BigInt & operator-=(const BigInt & other);
+    BigInt & operator*=(const BigInt & other);
+
+    friend BigInt operator+(const BigInt & a, const BigInt & b);
+    friend BigInt operator-(const BigInt & a, const BigInt & b);
+    friend BigInt operator*(const BigInt & a, const BigInt & b);
+    friend BigInt operator/(const BigInt & a, const BigInt & b);
+    friend BigInt operator%(const BigInt & a, const BigInt & b);
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Sign of the number; zero is never negative */
+    bool negative;
+
+    /* Little-endian limbs of the magnitude, without leading zero limbs */
+    std::vector<unsigned int> limbs;
+
+    /* Method: trim
+     * Usage: trim();
+     * ------------------------------------------------
+     * Removes leading zero limbs and clears the sign of zero
+     */
+    void trim();
+
+    friend class BigFloat;
+};
+
+bool operator==(const BigInt & a, const BigInt & b);
+bool operator!=(const BigInt & a, const BigInt & b);
+bool operator<(const BigInt & a, const BigInt & b);
+bool operator<=(const BigInt & a, const BigInt & b);
+bool operator>(const BigInt & a, const BigInt & b);
+bool operator>=(const BigInt & a, const BigInt & b);
+std::ostream & operator<<(std::ostream & os, const BigInt & n);
+
+#endif // BIGINT_H
@@ -0,0 +1,80 @@
+/* File: budget.cpp
+ * -----------------------------------
+ *
+ * Implementation of the EvaluationBudget class.
+ */
+
+#include "budget.h"
+#include <algorithm>
+#include <sstream>
+#include "error.h"
+
+using namespace std;
+
+thread_local long long EvaluationBudget::countdown = 0;
+thread_local long long EvaluationBudget::pollCountdown = 0;
+thread_local int EvaluationBudget::threadGeneration = 0;
+
+EvaluationLimits EvaluationBudget::current = { 0, 0, 0, 0 };
+atomic<bool> EvaluationBudget::active(false);
+atomic<long long> EvaluationBudget::remaining(0);
+atomic<int> EvaluationBudget::generation(0);
+chrono::steady_clock::time_point EvaluationBudget::deadline;
+
+EvaluationBudget::EvaluationBudget(){
+    remaining.store(current.steps, memory_order_relaxed);
+    deadline = chrono::steady_clock::now()
+            + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(current.seconds));
+    // the deadline is written before the workers can see the budget
+    generation.fetch_add(1, memory_order_relaxed);
+    active.store(current.steps > 0 || current.seconds > 0, memory_order_release);
+}
+
+EvaluationBudget::~EvaluationBudget(){
+    active.store(false, memory_order_release);
+}
+
+void EvaluationBudget::setLimits(const EvaluationLimits & limits){
+    current = limits;
+}
+
+const EvaluationLimits & EvaluationBudget::limits(){
+    return current;
+}
+
+void EvaluationBudget::refill(long long steps){
+    // steps charged beyond the slice are paid from the next one; a
+    // slice of an earlier budget is dropped, and the steps just charged
+    // are owed in full
+    long long owed = -countdown;
+    int latest = generation.load(memory_order_relaxed);
+    if (threadGeneration != latest){
+        threadGeneration = latest;
+        owed = steps;
+    }
+    countdown = 0;
+    if (!active.load(memory_order_acquire)){
+        countdown = STEP_SLICE;
+        return;
+    }
+    checkDeadline();
+    if (current.steps > 0){
+        long long left = remaining.fetch_sub(owed + STEP_SLICE, memory_order_relaxed);
+        if (left < owed){
+            ostringstream message;
+            message << "Evaluation exceeded the limit of " << current.steps << " steps";
+            error(message.str());
+        }
+        countdown = min(left - owed, STEP_SLICE);
+        return;
+    }
+    countdown = STEP_SLICE;
+}
+
+void EvaluationBudget::checkDeadline(){
+    if (active.load(memory_order_acquire) && current.seconds > 0 && chrono::steady_clock::now() > deadline){
+        ostringstream message;
+        message << "Evaluation exceeded the time limit of " << current.seconds << " s";
+        error(message.str());
+    }
+}
@@ -0,0 +1,134 @@
+/* File: budget.h
+ * -----------------------------------
+ *
+ * This file exports the limits on the work done for one line of input,
+ * so a pathological equation from an untrusted source ends with an
+ * error instead of stalling the calculator.
+ */
+
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <atomic>
+#include <chrono>
+
+/* Limits of the work for one line of input; 0 means no limit */
+struct EvaluationLimits {
+    long long steps;   // instructions run, counted for every row and call
+    double seconds;    // wall-clock time
+    int tokens;        // tokens in the polish record of an equation
+    int nesting;       // brackets, functions and operators open at once in the parser
+};
+
+/* Class EvaluationBudget
+ * --------------------------------
+ * An object of this class is the budget of the evaluations made while
+ * it exists, with the limits in effect when it was made. Evaluators
+ * charge the instructions they run with charge, which only decrements
+ * a per-thread counter: each thread takes steps from the shared budget
+ * in slices of STEP_SLICE, and only when its slice is used up does it
+ * take the next one and look at the clock. The step limit is thus
+ * exact to a slice per thread, and the deadline is noticed within a
+ * slice. One instruction on big numbers can take far longer than a
+ * slice, so their arithmetic also counts its work with poll, which
+ * looks at the clock every POLL_SLICE units of it. The threads of the
+ * pool charge the same budget, and the error of one of them reaches the
+ * caller through ThreadPool::wait. One budget exists at a time; each
+ * one has a new generation number, and a thread that sees a new number
+ * drops the slice it kept from the last budget.
+ */
+class EvaluationBudget {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: EvaluationBudget
+     * Usage: EvaluationBudget budget;
+     * -----------------------------------------------------
+     * Starts a budget of the current limits, which ends with the object
+     */
+    EvaluationBudget();
+    ~EvaluationBudget();
+
+    /* Method: setLimits / limits
+     * Usage: EvaluationBudget::setLimits(limits);
+     * -----------------------------------------------------
+     * Set or give the limits of the budgets started from now on
+     */
+    static void setLimits(const EvaluationLimits & limits);
+    static const EvaluationLimits & limits();
+
+    /* Method: charge
+     * Usage: EvaluationBudget::charge(code.size());
+     * -----------------------------------------------------
+     * Counts steps of an evaluation. Signals an error when the budget
+     * has no steps or time left.
+     */
+    static void charge(long long steps);
+
+    /* Method: poll
+     * Usage: EvaluationBudget::poll(limbs);
+     * -----------------------------------------------------
+     * Counts work inside one instruction, such as the limbs of a step
+     * of big number arithmetic; it costs no steps. Signals an error when
+     * the budget has no time left.
+     */
+    static void poll(long long work);
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Steps a thread takes from the budget at a time */
+    static const long long STEP_SLICE = 16384;
+
+    /* Work a thread does between two looks at the clock in poll */
+    static const long long POLL_SLICE = 1 << 16;
+
+    /* Steps left in the slice of the thread, and its work until poll
+     * looks at the clock */
+    static thread_local long long countdown;
+    static thread_local long long pollCountdown;
+
+    /* Generation of the current budget, and of the slice of the thread */
+    static std::atomic<int> generation;
+    static thread_local int threadGeneration;
+
+    static EvaluationLimits current;
+    static std::atomic<bool> active;
+    static std::atomic<long long> remaining;
+    static std::chrono::steady_clock::time_point deadline;
+
+    /* Method: refill
+     * Usage: refill(steps);
+     * ------------------------------------------------
+     * Takes the next slice of the thread, after checking the clock and
+     * the steps left; steps were just charged
+     */
+    static void refill(long long steps);
+
+    /* Method: checkDeadline
+     * Usage: checkDeadline();
+     * ------------------------------------------------
+     * Signals an error if the time of the budget is over
+     */
+    static void checkDeadline();
+
+    /* A budget is not copied */
+    EvaluationBudget(const EvaluationBudget &);
+    EvaluationBudget & operator =(const EvaluationBudget &);
+};
+
+inline void EvaluationBudget::charge(long long steps){
+    countdown -= steps;
+    if (countdown < 0 || threadGeneration != generation.load(std::memory_order_relaxed)) refill(steps);
+}
+
+inline void EvaluationBudget::poll(long long work){
+    pollCountdown -= work;
+    if (pollCountdown < 0){
+        pollCountdown = POLL_SLICE;
+        checkDeadline();
+    }
+}
+
+#endif // BUDGET_H
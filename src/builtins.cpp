@@ -0,0 +1,269 @@
+/* File: builtins.cpp
+ * -----------------------------------
+ *
+ * Implementation of the built-in functions.
+ */
+
+#include "builtins.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "calc.h"
+#include "error.h"
+#include "functions.h"
+#include "quadrature.h"
+#include "series.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* Largest index of sum and prod; every integer up to it is a double */
+static const double MAX_INDEX = 9007199254740992.0;
+
+/*
+ * Function: callKey
+ * Usage: string key = callKey(name, code);
+ * ______________________________________________________
+ *
+ * Returns a text that is the same for two calls exactly when they
+ * have the same function, variables and code
+ */
+static string callKey(const string & name, const Expression & code){
+    ostringstream key;
+    key << name;
+    for (int v = 0; v < code.variableCount(); v++){
+        key << ' ' << code.variableName(v);
+    }
+    key << ';';
+    for (int i = 0; i < code.size(); i++){
+        const Instruction & ins = code.instruction(i);
+        key << ' ' << ins.op << ':';
+        if (ins.op == PUSH_CONSTANT){
+            key << code.constantText(ins.operand);
+        } else {
+            key << ins.operand;
+        }
+    }
+    return key.str();
+}
+
+BuiltinRegistry::BuiltinRegistry(){
+    // calls are added by define
+}
+
+BuiltinRegistry & BuiltinRegistry::shared(){
+    static BuiltinRegistry registry;
+    return registry;
+}
+
+int BuiltinRegistry::define(const string & name, const SymbolicExpression & body){
+    Expression code = body.compile();
+    string key = callKey(name, code);
+    lock_guard<recursive_mutex> guard(lock);
+    map<string, int>::iterator it = index.find(key);
+    if (it != index.end()) return it->second;
+    int bound = code.variableCount() - 1;
+    BuiltinCall call = { name, body, code, bound + (name == "solve" ? 1 : 2), -1 };
+    if (name == "solve"){
+        solvers.push_back(EquationSolver(body, code.variableName(bound)));
+        call.solver = solvers.size() - 1;
+    }
+    calls.push_back(call);
+    index[key] = calls.size() - 1;
+    return calls.size() - 1;
+}
+
+const BuiltinCall & BuiltinRegistry::call(int id) const {
+    // a deque keeps the calls in place, so the reference outlives the lock
+    lock_guard<recursive_mutex> guard(lock);
+    return calls[id];
+}
+
+double BuiltinRegistry::evaluate(int id, const double * args) const {
+    const BuiltinCall & call = this->call(id);
+    int bound = call.code.variableCount() - 1;
+    vector<double> values(args, args + bound);
+    values.push_back(0);
+    const double * limits = args + bound;
+    if (call.name == "integrate"){
+        return integrate(call.code, bound, &values[0], limits[0], limits[1]);
+    }
+    if (call.name == "solve"){
+        const EquationSolver * solver;
+        {
+            lock_guard<recursive_mutex> guard(lock);
+            solver = &solvers[call.solver];
+        }
+        return solver->solve(&values[0], limits[0]);
+    }
+    double first = limits[0];
+    double last = limits[1];
+    if (first != floor(first) || last != floor(last) || fabs(first) > MAX_INDEX || fabs(last) > MAX_INDEX){
+        error(call.name + ": limits must be integers");
+    }
+    if (call.name == "sum"){
+        return sumRange(call.code, bound, &values[0], (long long) first, (long long) last);
+    }
+    return productRange(call.code, bound, &values[0], (long long) first, (long long) last);
+}
+
+const Expression & BuiltinRegistry::partial(int id, int argument){
+    lock_guard<recursive_mutex> guard(lock);
+    pair<int, int> key(id, argument);
+    map<pair<int, int>, Expression>::iterator it = partials.find(key);
+    if (it != partials.end()) return it->second;
+    // the call on variables of its own, one per argument
+    VectorSHPP<string> names;
+    for (int k = 0; k < calls[id].arguments; k++){
+        names.add("#" + integerToString(k));
+    }
+    Expression code(names);
+    for (int k = 0; k < names.size(); k++){
+        code.append(PUSH_VARIABLE, k);
+    }
+    code.append(BUILTIN, id);
+    Expression derivative = SymbolicExpression(code).derivative(names[argument]).compile();
+    return partials.insert(make_pair(key, derivative)).first->second;
+}
+
+int builtinArgumentCount(int id){
+    return BuiltinRegistry::shared().call(id).arguments;
+}
+
+double evaluateBuiltin(int id, const double * args){
+    return BuiltinRegistry::shared().evaluate(id, args);
+}
+
+/*
+ * Function: operandCount
+ * Usage: int count = operandCount(token);
+ * ______________________________________________________
+ *
+ * Returns the number of values a token of a polish record takes from
+ * the stack
+ */
+static int operandCount(const string & token){
+    string name;
+    int arguments;
+    int id;
+    if (isBuiltinToken(token, id)) return builtinArgumentCount(id);
+    if (isNumber(token[0]) || isNumber(token[1])) return 0;
+    if (isCallToken(token, name, arguments)) return arguments;
+    if (Expression::isFunctionName(token)) return 1;
+    if (isFunction(token)) return 0;
+    return 2;
+}
+
+/*
+ * Function: isVariableToken
+ * Usage: if (isVariableToken(token))...
+ * ______________________________________________________
+ *
+ * Checks for the name of a variable in a polish record
+ */
+static bool isVariableToken(const string & token){
+    return !token.empty() && isFunction(token) && !Expression::isFunctionName(token) && !isBuiltinName(token);
+}
+
+/*
+ * Function: bindCall
+ * Usage: vector<string> tokens = bindCall(name, args);
+ * ______________________________________________________
+ *
+ * Returns the tokens of a bound call of a built-in function from the
+ * tokens of its arguments
+ */
+static vector<string> bindCall(const string & name, const vector<vector<string> > & args){
+    int expected = name == "solve" ? 3 : 4;
+    if ((int) args.size() != expected){
+        error(name == "integrate" ? "Usage: integrate(equation, variable, from, to)"
+              : name == "solve" ? "Usage: solve(equation, variable, guess)"
+              : "Usage: " + name + "(index, from, to, equation)");
+    }
+    bool series = name == "sum" || name == "prod";
+    const vector<string> & variable = args[series ? 0 : 1];
+    const vector<string> & equation = args[series ? 3 : 0];
+    if (variable.size() != 1 || !isVariableToken(variable[0])){
+        string text;
+        for (size_t i = 0; i < variable.size(); i++) text += variable[i];
+        error(name + ": illegal variable name: " + text);
+    }
+    // the free variables of the equation, then the bound one
+    VectorSHPP<string> names;
+    vector<string> res;
+    for (size_t i = 0; i < equation.size(); i++){
+        const string & token = equation[i];
+        if (isVariableToken(token) && token != variable[0] && find(res.begin(), res.end(), token) == res.end()){
+            names.add(token);
+            res.push_back(token);
+        }
+    }
+    names.add(variable[0]);
+    VectorSHPP<string> body;
+    for (size_t i = 0; i < equation.size(); i++){
+        body.add(equation[i]);
+    }
+    int id = BuiltinRegistry::shared().define(name, SymbolicExpression(body, names));
+    for (size_t k = series ? 1 : 2; k < args.size() - (series ? 1 : 0); k++){
+        res.insert(res.end(), args[k].begin(), args[k].end());
+    }
+    res.push_back(name + "#" + integerToString(id));
+    return res;
+}
+
+void bindBuiltins(VectorSHPP<string> & records){
+    string name;
+    int arguments;
+    bool found = false;
+    for (int i = 0; i < records.size() && !found; i++){
+        found = isCallToken(records[i], name, arguments) && isBuiltinName(name);
+    }
+    if (!found) return;
+    // the tokens so far, and where each value on the stack starts in them
+    vector<string> res;
+    vector<size_t> starts;
+    for (int i = 0; i < records.size(); i++){
+        const string & token = records[i];
+        bool builtin = isCallToken(token, name, arguments) && isBuiltinName(name);
+        int count = builtin ? arguments : operandCount(token);
+        if ((int) starts.size() < count){
+            error("Incorrect data entered");
+        }
+        size_t start = count == 0 ? res.size() : starts[starts.size() - count];
+        if (builtin){
+            vector<vector<string> > args;
+            for (int k = 0; k < count; k++){
+                size_t from = starts[starts.size() - count + k];
+                size_t to = k + 1 < count ? starts[starts.size() - count + k + 1] : res.size();
+                args.push_back(vector<string>(res.begin() + from, res.begin() + to));
+            }
+            vector<string> call = bindCall(name, args);
+            res.resize(start);
+            res.insert(res.end(), call.begin(), call.end());
+        } else {
+            res.push_back(token);
+        }
+        starts.resize(starts.size() - count);
+        starts.push_back(start);
+    }
+    VectorSHPP<string> bound;
+    for (size_t i = 0; i < res.size(); i++){
+        bound.add(res[i]);
+    }
+    records.swap(bound);
+}
+
+bool isBuiltinToken(const string & token, int & id){
+    size_t mark = token.find('#');
+    if (mark == string::npos || mark + 1 >= token.length() || !isBuiltinName(token.substr(0, mark))){
+        return false;
+    }
+    id = stringToInteger(token.substr(mark + 1));
+    return true;
+}
+
+bool isBuiltinName(const string & name){
+    return name == "integrate" || name == "solve" || name == "sum" || name == "prod";
+}
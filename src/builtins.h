@@ -0,0 +1,161 @@
+/* File: builtins.h
+ * -----------------------------------
+ *
+ * This file exports the built-in functions that take whole equations
+ * as arguments, such as integrate(x^2, x, 0, 1).
+ */
+
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include "expression.h"
+#include "solver.h"
+#include "symbolic.h"
+#include "vectorshpp.h"
+
+/* A call of a built-in function bound to its equation, the body. The
+ * variables of the body are the free variables of the equation, in the
+ * order they first appear, and last the variable bound by the call. The
+ * code of a call pushes the values of the free variables and then the
+ * other arguments: the limits of integrate, sum and prod or the guess
+ * of solve. The body is evaluated at run time, so it may use anything
+ * its caller can: declared variables, cells, columns or the variable
+ * of an enclosing call. */
+struct BuiltinCall {
+    std::string name;
+    SymbolicExpression body;
+    Expression code;
+    int arguments;
+    int solver;      // index of the solver of solve, -1 for the others
+};
+
+/* Class BuiltinRegistry
+ * --------------------------------
+ * This class keeps the calls of built-in functions of the compiled
+ * equations, numbered in the order they are bound; equal calls share a
+ * number. Calls are never changed or removed, so compiled code stays
+ * valid. The derivative of a call by one of its arguments is a call
+ * too (see SymbolicExpression):
+ *   d/dv integrate(f, t, a, b) = integrate(df/dv, t, a, b), and f(b)
+ *                                and -f(a) by the limits
+ *   d/dv sum(i, a, b, f)       = sum(i, a, b, df/dv)
+ *   d/dv prod(i, a, b, f)      = prod(i, a, b, f) * sum(i, a, b, (df/dv)/f)
+ *   d/dv solve(g, y, guess)    = -(dg/dv)/(dg/dy) at the root
+ * The limits of sum and prod and the guess of solve have derivative 0.
+ * The registry may be used by the workers of the thread pool while the
+ * gradient mode adds derivatives, so its tables are locked.
+ */
+class BuiltinRegistry {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Method: shared
+     * Usage: BuiltinRegistry & registry = BuiltinRegistry::shared();
+     * -----------------------------------------------------
+     * Returns the registry of the calculator
+     */
+    static BuiltinRegistry & shared();
+
+    /* Method: define
+     * Usage: int id = registry.define("integrate", body);
+     * -----------------------------------------------------
+     * Returns the id of a call of a built-in function with the body;
+     * the last variable of the body is the bound one
+     */
+    int define(const std::string & name, const SymbolicExpression & body);
+
+    /* Method: call
+     * Usage: const BuiltinCall & call = registry.call(id);
+     * -----------------------------------------------------
+     * Returns a call
+     */
+    const BuiltinCall & call(int id) const;
+
+    /* Method: evaluate
+     * Usage: double res = registry.evaluate(id, args);
+     * -----------------------------------------------------
+     * Calculates a call for the values of its arguments. Signals an
+     * error for limits of sum and prod that are not integers.
+     */
+    double evaluate(int id, const double * args) const;
+
+    /* Method: partial
+     * Usage: const Expression & d = registry.partial(id, argument);
+     * -----------------------------------------------------
+     * Returns the derivative of a call by one of its arguments, compiled
+     * with the arguments as its variables, for the gradient mode
+     */
+    const Expression & partial(int id, int argument);
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* All calls by id; a deque keeps them in place as it grows */
+    std::deque<BuiltinCall> calls;
+    std::deque<EquationSolver> solvers;
+    std::map<std::string, int> index;
+    std::map<std::pair<int, int>, Expression> partials;
+
+    /* Recursive: a definition compiles derivatives that define calls */
+    mutable std::recursive_mutex lock;
+
+    BuiltinRegistry();
+
+    /* The registry is not copied */
+    BuiltinRegistry(const BuiltinRegistry &);
+    BuiltinRegistry & operator =(const BuiltinRegistry &);
+};
+
+/*
+ * Function: bindBuiltins
+ * Usage: bindBuiltins(polishRecord);
+ * ______________________________________________________
+ *
+ * Binds every call of a built-in function in a polish record to its
+ * equation: the arguments of the call are replaced by its free
+ * variables and its other arguments, followed by a token "name#id" of
+ * the call (see BuiltinCall), which Expression and SymbolicExpression
+ * compile. Calls inside the arguments are bound first. Signals an error
+ * for a wrong number of arguments or a bound variable that is not a
+ * name.
+ *
+ * Built-ins:
+ *   integrate(equation, x, a, b) - integral of the equation by x from a to b
+ *   solve(equation, x, guess)    - root of equation = 0 by x near the guess
+ *   sum(i, a, b, equation)       - sum of the equation for i = a..b
+ *   prod(i, a, b, equation)      - product of the equation for i = a..b
+ *
+ * @param records - polish record, changed in place
+ */
+void bindBuiltins(VectorSHPP<std::string> & records);
+
+/*
+ * Function: isBuiltinToken
+ * Usage: if (isBuiltinToken(token, id))...
+ * ______________________________________________________
+ *
+ * Checks for the token of a bound call in a polish record
+ *
+ * @param token - element of a polish record
+ * @param id - set to the id of the call
+ * @return - true if the token is a bound call
+ */
+bool isBuiltinToken(const std::string & token, int & id);
+
+/*
+ * Function: isBuiltinName
+ * Usage: if (isBuiltinName(name))...
+ * ______________________________________________________
+ *
+ * @param name - identifier
+ * @return - true if the name is a built-in function
+ */
+bool isBuiltinName(const std::string & name);
+
+#endif // BUILTINS_H
@@ -1,11 +1,38 @@
+#include <algorithm>
+#include <climits>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <new>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "math.h"
 #include "strlib.h"
+#include "simpio.h"
+#include "error.h"
 #include "stackshpp.h"
 #include "vectorshpp.h"
 #include "console.h"
+#include "calc.h"
+#include "bigfloat.h"
+#include "rational.h"
+#include "interval.h"
+#include "expression.h"
+#include "variables.h"
+#include "dual.h"
+#include "adjoint.h"
+#include "symbolic.h"
+#include "builtins.h"
+#include "aggregate.h"
+#include "spreadsheet.h"
+#include "columnfile.h"
+#include "csv.h"
+#include "functions.h"
+#include "budget.h"
+#include "parser.h"
+#include "selftest.h"
 
 using namespace std;
 
@@ -13,40 +40,764 @@ using namespace std;
  * This program is an advanced calculator that accepts an
  * equation and displays the result. The program accepts and
  * processes the following mathematical operators:
- * '+', '-', '*', '/', '^', 'sin', 'cos', 'sqrt', 'tan'.
- * To use the ('sin', 'cos', 'sqrt', 'tan'), you need to
+ * '+', '-', '*', '/', '^', 'sin', 'cos', 'sqrt', 'tan', 'log'.
+ * To use the ('sin', 'cos', 'sqrt', 'tan', 'log'), you need to
  * call desired function and write the value in parentheses.
  * Example: sin(25)
  * Fractional numbers must be entered using the '.'
  *
  * Example of writing the equation: -19+(sin(-0.5))*((7^4)/5)+sqrt(4)
+ *
+ * Lines starting with ':' are commands that change how equations
+ * are calculated:
+ *   :mode double       - machine floating point (default)
+ *   :mode big          - arbitrary-precision decimal numbers
+ *   :mode rational     - exact fractions; irrational functions fall
+ *                        back to big numbers at the current precision
+ *   :mode interval     - guaranteed lower and upper bounds of the result
+ *   :mode gradient     - the result and its derivatives by all variables
+ *   :precision 60      - significant digits of the big mode, up to 1000000
+ *   :memo on           - caches sin, cos, tan and log of repeated arguments
+ *                        in double calculations (':memo' alone prints the
+ *                        hit rate, ':memo off' stops caching)
+ *   :var x = 2.5       - declares a variable (':var' alone lists them)
+ *   :def f(x,y) = x^2+y*sin(x)
+ *                      - defines a function, which equations can call as
+ *                        f(2,3); the line f(x,y) = ... alone does the same
+ *                        (':def' alone lists the functions). The body may
+ *                        call functions defined before and the function
+ *                        itself; redefining a function does not change
+ *                        the equations and functions compiled before.
+ *   :cell total = price*qty
+ *                      - sets a cell of the sheet to a number or to a
+ *                        formula of other cells and recalculates the
+ *                        cells that depend on it (':cell' alone lists them)
+ *   :sheet cells.txt   - sets the cells of a file of "name = formula"
+ *                        lines at once; '#' starts a comment line
+ *   :d/dx x^2*sin(x)   - prints the simplified derivative of an equation
+ *                        by a declared variable and calculates it; a long
+ *                        part used more than once is printed once, on a
+ *                        line "#1 = ..." after the derivative
+ *   :csv in.csv out.csv price*qty*(1-disc)
+ *                      - calculates an equation of the columns for every
+ *                        row of a CSV file ('-' writes to the console)
+ *   :tocolumns in.csv in.col
+ *                      - converts a CSV file to the binary columnar format
+ *   :columns in.col out.col price*qty*(1-disc)
+ *                      - like :csv, for columnar files, which are read in
+ *                        place without parsing
+ *   :tocsv out.col out.csv
+ *                      - converts a columnar file back to CSV
+ *   :mean in.col price*qty
+ *                      - aggregate of an equation of the columns of a CSV
+ *                        or columnar file: sum, mean, min, max, variance
+ *                        (of the sample) or count; missing values are
+ *                        skipped
+ *   :limits steps 1e8  - limits the work for each line of input: steps
+ *                        (instructions run, for every row and call), time
+ *                        (seconds), tokens (of an equation) or depth (of
+ *                        nesting in an equation); 0 removes a limit and
+ *                        ':limits' alone prints them
+ *   :test              - runs the checks of the calculator (src/test);
+ *                        ':test parser' runs those with "parser" in
+ *                        their names
+ *   :bench regex       - runs the benchmarks with "regex" in their names
+ *
+ * Equations may use the declared variables, for example: x^2+sin(y)
+ *
+ * Built-in functions take equations as arguments and are calculated
+ * in double precision with the rest of the equation, so they may use
+ * its variables and be differentiated:
+ *   integrate(x^2, x, 0, 1) - integral of x^2 by x from 0 to 1
+ *   solve(x^2-2, x, 1)      - root of x^2-2 = 0 near x = 1
+ *   sum(i, 1, 100, 1/i^2)   - sum of 1/i^2 for i = 1..100
+ *   prod(i, 1, 10, i)       - product of i for i = 1..10
  */
 
+/* From this number of variables on, the gradient mode uses reverse mode */
+const int REVERSE_MODE_MIN_VARIABLES = 8;
+
+/* Characters of an equation given to the parser at a time */
+const size_t PARSE_CHUNK = 65536;
+
 // function prototypes
-VectorSHPP<string> polishInvertedRecord(string equation);
-double getResult(VectorSHPP<string> & records);
-int operatorPriority(char ch);
-bool isNumber(char ch);
-bool isOperator(char ch);
-bool isFunction(string func);
+void handleCommand(string command, CalcMode & mode, VariableTable & variables, Spreadsheet & sheet);
+void declareVariable(string declaration, VariableTable & variables);
+void defineFunction(string definition);
+bool isDefinition(string line);
+void setCell(string definition, Spreadsheet & sheet);
+void loadSheet(string arguments, Spreadsheet & sheet);
+void setMemo(string argument);
+void setLimits(string arguments);
+void runCsv(string arguments, const VariableTable & variables);
+void runColumns(string arguments, const VariableTable & variables);
+void convertFile(string name, string arguments);
+void runAggregate(string name, string arguments, const VariableTable & variables);
+void printDerivative(string variable, string equation, CalcMode mode, const VariableTable & variables);
+void printResult(const Expression & expr, CalcMode mode, const VariableTable & variables);
+string modeName(CalcMode mode);
+void printRational(const Rational & res);
+void printGradient(const Expression & expr, const VariableTable & variables);
+string removeSpaces(string str);
+
+template <>
+BigFloat numberFromString<BigFloat>(const string & str){
+    return BigFloat(str);
+}
+
+template <>
+Rational numberFromString<Rational>(const string & str){
+    return Rational(str);
+}
+
+template <>
+Interval numberFromString<Interval>(const string & str){
+    return Interval::fromDecimal(str);
+}
+
+template <>
+double numberToDouble<BigFloat>(const BigFloat & number){
+    return number.toDouble();
+}
+
+template <>
+double numberToDouble<Rational>(const Rational & number){
+    return number.toDouble();
+}
+
+template <>
+double numberToDouble<Interval>(const Interval & number){
+    if (number.getLower() == number.getUpper()) return number.getLower();
+    // halves first, so the sum of large bounds does not overflow
+    return number.getLower() / 2 + number.getUpper() / 2;
+}
+
+/**
+ * Function: evaluateExpression
+ * Usage: NumberType res = evaluateExpression<NumberType>(expr, variables)
+ * ______________________________________________________________________________
+ *
+ * Evaluates a compiled equation in the number type of a calculation mode,
+ * converting the values of the variables to that type.
+ *
+ * @param expr - equation compiled with the names of the declared variables
+ * @param variables - declared variables
+ * @return - result of the equation
+ */
+template <typename NumberType>
+NumberType evaluateExpression(const Expression & expr, const VariableTable & variables){
+    vector<NumberType> values;
+    for (int i = 0; i < expr.variableCount(); i++){
+        values.push_back(numberFromString<NumberType>(variables.get(expr.variableName(i))));
+    }
+    return expr.evaluate<NumberType>(values.empty() ? NULL : &values[0]);
+}
 
 /**
  * The main function of the program, which prompts the user for the
  * equation to be solved, and displays the result on the screen.
  */
 int main() {
+    CalcMode mode = DOUBLE_MODE;
+    VariableTable variables;
+    Spreadsheet sheet;
     while(true){
-        string equation;
-        cout << "Enter your equation: ";
-        cin >> equation;
-        equation = toLowerCase(equation);
+        string line = trim(getLine("Enter your equation: "));
+        if (line.empty()){
+            if (cin.eof()) break;
+            continue;
+        }
+        handleLine(line, mode, variables, sheet);
+    }
+    return 0;
+}
+
+/**
+ * Function: handleLine
+ * Usage: handleLine(string line, CalcMode & mode, VariableTable & variables, Spreadsheet & sheet)
+ * ______________________________________________________________________________
+ *
+ * Executes a line of input: a command, a function definition or an
+ * equation, whose result is printed. Errors are printed, not thrown,
+ * running out of memory included.
+ *
+ * @param line - line of input without surrounding spaces, not empty
+ * @param mode - current calculation mode
+ * @param variables - declared variables
+ * @param sheet - cells of the sheet
+ */
+void handleLine(string line, CalcMode & mode, VariableTable & variables, Spreadsheet & sheet){
+    try {
+        EvaluationBudget budget;
+        if (line[0] == ':'){
+            handleCommand(line.substr(1), mode, variables, sheet);
+            return;
+        }
+        if (isDefinition(line)){
+            defineFunction(line);
+            return;
+        }
+        VectorSHPP<string> polishRecord =  polishInvertedRecord(toLowerCase(removeSpaces(line)));
+        bindBuiltins(polishRecord);
+        Expression expr = compileEquation(polishRecord, variables.names());
+        printResult(expr, mode, variables);
+    } catch (ErrorException & ex) {
+        cout << "Error: " << ex.getMessage() << endl;
+    } catch (bad_alloc &) {
+        // the memory of the line is freed by now, so the next line can run
+        cout << "Error: Out of memory" << endl;
+    } catch (exception & ex) {
+        cout << "Error: " << ex.what() << endl;
+    }
+}
+
+/**
+ * Function: handleCommand
+ * Usage: handleCommand(string command, CalcMode & mode, VariableTable & variables, Spreadsheet & sheet)
+ * ______________________________________________________________________________
+ *
+ * Executes a calculator command (the text after ':') and prints the
+ * resulting settings.
+ *
+ * @param command - command name followed by its argument
+ * @param mode - current calculation mode, changed by the "mode" command
+ * @param variables - declared variables, changed by the "var" command
+ * @param sheet - cells, changed by the "cell" command
+ */
+void handleCommand(string command, CalcMode & mode, VariableTable & variables, Spreadsheet & sheet){
+    istringstream input(command);
+    string name, argument;
+    input >> name >> argument;
+    name = toLowerCase(name);
+    argument = toLowerCase(argument);
+    if (name == "var"){
+        declareVariable(command.substr(command.find(name) + name.length()), variables);
+        return;
+    } else if (name == "def"){
+        defineFunction(command.substr(command.find(name) + name.length()));
+        return;
+    } else if (name == "cell"){
+        setCell(command.substr(command.find(name) + name.length()), sheet);
+        return;
+    } else if (name == "memo"){
+        setMemo(argument);
+        return;
+    } else if (name == "limits"){
+        setLimits(command.substr(command.find(name) + name.length()));
+        return;
+    } else if (name == "sheet"){
+        loadSheet(command.substr(command.find(name) + name.length()), sheet);
+        return;
+    } else if (name == "csv"){
+        runCsv(command.substr(command.find(name) + name.length()), variables);
+        return;
+    } else if (name == "columns"){
+        runColumns(command.substr(command.find(name) + name.length()), variables);
+        return;
+    } else if (name == "tocolumns" || name == "tocsv"){
+        convertFile(name, command.substr(command.find(name) + name.length()));
+        return;
+    } else if (isAggregateName(name)){
+        runAggregate(name, command.substr(command.find(name) + name.length()), variables);
+        return;
+    } else if (name == "test" || name == "bench"){
+        runSelfTests(argument, name == "bench");
+        return;
+    } else if (startsWith(name, "d/d") && name.length() > 3){
+        printDerivative(name.substr(3), command.substr(command.find(name) + name.length()), mode, variables);
+        return;
+    } else if (name == "mode" && argument == "double"){
+        mode = DOUBLE_MODE;
+    } else if (name == "mode" && argument == "big"){
+        mode = BIG_MODE;
+    } else if (name == "mode" && argument == "rational"){
+        mode = RATIONAL_MODE;
+    } else if (name == "mode" && argument == "interval"){
+        mode = INTERVAL_MODE;
+    } else if (name == "mode" && argument == "gradient"){
+        mode = GRADIENT_MODE;
+    } else if (name == "precision" && stringIsInteger(argument)){
+        BigFloat::setPrecision(stringToInteger(argument));
+    } else {
+        cout << "Unknown command: " << command << endl;
+        return;
+    }
+    cout << "Mode: " << modeName(mode)
+         << ", precision: " << BigFloat::getPrecision() << " digits" << endl;
+}
+
+/**
+ * Function: declareVariable
+ * Usage: declareVariable(string declaration, VariableTable & variables)
+ * ______________________________________________________________________________
+ *
+ * Handles the "var" command: "name = value" declares a variable or changes
+ * its value, an empty declaration lists all variables.
+ *
+ * @param declaration - text of the command after "var"
+ * @param variables - declared variables
+ */
+void declareVariable(string declaration, VariableTable & variables){
+    declaration = toLowerCase(removeSpaces(declaration));
+    if (declaration.empty()){
+        for (int i = 0; i < variables.size(); i++){
+            string name = variables.names().get(i);
+            cout << name << " = " << variables.get(name) << endl;
+        }
+        return;
+    }
+    size_t equals = declaration.find('=');
+    if (equals == string::npos){
+        error("Usage: :var name = value");
+    }
+    string name = declaration.substr(0, equals);
+    string value = declaration.substr(equals + 1);
+    if (!stringIsReal(value)){
+        error("Variable value must be a number: " + value);
+    }
+    variables.set(name, value);
+    cout << name << " = " << value << endl;
+}
+
+/**
+ * Function: defineFunction
+ * Usage: defineFunction(string definition)
+ * ______________________________________________________________________________
+ *
+ * Handles the "def" command: "f(x,y) = body" defines a function and prints
+ * how it is called, an empty definition lists all functions.
+ *
+ * @param definition - text of the command after "def"
+ */
+void defineFunction(string definition){
+    definition = toLowerCase(removeSpaces(definition));
+    FunctionRegistry & registry = FunctionRegistry::shared();
+    vector<string> names;
+    if (definition.empty()){
+        names = registry.names();
+    } else {
+        names.push_back(registry.function(registry.define(definition)).name);
+    }
+    for (size_t i = 0; i < names.size(); i++){
+        const UserFunction & function = registry.function(registry.find(names[i]));
+        cout << function.name << "(";
+        for (size_t k = 0; k < function.parameters.size(); k++){
+            cout << (k > 0 ? "," : "") << function.parameters[k];
+        }
+        cout << ") = " << function.body << "  ("
+             << (function.inlined ? "inlined" : function.recursive ? "recursive" : "called") << ")" << endl;
+    }
+}
+
+/**
+ * Function: isDefinition
+ * Usage: if (isDefinition(string line))
+ * ______________________________________________________________________________
+ *
+ * Checks whether a line is a function definition "f(x) = body" rather
+ * than an equation, which may only contain '=' in comparisons.
+ *
+ * @param line - line entered by the user
+ * @return - true if the line defines a function
+ */
+bool isDefinition(string line){
+    line = removeSpaces(line);
+    size_t equals = line.find('=');
+    return equals != string::npos && equals > 0 && line[equals - 1] == ')' && line[equals + 1] != '=';
+}
+
+/**
+ * Function: setMemo
+ * Usage: setMemo(string argument)
+ * ______________________________________________________________________________
+ *
+ * Handles the "memo" command: "on" or "off" sets whether new equations
+ * cache function results and clears the statistics, no argument prints
+ * them.
+ *
+ * @param argument - "on", "off" or empty
+ */
+void setMemo(string argument){
+    if (argument == "on" || argument == "off"){
+        Expression::setMemoizedByDefault(argument == "on");
+        FunctionCache::resetStatistics();
+    } else if (!argument.empty()){
+        error("Usage: :memo on|off");
+    }
+    long long hits, misses;
+    FunctionCache::statistics(hits, misses);
+    cout << "Memo: " << (Expression::isMemoizedByDefault() ? "on" : "off")
+         << ", hits: " << hits << ", misses: " << misses;
+    if (hits + misses > 0){
+        cout << ", hit rate: " << 100.0 * hits / (hits + misses) << "%";
+    }
+    cout << endl;
+}
+
+/**
+ * Function: setLimits
+ * Usage: setLimits(string arguments)
+ * ______________________________________________________________________________
+ *
+ * Handles the "limits" command: pairs of a limit name (steps, time, tokens
+ * or depth) and its value set the limits of the next lines, where 0 means
+ * no limit; the limits are then printed.
+ *
+ * @param arguments - text of the command after "limits"
+ */
+void setLimits(string arguments){
+    istringstream input(toLowerCase(arguments));
+    EvaluationLimits limits = EvaluationBudget::limits();
+    string name, value;
+    while (input >> name){
+        if (!(input >> value) || !stringIsReal(value) || stringToReal(value) < 0){
+            error("Usage: :limits steps|time|tokens|depth value");
+        }
+        double number = stringToReal(value);
+        if (name == "steps" && number < LLONG_MAX){
+            limits.steps = (long long) number;
+        } else if (name == "time"){
+            limits.seconds = number;
+        } else if (name == "tokens" && number <= INT_MAX){
+            limits.tokens = (int) number;
+        } else if (name == "depth" && number <= INT_MAX){
+            limits.nesting = (int) number;
+        } else {
+            error("Usage: :limits steps|time|tokens|depth value");
+        }
+    }
+    EvaluationBudget::setLimits(limits);
+    cout << "Limits: steps " << limits.steps << ", time " << limits.seconds
+         << " s, tokens " << limits.tokens << ", depth " << limits.nesting << " (0 is no limit)" << endl;
+}
+
+/**
+ * Function: setCell
+ * Usage: setCell(string definition, Spreadsheet & sheet)
+ * ______________________________________________________________________________
+ *
+ * Handles the "cell" command: "name = formula" sets a cell and prints its
+ * value, an empty definition lists all cells.
+ *
+ * @param definition - text of the command after "cell"
+ * @param sheet - cells of the sheet
+ */
+void setCell(string definition, Spreadsheet & sheet){
+    definition = toLowerCase(removeSpaces(definition));
+    if (definition.empty()){
+        for (int i = 0; i < sheet.cellCount(); i++){
+            string name = sheet.cellName(i);
+            cout << name << " = " << sheet.value(name);
+            if (!sheet.formula(name).empty()) cout << "  (" << sheet.formula(name) << ")";
+            cout << endl;
+        }
+        return;
+    }
+    size_t equals = definition.find('=');
+    if (equals == string::npos){
+        error("Usage: :cell name = formula");
+    }
+    string name = definition.substr(0, equals);
+    string formula = definition.substr(equals + 1);
+    int recalculated = stringIsReal(formula) ? sheet.setValue(name, stringToReal(formula))
+                                             : sheet.set(name, formula);
+    cout << name << " = " << sheet.value(name) << ", cells recalculated: " << recalculated << endl;
+}
+
+/**
+ * Function: loadSheet
+ * Usage: loadSheet(string arguments, Spreadsheet & sheet)
+ * ______________________________________________________________________________
+ *
+ * Handles the "sheet" command: sets all cells of a file and recalculates
+ * once. A cycle among them leaves the sheet unchanged.
+ *
+ * @param arguments - path of the file
+ * @param sheet - cells of the sheet
+ */
+void loadSheet(string arguments, Spreadsheet & sheet){
+    string path = trim(arguments);
+    ifstream input(path.c_str());
+    if (path.empty() || !input){
+        error("Cannot open file: " + path);
+    }
+    vector<string> names, formulas;
+    string line;
+    while (getline(input, line)){
+        line = toLowerCase(removeSpaces(line));
+        if (line.empty() || line[0] == '#') continue;
+        size_t equals = line.find('=');
+        if (equals == string::npos){
+            error("Line without '=' in " + path + ": " + line);
+        }
+        names.push_back(line.substr(0, equals));
+        formulas.push_back(line.substr(equals + 1));
+    }
+    int recalculated = sheet.setAll(names, formulas);
+    cout << "Cells: " << names.size() << ", cells recalculated: " << recalculated << endl;
+}
+
+/**
+ * Function: runCsv
+ * Usage: runCsv(string arguments, const VariableTable & variables)
+ * ______________________________________________________________________________
+ *
+ * Handles the "csv" command: "input output equation" calculates the
+ * equation for every row of the input file and writes the results.
+ *
+ * @param arguments - text of the command after "csv"
+ * @param variables - declared variables, constant in every row
+ */
+void runCsv(string arguments, const VariableTable & variables){
+    istringstream input(arguments);
+    string inputPath, outputPath, equation;
+    input >> inputPath >> outputPath;
+    getline(input, equation);
+    equation = toLowerCase(removeSpaces(equation));
+    if (equation.empty()){
+        error("Usage: :csv input.csv output.csv equation");
+    }
+    long long invalid;
+    long long rows = evaluateCsv(inputPath, outputPath, equation, variables, invalid);
+    if (outputPath != "-"){
+        cout << "Rows: " << rows << ", written to " << outputPath << endl;
+    }
+    if (invalid > 0){
+        cout << "Missing or non-numeric fields: " << invalid << endl;
+    }
+}
+
+/**
+ * Function: runColumns
+ * Usage: runColumns(string arguments, const VariableTable & variables)
+ * ______________________________________________________________________________
+ *
+ * Handles the "columns" command: "input output equation" calculates the
+ * equation for every row of the input columnar file and writes the
+ * results as a columnar file.
+ *
+ * @param arguments - text of the command after "columns"
+ * @param variables - declared variables, constant in every row
+ */
+void runColumns(string arguments, const VariableTable & variables){
+    istringstream input(arguments);
+    string inputPath, outputPath, equation;
+    input >> inputPath >> outputPath;
+    getline(input, equation);
+    equation = toLowerCase(removeSpaces(equation));
+    if (equation.empty()){
+        error("Usage: :columns input.col output.col equation");
+    }
+    long long rows = evaluateColumnFile(inputPath, outputPath, equation, variables);
+    cout << "Rows: " << rows << ", written to " << outputPath << endl;
+}
+
+/**
+ * Function: convertFile
+ * Usage: convertFile(string name, string arguments)
+ * ______________________________________________________________________________
+ *
+ * Handles the "tocolumns" and "tocsv" commands: "input output" converts
+ * a CSV file to a columnar file or back.
+ *
+ * @param name - name of the command
+ * @param arguments - text of the command after its name
+ */
+void convertFile(string name, string arguments){
+    istringstream input(arguments);
+    string inputPath, outputPath;
+    if (!(input >> inputPath >> outputPath)){
+        error("Usage: :" + name + " input output");
+    }
+    long long rows = name == "tocsv" ? columnFileToCsv(inputPath, outputPath)
+                                     : csvToColumnFile(inputPath, outputPath);
+    cout << "Rows: " << rows << ", written to " << outputPath << endl;
+}
+
+/**
+ * Function: runAggregate
+ * Usage: runAggregate(string name, string arguments, const VariableTable & variables)
+ * ______________________________________________________________________________
+ *
+ * Handles the aggregate commands: "input equation" prints the aggregate
+ * of the equation over the rows of the input file.
+ *
+ * @param name - name of the aggregate
+ * @param arguments - text of the command after its name
+ * @param variables - declared variables, constant in every row
+ */
+void runAggregate(string name, string arguments, const VariableTable & variables){
+    istringstream input(arguments);
+    string inputPath, equation;
+    input >> inputPath;
+    getline(input, equation);
+    equation = toLowerCase(removeSpaces(equation));
+    if (equation.empty()){
+        error("Usage: :" + name + " input equation");
+    }
+    long long invalid;
+    ColumnAggregate aggregate = aggregateFile(inputPath, equation, variables, invalid);
+    if (name == "count"){
+        cout << name << " = " << aggregate.count() << endl;
+    } else {
+        double res = name == "sum" ? aggregate.sum()
+                   : name == "mean" ? aggregate.mean()
+                   : name == "min" ? aggregate.min()
+                   : name == "max" ? aggregate.max() : aggregate.variance();
+        streamsize precision = cout.precision(15);
+        cout << name << " = " << res << endl;
+        cout.precision(precision);
+    }
+    if (invalid > 0){
+        cout << "Missing or non-numeric fields: " << invalid << endl;
+    }
+}
+
+/**
+ * Function: printDerivative
+ * Usage: printDerivative(string variable, string equation, CalcMode mode, const VariableTable & variables)
+ * ______________________________________________________________________________
+ *
+ * Handles the "d/dx" command: prints the simplified derivative of the
+ * equation by the variable, then its value in the current mode.
+ *
+ * @param variable - name of a declared variable
+ * @param equation - equation to differentiate
+ * @param mode - current calculation mode
+ * @param variables - declared variables
+ */
+void printDerivative(string variable, string equation, CalcMode mode, const VariableTable & variables){
+    VectorSHPP<string> polishRecord = polishInvertedRecord(toLowerCase(removeSpaces(equation)));
+    bindBuiltins(polishRecord);
+    SymbolicExpression derivative = SymbolicExpression(polishRecord, variables.names()).derivative(variable);
+    string text = derivative.toString();
+    cout << "d/d" << variable << " = " << text << endl;
+    printResult(derivative.compile(), mode, variables);
+}
+
+/**
+ * Function: printResult
+ * Usage: printResult(const Expression & expr, CalcMode mode, const VariableTable & variables)
+ * ______________________________________________________________________________
+ *
+ * Calculates a compiled equation in the number type of the mode and
+ * prints the result.
+ *
+ * @param expr - equation compiled with the names of the declared variables
+ * @param mode - current calculation mode
+ * @param variables - declared variables
+ */
+void printResult(const Expression & expr, CalcMode mode, const VariableTable & variables){
+    if (mode == BIG_MODE){
+        BigFloat res = evaluateExpression<BigFloat>(expr, variables);
+        cout << "Result: " << res << endl;
+    } else if (mode == RATIONAL_MODE){
+        printRational(evaluateExpression<Rational>(expr, variables));
+    } else if (mode == INTERVAL_MODE){
+        Interval res = evaluateExpression<Interval>(expr, variables);
+        cout << "Result: " << res << endl;
+    } else if (mode == GRADIENT_MODE){
+        printGradient(expr, variables);
+    } else {
+        double res = evaluateExpression<double>(expr, variables);
+        cout << "Result: " << res << endl;
+    }
+}
 
-        VectorSHPP<string> polishRecord =  polishInvertedRecord(equation);
-        double res = getResult(polishRecord);
+/**
+ * Function: modeName
+ * Usage: string name = modeName(CalcMode mode)
+ * ______________________________________________________________________________
+ *
+ * @param mode - calculation mode
+ * @return - name of the mode, as accepted by the "mode" command
+ */
+string modeName(CalcMode mode){
+    switch (mode){
+    case BIG_MODE:
+        return "big";
+    case RATIONAL_MODE:
+        return "rational";
+    case INTERVAL_MODE:
+        return "interval";
+    case GRADIENT_MODE:
+        return "gradient";
+    default:
+        return "double";
+    }
+}
 
+/**
+ * Function: printRational
+ * Usage: printRational(const Rational & res)
+ * ______________________________________________________________________________
+ *
+ * Prints the result of the rational mode: the exact fraction followed by
+ * its decimal value, or only the decimal value if a floating-point
+ * fallback made the fraction approximate.
+ *
+ * @param res - result of the equation
+ */
+void printRational(const Rational & res){
+    if (!res.isExact()){
+        cout << "Result: ~" << res.toBigFloat() << endl;
+    } else if (res.isInteger()){
         cout << "Result: " << res << endl;
+    } else {
+        cout << "Result: " << res << " = " << res.toBigFloat() << endl;
     }
-    return 0;
+}
+
+/**
+ * Function: printGradient
+ * Usage: printGradient(const Expression & expr, const VariableTable & variables)
+ * ______________________________________________________________________________
+ *
+ * Prints the result of the gradient mode: the value of the equation and
+ * its partial derivatives by every declared variable. Forward mode is
+ * cheaper for a few variables, reverse mode for many.
+ *
+ * @param expr - equation compiled with the names of the declared variables
+ * @param variables - declared variables
+ */
+void printGradient(const Expression & expr, const VariableTable & variables){
+    int count = expr.variableCount();
+    vector<double> values(count + 1), gradient(count + 1);
+    for (int i = 0; i < count; i++){
+        values[i] = stringToDouble(variables.get(expr.variableName(i)));
+    }
+    double res;
+    if (count >= REVERSE_MODE_MIN_VARIABLES){
+        ReverseGradient reverse(expr);
+        res = reverse.evaluate(&values[0], &gradient[0]);
+    } else {
+        res = evaluateGradient(expr, &values[0], &gradient[0]);
+    }
+    cout << "Result: " << res << endl;
+    for (int i = 0; i < count; i++){
+        cout << "  d/d" << expr.variableName(i) << " = " << gradient[i] << endl;
+    }
+}
+
+/**
+ * Function: removeSpaces
+ * Usage: string equation = removeSpaces(string str)
+ * ______________________________________________________________________________
+ *
+ * Returns the string without blank characters, so equations
+ * may be typed with spaces between the terms.
+ *
+ * @param str - line entered by the user
+ * @return - line without blanks
+ */
+string removeSpaces(string str){
+    string res;
+    for (int i = 0; i < str.length(); i++){
+        if (!isspace(str[i])){
+            res += str[i];
+        }
+    }
+    return res;
 }
 
 /**
@@ -57,53 +808,18 @@ int main() {
  * Function accepts a string entered by the user, and allows it puts priority
  * actions. Using an algorithm sorting station. Returns a vector of strings, where
  * string is decomposed by the algorithm reverse Polish notation.
+ * The equation is read by PolishRecordParser in chunks of PARSE_CHUNK
+ * characters, whose classes stay in the cache.
  *
  * @param equation - expression entered by the user
  * @return - vector of strings
  */
 VectorSHPP<string> polishInvertedRecord(string equation){
-    StackSHPP<string> stack;
-    string output("");
-    VectorSHPP<string> res;
-    for (int i = 0; i < equation.length(); i++){
-        if (isNumber(equation[i]) || (equation[i] == '-' && i == 0) || (i > 0 && equation[i-1] == '(' && equation[i] == '-')){ // Checking whether an incoming character part number
-            if(i == equation.length() - 1 || !isNumber(equation[i + 1])){ // check whether a character is, the latest in a number of
-                output += equation[i];
-                res.add(output);
-                output = "";
-            } else {
-                output += equation[i];
-            }
-        } else if (equation[i] >= 'a' && equation[i] <= 'z'){ // Check whether the incoming part of the function symbol
-            if(equation[i+1] == '('){ // check whether a character is, the latest in a function
-                output += equation[i];
-                stack.push(output);
-                output = "";
-            } else {
-                output += equation[i];
-            }
-        } else if (equation[i] == '(') {
-            stack.push("(");
-        } else if (equation[i] == ')') {
-            while (stack.peek() != "(") {
-                res.add(stack.pop());
-            }
-            stack.pop();
-        } else if (isOperator(equation[i])) {
-            while (!stack.isEmpty() && (operatorPriority(stack.peek()[0]) >= operatorPriority(equation[i]))) {
-                res.add(stack.pop());
-            }
-            stack.push(charToString(equation[i]));
-        } else {
-            cout << "Error incoming data" << endl;
-            break;
-        }
+    PolishRecordParser parser;
+    for (size_t start = 0; start < equation.length(); start += PARSE_CHUNK){
+        parser.feed(equation.data() + start, min(PARSE_CHUNK, equation.length() - start));
     }
-    // Takes out remaining values from the stack
-    while(!stack.isEmpty()){
-        res.add(stack.pop());
-    }
-    return res;
+    return parser.finish();
 }
 
 /**
@@ -119,12 +835,18 @@ VectorSHPP<string> polishInvertedRecord(string equation){
 int operatorPriority(char ch) {
     int res = 0;
     if(ch >= 'a' && ch <= 'z'){
-        res = 4;
+        res = 7;
     } else if (ch == '^'){
-        res = 3;
+        res = 6;
     } else if (ch == '*' || ch == '/'){
-        res = 2;
+        res = 5;
     } else if (ch == '+' || ch == '-'){
+        res = 4;
+    } else if (ch == '<' || ch == '>' || ch == '=' || ch == '!'){
+        res = 3;
+    } else if (ch == '&'){
+        res = 2;
+    } else if (ch == '|'){
         res = 1;
     }
     return res;
@@ -157,7 +879,8 @@ bool isNumber(char ch) {
  * @return - true if character is operator
  */
 bool isOperator(char ch) {
-    return (ch == '+' || ch == '-' || ch == '/' || ch == '*' || ch == '^' || (ch >= 'a' && ch <= 'z'));
+    return (ch == '+' || ch == '-' || ch == '/' || ch == '*' || ch == '^' || (ch >= 'a' && ch <= 'z')
+            || ch == '<' || ch == '>' || ch == '=' || ch == '!' || ch == '&' || ch == '|');
 }
 
 /**
@@ -180,66 +903,3 @@ bool isFunction(string func) {
     return true;
 }
 
-/**
- * Function: getResult
- * Usage: double result = getResult(VectorSHPP<string> & records)
- * ____________________________________________________________
- *
- * This function takes each element of the vector values and
- * places numbers in the stack, if the value is an operator or
- * function then removed numbers from stack and made mathematical equations
- * and places back in stack. So is continued until vector will not empty and
- * in the stack remains only a single number. It will be result.
- *
- * @param records - Vector values, sorted by Polish writeback algorithm
- * @return - Result of the solution of equation
- */
-double getResult(VectorSHPP<string> & records){
-    StackSHPP<double> stack;
-
-    for (int i = 0; i < records.size(); i++){
-        double res;
-        string element = records[i];
-
-        if (isNumber(element[0]) || isNumber(element[1])){
-            stack.push(stringToDouble(element));
-        } else if (isFunction(element)){
-            double operand = stack.pop();
-
-            if(element == "sin"){
-                res = sin(operand);
-            } else if (element == "cos"){
-                res = cos(operand);
-            } else if (element == "sqrt"){
-                res = sqrt(operand);
-            } else if (element == "tan"){
-                res = tan(operand);
-            } else {
-                cout << "Error: unknown operator" << endl;
-                exit(1);
-            }
-            stack.push(res);
-
-        } else if (isOperator(element[0])){
-            double firstOperand = stack.pop();
-            double secondOperand = stack.pop();
-            if(element[0] == '+'){
-                res = secondOperand + firstOperand;
-            } else if (element[0] == '-'){
-                res = secondOperand - firstOperand;
-            } else if (element[0] == '*'){
-                res = secondOperand * firstOperand;
-            } else if (element[0] == '/'){
-                res = secondOperand / firstOperand;
-            } else if (element[0] == '^'){
-                res = pow(secondOperand, firstOperand);
-            }
-            stack.push(res);
-        } else {
-            cout << "Incorrect data entered" << endl;
-            exit(1);
-        }
-    }
-    // in the stack is only one value - the result
-    return stack.pop();
-}
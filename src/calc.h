@@ -0,0 +1,73 @@
+/* File: calc.h
+ * -----------------------------------
+ *
+ * This file exports the parsing functions of the calculator and the
+ * conversion of number tokens, so the number types of the other
+ * calculation modes can reuse them, and the execution of a line of
+ * input, so the checks in src/test can run the calculator.
+ */
+
+#ifndef CALC_H
+#define CALC_H
+
+#include <string>
+#include "strlib.h"
+#include "stackshpp.h"
+#include "vectorshpp.h"
+
+class VariableTable;
+class Spreadsheet;
+class Interval;
+
+/* Number representation used to calculate equations */
+enum CalcMode { DOUBLE_MODE, BIG_MODE, RATIONAL_MODE, INTERVAL_MODE, GRADIENT_MODE };
+
+// function prototypes
+void handleLine(std::string line, CalcMode & mode, VariableTable & variables, Spreadsheet & sheet);
+VectorSHPP<std::string> polishInvertedRecord(std::string equation);
+int operatorPriority(char ch);
+bool isNumber(char ch);
+bool isOperator(char ch);
+bool isFunction(std::string func);
+
+/*
+ * Function: numberFromString
+ * Usage: NumberType value = numberFromString<NumberType>(str);
+ * ______________________________________________________
+ *
+ * Converts a number token of the polish record to the number type
+ * of a calculation mode. Each number type provides a specialization.
+ */
+template <typename NumberType>
+NumberType numberFromString(const std::string & str);
+
+template <>
+inline double numberFromString<double>(const std::string & str){
+    return stringToDouble(str);
+}
+
+template <>
+Interval numberFromString<Interval>(const std::string & str);
+
+/*
+ * Function: numberToDouble
+ * Usage: double value = numberToDouble(number);
+ * ______________________________________________________
+ *
+ * Converts a number of a calculation mode to the nearest double, for
+ * the built-in functions, which calculate in double precision. An
+ * interval gives its midpoint. Each number type provides a
+ * specialization.
+ */
+template <typename NumberType>
+double numberToDouble(const NumberType & number);
+
+template <>
+inline double numberToDouble<double>(const double & number){
+    return number;
+}
+
+template <>
+double numberToDouble<Interval>(const Interval & number);
+
+#endif // CALC_H
@@ -0,0 +1,338 @@
+/* File: columnfile.cpp
+ * -----------------------------------
+ *
+ * Implementation of the columnar file format.
+ */
+
+#include "columnfile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "csv.h"
+#include "error.h"
+#include "expression.h"
+#include "threadpool.h"
+
+using namespace std;
+
+static const char MAGIC[8] = { 'C', 'A', 'L', 'C', 'C', 'O', 'L', '1' };
+
+/* Size of the fixed part of the header */
+static const size_t FIXED_HEADER_SIZE = 24;
+
+/* Alignment of the columns in the file */
+static const size_t COLUMN_ALIGNMENT = 64;
+
+/* Rows evaluated or formatted by one task */
+static const long long ROWS_PER_TASK = 65536;
+
+/* Tasks whose CSV text is formatted before it is written */
+static const int TASKS_PER_WAVE = 64;
+
+/*
+ * Function: isLittleEndian
+ * Usage: if (isLittleEndian())...
+ * ______________________________________________________
+ *
+ * Returns true if the machine stores numbers in the byte order of the file
+ */
+static bool isLittleEndian(){
+    unsigned int one = 1;
+    unsigned char first;
+    memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+/*
+ * Function: readInteger / appendInteger
+ * Usage: long long rows = readInteger(data + 8, 8);
+ * ______________________________________________________
+ *
+ * Read or append an unsigned little-endian integer of the given size
+ */
+static unsigned long long readInteger(const char * data, int bytes){
+    unsigned long long value = 0;
+    for (int i = bytes - 1; i >= 0; i--){
+        value = (value << 8) | (unsigned char) data[i];
+    }
+    return value;
+}
+
+static void appendInteger(string & out, unsigned long long value, int bytes){
+    for (int i = 0; i < bytes; i++){
+        out += (char) ((value >> (8 * i)) & 0xFF);
+    }
+}
+
+/*
+ * Function: paddedSize
+ * Usage: size_t size = paddedSize(bytes);
+ * ______________________________________________________
+ *
+ * Rounds a size up to the column alignment
+ */
+static size_t paddedSize(size_t bytes){
+    return (bytes + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+}
+
+/*
+ * Function: swapBytes
+ * Usage: double value = swapBytes(raw);
+ * ______________________________________________________
+ *
+ * Reverses the byte order of a double
+ */
+static double swapBytes(double value){
+    unsigned char bytes[sizeof(double)];
+    memcpy(bytes, &value, sizeof(double));
+    reverse(bytes, bytes + sizeof(double));
+    memcpy(&value, bytes, sizeof(double));
+    return value;
+}
+
+/*
+ * Function: checkDistinctFiles
+ * Usage: checkDistinctFiles(input, output);
+ * ______________________________________________________
+ *
+ * Signals an error if the output would overwrite the mapped input
+ */
+static void checkDistinctFiles(const string & input, const string & output){
+    if (isSameFile(input, output)){
+        error("Output file is the input file: " + output);
+    }
+}
+
+ColumnFile::ColumnFile(const string & path) : file(path){
+    const char * data = file.data();
+    size_t size = file.size();
+    if (size < FIXED_HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0){
+        error("Not a column file: " + path);
+    }
+    unsigned long long rowField = readInteger(data + 8, 8);
+    unsigned long long count = readInteger(data + 16, 4);
+    size_t offset = readInteger(data + 20, 4);
+    if (offset > size || rowField > size / sizeof(double)){
+        error("Column file is truncated: " + path);
+    }
+    if (offset % COLUMN_ALIGNMENT != 0){
+        error("Column file has misaligned columns: " + path);
+    }
+    rows = rowField;
+    size_t p = FIXED_HEADER_SIZE;
+    for (unsigned long long i = 0; i < count; i++){
+        if (p + 4 > offset){
+            error("Column file is truncated: " + path);
+        }
+        size_t length = readInteger(data + p, 4);
+        p += 4;
+        if (p + length > offset){
+            error("Column file is truncated: " + path);
+        }
+        names.push_back(string(data + p, length));
+        p += length;
+    }
+    size_t columnBytes = paddedSize(rows * sizeof(double));
+    if (count > 0 && (size - offset) / count < columnBytes){
+        error("Column file is truncated: " + path);
+    }
+    bool native = isLittleEndian();
+    if (!native) converted.resize(count);
+    for (unsigned long long i = 0; i < count; i++){
+        const char * start = data + offset + i * columnBytes;
+        if (native){
+            columns.push_back(reinterpret_cast<const double *>(start));
+        } else {
+            converted[i].resize(rows);
+            memcpy(&converted[i][0], start, rows * sizeof(double));
+            for (long long r = 0; r < rows; r++) converted[i][r] = swapBytes(converted[i][r]);
+            columns.push_back(&converted[i][0]);
+        }
+    }
+}
+
+long long ColumnFile::rowCount() const {
+    return rows;
+}
+
+int ColumnFile::columnCount() const {
+    return names.size();
+}
+
+const string & ColumnFile::columnName(int index) const {
+    return names[index];
+}
+
+int ColumnFile::columnIndex(const string & name) const {
+    for (size_t i = 0; i < names.size(); i++){
+        if (names[i] == name) return i;
+    }
+    return -1;
+}
+
+const double * ColumnFile::column(int index) const {
+    return columns[index];
+}
+
+bool isColumnFile(const string & path){
+    ifstream input(path.c_str(), ios::binary);
+    char magic[sizeof(MAGIC)];
+    return input.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void writeColumnFile(const string & path, const vector<string> & names,
+                     const vector<const double *> & columns, long long rows){
+    ofstream out(path.c_str(), ios::binary);
+    if (!out){
+        error("Cannot write file: " + path);
+    }
+    string header(MAGIC, sizeof(MAGIC));
+    size_t headerSize = FIXED_HEADER_SIZE;
+    for (size_t i = 0; i < names.size(); i++){
+        headerSize += 4 + names[i].length();
+    }
+    appendInteger(header, rows, 8);
+    appendInteger(header, names.size(), 4);
+    appendInteger(header, paddedSize(headerSize), 4);
+    for (size_t i = 0; i < names.size(); i++){
+        appendInteger(header, names[i].length(), 4);
+        header += names[i];
+    }
+    header.resize(paddedSize(headerSize), '\0');
+    out.write(header.data(), header.size());
+
+    size_t bytes = rows * sizeof(double);
+    string padding(paddedSize(bytes) - bytes, '\0');
+    vector<double> swapped;
+    for (size_t i = 0; i < columns.size(); i++){
+        if (isLittleEndian()){
+            out.write(reinterpret_cast<const char *>(columns[i]), bytes);
+        } else {
+            swapped.resize(rows);
+            for (long long r = 0; r < rows; r++) swapped[r] = swapBytes(columns[i][r]);
+            out.write(reinterpret_cast<const char *>(&swapped[0]), bytes);
+        }
+        out.write(padding.data(), padding.size());
+    }
+    if (!out){
+        error("Cannot write file: " + path);
+    }
+}
+
+long long evaluateColumnFile(const string & input, const string & output,
+                             const string & equation, const VariableTable & variables){
+    checkDistinctFiles(input, output);
+    ColumnFile file(input);
+    vector<string> columnNames;
+    for (int c = 0; c < file.columnCount(); c++){
+        columnNames.push_back(file.columnName(c));
+    }
+    vector<int> sources;
+    vector<double> constants;
+    Expression expr = compileColumnEquation(columnNames, equation, variables, sources, constants);
+    int variableCount = expr.variableCount();
+    long long rows = file.rowCount();
+    vector<double> results(max(rows, 1LL));
+
+    ThreadPool & pool = ThreadPool::shared();
+    for (long long start = 0; start < rows; start += ROWS_PER_TASK){
+        pool.submit([&, start]{
+            int n = min(ROWS_PER_TASK, rows - start);
+            // the columns are read in place, only constants need arrays
+            vector<vector<double> > constantColumns(variableCount);
+            vector<const double *> pointers(variableCount + 1);
+            for (int v = 0; v < variableCount; v++){
+                if (sources[v] >= 0){
+                    pointers[v] = file.column(sources[v]) + start;
+                } else {
+                    constantColumns[v].assign(n, constants[v]);
+                    pointers[v] = &constantColumns[v][0];
+                }
+            }
+            expr.evaluateBatch(&pointers[0], n, &results[start]);
+        });
+    }
+    pool.wait();
+    writeColumnFile(output, vector<string>(1, "result"), vector<const double *>(1, &results[0]), rows);
+    return rows;
+}
+
+long long csvToColumnFile(const string & csvPath, const string & columnPath){
+    checkDistinctFiles(csvPath, columnPath);
+    CsvFile csv(csvPath);
+    int count = csv.columnCount();
+    vector<int> all(count);
+    vector<string> names(count);
+    for (int c = 0; c < count; c++){
+        all[c] = c;
+        names[c] = csv.columnName(c);
+    }
+    vector<vector<vector<double> > > chunks(csv.chunkCount());
+    ThreadPool & pool = ThreadPool::shared();
+    for (int chunk = 0; chunk < csv.chunkCount(); chunk++){
+        pool.submit([&, chunk]{
+            long long invalid = 0;
+            csv.readChunk(chunk, all, chunks[chunk], invalid);
+        });
+    }
+    pool.wait();
+    long long rows = 0;
+    for (size_t chunk = 0; chunk < chunks.size(); chunk++){
+        if (count > 0) rows += chunks[chunk][0].size();
+    }
+    vector<vector<double> > columns(count);
+    vector<const double *> pointers(count);
+    for (int c = 0; c < count; c++){
+        columns[c].reserve(max(rows, 1LL));
+        for (size_t chunk = 0; chunk < chunks.size(); chunk++){
+            columns[c].insert(columns[c].end(), chunks[chunk][c].begin(), chunks[chunk][c].end());
+            vector<double>().swap(chunks[chunk][c]);
+        }
+        pointers[c] = columns[c].empty() ? NULL : &columns[c][0];
+    }
+    writeColumnFile(columnPath, names, pointers, rows);
+    return rows;
+}
+
+long long columnFileToCsv(const string & columnPath, const string & csvPath){
+    checkDistinctFiles(columnPath, csvPath);
+    ColumnFile file(columnPath);
+    ofstream out(csvPath.c_str(), ios::binary);
+    if (!out){
+        error("Cannot write file: " + csvPath);
+    }
+    for (int c = 0; c < file.columnCount(); c++){
+        out << (c > 0 ? "," : "") << file.columnName(c);
+    }
+    out << "\n";
+    long long rows = file.rowCount();
+    long long tasks = (rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+    ThreadPool & pool = ThreadPool::shared();
+    for (long long first = 0; first < tasks; first += TASKS_PER_WAVE){
+        int count = min((long long) TASKS_PER_WAVE, tasks - first);
+        vector<string> texts(count);
+        for (int i = 0; i < count; i++){
+            pool.submit([&, i]{
+                long long start = (first + i) * ROWS_PER_TASK;
+                long long end = min(rows, start + ROWS_PER_TASK);
+                char buffer[32];
+                for (long long r = start; r < end; r++){
+                    for (int c = 0; c < file.columnCount(); c++){
+                        int length = snprintf(buffer, sizeof(buffer), c > 0 ? ",%.17g" : "%.17g", file.column(c)[r]);
+                        texts[i].append(buffer, length);
+                    }
+                    texts[i] += '\n';
+                }
+            });
+        }
+        pool.wait();
+        for (int i = 0; i < count; i++){
+            out << texts[i];
+        }
+    }
+    if (!out){
+        error("Cannot write file: " + csvPath);
+    }
+    return rows;
+}
@@ -0,0 +1,138 @@
+/* File: columnfile.h
+ * -----------------------------------
+ *
+ * This file exports a binary columnar file format that the evaluator
+ * reads and writes without parsing, and its converters from and to CSV.
+ *
+ * Layout (all integers little-endian):
+ *   bytes 0-7    magic "CALCCOL1"
+ *   bytes 8-15   number of rows (uint64)
+ *   bytes 16-19  number of columns (uint32)
+ *   bytes 20-23  offset of the first column (uint32), a multiple of 64
+ *   then for each column the length of its name (uint32) and the name
+ * The columns follow the header one after another, each an array of
+ * little-endian doubles padded with zeros to a multiple of 64 bytes, so
+ * every column is aligned for SIMD loads when the file is mapped.
+ */
+
+#ifndef COLUMNFILE_H
+#define COLUMNFILE_H
+
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+#include "variables.h"
+
+/* Class ColumnFile
+ * --------------------------------
+ * This class maps a columnar file and gives direct pointers to its
+ * columns. On a little-endian machine nothing is copied or converted;
+ * the evaluator reads the values straight from the mapped pages.
+ */
+class ColumnFile {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: ColumnFile
+     * Usage: ColumnFile file(path);
+     * -----------------------------------------------------
+     * Maps the file and checks its header; signals an error if it is
+     * not a columnar file or is truncated
+     */
+    explicit ColumnFile(const std::string & path);
+
+    /* Method: rowCount / columnCount
+     * Usage: long long rows = file.rowCount();
+     * -----------------------------------------------------
+     * Return the size of the table
+     */
+    long long rowCount() const;
+    int columnCount() const;
+
+    /* Method: columnName / columnIndex
+     * Usage: int index = file.columnIndex("price");
+     * -----------------------------------------------------
+     * Give the names of the columns; columnIndex returns -1 for an
+     * unknown name
+     */
+    const std::string & columnName(int index) const;
+    int columnIndex(const std::string & name) const;
+
+    /* Method: column
+     * Usage: const double * prices = file.column(index);
+     * -----------------------------------------------------
+     * Returns the values of a column, rowCount doubles
+     */
+    const double * column(int index) const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    MappedFile file;
+    long long rows;
+    std::vector<std::string> names;
+    std::vector<const double *> columns;
+
+    /* Byte-swapped copies of the columns on big-endian machines */
+    std::vector<std::vector<double> > converted;
+};
+
+/*
+ * Function: isColumnFile
+ * Usage: if (isColumnFile(path))...
+ * ______________________________________________________
+ *
+ * Returns true if the file starts with the magic of a columnar file
+ */
+bool isColumnFile(const std::string & path);
+
+/*
+ * Function: writeColumnFile
+ * Usage: writeColumnFile(path, names, columns, rows);
+ * ______________________________________________________
+ *
+ * Writes a columnar file
+ *
+ * @param path - path of the file
+ * @param names - names of the columns
+ * @param columns - values of each column, rows doubles each
+ * @param rows - number of rows
+ */
+void writeColumnFile(const std::string & path, const std::vector<std::string> & names,
+                     const std::vector<const double *> & columns, long long rows);
+
+/*
+ * Function: evaluateColumnFile
+ * Usage: long long rows = evaluateColumnFile(input, output, equation, variables);
+ * ______________________________________________________
+ *
+ * Calculates an equation for every row of a columnar file, reading the
+ * columns in place, and writes the results as the column "result" of a
+ * new columnar file. Blocks of rows are evaluated in parallel. The
+ * output cannot be the input file.
+ *
+ * @param input - path of the columnar file
+ * @param output - path of the result
+ * @param equation - equation without spaces, in lower case
+ * @param variables - declared variables, constant in every row
+ * @return - number of rows
+ */
+long long evaluateColumnFile(const std::string & input, const std::string & output,
+                             const std::string & equation, const VariableTable & variables);
+
+/*
+ * Function: csvToColumnFile / columnFileToCsv
+ * Usage: long long rows = csvToColumnFile(csvPath, columnPath);
+ * ______________________________________________________
+ *
+ * Convert between CSV and columnar files; the CSV chunks are parsed or
+ * formatted in parallel. Missing and non-numeric CSV fields become NaN.
+ * The output cannot be the input file.
+ *
+ * @return - number of rows
+ */
+long long csvToColumnFile(const std::string & csvPath, const std::string & columnPath);
+long long columnFileToCsv(const std::string & columnPath, const std::string & csvPath);
+
+#endif // COLUMNFILE_H
@@ -0,0 +1,364 @@
+/* File: csv.cpp
+ * -----------------------------------
+ *
+ * Implementation of CSV reading and evaluation.
+ */
+
+#include "csv.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "builtins.h"
+#include "calc.h"
+#include "error.h"
+#include "expression.h"
+#include "functions.h"
+#include "threadpool.h"
+
+using namespace std;
+
+/* Powers of ten that are exact doubles */
+static const double EXACT_POWERS_OF_TEN[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Largest integer up to which every integer is a double */
+static const unsigned long long EXACT_INTEGER_LIMIT = 1ULL << 53;
+
+/* Longest number copied for strtod */
+static const int MAX_NUMBER_LENGTH = 64;
+
+/* Chunks evaluated before their results are written */
+static const int CHUNKS_PER_WAVE = 64;
+
+/*
+ * Function: isDigit
+ * Usage: if (isDigit(ch))...
+ * ______________________________________________________
+ *
+ * Returns true for '0'..'9' (isNumber also accepts the decimal point)
+ */
+static bool isDigit(char ch){
+    return '0' <= ch && ch <= '9';
+}
+
+/*
+ * Function: fieldEnd
+ * Usage: const char * end = fieldEnd(begin, lineEnd, contentBegin, contentEnd);
+ * ______________________________________________________
+ *
+ * Finds the end of the field starting at begin (the comma or the end of
+ * the line) and the text of the field without its quotes
+ */
+static const char * fieldEnd(const char * begin, const char * lineEnd,
+                             const char * & contentBegin, const char * & contentEnd){
+    const char * p = begin;
+    while (p < lineEnd && *p == ' ') p++;
+    if (p < lineEnd && *p == '"'){
+        contentBegin = p + 1;
+        const char * quote = static_cast<const char *>(memchr(contentBegin, '"', lineEnd - contentBegin));
+        contentEnd = quote != NULL ? quote : lineEnd;
+        p = contentEnd;
+    } else {
+        contentBegin = begin;
+        p = begin;
+    }
+    const char * comma = static_cast<const char *>(memchr(p, ',', lineEnd - p));
+    const char * end = comma != NULL ? comma : lineEnd;
+    if (contentBegin == begin) contentEnd = end;
+    return end;
+}
+
+/*
+ * Function: lineEnd
+ * Usage: const char * end = lineEnd(begin, limit, next);
+ * ______________________________________________________
+ *
+ * Returns the end of the line starting at begin, without "\r", and the
+ * start of the next line in next
+ */
+static const char * lineEnd(const char * begin, const char * limit, const char * & next){
+    const char * newline = static_cast<const char *>(memchr(begin, '\n', limit - begin));
+    const char * end = newline != NULL ? newline : limit;
+    next = newline != NULL ? newline + 1 : limit;
+    if (end > begin && end[-1] == '\r') end--;
+    return end;
+}
+
+bool parseNumber(const char * begin, const char * end, double & value){
+    const char * p = begin;
+    while (p < end && *p == ' ') p++;
+    while (end > p && end[-1] == ' ') end--;
+    const char * start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')){
+        negative = *p == '-';
+        p++;
+    }
+    // up to 19 significant digits in an integer, the others only move
+    // the decimal exponent
+    unsigned long long mantissa = 0;
+    int significant = 0, exponent = 0, digits = 0;
+    bool truncated = false;
+    for (; p < end && isDigit(*p); p++, digits++){
+        if (significant < 19){
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0) significant++;
+        } else {
+            exponent++;
+            truncated |= *p != '0';
+        }
+    }
+    if (p < end && *p == '.'){
+        for (p++; p < end && isDigit(*p); p++, digits++){
+            if (significant < 19){
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0) significant++;
+                exponent--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+    if (digits == 0) return false;
+    if (p < end && (*p == 'e' || *p == 'E')){
+        p++;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')){
+            negativeExponent = *p == '-';
+            p++;
+        }
+        if (p == end || !isDigit(*p)) return false;
+        int power = 0;
+        for (; p < end && isDigit(*p); p++){
+            if (power < 100000) power = power * 10 + (*p - '0');
+        }
+        exponent += negativeExponent ? -power : power;
+    }
+    if (p != end) return false;
+    if (!truncated && mantissa <= EXACT_INTEGER_LIMIT && exponent >= -22 && exponent <= 22){
+        // both operands are exact, so the one rounding is correct
+        double res = (double) mantissa;
+        res = exponent < 0 ? res / EXACT_POWERS_OF_TEN[-exponent] : res * EXACT_POWERS_OF_TEN[exponent];
+        value = negative ? -res : res;
+        return true;
+    }
+    char text[MAX_NUMBER_LENGTH + 1];
+    if (end - start <= MAX_NUMBER_LENGTH){
+        memcpy(text, start, end - start);
+        text[end - start] = '\0';
+        value = strtod(text, NULL);
+    } else {
+        value = strtod(string(start, end).c_str(), NULL);
+    }
+    return true;
+}
+
+CsvFile::CsvFile(const string & path) : file(path){
+    const char * data = file.data();
+    const char * limit = data + file.size();
+    const char * p = data;
+    // skip the byte order mark of UTF-8 files
+    if (file.size() >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3;
+    if (p == limit){
+        error("CSV file has no header: " + path);
+    }
+    const char * next;
+    const char * end = lineEnd(p, limit, next);
+    while (true){
+        const char * contentBegin;
+        const char * contentEnd;
+        const char * fieldLimit = fieldEnd(p, end, contentBegin, contentEnd);
+        names.push_back(toLowerCase(trim(string(contentBegin, contentEnd))));
+        if (fieldLimit == end) break;
+        p = fieldLimit + 1;
+    }
+    size_t offset = next - data;
+    chunkStarts.push_back(offset);
+    while (offset < file.size()){
+        size_t cut = offset + CHUNK_BYTES;
+        if (cut >= file.size()){
+            offset = file.size();
+        } else {
+            const char * newline = static_cast<const char *>(memchr(data + cut, '\n', file.size() - cut));
+            offset = newline != NULL ? newline - data + 1 : file.size();
+        }
+        chunkStarts.push_back(offset);
+    }
+    if (chunkStarts.size() == 1) chunkStarts.push_back(offset);
+}
+
+int CsvFile::columnCount() const {
+    return names.size();
+}
+
+const string & CsvFile::columnName(int index) const {
+    return names[index];
+}
+
+int CsvFile::columnIndex(const string & name) const {
+    for (size_t i = 0; i < names.size(); i++){
+        if (names[i] == name) return i;
+    }
+    return -1;
+}
+
+int CsvFile::chunkCount() const {
+    return chunkStarts.size() - 1;
+}
+
+int CsvFile::readChunk(int chunk, const vector<int> & columns,
+                       vector<vector<double> > & values, long long & invalid) const {
+    // slot of each column of the file in values, -1 if not read
+    vector<int> slots(names.size(), -1);
+    int lastColumn = -1;
+    for (size_t k = 0; k < columns.size(); k++){
+        slots[columns[k]] = k;
+        lastColumn = max(lastColumn, columns[k]);
+    }
+    values.resize(columns.size());
+    for (size_t k = 0; k < columns.size(); k++) values[k].clear();
+    const char * p = file.data() + chunkStarts[chunk];
+    const char * limit = file.data() + chunkStarts[chunk + 1];
+    int rows = 0;
+    while (p < limit){
+        const char * next;
+        const char * end = lineEnd(p, limit, next);
+        if (end == p){
+            p = next;
+            continue;
+        }
+        for (size_t k = 0; k < columns.size(); k++) values[k].push_back(NAN);
+        const char * field = p;
+        for (int column = 0; column <= lastColumn; column++){
+            const char * contentBegin;
+            const char * contentEnd;
+            const char * fieldLimit = fieldEnd(field, end, contentBegin, contentEnd);
+            if (slots[column] >= 0 && !parseNumber(contentBegin, contentEnd, values[slots[column]][rows])){
+                values[slots[column]][rows] = NAN;
+            }
+            // the missing fields of a short line stay NaN
+            if (fieldLimit == end) break;
+            field = fieldLimit + 1;
+        }
+        for (size_t k = 0; k < columns.size(); k++){
+            if (isnan(values[k][rows])) invalid++;
+        }
+        rows++;
+        p = next;
+    }
+    return rows;
+}
+
+Expression compileColumnEquation(const vector<string> & columnNames, const string & equation,
+                                 const VariableTable & variables, vector<int> & sources, vector<double> & constants){
+    // variables of the equation: the columns with usable names, then the
+    // declared variables, which stay constant
+    VectorSHPP<string> names;
+    sources.clear();
+    constants.clear();
+    for (size_t c = 0; c < columnNames.size(); c++){
+        const string & name = columnNames[c];
+        if (!name.empty() && isFunction(name) && !Expression::isFunctionName(name) && !isBuiltinName(name)){
+            names.add(name);
+            sources.push_back(c);
+            constants.push_back(0);
+        }
+    }
+    for (int i = 0; i < variables.size(); i++){
+        string name = variables.names().get(i);
+        if (find(columnNames.begin(), columnNames.end(), name) == columnNames.end()){
+            names.add(name);
+            sources.push_back(-1);
+            constants.push_back(stringToDouble(variables.get(name)));
+        }
+    }
+    VectorSHPP<string> polishRecord = polishInvertedRecord(equation);
+    bindBuiltins(polishRecord);
+    return compileEquation(polishRecord, names);
+}
+
+long long evaluateCsv(const string & input, const string & output, const string & equation,
+                      const VariableTable & variables, long long & invalid){
+    if (output != "-" && isSameFile(input, output)){
+        error("Output file is the input file: " + output);
+    }
+    CsvFile file(input);
+    vector<string> columnNames;
+    for (int c = 0; c < file.columnCount(); c++){
+        columnNames.push_back(file.columnName(c));
+    }
+    vector<int> sources;
+    vector<double> constants;
+    Expression expr = compileColumnEquation(columnNames, equation, variables, sources, constants);
+    int variableCount = expr.variableCount();
+
+    // only the columns the equation uses are parsed
+    vector<int> slots(variableCount, -1);
+    vector<int> columns;
+    for (int i = 0; i < expr.size(); i++){
+        const Instruction & ins = expr.instruction(i);
+        if (ins.op == PUSH_VARIABLE && sources[ins.operand] >= 0 && slots[ins.operand] < 0){
+            slots[ins.operand] = columns.size();
+            columns.push_back(sources[ins.operand]);
+        }
+    }
+
+    ofstream stream;
+    if (output != "-"){
+        stream.open(output.c_str());
+        if (!stream){
+            error("Cannot write file: " + output);
+        }
+    }
+    ostream & out = output == "-" ? cout : stream;
+    out << "result\n";
+
+    ThreadPool & pool = ThreadPool::shared();
+    atomic<long long> rows(0), invalidFields(0);
+    for (int first = 0; first < file.chunkCount(); first += CHUNKS_PER_WAVE){
+        int count = min(CHUNKS_PER_WAVE, file.chunkCount() - first);
+        vector<string> texts(count);
+        for (int i = 0; i < count; i++){
+            pool.submit([&, i]{
+                vector<vector<double> > values;
+                long long chunkInvalid = 0;
+                int n = file.readChunk(first + i, columns, values, chunkInvalid);
+                if (n == 0) return;
+                vector<vector<double> > constantColumns(variableCount);
+                vector<const double *> pointers(variableCount + 1, (const double *) NULL);
+                for (int v = 0; v < variableCount; v++){
+                    if (slots[v] >= 0){
+                        pointers[v] = &values[slots[v]][0];
+                    } else if (sources[v] < 0){
+                        constantColumns[v].assign(n, constants[v]);
+                        pointers[v] = &constantColumns[v][0];
+                    }
+                }
+                vector<double> results(n);
+                expr.evaluateBatch(&pointers[0], n, &results[0]);
+                string & text = texts[i];
+                char buffer[32];
+                for (int r = 0; r < n; r++){
+                    int length = snprintf(buffer, sizeof(buffer), "%.17g\n", results[r]);
+                    text.append(buffer, length);
+                }
+                rows += n;
+                invalidFields += chunkInvalid;
+            });
+        }
+        pool.wait();
+        for (int i = 0; i < count; i++){
+            out << texts[i];
+        }
+    }
+    out.flush();
+    invalid = invalidFields;
+    return rows;
+}
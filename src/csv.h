@@ -0,0 +1,135 @@
+/* File: csv.h
+ * -----------------------------------
+ *
+ * This file exports reading of numeric CSV files by columns and the
+ * evaluation of an equation over every row of such a file.
+ */
+
+#ifndef CSV_H
+#define CSV_H
+
+#include <string>
+#include <vector>
+#include "expression.h"
+#include "mappedfile.h"
+#include "variables.h"
+
+/*
+ * Function: parseNumber
+ * Usage: if (parseNumber(begin, end, value))...
+ * ______________________________________________________
+ *
+ * Parses a decimal number such as -12.5e3, with optional spaces around
+ * it. Numbers of up to 19 significant digits and small exponents are
+ * converted with one exact operation on doubles (the result is correctly
+ * rounded); other numbers go through strtod.
+ *
+ * @param begin - first character of the text
+ * @param end - end of the text
+ * @param value - receives the number
+ * @return - false if the text is not a number
+ */
+bool parseNumber(const char * begin, const char * end, double & value);
+
+/* Class CsvFile
+ * --------------------------------
+ * This class reads a CSV file whose first line names the columns. The
+ * file is mapped into memory and cut at line ends into chunks of about
+ * a megabyte, which can be parsed independently, in parallel. Fields
+ * may be quoted, but a quoted field cannot contain a line break.
+ */
+class CsvFile {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: CsvFile
+     * Usage: CsvFile file(path);
+     * -----------------------------------------------------
+     * Opens the file and reads its header
+     */
+    explicit CsvFile(const std::string & path);
+
+    /* Method: columnCount / columnName / columnIndex
+     * Usage: int index = file.columnIndex("price");
+     * -----------------------------------------------------
+     * Give the columns of the header; names are trimmed and in lower
+     * case. columnIndex returns -1 for an unknown name.
+     */
+    int columnCount() const;
+    const std::string & columnName(int index) const;
+    int columnIndex(const std::string & name) const;
+
+    /* Method: chunkCount
+     * Usage: int chunks = file.chunkCount();
+     * -----------------------------------------------------
+     * Returns the number of chunks of the data lines
+     */
+    int chunkCount() const;
+
+    /* Method: readChunk
+     * Usage: int rows = file.readChunk(chunk, columns, values, invalid);
+     * -----------------------------------------------------
+     * Parses the rows of a chunk; values[k] receives the numbers of column
+     * columns[k]. Missing or non-numeric fields give NaN and are counted
+     * in invalid. Empty lines are skipped. Returns the number of rows.
+     */
+    int readChunk(int chunk, const std::vector<int> & columns,
+                  std::vector<std::vector<double> > & values, long long & invalid) const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Approximate size of a chunk in bytes */
+    static const size_t CHUNK_BYTES = 1 << 20;
+
+    MappedFile file;
+    std::vector<std::string> names;
+
+    /* Offsets of the chunks, followed by the size of the file */
+    std::vector<size_t> chunkStarts;
+};
+
+/*
+ * Function: compileColumnEquation
+ * Usage: Expression expr = compileColumnEquation(columnNames, equation, variables, sources, constants);
+ * ______________________________________________________
+ *
+ * Compiles an equation over the columns of a table. Its variables are
+ * the columns whose names are identifiers, followed by the declared
+ * variables that are not columns.
+ *
+ * @param columnNames - names of the columns of the table
+ * @param equation - equation without spaces, in lower case
+ * @param variables - declared variables
+ * @param sources - receives the column of each variable, -1 for a constant
+ * @param constants - receives the value of each constant variable
+ * @return - the compiled equation
+ */
+Expression compileColumnEquation(const std::vector<std::string> & columnNames, const std::string & equation,
+                                 const VariableTable & variables, std::vector<int> & sources,
+                                 std::vector<double> & constants);
+
+/*
+ * Function: evaluateCsv
+ * Usage: long long rows = evaluateCsv(input, output, equation, variables);
+ * ______________________________________________________
+ *
+ * Calculates an equation for every row of a CSV file and writes the
+ * results as a one-column CSV file. The equation uses the column names
+ * as variables, and the declared variables as constants. Chunks of the
+ * file are parsed and evaluated in parallel, in waves, and written in
+ * order. The output cannot be the input file, which is read while the
+ * results are written.
+ *
+ * @param input - path of the CSV file
+ * @param output - path of the result, "-" for the console
+ * @param equation - equation without spaces, in lower case
+ * @param variables - declared variables
+ * @param invalid - receives the number of missing or non-numeric fields
+ * @return - number of rows written
+ */
+long long evaluateCsv(const std::string & input, const std::string & output, const std::string & equation,
+                      const VariableTable & variables, long long & invalid);
+
+#endif // CSV_H
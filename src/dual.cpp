@@ -0,0 +1,235 @@
+/* File: dual.cpp
+ * -----------------------------------
+ *
+ * Implementation of forward-mode automatic differentiation.
+ * A stack slot holds one dual number per row of the block:
+ * component 0 is the value, component 1 + v the derivative by
+ * variable v, each stored as an array of blockRows doubles.
+ * Both branches of a conditional run for every row and the condition
+ * selects the value and derivatives of one of them.
+ */
+
+#include "dual.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "builtins.h"
+
+using namespace std;
+
+double evaluateGradient(const Expression & expr, const double * values, double * gradient){
+    int variables = expr.variableCount();
+    vector<const double *> columns(variables + 1);
+    vector<double *> gradients(variables + 1);
+    for (int v = 0; v < variables; v++){
+        columns[v] = values + v;
+        gradients[v] = gradient + v;
+    }
+    double result;
+    evaluateGradientBatch(expr, &columns[0], 1, &result, &gradients[0]);
+    return result;
+}
+
+void evaluateGradientBatch(const Expression & expr, const double * const * columns, int rows,
+                           double * results, double * const * gradients){
+    if (rows <= 0) return;
+    int components = expr.variableCount() + 1;
+    int slotCount = (expr.stackDepth() + expr.tempCount() + expr.branchCount()) * components + expr.branchCount();
+    int blockRows = max(1, min(min(rows, (int) Expression::BLOCK_ROWS), Expression::MAX_BLOCK_VALUES / slotCount));
+    int slotSize = components * blockRows;
+    // and for each level of conditionals, the mask of the rows of the
+    // first branch and the dual numbers of that branch
+    int levelSize = blockRows + slotSize;
+    vector<double> workspace((size_t) slotCount * blockRows);
+    // per-row factors of the chain rule for the current instruction
+    vector<double> factorArray(blockRows), secondFactorArray(blockRows);
+    double * slots = &workspace[0];
+    double * temporaries = slots + expr.stackDepth() * slotSize;
+    double * levels = temporaries + expr.tempCount() * slotSize;
+    vector<int> ends;
+    double * factor = &factorArray[0];
+    double * secondFactor = &secondFactorArray[0];
+
+    for (int start = 0; start < rows; start += blockRows){
+        int n = min(blockRows, rows - start);
+        EvaluationBudget::charge((long long) expr.size() * n);
+        int top = 0;
+        for (int i = 0; ; i++){
+            while (!ends.empty() && ends.back() == i){
+                double * a = slots + (top - 1) * slotSize;
+                const double * mask = levels + (ends.size() - 1) * levelSize;
+                const double * first = mask + blockRows;
+                for (int c = 0; c < components; c++){
+                    for (int r = 0; r < n; r++){
+                        a[c * blockRows + r] = mask[r] != 0 ? first[c * blockRows + r] : a[c * blockRows + r];
+                    }
+                }
+                ends.pop_back();
+            }
+            if (i == expr.size()) break;
+            const Instruction & ins = expr.instruction(i);
+            if (ins.op == PUSH_CONSTANT || ins.op == PUSH_VARIABLE){
+                double * dst = slots + top * slotSize;
+                if (ins.op == PUSH_CONSTANT){
+                    double value = expr.constant(ins.operand);
+                    for (int r = 0; r < n; r++) dst[r] = value;
+                } else {
+                    const double * src = columns[ins.operand] + start;
+                    for (int r = 0; r < n; r++) dst[r] = src[r];
+                }
+                for (int c = 1; c < components; c++){
+                    double seed = ins.op == PUSH_VARIABLE && c == ins.operand + 1 ? 1 : 0;
+                    double * d = dst + c * blockRows;
+                    for (int r = 0; r < n; r++) d[r] = seed;
+                }
+                top++;
+            } else if (ins.op == STORE_TEMP){
+                const double * src = slots + (top - 1) * slotSize;
+                double * temp = temporaries + ins.operand * slotSize;
+                for (int k = 0; k < slotSize; k++) temp[k] = src[k];
+            } else if (ins.op == LOAD_TEMP){
+                const double * temp = temporaries + ins.operand * slotSize;
+                double * dst = slots + top * slotSize;
+                for (int k = 0; k < slotSize; k++) dst[k] = temp[k];
+                top++;
+            } else if (ins.op == CALL){
+                error("The gradient mode does not support calls of functions that are not inlined");
+            } else if (ins.op == BUILTIN){
+                // chain rule over the arguments: f' = sum of df/da_k a_k'
+                int count = builtinArgumentCount(ins.operand);
+                top -= count - 1;
+                double * a = slots + (top - 1) * slotSize;
+                vector<double> args(count), partials(count);
+                for (int r = 0; r < n; r++){
+                    for (int k = 0; k < count; k++) args[k] = a[k * slotSize + r];
+                    for (int k = 0; k < count; k++){
+                        const double * da = a + k * slotSize + r;
+                        bool reached = false;
+                        for (int c = 1; c < components && !reached; c++) reached = da[c * blockRows] != 0;
+                        partials[k] = reached ? BuiltinRegistry::shared().partial(ins.operand, k).evaluate(&args[0]) : 0;
+                    }
+                    for (int c = 1; c < components; c++){
+                        double sum = 0;
+                        for (int k = 0; k < count; k++){
+                            if (partials[k] != 0) sum += partials[k] * a[k * slotSize + c * blockRows + r];
+                        }
+                        a[c * blockRows + r] = sum;
+                    }
+                    a[r] = evaluateBuiltin(ins.operand, &args[0]);
+                }
+            } else if (ins.op == JUMP_IF_FALSE || ins.op == JUMP_IF_TRUE){
+                top--;
+                const double * condition = slots + top * slotSize;
+                double * mask = levels + ends.size() * levelSize;
+                double whenTrue = ins.op == JUMP_IF_FALSE ? 1 : 0;
+                for (int r = 0; r < n; r++) mask[r] = condition[r] != 0 ? whenTrue : 1 - whenTrue;
+                int second = i + ins.operand;
+                ends.push_back(second - 1 + expr.instruction(second - 1).operand);
+            } else if (ins.op == JUMP){
+                // keep the first branch and run the second one too
+                top--;
+                const double * src = slots + top * slotSize;
+                double * first = levels + (ends.size() - 1) * levelSize + blockRows;
+                for (int k = 0; k < slotSize; k++) first[k] = src[k];
+            } else if (Expression::isComparison(ins.op)){
+                // a comparison is constant where it is differentiable
+                top--;
+                double * a = slots + (top - 1) * slotSize;
+                const double * b = slots + top * slotSize;
+                for (int r = 0; r < n; r++) a[r] = Expression::compare(ins.op, a[r], b[r]) ? 1 : 0;
+                for (int k = blockRows; k < slotSize; k++) a[k] = 0;
+            } else if (ins.op <= POWER){
+                top--;
+                double * a = slots + (top - 1) * slotSize;
+                const double * b = slots + top * slotSize;
+                switch (ins.op){
+                case ADD:
+                    for (int k = 0; k < components * blockRows; k++) a[k] += b[k];
+                    break;
+                case SUBTRACT:
+                    for (int k = 0; k < components * blockRows; k++) a[k] -= b[k];
+                    break;
+                case MULTIPLY:
+                    // (u v)' = u' v + u v'
+                    for (int c = 1; c < components; c++){
+                        double * da = a + c * blockRows;
+                        const double * db = b + c * blockRows;
+                        for (int r = 0; r < n; r++) da[r] = da[r] * b[r] + a[r] * db[r];
+                    }
+                    for (int r = 0; r < n; r++) a[r] *= b[r];
+                    break;
+                case DIVIDE:
+                    // (u / v)' = (u' - (u / v) v') / v
+                    for (int r = 0; r < n; r++) a[r] /= b[r];
+                    for (int c = 1; c < components; c++){
+                        double * da = a + c * blockRows;
+                        const double * db = b + c * blockRows;
+                        for (int r = 0; r < n; r++) da[r] = (da[r] - a[r] * db[r]) / b[r];
+                    }
+                    break;
+                default:
+                    // (u^v)' = v u^(v-1) u' + u^v ln(u) v'; the second term
+                    // is skipped when v' = 0, so negative bases keep working
+                    for (int r = 0; r < n; r++){
+                        double value = pow(a[r], b[r]);
+                        factor[r] = b[r] * pow(a[r], b[r] - 1);
+                        secondFactor[r] = value * log(a[r]);
+                        a[r] = value;
+                    }
+                    for (int c = 1; c < components; c++){
+                        double * da = a + c * blockRows;
+                        const double * db = b + c * blockRows;
+                        for (int r = 0; r < n; r++){
+                            da[r] = factor[r] * da[r] + (db[r] != 0 ? secondFactor[r] * db[r] : 0);
+                        }
+                    }
+                    break;
+                }
+            } else {
+                double * a = slots + (top - 1) * slotSize;
+                switch (ins.op){
+                case SIN:
+                    for (int r = 0; r < n; r++){
+                        factor[r] = cos(a[r]);
+                        a[r] = sin(a[r]);
+                    }
+                    break;
+                case COS:
+                    for (int r = 0; r < n; r++){
+                        factor[r] = -sin(a[r]);
+                        a[r] = cos(a[r]);
+                    }
+                    break;
+                case SQRT:
+                    for (int r = 0; r < n; r++){
+                        a[r] = sqrt(a[r]);
+                        factor[r] = 0.5 / a[r];
+                    }
+                    break;
+                case TAN:
+                    for (int r = 0; r < n; r++){
+                        a[r] = tan(a[r]);
+                        factor[r] = 1 + a[r] * a[r];
+                    }
+                    break;
+                default:
+                    for (int r = 0; r < n; r++){
+                        factor[r] = 1 / a[r];
+                        a[r] = log(a[r]);
+                    }
+                    break;
+                }
+                // chain rule: f(u)' = f'(u) u'
+                for (int c = 1; c < components; c++){
+                    double * da = a + c * blockRows;
+                    for (int r = 0; r < n; r++) da[r] *= factor[r];
+                }
+            }
+        }
+        for (int r = 0; r < n; r++) results[start + r] = slots[r];
+        for (int c = 1; c < components; c++){
+            const double * d = slots + c * blockRows;
+            for (int r = 0; r < n; r++) gradients[c - 1][start + r] = d[r];
+        }
+    }
+}
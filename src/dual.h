@@ -0,0 +1,47 @@
+/* File: dual.h
+ * -----------------------------------
+ *
+ * This file exports forward-mode automatic differentiation of
+ * compiled expressions with dual numbers.
+ */
+
+#ifndef DUAL_H
+#define DUAL_H
+
+#include "expression.h"
+
+/*
+ * Function: evaluateGradient
+ * Usage: double value = evaluateGradient(expr, values, gradient);
+ * ______________________________________________________
+ *
+ * Evaluates the expression together with its partial derivatives
+ * with respect to every variable of the expression, in one pass.
+ *
+ * @param expr - compiled expression
+ * @param values - value of each variable
+ * @param gradient - receives the derivative by each variable
+ * @return - value of the expression
+ */
+double evaluateGradient(const Expression & expr, const double * values, double * gradient);
+
+/*
+ * Function: evaluateGradientBatch
+ * Usage: evaluateGradientBatch(expr, columns, rows, results, gradients);
+ * ______________________________________________________
+ *
+ * Evaluates the expression and its gradient for each row. Each value is
+ * a dual number: the value and one derivative per variable, kept as
+ * separate arrays over a block of rows, so every rule of differentiation
+ * is a loop over the rows that the compiler vectorizes.
+ *
+ * @param expr - compiled expression
+ * @param columns - columns[v][row] is the value of variable v
+ * @param rows - number of rows
+ * @param results - receives the value of each row
+ * @param gradients - gradients[v][row] receives the derivative by variable v
+ */
+void evaluateGradientBatch(const Expression & expr, const double * const * columns, int rows,
+                           double * results, double * const * gradients);
+
+#endif // DUAL_H
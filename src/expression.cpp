@@ -0,0 +1,692 @@
+/* File: expression.cpp
+ * -----------------------------------
+ *
+ * Implementation of the Expression class.
+ */
+
+#include "expression.h"
+#include <algorithm>
+#include <cfenv>
+#include <cmath>
+#include "builtins.h"
+#include "functions.h"
+#include "interval.h"
+#include "strlib.h"
+
+using namespace std;
+
+bool Expression::memoizedByDefault = false;
+
+/* Doubles in a block of the frame stack, unless a frame needs more */
+static const size_t FRAME_BLOCK = 4096;
+
+/* Class FrameStack
+ * --------------------------------
+ * Workspaces of the calls of user functions in progress on a thread,
+ * taken and given back in stack order. Blocks are never freed or moved,
+ * so the frame of a caller stays in place while it calls.
+ */
+class FrameStack {
+public:
+    size_t block;
+    size_t used;
+    int depth;
+
+    FrameStack() : block(0), used(0), depth(0), blocks(1, vector<double>(FRAME_BLOCK)) {}
+
+    double * allocate(size_t size){
+        if (used + size > blocks[block].size()){
+            // the blocks above the current one are free
+            block++;
+            used = 0;
+            if (block == blocks.size()){
+                blocks.push_back(vector<double>(max(size, FRAME_BLOCK)));
+            } else if (blocks[block].size() < size){
+                blocks[block].assign(size, 0);
+            }
+        }
+        double * frame = &blocks[block][used];
+        used += size;
+        return frame;
+    }
+
+private:
+    vector<vector<double> > blocks;
+};
+
+/*
+ * Function: localFrames
+ * Usage: FrameStack & frames = localFrames();
+ * ______
+ *
+ * Returns the frame stack of the calling thread
+ */
+static FrameStack & localFrames(){
+    thread_local FrameStack frames;
+    return frames;
+}
+
+Expression::Expression(){
+    depth = 0;
+    maxDepth = 0;
+    temps = 0;
+    branches = 0;
+    memoized = memoizedByDefault;
+    append(PUSH_CONSTANT, addConstant("0"));
+}
+
+Expression::Expression(const VectorSHPP<string> & variables){
+    for (int i = 0; i < variables.size(); i++){
+        variableNames.push_back(variables.get(i));
+    }
+    depth = 0;
+    maxDepth = 0;
+    temps = 0;
+    branches = 0;
+    memoized = memoizedByDefault;
+}
+
+Expression::Expression(VectorSHPP<string> & records, const VectorSHPP<string> & variables){
+    for (int i = 0; i < variables.size(); i++){
+        variableNames.push_back(variables.get(i));
+    }
+    depth = 0;
+    maxDepth = 0;
+    temps = 0;
+    branches = 0;
+    memoized = memoizedByDefault;
+    // a conditional needs a jump after the code of its condition and of
+    // its first branch: find the conditional whose operand each token ends
+    vector<int> owners(records.size(), -1);
+    vector<int> values;
+    for (int i = 0; i < records.size(); i++){
+        int count = operandCount(records[i]);
+        if ((int) values.size() < count) error("Incorrect data entered");
+        if (records[i] == "&&" || records[i] == "||" || isConditional(records[i])){
+            owners[values[values.size() - count]] = i;
+            if (count == 3) owners[values[values.size() - 2]] = i;
+        }
+        values.resize(values.size() - count);
+        values.push_back(i);
+    }
+    // the jumps of each conditional, to land when it ends
+    vector<int> tests(records.size(), -1);
+    vector<int> skips(records.size(), -1);
+    for (int i = 0; i < records.size(); i++){
+        string element = records[i];
+        OpCode op;
+        int id;
+        if (isBuiltinToken(element, id)){
+            append(BUILTIN, id);
+        } else if (isNumber(element[0]) || isNumber(element[1])){
+            append(PUSH_CONSTANT, addConstant(element));
+        } else if (isFunctionName(element)){
+            if (element == "sin"){
+                append(SIN);
+            } else if (element == "cos"){
+                append(COS);
+            } else if (element == "sqrt"){
+                append(SQRT);
+            } else if (element == "tan"){
+                append(TAN);
+            } else {
+                append(LOG);
+            }
+        } else if (isFunction(element)){
+            vector<string>::iterator it = find(variableNames.begin(), variableNames.end(), element);
+            if (it == variableNames.end()){
+                error("Unknown variable: " + element);
+            }
+            append(PUSH_VARIABLE, it - variableNames.begin());
+        } else if (isConditional(element)){
+            landJump(skips[i]);
+        } else if (element[element.length() - 1] == ')'){
+            append(CALL, resolveCall(element));
+        } else if (element == "&&" || element == "||"){
+            // a && b is if(a, b != 0, 0), a || b is if(a == 0, b != 0, 1)
+            append(PUSH_CONSTANT, addConstant("0"));
+            append(NOT_EQUAL);
+            int skip = appendJump(JUMP);
+            landJump(tests[i]);
+            append(PUSH_CONSTANT, addConstant(element == "&&" ? "0" : "1"));
+            landJump(skip);
+        } else if (isOperatorToken(element, op)){
+            append(op);
+        }
+        int owner = owners[i];
+        if (owner >= 0 && tests[owner] < 0){
+            // the condition of a conditional ends here
+            tests[owner] = appendJump(records[owner] == "||" ? JUMP_IF_TRUE : JUMP_IF_FALSE);
+        } else if (owner >= 0){
+            // and here its first branch
+            skips[owner] = appendJump(JUMP);
+            landJump(tests[owner]);
+        }
+    }
+    if (depth != 1){
+        error("Incorrect data entered");
+    }
+}
+
+int Expression::operandCount(const string & element){
+    OpCode op;
+    int id;
+    if (isBuiltinToken(element, id)) return builtinArgumentCount(id);
+    if (isNumber(element[0]) || isNumber(element[1])) return 0;
+    if (isFunctionName(element)) return 1;
+    if (isFunction(element)) return 0;
+    if (isConditional(element)) return 3;
+    if (element[element.length() - 1] == ')'){
+        return FunctionRegistry::shared().function(resolveCall(element)).parameters.size();
+    }
+    if (element == "&&" || element == "||" || isOperatorToken(element, op)) return 2;
+    error("Incorrect data entered");
+    return 0;
+}
+
+int Expression::addConstant(const string & text){
+    constants.push_back(stringToDouble(text));
+    constantTexts.push_back(text);
+    return constants.size() - 1;
+}
+
+void Expression::append(OpCode op, int operand){
+    // track the stack to reject code with missing operands
+    if (op == PUSH_CONSTANT || op == PUSH_VARIABLE || op == LOAD_TEMP){
+        depth++;
+    } else if (op >= JUMP){
+        error("Incorrect data entered");
+    } else if (isBinary(op)){
+        if (depth < 2) error("Incorrect data entered");
+        depth--;
+    } else if (op == CALL || op == BUILTIN){
+        int arguments = op == BUILTIN ? builtinArgumentCount(operand)
+                      : FunctionRegistry::shared().function(operand).parameters.size();
+        if (depth < arguments) error("Incorrect data entered");
+        depth -= arguments - 1;
+    } else if (depth < 1){
+        error("Incorrect data entered");
+    }
+    if (op == STORE_TEMP || op == LOAD_TEMP){
+        temps = max(temps, operand + 1);
+    }
+    maxDepth = max(maxDepth, depth);
+    Instruction ins = { op, operand };
+    code.push_back(ins);
+}
+
+int Expression::appendJump(OpCode jump){
+    // the value of the condition, or of the first branch, leaves the stack
+    if (depth < 1){
+        error("Incorrect data entered");
+    }
+    depth--;
+    if (jump != JUMP) branches++;
+    Instruction ins = { jump, 0 };
+    code.push_back(ins);
+    return code.size() - 1;
+}
+
+void Expression::landJump(int index){
+    code[index].operand = code.size() - index;
+}
+
+int Expression::size() const {
+    return code.size();
+}
+
+const Instruction & Expression::instruction(int index) const {
+    return code[index];
+}
+
+double Expression::constant(int index) const {
+    return constants[index];
+}
+
+const string & Expression::constantText(int index) const {
+    return constantTexts[index];
+}
+
+int Expression::variableCount() const {
+    return variableNames.size();
+}
+
+const string & Expression::variableName(int index) const {
+    return variableNames[index];
+}
+
+int Expression::stackDepth() const {
+    return maxDepth;
+}
+
+int Expression::tempCount() const {
+    return temps;
+}
+
+int Expression::branchCount() const {
+    return branches;
+}
+
+bool Expression::isComplete() const {
+    return depth == 1;
+}
+
+void Expression::setMemoized(bool on){
+    memoized = on;
+}
+
+bool Expression::isMemoized() const {
+    return memoized;
+}
+
+void Expression::setMemoizedByDefault(bool on){
+    memoizedByDefault = on;
+}
+
+bool Expression::isMemoizedByDefault(){
+    return memoizedByDefault;
+}
+
+bool Expression::isFunctionName(const string & name){
+    return name == "sin" || name == "cos" || name == "sqrt" || name == "tan" || name == "log";
+}
+
+bool Expression::isOperatorToken(const string & token, OpCode & op){
+    static const char * const tokens[] = { "+", "-", "*", "/", "^", "<", ">", "<=", ">=", "==", "!=" };
+    static const OpCode codes[] = { ADD, SUBTRACT, MULTIPLY, DIVIDE, POWER,
+                                    LESS, GREATER, LESS_EQUAL, GREATER_EQUAL, EQUAL, NOT_EQUAL };
+    for (int i = 0; i < 11; i++){
+        if (token == tokens[i]){
+            op = codes[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Expression::isBinary(OpCode op){
+    return (op >= ADD && op <= POWER) || isComparison(op);
+}
+
+bool Expression::isComparison(OpCode op){
+    return op >= LESS && op <= NOT_EQUAL;
+}
+
+int Expression::instructionCost(OpCode op){
+    switch (op){
+    case POWER: case SIN: case COS: case TAN: case LOG:
+        return 16;
+    case SQRT:
+        return 4;
+    case CALL:
+        return 64;
+    case BUILTIN:
+        return 4096;
+    default:
+        return 1;
+    }
+}
+
+void Expression::enterCall(){
+    FrameStack & frames = localFrames();
+    if (frames.depth >= MAX_CALL_DEPTH){
+        error("Too many nested function calls");
+    }
+    frames.depth++;
+}
+
+void Expression::leaveCall(){
+    localFrames().depth--;
+}
+
+template <>
+bool Expression::compare<Interval>(OpCode op, const Interval & a, const Interval & b){
+    switch (op){
+    case LESS: return a < b;
+    case GREATER: return a > b;
+    case LESS_EQUAL: return a <= b;
+    case GREATER_EQUAL: return a >= b;
+    case EQUAL: return a == b;
+    default: return a != b;
+    }
+}
+
+template <>
+double Expression::call<double>(const Expression & callee, const double * args){
+    FrameStack & frames = localFrames();
+    size_t block = frames.block;
+    size_t used = frames.used;
+    CallDepth counted;
+    double * frame = frames.allocate(callee.maxDepth + callee.temps + 1);
+    double res;
+    try {
+        res = callee.evaluateOn(args, frame, frame + callee.maxDepth);
+    } catch (...) {
+        frames.block = block;
+        frames.used = used;
+        throw;
+    }
+    frames.block = block;
+    frames.used = used;
+    return res;
+}
+
+double Expression::evaluate(const double * values, double * workspace) const {
+    if (depth != 1){
+        error("Incorrect data entered");
+    }
+    return evaluateOn(values, workspace, workspace + maxDepth);
+}
+
+void Expression::evaluateBatch(const double * const * columns, int rows, double * results) const {
+    if (depth != 1){
+        error("Incorrect data entered");
+    }
+    if (rows <= 0) return;
+    int slotCount = maxDepth + temps + 2 * branches;
+    int blockRows = max(1, min(min(rows, (int) BLOCK_ROWS), MAX_BLOCK_VALUES / slotCount));
+    // one array of blockRows values for each stack slot and temporary,
+    // and for each level of conditionals the mask of the rows of the
+    // first branch and the values of that branch
+    vector<double> workspace((size_t) slotCount * blockRows);
+    double * slots = &workspace[0];
+    double * temporaries = slots + maxDepth * blockRows;
+    double * masks = temporaries + temps * blockRows;
+    // arguments of the calls of user and built-in functions
+    vector<const double *> arguments;
+    vector<double> row;
+    // conditionals whose branches are both cheap are always blended;
+    // costs[i] is the cost of the code before instruction i
+    vector<long long> costs(code.size() + 1, 0);
+    for (int i = 0; i < (int) code.size(); i++){
+        costs[i + 1] = costs[i] + instructionCost(code[i].op);
+    }
+    vector<bool> cheap(code.size(), false);
+    for (int i = 0; i < (int) code.size(); i++){
+        if (code[i].op == JUMP_IF_FALSE || code[i].op == JUMP_IF_TRUE){
+            int second = i + code[i].operand;
+            int end = second - 1 + code[second - 1].operand;
+            cheap[i] = costs[second - 1] - costs[i + 1] <= MAX_BLEND_COST && costs[end] - costs[second] <= MAX_BLEND_COST;
+        }
+    }
+    // conditionals being run: where they end and whether both branches run
+    struct Conditional {
+        int end;
+        bool blend;
+    };
+    vector<Conditional> conditionals;
+    for (int start = 0; start < rows; start += blockRows){
+        int n = min(blockRows, rows - start);
+        EvaluationBudget::charge((long long) code.size() * n);
+        int top = 0;
+        for (int i = 0; ; i++){
+            while (!conditionals.empty() && conditionals.back().end == i){
+                // both branches ran: take the first where the mask is set
+                double * a = slots + (top - 1) * blockRows;
+                const double * mask = masks + 2 * (conditionals.size() - 1) * blockRows;
+                const double * first = mask + blockRows;
+                for (int r = 0; r < n; r++) a[r] = mask[r] != 0 ? first[r] : a[r];
+                conditionals.pop_back();
+            }
+            if (i == (int) code.size()) break;
+            const Instruction & ins = code[i];
+            if (ins.op == PUSH_CONSTANT){
+                double * dst = slots + top * blockRows;
+                double value = constants[ins.operand];
+                for (int r = 0; r < n; r++) dst[r] = value;
+                top++;
+            } else if (ins.op == PUSH_VARIABLE){
+                double * dst = slots + top * blockRows;
+                const double * src = columns[ins.operand] + start;
+                for (int r = 0; r < n; r++) dst[r] = src[r];
+                top++;
+            } else if (ins.op == STORE_TEMP || ins.op == LOAD_TEMP){
+                double * temp = temporaries + ins.operand * blockRows;
+                if (ins.op == STORE_TEMP){
+                    const double * src = slots + (top - 1) * blockRows;
+                    for (int r = 0; r < n; r++) temp[r] = src[r];
+                } else {
+                    double * dst = slots + top * blockRows;
+                    for (int r = 0; r < n; r++) dst[r] = temp[r];
+                    top++;
+                }
+            } else if (ins.op == JUMP_IF_FALSE || ins.op == JUMP_IF_TRUE){
+                top--;
+                const double * c = slots + top * blockRows;
+                double * mask = masks + 2 * conditionals.size() * blockRows;
+                double whenTrue = ins.op == JUMP_IF_FALSE ? 1 : 0;
+                for (int r = 0; r < n; r++) mask[r] = c[r] != 0 ? whenTrue : 1 - whenTrue;
+                int second = i + ins.operand;
+                Conditional conditional = { second - 1 + code[second - 1].operand, true };
+                if (!cheap[i]){
+                    // an expensive branch is skipped if no row needs it
+                    double count = 0;
+                    for (int r = 0; r < n; r++) count += mask[r];
+                    if (count == 0){
+                        i = second - 1;
+                        continue;
+                    }
+                    conditional.blend = count < n;
+                }
+                conditionals.push_back(conditional);
+            } else if (ins.op == JUMP){
+                if (conditionals.back().blend){
+                    // keep the first branch and run the second one too
+                    top--;
+                    const double * src = slots + top * blockRows;
+                    double * first = masks + (2 * conditionals.size() - 1) * blockRows;
+                    for (int r = 0; r < n; r++) first[r] = src[r];
+                } else {
+                    conditionals.pop_back();
+                    i += ins.operand - 1;
+                }
+            } else if (isComparison(ins.op)){
+                top--;
+                double * a = slots + (top - 1) * blockRows;
+                const double * b = slots + top * blockRows;
+                switch (ins.op){
+                case LESS:
+                    for (int r = 0; r < n; r++) a[r] = a[r] < b[r] ? 1 : 0;
+                    break;
+                case GREATER:
+                    for (int r = 0; r < n; r++) a[r] = a[r] > b[r] ? 1 : 0;
+                    break;
+                case LESS_EQUAL:
+                    for (int r = 0; r < n; r++) a[r] = a[r] <= b[r] ? 1 : 0;
+                    break;
+                case GREATER_EQUAL:
+                    for (int r = 0; r < n; r++) a[r] = a[r] >= b[r] ? 1 : 0;
+                    break;
+                case EQUAL:
+                    for (int r = 0; r < n; r++) a[r] = a[r] == b[r] ? 1 : 0;
+                    break;
+                default:
+                    for (int r = 0; r < n; r++) a[r] = a[r] != b[r] ? 1 : 0;
+                    break;
+                }
+            } else if (ins.op == CALL){
+                const Expression & callee = userFunctionCode(ins.operand);
+                int count = callee.variableCount();
+                top -= count - 1;
+                double * a = slots + (top - 1) * blockRows;
+                if (FunctionRegistry::shared().function(ins.operand).recursive){
+                    // the depth of recursion differs by row: one row at a time
+                    row.resize(count);
+                    for (int r = 0; r < n; r++){
+                        for (int k = 0; k < count; k++) row[k] = a[k * blockRows + r];
+                        a[r] = call(callee, &row[0]);
+                    }
+                } else {
+                    arguments.resize(count);
+                    for (int k = 0; k < count; k++) arguments[k] = a + k * blockRows;
+                    callee.evaluateBatch(&arguments[0], n, a);
+                }
+            } else if (ins.op == BUILTIN){
+                // a built-in runs batches of its own: one row at a time
+                int count = builtinArgumentCount(ins.operand);
+                top -= count - 1;
+                double * a = slots + (top - 1) * blockRows;
+                row.resize(count);
+                for (int r = 0; r < n; r++){
+                    for (int k = 0; k < count; k++) row[k] = a[k * blockRows + r];
+                    a[r] = evaluateBuiltin(ins.operand, &row[0]);
+                }
+            } else if (ins.op <= POWER){
+                top--;
+                double * a = slots + (top - 1) * blockRows;
+                const double * b = slots + top * blockRows;
+                switch (ins.op){
+                case ADD:
+                    for (int r = 0; r < n; r++) a[r] += b[r];
+                    break;
+                case SUBTRACT:
+                    for (int r = 0; r < n; r++) a[r] -= b[r];
+                    break;
+                case MULTIPLY:
+                    for (int r = 0; r < n; r++) a[r] *= b[r];
+                    break;
+                case DIVIDE:
+                    for (int r = 0; r < n; r++) a[r] /= b[r];
+                    break;
+                default:
+                    for (int r = 0; r < n; r++) a[r] = pow(a[r], b[r]);
+                    break;
+                }
+            } else if (memoized && ins.op != SQRT){
+                double * a = slots + (top - 1) * blockRows;
+                FunctionCache & cache = FunctionCache::local();
+                MemoFunction function = memoFunction(ins.op);
+                for (int r = 0; r < n; r++) a[r] = cache.call(function, a[r]);
+            } else {
+                double * a = slots + (top - 1) * blockRows;
+                switch (ins.op){
+                case SIN:
+                    for (int r = 0; r < n; r++) a[r] = sin(a[r]);
+                    break;
+                case COS:
+                    for (int r = 0; r < n; r++) a[r] = cos(a[r]);
+                    break;
+                case SQRT:
+                    for (int r = 0; r < n; r++) a[r] = sqrt(a[r]);
+                    break;
+                case TAN:
+                    for (int r = 0; r < n; r++) a[r] = tan(a[r]);
+                    break;
+                default:
+                    for (int r = 0; r < n; r++) a[r] = log(a[r]);
+                    break;
+                }
+            }
+        }
+        for (int r = 0; r < n; r++) results[start + r] = slots[r];
+    }
+}
+
+void Expression::evaluateBatch(const double * const * lowerColumns, const double * const * upperColumns, int rows,
+                               double * lower, double * upper) const {
+    if (depth != 1){
+        error("Incorrect data entered");
+    }
+    if (rows <= 0) return;
+    bool rowByRow = branches > 0;
+    for (int i = 0; i < (int) code.size(); i++){
+        if (code[i].op == CALL || code[i].op == BUILTIN) rowByRow = true;
+    }
+    int variableCount = variableNames.size();
+    if (rowByRow){
+        vector<Interval> values(variableCount);
+        for (int r = 0; r < rows; r++){
+            for (int v = 0; v < variableCount; v++) values[v] = Interval(lowerColumns[v][r], upperColumns[v][r]);
+            Interval res = evaluate(&values[0]);
+            lower[r] = res.getLower();
+            upper[r] = res.getUpper();
+        }
+        return;
+    }
+    vector<Interval> constantBounds(constantTexts.size());
+    for (size_t k = 0; k < constantTexts.size(); k++){
+        constantBounds[k] = Interval::fromDecimal(constantTexts[k]);
+    }
+    int slotCount = maxDepth + temps;
+    int blockRows = max(1, min(min(rows, (int) BLOCK_ROWS), MAX_BLOCK_VALUES / (2 * slotCount)));
+    // for each stack slot and temporary an array of the negated lower
+    // bounds of blockRows values followed by one of their upper bounds
+    vector<double> workspace((size_t) 2 * slotCount * blockRows);
+    double * slots = &workspace[0];
+    double * temporaries = slots + 2 * maxDepth * blockRows;
+    RoundingMode upward(FE_UPWARD);
+    for (int start = 0; start < rows; start += blockRows){
+        int n = min(blockRows, rows - start);
+        EvaluationBudget::charge((long long) code.size() * n);
+        int top = 0;
+        for (int i = 0; i < (int) code.size(); i++){
+            const Instruction & ins = code[i];
+            if (ins.op == PUSH_CONSTANT || ins.op == PUSH_VARIABLE || ins.op == LOAD_TEMP){
+                double * minus = slots + 2 * top * blockRows;
+                double * up = minus + blockRows;
+                if (ins.op == PUSH_CONSTANT){
+                    double lowerBound = -constantBounds[ins.operand].getLower();
+                    double upperBound = constantBounds[ins.operand].getUpper();
+                    for (int r = 0; r < n; r++) minus[r] = lowerBound;
+                    for (int r = 0; r < n; r++) up[r] = upperBound;
+                } else if (ins.op == PUSH_VARIABLE){
+                    const double * lowerSource = lowerColumns[ins.operand] + start;
+                    const double * upperSource = upperColumns[ins.operand] + start;
+                    for (int r = 0; r < n; r++) minus[r] = -lowerSource[r];
+                    for (int r = 0; r < n; r++) up[r] = upperSource[r];
+                } else {
+                    const double * temp = temporaries + 2 * ins.operand * blockRows;
+                    copy(temp, temp + 2 * blockRows, minus);
+                }
+                top++;
+            } else if (ins.op == STORE_TEMP){
+                const double * src = slots + 2 * (top - 1) * blockRows;
+                copy(src, src + 2 * blockRows, temporaries + 2 * ins.operand * blockRows);
+            } else if (ins.op == SQRT){
+                double * minus = slots + 2 * (top - 1) * blockRows;
+                sqrtBlock(minus, minus + blockRows, n);
+            } else if (ins.op == ADD || ins.op == SUBTRACT || ins.op == MULTIPLY || ins.op == DIVIDE){
+                top--;
+                double * a = slots + 2 * (top - 1) * blockRows;
+                const double * b = a + 2 * blockRows;
+                switch (ins.op){
+                case ADD:
+                    addBlocks(a, a + blockRows, b, b + blockRows, n);
+                    break;
+                case SUBTRACT:
+                    subtractBlocks(a, a + blockRows, b, b + blockRows, n);
+                    break;
+                case MULTIPLY:
+                    multiplyBlocks(a, a + blockRows, b, b + blockRows, n);
+                    break;
+                default:
+                    divideBlocks(a, a + blockRows, b, b + blockRows, n);
+                    break;
+                }
+            } else {
+                // the other operations take the Interval functions, which
+                // round to nearest, one row at a time
+                RoundingMode nearest(FE_TONEAREST);
+                bool binary = ins.op == POWER || isComparison(ins.op);
+                if (binary) top--;
+                double * a = slots + 2 * (top - 1) * blockRows;
+                const double * b = a + 2 * blockRows;
+                for (int r = 0; r < n; r++){
+                    Interval x(-a[r], a[blockRows + r]);
+                    Interval res;
+                    if (ins.op == POWER){
+                        res = pow(x, Interval(-b[r], b[blockRows + r]));
+                    } else if (binary){
+                        res = truth<Interval>(compare(ins.op, x, Interval(-b[r], b[blockRows + r])));
+                    } else {
+                        res = applyFunction(ins.op, x);
+                    }
+                    a[r] = -res.getLower();
+                    a[blockRows + r] = res.getUpper();
+                }
+            }
+        }
+        for (int r = 0; r < n; r++) lower[start + r] = -slots[r];
+        for (int r = 0; r < n; r++) upper[start + r] = slots[blockRows + r];
+    }
+}
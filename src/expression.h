@@ -0,0 +1,591 @@
+/* File: expression.h
+ * -----------------------------------
+ *
+ * This file exports the compiled form of an equation: a flat list
+ * of stack-machine instructions built once from the polish record
+ * and then evaluated many times, for single values or whole columns.
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "budget.h"
+#include "error.h"
+#include "calc.h"
+#include "memo.h"
+#include "vectorshpp.h"
+
+/* Operations of the compiled expression */
+enum OpCode {
+    PUSH_CONSTANT, PUSH_VARIABLE,
+    ADD, SUBTRACT, MULTIPLY, DIVIDE, POWER,
+    SIN, COS, SQRT, TAN, LOG,
+    STORE_TEMP, LOAD_TEMP,
+    CALL, BUILTIN,
+    LESS, GREATER, LESS_EQUAL, GREATER_EQUAL, EQUAL, NOT_EQUAL,
+    JUMP, JUMP_IF_FALSE, JUMP_IF_TRUE
+};
+
+/* One instruction; operand is the constant, variable or temporary index.
+ * STORE_TEMP copies the top of the stack to a temporary and leaves it
+ * on the stack; LOAD_TEMP pushes it again. Together they let a shared
+ * subexpression be computed once. CALL replaces the arguments on the
+ * stack by the value of the user function whose id is the operand
+ * (see functions.h), BUILTIN likewise for a call of a built-in
+ * function such as integrate (see builtins.h). Comparisons give 1 or
+ * 0. The jumps skip operand instructions forward; the conditional ones
+ * pop the condition, which is true when it is not 0. They only appear
+ * in the pattern built with Expression::appendJump. */
+struct Instruction {
+    OpCode op;
+    int operand;
+};
+
+/* Class Expression
+ * --------------------------------
+ * This class holds an equation compiled to instructions for a stack
+ * machine. Variables are numbered in the order of the list given to
+ * the constructor, and every evaluation takes their values in that
+ * order. Batch evaluation works on blocks of rows and runs every
+ * instruction over the whole block, so the inner loops are simple
+ * array operations the compiler turns into SIMD code.
+ *
+ * Conditionals (if, && and ||) are lazy when evaluating one value: only
+ * the branch chosen runs. A block of rows may need both branches, so
+ * when both are cheap the batch runs both and blends the results with
+ * the condition as a mask, without any branch. When a branch is
+ * expensive, a block whose rows all choose the same branch runs only
+ * that one.
+ */
+class Expression {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Number of rows evaluated together by the batch functions */
+    static const int BLOCK_ROWS = 256;
+
+    /* Largest number of values in the workspace of a block; deeply
+     * nested expressions evaluate fewer rows at a time */
+    static const int MAX_BLOCK_VALUES = 1 << 20;
+
+    /* Constructor: Expression
+     * Usage: Expression expr(polishRecord, variableNames);
+     * -----------------------------------------------------
+     * Compiles a polish record. Names that are not functions must be
+     * in the variable list. Signals an error for a malformed record.
+     * Calls of user functions are compiled as they are, without
+     * inlining (see compileEquation).
+     */
+    Expression();
+    Expression(VectorSHPP<std::string> & records, const VectorSHPP<std::string> & variables);
+
+    /* Constructor: Expression
+     * Usage: Expression expr(variableNames);
+     *        expr.append(PUSH_VARIABLE, 0);
+     * -----------------------------------------------------
+     * Starts an empty expression that is built with addConstant and
+     * append, for code produced by transformations of other expressions
+     */
+    explicit Expression(const VectorSHPP<std::string> & variables);
+
+    /* Method: addConstant / append
+     * Usage: int index = expr.addConstant("2.5");
+     *        expr.append(PUSH_CONSTANT, index);
+     * -----------------------------------------------------
+     * Add a constant or an instruction at the end of the code. Signals
+     * an error if the instruction has no operands on the stack.
+     */
+    int addConstant(const std::string & text);
+    void append(OpCode op, int operand = 0);
+
+    /* Method: appendJump / landJump
+     * Usage: int test = expr.appendJump(JUMP_IF_FALSE);
+     *        ... code of the first branch ...
+     *        int skip = expr.appendJump(JUMP);
+     *        expr.landJump(test);
+     *        ... code of the second branch ...
+     *        expr.landJump(skip);
+     * -----------------------------------------------------
+     * Build a conditional after the code of its condition, so only one
+     * of its branches runs, each leaving one value: the first unless the
+     * jump (JUMP_IF_FALSE or JUMP_IF_TRUE) is taken. appendJump appends
+     * a jump and returns its index; landJump makes it land at the end
+     * of the code.
+     */
+    int appendJump(OpCode jump);
+    void landJump(int index);
+
+    /* Method: size / instruction
+     * Usage: for (int i = 0; i < expr.size(); i++) expr.instruction(i)...
+     * -----------------------------------------------------
+     * Give access to the instructions
+     */
+    int size() const;
+    const Instruction & instruction(int index) const;
+
+    /* Method: constant / constantText
+     * Usage: double c = expr.constant(index);
+     * -----------------------------------------------------
+     * Return a constant as a double or as written in the equation
+     */
+    double constant(int index) const;
+    const std::string & constantText(int index) const;
+
+    /* Method: variableCount / variableName
+     * Usage: string name = expr.variableName(index);
+     * -----------------------------------------------------
+     * Return the number and the names of the variables
+     */
+    int variableCount() const;
+    const std::string & variableName(int index) const;
+
+    /* Method: stackDepth / tempCount / branchCount
+     * Usage: int depth = expr.stackDepth();
+     * -----------------------------------------------------
+     * Return the largest number of values on the stack during evaluation,
+     * the number of temporaries and the number of conditionals
+     */
+    int stackDepth() const;
+    int tempCount() const;
+    int branchCount() const;
+
+    /* Method: isComplete
+     * Usage: if (expr.isComplete())...
+     * -----------------------------------------------------
+     * Returns true if the code leaves exactly one value on the stack
+     */
+    bool isComplete() const;
+
+    /* Method: evaluate
+     * Usage: NumberType res = expr.evaluate<NumberType>(values);
+     * -----------------------------------------------------
+     * Evaluates the expression with the given number type, taking the
+     * variables from values; constants are converted with numberFromString
+     */
+    template <typename NumberType>
+    NumberType evaluate(const NumberType * values) const;
+
+    /* Method: evaluate
+     * Usage: double res = expr.evaluate(values, workspace);
+     * -----------------------------------------------------
+     * Evaluates the expression in doubles on a workspace of stackDepth()
+     * + tempCount() doubles given by the caller, without allocating
+     */
+    double evaluate(const double * values, double * workspace) const;
+
+    /* Method: evaluateBatch
+     * Usage: expr.evaluateBatch(columns, rows, results);
+     * -----------------------------------------------------
+     * Evaluates the expression for each row; columns[v][row] is the value
+     * of variable v in that row
+     */
+    void evaluateBatch(const double * const * columns, int rows, double * results) const;
+
+    /* Method: evaluateBatch
+     * Usage: expr.evaluateBatch(lowerColumns, upperColumns, rows, lower, upper);
+     * -----------------------------------------------------
+     * Evaluates the expression in intervals for each row; variable v is
+     * [lowerColumns[v][row], upperColumns[v][row]] and the bounds of the
+     * results are written to lower and upper. Sums, differences,
+     * products, quotients and square roots run over blocks of rows with
+     * upward rounding (see multiplyBlocks), other operations row by row;
+     * code with conditionals or calls is evaluated row by row.
+     */
+    void evaluateBatch(const double * const * lowerColumns, const double * const * upperColumns, int rows,
+                       double * lower, double * upper) const;
+
+    /* Method: isFunctionName
+     * Usage: if (Expression::isFunctionName(name))...
+     * -----------------------------------------------------
+     * Returns true if the name is a built-in function
+     */
+    static bool isFunctionName(const std::string & name);
+
+    /* Method: isBinary / isComparison
+     * Usage: if (Expression::isBinary(op))...
+     * -----------------------------------------------------
+     * Check for an operation of two operands, or a comparison
+     */
+    static bool isBinary(OpCode op);
+    static bool isComparison(OpCode op);
+
+    /* Method: isOperatorToken
+     * Usage: if (Expression::isOperatorToken(token, op))...
+     * -----------------------------------------------------
+     * Checks for an operator of two operands in a polish record and
+     * gives its operation
+     */
+    static bool isOperatorToken(const std::string & token, OpCode & op);
+
+    /* Method: compare
+     * Usage: if (Expression::compare(LESS, a, b))...
+     * -----------------------------------------------------
+     * Applies a comparison to two numbers of any number type
+     */
+    template <typename NumberType>
+    static bool compare(OpCode op, const NumberType & a, const NumberType & b);
+
+    /* Method: setMemoized / isMemoized
+     * Usage: expr.setMemoized(true);
+     * -----------------------------------------------------
+     * Turn on or off the caching of sin, cos, tan and log in evaluations
+     * in doubles (see FunctionCache); it pays off when the arguments
+     * repeat, as with a few discrete angles in many rows
+     */
+    void setMemoized(bool on);
+    bool isMemoized() const;
+
+    /* Method: setMemoizedByDefault / isMemoizedByDefault
+     * Usage: Expression::setMemoizedByDefault(true);
+     * -----------------------------------------------------
+     * Set or give whether new expressions cache function results
+     */
+    static void setMemoizedByDefault(bool on);
+    static bool isMemoizedByDefault();
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    std::vector<Instruction> code;
+    std::vector<double> constants;
+    std::vector<std::string> constantTexts;
+    std::vector<std::string> variableNames;
+    int depth;
+    int maxDepth;
+    int temps;
+    int branches;
+    bool memoized;
+
+    static bool memoizedByDefault;
+
+    /* Deepest nesting of calls of user functions on a thread */
+    static const int MAX_CALL_DEPTH = 10000;
+
+    /* Cost of the instructions of a branch, in additions, up to which
+     * the batch evaluation runs both branches for every block */
+    static const int MAX_BLEND_COST = 16;
+
+    /* Method: constantValue
+     * Usage: NumberType c = constantValue<NumberType>(index);
+     * ------------------------------------------------
+     * Returns a constant in the given number type
+     */
+    template <typename NumberType>
+    NumberType constantValue(int index) const;
+
+    /* Method: memoFunction
+     * Usage: MemoFunction function = memoFunction(SIN);
+     * ------------------------------------------------
+     * Returns the cached function of an instruction
+     */
+    static MemoFunction memoFunction(OpCode op);
+
+    /* Method: applyFunction
+     * Usage: NumberType res = applyFunction(SIN, x);
+     * ------------------------------------------------
+     * Calculates sin, cos, tan or log, through the cache if memoized
+     */
+    template <typename NumberType>
+    NumberType applyFunction(OpCode op, const NumberType & x) const;
+
+    /* Method: evaluateOn
+     * Usage: NumberType res = evaluateOn(values, stack, temporaries);
+     * ------------------------------------------------
+     * Runs the code on a stack of maxDepth values and temps temporaries
+     */
+    template <typename NumberType>
+    NumberType evaluateOn(const NumberType * values, NumberType * stack, NumberType * temporaries) const;
+
+    /* Method: truth / isTrue
+     * Usage: NumberType one = truth<NumberType>(true);
+     * ------------------------------------------------
+     * Make 1 or 0 of a truth value and test a condition
+     */
+    template <typename NumberType>
+    static NumberType truth(bool value);
+    template <typename NumberType>
+    static bool isTrue(const NumberType & x);
+
+    /* Method: operandCount
+     * Usage: int count = operandCount(element);
+     * ------------------------------------------------
+     * Returns the number of values a token of a polish record takes
+     * from the stack. Signals an error for an unknown token.
+     */
+    static int operandCount(const std::string & element);
+
+    /* Method: instructionCost
+     * Usage: int cost = instructionCost(op);
+     * ------------------------------------------------
+     * Estimates the cost of an instruction, in additions
+     */
+    static int instructionCost(OpCode op);
+
+    /* Method: builtin
+     * Usage: NumberType res = builtin(id, args);
+     * ------------------------------------------------
+     * Evaluates a call of a built-in function. Built-ins calculate in
+     * double precision, so other number types are converted to double
+     * and back.
+     */
+    template <typename NumberType>
+    static NumberType builtin(int id, const NumberType * args);
+
+    /* Method: call
+     * Usage: NumberType res = call(callee, args);
+     * ------------------------------------------------
+     * Evaluates a user function with the arguments as its variables.
+     * In doubles the workspace is a frame of a per-thread stack, so
+     * calls do not allocate.
+     */
+    template <typename NumberType>
+    static NumberType call(const Expression & callee, const NumberType * args);
+
+    /* Method: enterCall / leaveCall
+     * Usage: enterCall();
+     * ------------------------------------------------
+     * Count the calls in progress on the thread; enterCall signals an
+     * error when they are nested deeper than MAX_CALL_DEPTH
+     */
+    static void enterCall();
+    static void leaveCall();
+
+    /* Counts a call for its lifetime, also when it ends with an error */
+    struct CallDepth {
+        CallDepth(){ enterCall(); }
+        ~CallDepth(){ leaveCall(); }
+    };
+};
+
+/*
+ * Function: userFunctionCode
+ * Usage: const Expression & code = userFunctionCode(id);
+ * ______________________________________________________
+ *
+ * Returns the compiled body of a user function (see functions.h)
+ *
+ * @param id - id of the function
+ * @return - the body, with the parameters as variables
+ */
+const Expression & userFunctionCode(int id);
+
+/*
+ * Function: builtinArgumentCount / evaluateBuiltin
+ * Usage: double res = evaluateBuiltin(id, args);
+ * ______________________________________________________
+ *
+ * Give the number of values a call of a built-in function takes from
+ * the stack, and its value for them (see builtins.h)
+ *
+ * @param id - id of the call
+ * @param args - values of the arguments
+ * @return - the number of arguments, or the value of the call
+ */
+int builtinArgumentCount(int id);
+double evaluateBuiltin(int id, const double * args);
+
+template <typename NumberType>
+NumberType Expression::constantValue(int index) const {
+    return numberFromString<NumberType>(constantTexts[index]);
+}
+
+template <>
+inline double Expression::constantValue<double>(int index) const {
+    return constants[index];
+}
+
+inline MemoFunction Expression::memoFunction(OpCode op){
+    return op == SIN ? MEMO_SIN : op == COS ? MEMO_COS : op == TAN ? MEMO_TAN : MEMO_LOG;
+}
+
+template <typename NumberType>
+NumberType Expression::applyFunction(OpCode op, const NumberType & x) const {
+    switch (op){
+    case SIN: return sin(x);
+    case COS: return cos(x);
+    case TAN: return tan(x);
+    default: return log(x);
+    }
+}
+
+template <>
+inline double Expression::applyFunction<double>(OpCode op, const double & x) const {
+    if (memoized){
+        return FunctionCache::local().call(memoFunction(op), x);
+    }
+    switch (op){
+    case SIN: return sin(x);
+    case COS: return cos(x);
+    case TAN: return tan(x);
+    default: return log(x);
+    }
+}
+
+template <typename NumberType>
+bool Expression::compare(OpCode op, const NumberType & a, const NumberType & b){
+    switch (op){
+    case LESS: return a < b;
+    case GREATER: return a > b;
+    case LESS_EQUAL: return a < b || a == b;
+    case GREATER_EQUAL: return a > b || a == b;
+    case EQUAL: return a == b;
+    default: return a != b;
+    }
+}
+
+/* Intervals decide <= and >= on their bounds: [1, 2] <= [2, 2] holds,
+ * though [1, 2] < [2, 2] and [1, 2] == [2, 2] are both uncertain */
+template <>
+bool Expression::compare<Interval>(OpCode op, const Interval & a, const Interval & b);
+
+template <typename NumberType>
+NumberType Expression::truth(bool value){
+    static const NumberType one = numberFromString<NumberType>("1");
+    static const NumberType zero = numberFromString<NumberType>("0");
+    return value ? one : zero;
+}
+
+template <>
+inline double Expression::truth<double>(bool value){
+    return value ? 1 : 0;
+}
+
+template <typename NumberType>
+bool Expression::isTrue(const NumberType & x){
+    return x != truth<NumberType>(false);
+}
+
+template <typename NumberType>
+NumberType Expression::call(const Expression & callee, const NumberType * args){
+    CallDepth counted;
+    return callee.evaluate(args);
+}
+
+template <>
+double Expression::call<double>(const Expression & callee, const double * args);
+
+template <typename NumberType>
+NumberType Expression::builtin(int id, const NumberType * args){
+    int count = builtinArgumentCount(id);
+    std::vector<double> values(count);
+    for (int k = 0; k < count; k++) values[k] = numberToDouble(args[k]);
+    double res = evaluateBuiltin(id, &values[0]);
+    if (!std::isfinite(res)){
+        error("The result of a built-in function is not a finite number");
+    }
+    std::ostringstream text;
+    text.precision(17);
+    text << res;
+    return numberFromString<NumberType>(text.str());
+}
+
+template <>
+inline double Expression::builtin<double>(int id, const double * args){
+    return evaluateBuiltin(id, args);
+}
+
+template <typename NumberType>
+NumberType Expression::evaluate(const NumberType * values) const {
+    if (depth != 1){
+        error("Incorrect data entered");
+    }
+    std::vector<NumberType> stack(maxDepth);
+    std::vector<NumberType> temporaries(temps + 1);
+    return evaluateOn(values, &stack[0], &temporaries[0]);
+}
+
+template <typename NumberType>
+NumberType Expression::evaluateOn(const NumberType * values, NumberType * stack, NumberType * temporaries) const {
+    // jumps only go forward, so no more than the whole code runs
+    EvaluationBudget::charge(code.size());
+    int top = 0;
+    for (int i = 0; i < (int) code.size(); i++){
+        const Instruction & ins = code[i];
+        switch (ins.op){
+        case PUSH_CONSTANT:
+            stack[top++] = constantValue<NumberType>(ins.operand);
+            break;
+        case LESS:
+        case GREATER:
+        case LESS_EQUAL:
+        case GREATER_EQUAL:
+        case EQUAL:
+        case NOT_EQUAL:
+            top--;
+            stack[top - 1] = truth<NumberType>(compare(ins.op, stack[top - 1], stack[top]));
+            break;
+        case JUMP:
+            i += ins.operand - 1;
+            break;
+        case JUMP_IF_FALSE:
+        case JUMP_IF_TRUE:
+            top--;
+            if (isTrue(stack[top]) == (ins.op == JUMP_IF_TRUE)) i += ins.operand - 1;
+            break;
+        case PUSH_VARIABLE:
+            stack[top++] = values[ins.operand];
+            break;
+        case ADD:
+            top--;
+            stack[top - 1] = stack[top - 1] + stack[top];
+            break;
+        case SUBTRACT:
+            top--;
+            stack[top - 1] = stack[top - 1] - stack[top];
+            break;
+        case MULTIPLY:
+            top--;
+            stack[top - 1] = stack[top - 1] * stack[top];
+            break;
+        case DIVIDE:
+            top--;
+            stack[top - 1] = stack[top - 1] / stack[top];
+            break;
+        case POWER:
+            top--;
+            stack[top - 1] = pow(stack[top - 1], stack[top]);
+            break;
+        case SIN:
+            stack[top - 1] = applyFunction(SIN, stack[top - 1]);
+            break;
+        case COS:
+            stack[top - 1] = applyFunction(COS, stack[top - 1]);
+            break;
+        case SQRT:
+            stack[top - 1] = sqrt(stack[top - 1]);
+            break;
+        case TAN:
+            stack[top - 1] = applyFunction(TAN, stack[top - 1]);
+            break;
+        case LOG:
+            stack[top - 1] = applyFunction(LOG, stack[top - 1]);
+            break;
+        case STORE_TEMP:
+            temporaries[ins.operand] = stack[top - 1];
+            break;
+        case LOAD_TEMP:
+            stack[top++] = temporaries[ins.operand];
+            break;
+        case CALL: {
+            const Expression & callee = userFunctionCode(ins.operand);
+            top -= callee.variableCount();
+            stack[top] = call(callee, stack + top);
+            top++;
+            break;
+        }
+        case BUILTIN:
+            top -= builtinArgumentCount(ins.operand);
+            stack[top] = builtin(ins.operand, stack + top);
+            top++;
+            break;
+        }
+    }
+    return stack[0];
+}
+
+#endif // EXPRESSION_H
@@ -0,0 +1,172 @@
+/* File: functions.cpp
+ * -----------------------------------
+ *
+ * Implementation of the FunctionRegistry class and the compilation of
+ * equations with calls of user functions.
+ */
+
+#include "functions.h"
+#include <algorithm>
+#include <cstdlib>
+#include "builtins.h"
+#include "calc.h"
+#include "error.h"
+#include "symbolic.h"
+#include "variables.h"
+
+using namespace std;
+
+/*
+ * Function: checkName
+ * Usage: checkName(name, "function");
+ * ______________________________________________________
+ *
+ * Signals an error if the name is not a word or is taken by a
+ * built-in function
+ */
+static void checkName(const string & name, const string & kind){
+    if (name.empty() || !isFunction(name) || Expression::isFunctionName(name) || isBuiltinName(name) || name == "if"){
+        error("Invalid " + kind + " name: " + name);
+    }
+}
+
+FunctionRegistry::FunctionRegistry(){
+    // functions are added by define
+}
+
+FunctionRegistry & FunctionRegistry::shared(){
+    static FunctionRegistry registry;
+    return registry;
+}
+
+int FunctionRegistry::define(const string & definition){
+    size_t open = definition.find('(');
+    size_t close = definition.find(')');
+    if (open == string::npos || close == string::npos || close < open
+            || close + 1 >= definition.length() || definition[close + 1] != '='){
+        error("Incorrect function definition: " + definition);
+    }
+    UserFunction function;
+    function.name = definition.substr(0, open);
+    checkName(function.name, "function");
+    string list = definition.substr(open + 1, close - open - 1);
+    VectorSHPP<string> names;
+    for (size_t start = 0; start <= list.length(); ){
+        size_t comma = list.find(',', start);
+        if (comma == string::npos) comma = list.length();
+        string parameter = list.substr(start, comma - start);
+        checkName(parameter, "parameter");
+        if (std::find(function.parameters.begin(), function.parameters.end(), parameter) != function.parameters.end()){
+            error("Repeated parameter: " + parameter);
+        }
+        function.parameters.push_back(parameter);
+        names.add(parameter);
+        start = comma + 1;
+    }
+    function.body = definition.substr(close + 2);
+    if (function.body.empty()){
+        error("Incorrect function definition: " + definition);
+    }
+    function.recursive = false;
+    function.inlined = false;
+    VectorSHPP<string> polishRecord = polishInvertedRecord(function.body);
+
+    // the new version is visible while its body compiles, so the body
+    // can call it; a failed definition takes it back
+    int id = functions.size();
+    map<string, int>::iterator it = current.find(function.name);
+    int previous = it == current.end() ? -1 : it->second;
+    functions.push_back(function);
+    current[function.name] = id;
+    try {
+        bindBuiltins(polishRecord);
+        Expression code = compileEquation(polishRecord, names);
+        UserFunction & stored = functions.back();
+        for (int i = 0; i < code.size(); i++){
+            if (code.instruction(i).op == CALL && code.instruction(i).operand == id){
+                stored.recursive = true;
+            }
+        }
+        stored.inlined = !stored.recursive && code.size() <= MAX_INLINE_INSTRUCTIONS;
+        stored.code = code;
+    } catch (...) {
+        functions.pop_back();
+        if (previous < 0){
+            current.erase(function.name);
+        } else {
+            current[function.name] = previous;
+        }
+        throw;
+    }
+    return id;
+}
+
+int FunctionRegistry::find(const string & name) const {
+    map<string, int>::const_iterator it = current.find(name);
+    return it == current.end() ? -1 : it->second;
+}
+
+const UserFunction & FunctionRegistry::function(int id) const {
+    return functions[id];
+}
+
+vector<string> FunctionRegistry::names() const {
+    vector<string> res;
+    for (map<string, int>::const_iterator it = current.begin(); it != current.end(); ++it){
+        res.push_back(it->first);
+    }
+    return res;
+}
+
+const Expression & userFunctionCode(int id){
+    return FunctionRegistry::shared().function(id).code;
+}
+
+bool isCallToken(const string & token, string & name, int & arguments){
+    size_t open = token.find('(');
+    if (open == string::npos || open == 0 || token[token.length() - 1] != ')'){
+        return false;
+    }
+    name = token.substr(0, open);
+    arguments = atoi(token.substr(open + 1).c_str());
+    return isFunction(name);
+}
+
+bool isConditional(const string & token){
+    string name;
+    int arguments;
+    if (!isCallToken(token, name, arguments) || name != "if") return false;
+    if (arguments != 3){
+        error("Function if takes 3 arguments");
+    }
+    return true;
+}
+
+int resolveCall(const string & token){
+    string name;
+    int arguments;
+    if (!isCallToken(token, name, arguments)){
+        error("Incorrect data entered");
+    }
+    const FunctionRegistry & registry = FunctionRegistry::shared();
+    int id = registry.find(name);
+    if (id < 0){
+        error("Unknown function: " + name);
+    }
+    int expected = registry.function(id).parameters.size();
+    if (arguments != expected){
+        error("Function " + name + " takes " + integerToString(expected) + (expected == 1 ? " argument" : " arguments"));
+    }
+    return id;
+}
+
+Expression compileEquation(VectorSHPP<string> & records, const VectorSHPP<string> & variables){
+    string name;
+    int arguments;
+    for (int i = 0; i < records.size(); i++){
+        if (isCallToken(records[i], name, arguments)){
+            return SymbolicExpression(records, variables).compile();
+        }
+    }
+    return Expression(records, variables);
+}
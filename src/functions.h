@@ -0,0 +1,157 @@
+/* File: functions.h
+ * -----------------------------------
+ *
+ * This file exports the functions defined by the user, such as
+ * f(x,y) = x^2 + y*sin(x), and the compilation of equations that
+ * call them.
+ */
+
+#ifndef FUNCTIONS_H
+#define FUNCTIONS_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "expression.h"
+#include "vectorshpp.h"
+
+/* A version of a user function; versions are never changed or removed,
+ * so code compiled with one stays valid when the name is redefined */
+struct UserFunction {
+    std::string name;
+    std::vector<std::string> parameters;
+    std::string body;
+    Expression code;
+    bool recursive;
+    bool inlined;
+};
+
+/* Class FunctionRegistry
+ * --------------------------------
+ * This class keeps the user functions, numbered by the order of their
+ * definitions. A call in an equation is bound to the current version of
+ * the function when the equation is compiled. Small functions that do
+ * not call themselves are inlined: their body replaces the call in the
+ * symbolic form of the caller, so constants are folded and common
+ * subexpressions shared across the call. The others are called at run
+ * time with a frame on a per-thread stack (see Expression).
+ */
+class FunctionRegistry {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Method: shared
+     * Usage: FunctionRegistry & registry = FunctionRegistry::shared();
+     * -----------------------------------------------------
+     * Returns the registry of the calculator
+     */
+    static FunctionRegistry & shared();
+
+    /* Method: define
+     * Usage: int id = registry.define("f(x,y)=x^2+y*sin(x)");
+     * -----------------------------------------------------
+     * Defines or redefines a function from a definition without spaces,
+     * in lower case. The body may use the parameters, functions defined
+     * before and the function itself. Signals an error for a malformed
+     * definition; the registry is then unchanged. Returns the id.
+     */
+    int define(const std::string & definition);
+
+    /* Method: find
+     * Usage: int id = registry.find("f");
+     * -----------------------------------------------------
+     * Returns the id of the current version of a function, -1 if there
+     * is none
+     */
+    int find(const std::string & name) const;
+
+    /* Method: function
+     * Usage: const UserFunction & f = registry.function(id);
+     * -----------------------------------------------------
+     * Returns a version of a function
+     */
+    const UserFunction & function(int id) const;
+
+    /* Method: names
+     * Usage: vector<string> names = registry.names();
+     * -----------------------------------------------------
+     * Returns the names of the defined functions in alphabetical order
+     */
+    std::vector<std::string> names() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Largest body, in instructions, that is inlined into callers */
+    static const int MAX_INLINE_INSTRUCTIONS = 24;
+
+    /* All versions by id; a deque keeps them in place as it grows */
+    std::deque<UserFunction> functions;
+    std::map<std::string, int> current;
+
+    FunctionRegistry();
+
+    /* The registry is not copied */
+    FunctionRegistry(const FunctionRegistry &);
+    FunctionRegistry & operator =(const FunctionRegistry &);
+};
+
+/*
+ * Function: isCallToken
+ * Usage: if (isCallToken(token, name, arguments))...
+ * ______________________________________________________
+ *
+ * Checks for a call of a user function in a polish record, written
+ * "f(2)" with the number of arguments
+ *
+ * @param token - element of a polish record
+ * @param name - set to the name of the function
+ * @param arguments - set to the number of arguments
+ * @return - true if the token is a call
+ */
+bool isCallToken(const std::string & token, std::string & name, int & arguments);
+
+/*
+ * Function: isConditional
+ * Usage: if (isConditional(token))...
+ * ______________________________________________________
+ *
+ * Checks for the call token of if(condition, then, else). Signals an
+ * error if it does not have three arguments.
+ *
+ * @param token - element of a polish record
+ * @return - true if the token is a call of if
+ */
+bool isConditional(const std::string & token);
+
+/*
+ * Function: resolveCall
+ * Usage: int id = resolveCall(token);
+ * ______________________________________________________
+ *
+ * Finds the function of a call token. Signals an error for an unknown
+ * function or a wrong number of arguments.
+ *
+ * @param token - call token of a polish record
+ * @return - id of the function
+ */
+int resolveCall(const std::string & token);
+
+/*
+ * Function: compileEquation
+ * Usage: Expression expr = compileEquation(polishRecord, variableNames);
+ * ______________________________________________________
+ *
+ * Compiles a polish record like the Expression constructor; a record
+ * with calls of user functions goes through the symbolic form, so
+ * small functions are inlined and simplified with the caller
+ *
+ * @param records - polish record
+ * @param variables - names of the variables
+ * @return - compiled equation
+ */
+Expression compileEquation(VectorSHPP<std::string> & records, const VectorSHPP<std::string> & variables);
+
+#endif // FUNCTIONS_H
@@ -0,0 +1,480 @@
+/* File: interval.cpp
+ * -----------------------------------
+ *
+ * Implementation of the Interval class.
+ */
+
+#include "interval.h"
+#include <cctype>
+#include <cfenv>
+#include <sstream>
+#include "error.h"
+#include "strlib.h"
+
+using namespace std;
+
+static const double PI = 3.14159265358979323846;
+
+/* Largest integer up to which every integer is a double */
+static const double EXACT_INTEGER_LIMIT = 9007199254740992.0;
+
+/*
+ * Function: libmDown / libmUp
+ * Usage: double lo = libmDown(sin(x));
+ * ______________________________________________________
+ *
+ * Outward rounding for results of the math library, which are not
+ * correctly rounded but stay within one ulp: two steps cover that
+ */
+static double libmDown(double x){
+    return roundDown(roundDown(x));
+}
+
+static double libmUp(double x){
+    return roundUp(roundUp(x));
+}
+
+/* Below this magnitude the rounding error of a product may underflow */
+static const double EXACT_ERROR_MIN = 4 * DBL_MIN / DBL_EPSILON;
+
+/* Operands above this overflow when they are split by twoProductError */
+static const double SPLIT_MAX = 1e299;
+
+/*
+ * Function: twoProductError
+ * Usage: double err = twoProductError(a, b, a * b);
+ * ______________________________________________________
+ *
+ * Returns the exact rounding error of a product, a * b - product, by
+ * Dekker's TwoProduct, which splits the operands into halves whose
+ * products are exact. The product must be at least 4 * DBL_MIN /
+ * DBL_EPSILON in magnitude, so the error does not underflow.
+ */
+static double twoProductError(double a, double b, double product){
+    const double splitter = 134217729.0;  // 2^27 + 1
+    double ca = splitter * a;
+    double aHigh = ca - (ca - a);
+    double aLow = a - aHigh;
+    double cb = splitter * b;
+    double bHigh = cb - (cb - b);
+    double bLow = b - bHigh;
+    return ((aHigh * bHigh - product) + aHigh * bLow + aLow * bHigh) + aLow * bLow;
+}
+
+/*
+ * Function: quotientError
+ * Usage: double err = quotientError(a, b, a / b);
+ * ______________________________________________________
+ *
+ * Returns a number of the sign of the rounding error a / b - quotient.
+ * The remainder a - quotient * b is exact: the product is within a
+ * factor of two of a, so a - product is exact, and the remainder is
+ * representable, so subtracting the error of the product is exact too.
+ * NaN if the error is not known, as when the quotient underflowed.
+ */
+static double quotientError(double a, double b, double quotient){
+    if (a == 0) return 0;
+    double product = quotient * b;
+    double rest = (a - product) - twoProductError(quotient, b, product);
+    bool known = fabs(a) >= EXACT_ERROR_MIN && fabs(quotient) >= EXACT_ERROR_MIN
+            && fabs(quotient) < SPLIT_MAX && fabs(b) < SPLIT_MAX;
+    return known ? (b > 0 ? rest : -rest) : NAN;
+}
+
+/*
+ * Function: sqrtError
+ * Usage: double err = sqrtError(x, sqrt(x));
+ * ______________________________________________________
+ *
+ * Returns a number of the sign of the rounding error sqrt(x) - root,
+ * which is that of x - root * root, found like the remainder of a
+ * quotient; NaN if the error is not known
+ */
+static double sqrtError(double x, double root){
+    if (x == 0) return 0;
+    double product = root * root;
+    double rest = (x - product) - twoProductError(root, root, product);
+    return x >= EXACT_ERROR_MIN && x < SPLIT_MAX ? rest : NAN;
+}
+
+/*
+ * Function: containsPeriodicPoint
+ * Usage: if (containsPeriodicPoint(lo, hi, offset, period))...
+ * ______________________________________________________
+ *
+ * Returns true if some point offset + k * period (k integer) may lie in
+ * [lo, hi]. The test is widened by the rounding error of the reduction,
+ * so a point close to a bound is reported as contained; that only makes
+ * the resulting interval wider, never wrong.
+ */
+static bool containsPeriodicPoint(double lo, double hi, double offset, double period){
+    double slack = 8 * DBL_EPSILON * (fabs(lo) + fabs(hi) + period);
+    double k = ceil((lo - slack - offset) / period);
+    return offset + k * period <= hi + slack;
+}
+
+/* Largest power of ten that is a double */
+static const int EXACT_POWER_OF_TEN_LIMIT = 22;
+
+/*
+ * Function: isExactDecimal
+ * Usage: if (isExactDecimal(str, value))...
+ * ______________________________________________________
+ *
+ * Returns true if the double value is exactly the decimal number str,
+ * like 1.5 or 0.25: with k digits after the point, the digits m as an
+ * integer must be value * 10^k, and the product must be exact
+ */
+static bool isExactDecimal(const string & str, double value){
+    if (str.find_first_not_of("+-.0123456789") != string::npos) return false;
+    double digits = 0;
+    int fraction = -1;
+    for (size_t i = 0; i < str.length(); i++){
+        if (str[i] == '.'){
+            fraction = 0;
+        } else if (isdigit(str[i])){
+            digits = digits * 10 + (str[i] - '0');
+            if (fraction >= 0) fraction++;
+            if (digits > EXACT_INTEGER_LIMIT) return false;
+        }
+    }
+    if (fraction > EXACT_POWER_OF_TEN_LIMIT) return false;
+    double scale = 1;
+    for (int k = 0; k < fraction; k++) scale *= 10;
+    double product = fabs(value) * scale;
+    return product == digits && twoProductError(fabs(value), scale, product) == 0;
+}
+
+/* Largest exponent computed by multiplication instead of pow */
+static const double MULTIPLIED_POWER_LIMIT = 64;
+
+/*
+ * Function: productDown / productUp
+ * Usage: double lo = productDown(a, b);
+ * ______________________________________________________
+ *
+ * Return a * b rounded downward or upward, stepped unless it is exact
+ */
+static double productDown(double a, double b){
+    double product = a * b;
+    return isExactProduct(a, b, product, significantBits(a) + significantBits(b)) ? product : roundDown(product);
+}
+
+static double productUp(double a, double b){
+    double product = a * b;
+    return isExactProduct(a, b, product, significantBits(a) + significantBits(b)) ? product : roundUp(product);
+}
+
+/*
+ * Function: powerDown / powerUp
+ * Usage: double lo = powerDown(x, n);
+ * ______________________________________________________
+ *
+ * Return x^n for a non-negative integer n rounded downward or upward.
+ * Small powers are multiplied out by squaring with directed rounding,
+ * so exact powers such as 2^10 stay exact; larger ones take pow with
+ * two steps for its error.
+ */
+static double powerUp(double x, double n);
+
+static double powerDown(double x, double n){
+    if (n > MULTIPLIED_POWER_LIMIT) return libmDown(pow(x, n));
+    if (x < 0) return fmod(n, 2) == 0 ? powerDown(-x, n) : -powerUp(-x, n);
+    double res = 1;
+    for (int k = (int) n; k > 0; k /= 2){
+        if (k % 2 == 1) res = productDown(res, x);
+        if (k > 1) x = productDown(x, x);
+    }
+    return res;
+}
+
+static double powerUp(double x, double n){
+    if (n > MULTIPLIED_POWER_LIMIT) return libmUp(pow(x, n));
+    if (x < 0) return fmod(n, 2) == 0 ? powerUp(-x, n) : -powerDown(-x, n);
+    double res = 1;
+    for (int k = (int) n; k > 0; k /= 2){
+        if (k % 2 == 1) res = productUp(res, x);
+        if (k > 1) x = productUp(x, x);
+    }
+    return res;
+}
+
+/*
+ * Function: integerPower
+ * Usage: Interval res = integerPower(x, n);
+ * ______________________________________________________
+ *
+ * Interval extension of x^n for a non-negative integer n: odd powers are
+ * increasing, even powers decrease on the negative half-line
+ */
+static Interval integerPower(const Interval & x, double n){
+    double lo = x.getLower();
+    double hi = x.getUpper();
+    if (n == 0) return Interval(1);
+    bool even = fmod(n, 2) == 0;
+    if (!even || lo >= 0){
+        return Interval(powerDown(lo, n), powerUp(hi, n));
+    }
+    if (hi <= 0){
+        return Interval(powerDown(hi, n), powerUp(lo, n));
+    }
+    return Interval(0, max(powerUp(lo, n), powerUp(hi, n)));
+}
+
+Interval Interval::fromDecimal(const string & str){
+    double value = stringToDouble(str);
+    if (isExactDecimal(str, value)){
+        return Interval(value);
+    }
+    // strtod rounds to nearest, so the decimal is within half an ulp
+    return Interval(roundDown(value), roundUp(value));
+}
+
+double Interval::width() const {
+    return upper - lower;
+}
+
+bool Interval::contains(double value) const {
+    return lower <= value && value <= upper;
+}
+
+string Interval::toString() const {
+    ostringstream stream;
+    stream.precision(17);
+    stream << "[" << lower << ", " << upper << "]";
+    return stream.str();
+}
+
+Interval operator/(const Interval & a, const Interval & b){
+    if (b.lower <= 0 && b.upper >= 0){
+        error("Division by an interval containing zero");
+    }
+    double q1 = a.lower / b.lower;
+    double q2 = a.lower / b.upper;
+    double q3 = a.upper / b.lower;
+    double q4 = a.upper / b.upper;
+    double e1 = quotientError(a.lower, b.lower, q1);
+    double e2 = quotientError(a.lower, b.upper, q2);
+    double e3 = quotientError(a.upper, b.lower, q3);
+    double e4 = quotientError(a.upper, b.upper, q4);
+    return Interval(min(min(lowerBound(q1, e1), lowerBound(q2, e2)), min(lowerBound(q3, e3), lowerBound(q4, e4))),
+                    max(max(upperBound(q1, e1), upperBound(q2, e2)), max(upperBound(q3, e3), upperBound(q4, e4))));
+}
+
+Interval sqrt(const Interval & x){
+    if (x.upper < 0){
+        error("sqrt: negative argument");
+    }
+    // the part of the interval below zero is outside the domain
+    double lo = 0;
+    if (x.lower > 0){
+        lo = sqrt(x.lower);
+        lo = lowerBound(lo, sqrtError(x.lower, lo));
+    }
+    double hi = sqrt(x.upper);
+    return Interval(max(lo, 0.0), upperBound(hi, sqrtError(x.upper, hi)));
+}
+
+Interval pow(const Interval & base, const Interval & exponent){
+    double n = exponent.lower;
+    if (n == exponent.upper && n == floor(n) && fabs(n) <= EXACT_INTEGER_LIMIT){
+        if (n >= 0) return integerPower(base, n);
+        return Interval(1) / integerPower(base, -n);
+    }
+    if (base.lower < 0){
+        error("pow: negative base with a fractional exponent");
+    }
+    if (base.lower == 0 && exponent.lower < 0){
+        error("Division by zero");
+    }
+    // for a positive base, x^y is monotonic in each argument,
+    // so the extremes are at the corners
+    double p1 = pow(base.lower, exponent.lower);
+    double p2 = pow(base.lower, exponent.upper);
+    double p3 = pow(base.upper, exponent.lower);
+    double p4 = pow(base.upper, exponent.upper);
+    double lo = libmDown(min(min(p1, p2), min(p3, p4)));
+    return Interval(max(lo, 0.0), libmUp(max(max(p1, p2), max(p3, p4))));
+}
+
+Interval sin(const Interval & x){
+    if (!(x.width() < 2 * PI)){
+        return Interval(-1, 1);
+    }
+    double a = sin(x.lower);
+    double b = sin(x.upper);
+    double lo = containsPeriodicPoint(x.lower, x.upper, 1.5 * PI, 2 * PI) ? -1 : libmDown(min(a, b));
+    double hi = containsPeriodicPoint(x.lower, x.upper, 0.5 * PI, 2 * PI) ? 1 : libmUp(max(a, b));
+    return Interval(max(lo, -1.0), min(hi, 1.0));
+}
+
+Interval cos(const Interval & x){
+    if (!(x.width() < 2 * PI)){
+        return Interval(-1, 1);
+    }
+    double a = cos(x.lower);
+    double b = cos(x.upper);
+    double lo = containsPeriodicPoint(x.lower, x.upper, PI, 2 * PI) ? -1 : libmDown(min(a, b));
+    double hi = containsPeriodicPoint(x.lower, x.upper, 0, 2 * PI) ? 1 : libmUp(max(a, b));
+    return Interval(max(lo, -1.0), min(hi, 1.0));
+}
+
+Interval tan(const Interval & x){
+    if (!(x.width() < PI) || containsPeriodicPoint(x.lower, x.upper, 0.5 * PI, PI)){
+        error("tan: interval contains a pole");
+    }
+    // tan is increasing between its poles
+    return Interval(libmDown(tan(x.lower)), libmUp(tan(x.upper)));
+}
+
+Interval log(const Interval & x){
+    if (x.upper <= 0){
+        error("log: argument must be positive");
+    }
+    // log is increasing; near zero it is unbounded below
+    double lo = x.lower > 0 ? libmDown(log(x.lower)) : -HUGE_VAL;
+    return Interval(lo, libmUp(log(x.upper)));
+}
+
+bool operator<(const Interval & a, const Interval & b){
+    if (a.lower >= b.upper) return false;
+    if (a.upper >= b.lower){
+        error("Comparison of overlapping intervals is uncertain");
+    }
+    return true;
+}
+
+bool operator>(const Interval & a, const Interval & b){
+    return b < a;
+}
+
+bool operator<=(const Interval & a, const Interval & b){
+    if (a.upper <= b.lower) return true;
+    if (a.lower <= b.upper){
+        error("Comparison of overlapping intervals is uncertain");
+    }
+    return false;
+}
+
+bool operator>=(const Interval & a, const Interval & b){
+    return b <= a;
+}
+
+bool operator==(const Interval & a, const Interval & b){
+    if (a.upper < b.lower || b.upper < a.lower) return false;
+    if (a.lower != a.upper || b.lower != b.upper){
+        error("Comparison of overlapping intervals is uncertain");
+    }
+    return true;
+}
+
+bool operator!=(const Interval & a, const Interval & b){
+    return !(a == b);
+}
+
+ostream & operator<<(ostream & os, const Interval & x){
+    return os << x.toString();
+}
+
+RoundingMode::RoundingMode(int mode){
+    saved = fegetround();
+    fesetround(mode);
+}
+
+RoundingMode::~RoundingMode(){
+    fesetround(saved);
+}
+
+/* The block operations run under upward rounding: the compiler must
+ * keep the rounding of every operation, and not fold (-a) * b into
+ * -(a * b), which rounds the other way. Their loops are vectorized at
+ * -O2 too. */
+#if defined(__clang__)
+#pragma STDC FENV_ACCESS ON
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize ("rounding-math", "tree-vectorize")
+#endif
+
+/*
+ * Function: larger
+ * Usage: double upper = larger(a, b);
+ * ______________________________________________________
+ *
+ * Returns the larger of two bounds; std::max compiled for the other
+ * rounding mode is not inlined here
+ */
+static inline double larger(double a, double b){
+    return a < b ? b : a;
+}
+
+void addBlocks(double * __restrict__ aMinus, double * __restrict__ aUpper,
+               const double * __restrict__ bMinus, const double * __restrict__ bUpper, int rows){
+    for (int r = 0; r < rows; r++){
+        aMinus[r] += bMinus[r];
+        aUpper[r] += bUpper[r];
+    }
+}
+
+void subtractBlocks(double * __restrict__ aMinus, double * __restrict__ aUpper,
+                    const double * __restrict__ bMinus, const double * __restrict__ bUpper, int rows){
+    // [al, au] - [bl, bu] = [al - bu, au - bl]
+    for (int r = 0; r < rows; r++){
+        double minus = aMinus[r] + bUpper[r];
+        aUpper[r] += bMinus[r];
+        aMinus[r] = minus;
+    }
+}
+
+void multiplyBlocks(double * __restrict__ aMinus, double * __restrict__ aUpper,
+                    const double * __restrict__ bMinus, const double * __restrict__ bUpper, int rows){
+    // the bounds are the extremes of the products of the bounds; the
+    // lower one is the largest of the products negated, each rounded up
+    for (int r = 0; r < rows; r++){
+        double al = -aMinus[r], au = aUpper[r], bl = -bMinus[r], bu = bUpper[r];
+        double upper = larger(larger(al * bl, al * bu), larger(au * bl, au * bu));
+        double minus = larger(larger(-al * bl, -al * bu), larger(-au * bl, -au * bu));
+        aMinus[r] = minus;
+        aUpper[r] = upper;
+    }
+}
+
+void divideBlocks(double * __restrict__ aMinus, double * __restrict__ aUpper,
+                  const double * __restrict__ bMinus, const double * __restrict__ bUpper, int rows){
+    for (int r = 0; r < rows; r++){
+        if (!(bMinus[r] < 0 || bUpper[r] < 0)){
+            error("Division by an interval containing zero");
+        }
+    }
+    for (int r = 0; r < rows; r++){
+        double al = -aMinus[r], au = aUpper[r], bl = -bMinus[r], bu = bUpper[r];
+        double upper = larger(larger(al / bl, al / bu), larger(au / bl, au / bu));
+        double minus = larger(larger(-al / bl, -al / bu), larger(-au / bl, -au / bu));
+        aMinus[r] = minus;
+        aUpper[r] = upper;
+    }
+}
+
+void sqrtBlock(double * __restrict__ minus, double * __restrict__ upper, int rows){
+    for (int r = 0; r < rows; r++){
+        if (upper[r] < 0){
+            error("sqrt: negative argument");
+        }
+    }
+    for (int r = 0; r < rows; r++){
+        // the root of the lower bound rounded up is its lower bound if
+        // it is exact, which its square shows rounded both ways, and is
+        // stepped by at least an ulp otherwise; roots are never subnormal
+        double lower = larger(-minus[r], 0.0);
+        double root = sqrt(lower);
+        bool exact = root * root == lower && -root * root == -lower;
+        minus[r] = -(exact ? root : root - root * DBL_EPSILON);
+        upper[r] = sqrt(upper[r]);
+    }
+}
+
+#if defined(__clang__)
+#pragma STDC FENV_ACCESS OFF
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
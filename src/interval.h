@@ -0,0 +1,296 @@
+/* File: interval.h
+ * -----------------------------------
+ *
+ * This file exports a closed interval of doubles used by the
+ * interval calculation mode.
+ */
+
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+
+/* Class Interval
+ * --------------------------------
+ * This class implements interval arithmetic: every operation returns an
+ * interval [lower, upper] that is guaranteed to contain the exact result
+ * for any choice of the operands inside their intervals. Rounding is
+ * directed outward by stepping a computed bound away from the result
+ * (see roundDown / roundUp below) unless the operation is known to be
+ * exact, from the rounding error of a sum or the bits of the factors of
+ * a product, so exact results such as 5-1 stay points. The checks are
+ * a few operations without loops, so the arithmetic operators are
+ * defined inline and compile to straight-line code.
+ */
+class Interval {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: Interval
+     * Usage: Interval zero;
+     *        Interval point(2.5);
+     *        Interval x(lower, upper);
+     * -----------------------------------------------------
+     * Initializes a new interval; a single value makes a point interval
+     */
+    Interval();
+    Interval(double value);
+    Interval(double lower, double upper);
+
+    /* Method: fromDecimal
+     * Usage: Interval x = Interval::fromDecimal("0.1");
+     * -----------------------------------------------------
+     * Returns the smallest interval known to contain the decimal number,
+     * which is a point only if the number is exactly representable
+     */
+    static Interval fromDecimal(const std::string & str);
+
+    /* Method: getLower / getUpper
+     * Usage: double lo = x.getLower();
+     * -----------------------------------------------------
+     * Return the bounds of the interval
+     */
+    double getLower() const;
+    double getUpper() const;
+
+    /* Method: width / contains
+     * Usage: if (x.contains(0))...
+     * -----------------------------------------------------
+     * Return the width of the interval, or whether it contains a value
+     */
+    double width() const;
+    bool contains(double value) const;
+
+    /* Method: toString
+     * Usage: string str = x.toString();
+     * -----------------------------------------------------
+     * Returns "[lower, upper]" with enough digits to identify each bound
+     */
+    std::string toString() const;
+
+    Interval operator-() const;
+    friend Interval operator+(const Interval & a, const Interval & b);
+    friend Interval operator-(const Interval & a, const Interval & b);
+    friend Interval operator*(const Interval & a, const Interval & b);
+    friend Interval operator/(const Interval & a, const Interval & b);
+
+    friend Interval sqrt(const Interval & x);
+    friend Interval pow(const Interval & base, const Interval & exponent);
+    friend Interval sin(const Interval & x);
+    friend Interval cos(const Interval & x);
+    friend Interval tan(const Interval & x);
+    friend Interval log(const Interval & x);
+
+    /* Comparisons hold for all values of the intervals or for none;
+     * they signal an error when the answer depends on the values */
+    friend bool operator<(const Interval & a, const Interval & b);
+    friend bool operator>(const Interval & a, const Interval & b);
+    friend bool operator<=(const Interval & a, const Interval & b);
+    friend bool operator>=(const Interval & a, const Interval & b);
+    friend bool operator==(const Interval & a, const Interval & b);
+    friend bool operator!=(const Interval & a, const Interval & b);
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Bounds of the interval, lower <= upper */
+    double lower;
+    double upper;
+};
+
+std::ostream & operator<<(std::ostream & os, const Interval & x);
+
+/*
+ * Function: roundDown / roundUp
+ * Usage: double lo = roundDown(a + b);
+ * ______________________________________________________
+ *
+ * Move a rounded-to-nearest result at least one ulp away from the
+ * exact value, downward or upward. |x| * 2^-52 is at least one ulp of x,
+ * and the smallest subnormal covers zero and underflow. A bound that
+ * overflowed to the wrong infinity is clamped to the largest double.
+ */
+inline double roundDown(double x){
+    double res = x - (std::fabs(x) * DBL_EPSILON + std::numeric_limits<double>::denorm_min());
+    return res == res ? res : DBL_MAX;
+}
+
+inline double roundUp(double x){
+    double res = x + (std::fabs(x) * DBL_EPSILON + std::numeric_limits<double>::denorm_min());
+    return res == res ? res : -DBL_MAX;
+}
+
+/*
+ * Function: lowerBound / upperBound
+ * Usage: double lo = lowerBound(sum, err);
+ * ______________________________________________________
+ *
+ * Return a rounded result as a lower or an upper bound of the exact
+ * result, which is the rounded one plus err: the result is kept if err
+ * shows it is on the right side and is stepped otherwise, or if err is
+ * NaN because the error is not known.
+ */
+inline double lowerBound(double value, double err){
+    return err >= 0 ? value : roundDown(value);
+}
+
+inline double upperBound(double value, double err){
+    return err <= 0 ? value : roundUp(value);
+}
+
+/*
+ * Function: sumError
+ * Usage: double err = sumError(a, b, a + b);
+ * ______________________________________________________
+ *
+ * Returns the exact rounding error of a sum, a + b - sum, by TwoSum,
+ * which holds for subnormal sums too; it is NaN if the sum overflowed
+ */
+inline double sumError(double a, double b, double sum){
+    double part = sum - a;
+    return (a - (sum - part)) + (b - part);
+}
+
+/*
+ * Function: significantBits
+ * Usage: int bits = significantBits(x);
+ * ______________________________________________________
+ *
+ * Returns the number of bits of the significand of x from its leading
+ * bit to its last one bit: 1 for powers of two, 0 for zero. Subnormals,
+ * infinities and NaN give more bits than a double has.
+ */
+inline int significantBits(double x){
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof bits);
+    uint64_t exponent = (bits >> 52) & 0x7ff;
+    int count = DBL_MANT_DIG - __builtin_ctzll(bits | 0x10000000000000ULL);
+    bool special = exponent == 0 || exponent == 0x7ff;
+    return special ? (x == 0 ? 0 : DBL_MANT_DIG + 1) : count;
+}
+
+/*
+ * Function: isExactProduct
+ * Usage: if (isExactProduct(a, b, a * b, significantBits(a) + significantBits(b)))...
+ * ______________________________________________________
+ *
+ * Returns true if a product is known to be exact: the significant bits
+ * of the factors fit in a double together, and it neither overflowed
+ * nor went below the normal range (unless a factor is zero). The few
+ * exact products this misses are stepped like inexact ones. Counting
+ * bits takes a few integer operations, where the rounding error itself
+ * would need a fused multiply-add, a library call without -mfma, or
+ * TwoProduct, several times the work of the product.
+ */
+inline bool isExactProduct(double a, double b, double product, int bits){
+    double size = std::fabs(product);
+    return bits <= DBL_MANT_DIG && size <= DBL_MAX && (size >= DBL_MIN || a == 0 || b == 0);
+}
+
+/* Class RoundingMode
+ * --------------------------------
+ * Sets the rounding mode of the floating-point unit for its lifetime
+ * and then restores the previous one. The block operations below run
+ * under FE_UPWARD; the rest of the program assumes rounding to nearest.
+ * Only exact operations, such as negations and copies, may be inlined
+ * between the switches; the rest goes to functions compiled for the
+ * rounding mode, as the block operations are in interval.cpp.
+ */
+class RoundingMode {
+public:
+    explicit RoundingMode(int mode);
+    ~RoundingMode();
+
+private:
+    int saved;
+
+    RoundingMode(const RoundingMode &);
+    RoundingMode & operator =(const RoundingMode &);
+};
+
+/*
+ * Function: addBlocks / subtractBlocks / multiplyBlocks / divideBlocks / sqrtBlock
+ * Usage: multiplyBlocks(aMinus, aUpper, bMinus, bUpper, rows);
+ * ______________________________________________________
+ *
+ * Interval operations on blocks of rows, for the batch evaluation: a
+ * block is an array of the negated lower bounds and an array of the
+ * upper bounds, and the result replaces the first operand. With the
+ * lower bounds negated every bound is rounded upward, so a whole block
+ * is calculated under one RoundingMode(FE_UPWARD) without a check of
+ * exactness per operation, in loops the compiler turns into SIMD code;
+ * exact results stay points. divideBlocks and sqrtBlock signal the
+ * errors of the operators of Interval.
+ */
+void addBlocks(double * aMinus, double * aUpper, const double * bMinus, const double * bUpper, int rows);
+void subtractBlocks(double * aMinus, double * aUpper, const double * bMinus, const double * bUpper, int rows);
+void multiplyBlocks(double * aMinus, double * aUpper, const double * bMinus, const double * bUpper, int rows);
+void divideBlocks(double * aMinus, double * aUpper, const double * bMinus, const double * bUpper, int rows);
+void sqrtBlock(double * minus, double * upper, int rows);
+
+inline Interval::Interval(){
+    lower = 0;
+    upper = 0;
+}
+
+inline Interval::Interval(double value){
+    lower = value;
+    upper = value;
+}
+
+inline Interval::Interval(double lower, double upper){
+    this->lower = lower;
+    this->upper = upper;
+}
+
+inline double Interval::getLower() const {
+    return lower;
+}
+
+inline double Interval::getUpper() const {
+    return upper;
+}
+
+inline Interval Interval::operator-() const {
+    return Interval(-upper, -lower);
+}
+
+inline Interval operator+(const Interval & a, const Interval & b){
+    double lo = a.lower + b.lower;
+    double hi = a.upper + b.upper;
+    return Interval(lowerBound(lo, sumError(a.lower, b.lower, lo)),
+                    upperBound(hi, sumError(a.upper, b.upper, hi)));
+}
+
+inline Interval operator-(const Interval & a, const Interval & b){
+    double lo = a.lower - b.upper;
+    double hi = a.upper - b.lower;
+    return Interval(lowerBound(lo, sumError(a.lower, -b.upper, lo)),
+                    upperBound(hi, sumError(a.upper, -b.lower, hi)));
+}
+
+inline Interval operator*(const Interval & a, const Interval & b){
+    double p1 = a.lower * b.lower;
+    double p2 = a.lower * b.upper;
+    double p3 = a.upper * b.lower;
+    double p4 = a.upper * b.upper;
+    // the bounds are exact if the products of the bounds all are; the
+    // bits are counted for the wider bound of each operand
+    int bits = std::max(significantBits(a.lower), significantBits(a.upper))
+             + std::max(significantBits(b.lower), significantBits(b.upper));
+    bool inexact = !(isExactProduct(a.lower, b.lower, p1, bits) && isExactProduct(a.lower, b.upper, p2, bits)
+                     && isExactProduct(a.upper, b.lower, p3, bits) && isExactProduct(a.upper, b.upper, p4, bits));
+    double lo = std::min(std::min(p1, p2), std::min(p3, p4));
+    double hi = std::max(std::max(p1, p2), std::max(p3, p4));
+    return inexact ? Interval(roundDown(lo), roundUp(hi)) : Interval(lo, hi);
+}
+
+#endif // INTERVAL_H
@@ -0,0 +1,84 @@
+/* File: mappedfile.cpp
+ * -----------------------------------
+ *
+ * Implementation of the MappedFile class.
+ */
+
+#include "mappedfile.h"
+#include <fstream>
+#include "error.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile(const string & path){
+    contents = NULL;
+    length = 0;
+    mapped = false;
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        error("Cannot open file: " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)){
+        length = info.st_size;
+        if (length == 0){
+            close(fd);
+            return;
+        }
+        void * memory = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory != MAP_FAILED){
+            madvise(memory, length, MADV_SEQUENTIAL);
+            contents = static_cast<const char *>(memory);
+            mapped = true;
+            close(fd);
+            return;
+        }
+    }
+    close(fd);
+#endif
+    // no mapping: read the whole file
+    ifstream input(path.c_str(), ios::binary);
+    if (!input){
+        error("Cannot open file: " + path);
+    }
+    buffer.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    length = buffer.size();
+    contents = buffer.empty() ? NULL : &buffer[0];
+}
+
+MappedFile::~MappedFile(){
+#ifndef _WIN32
+    if (mapped){
+        munmap(const_cast<char *>(contents), length);
+    }
+#endif
+}
+
+const char * MappedFile::data() const {
+    return contents;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+bool isSameFile(const string & first, const string & second){
+#ifndef _WIN32
+    struct stat a, b;
+    if (stat(first.c_str(), &a) != 0 || stat(second.c_str(), &b) != 0){
+        return false;
+    }
+    return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+#else
+    // without mapping the whole input is read before any output
+    return first == second;
+#endif
+}
@@ -0,0 +1,70 @@
+/* File: mappedfile.h
+ * -----------------------------------
+ *
+ * This file exports read-only access to a whole file through
+ * memory mapping.
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/* Class MappedFile
+ * --------------------------------
+ * This class maps a file into memory, so large inputs are read by the
+ * operating system on demand instead of being copied through streams.
+ * Where mapping is not available the file is read into a buffer.
+ */
+class MappedFile {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: MappedFile
+     * Usage: MappedFile file(path);
+     * -----------------------------------------------------
+     * Maps the file; signals an error if it cannot be opened
+     */
+    explicit MappedFile(const std::string & path);
+
+    /* Destructor: ~MappedFile
+     * -----------------------------------------------------
+     * Unmaps the file
+     */
+    ~MappedFile();
+
+    /* Method: data / size
+     * Usage: const char * bytes = file.data();
+     * -----------------------------------------------------
+     * Return the contents of the file and their length
+     */
+    const char * data() const;
+    size_t size() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    const char * contents;
+    size_t length;
+    bool mapped;
+    std::vector<char> buffer;
+
+    /* The mapping is owned by the object and cannot be copied */
+    MappedFile(const MappedFile & src);
+    MappedFile & operator=(const MappedFile & src);
+};
+
+/*
+ * Function: isSameFile
+ * Usage: if (isSameFile(input, output))...
+ * ______________________________________________________
+ *
+ * Returns true if both paths name one existing file, so writing the
+ * second would truncate the mapping of the first
+ */
+bool isSameFile(const std::string & first, const std::string & second);
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,79 @@
+/* File: memo.cpp
+ * -----------------------------------
+ *
+ * Implementation of the FunctionCache class.
+ */
+
+#include "memo.h"
+#include <mutex>
+#include <set>
+
+using namespace std;
+
+/*
+ * Function: registry / registryLock
+ * Usage: lock_guard<mutex> lock(registryLock());
+ * ______________________________________________________
+ *
+ * Give the caches of the running threads and their lock. They are made
+ * on first use and never destroyed: the caches of the workers of the
+ * thread pool are destroyed as the workers end, after the static
+ * objects of the program.
+ */
+static set<FunctionCache *> & registry(){
+    static set<FunctionCache *> * caches = new set<FunctionCache *>;
+    return *caches;
+}
+static mutex & registryLock(){
+    static mutex * lock = new mutex;
+    return *lock;
+}
+
+/* The counts of finished threads */
+static long long retiredHits = 0;
+static long long retiredMisses = 0;
+
+FunctionCache::FunctionCache() : hitCount(0), missCount(0){
+    for (int f = 0; f < MEMO_FUNCTIONS; f++){
+        double zero = calculate(f, 0.0);
+        for (int s = 0; s < SLOTS; s++){
+            slots[f][s].key = 0;
+            slots[f][s].value = zero;
+        }
+    }
+    lock_guard<mutex> lock(registryLock());
+    registry().insert(this);
+}
+
+FunctionCache::~FunctionCache(){
+    lock_guard<mutex> lock(registryLock());
+    retiredHits += hitCount;
+    retiredMisses += missCount;
+    registry().erase(this);
+}
+
+FunctionCache & FunctionCache::local(){
+    thread_local FunctionCache cache;
+    return cache;
+}
+
+void FunctionCache::statistics(long long & hits, long long & misses){
+    lock_guard<mutex> lock(registryLock());
+    hits = retiredHits;
+    misses = retiredMisses;
+    for (set<FunctionCache *>::iterator it = registry().begin(); it != registry().end(); ++it){
+        hits += (*it)->hitCount.load(memory_order_relaxed);
+        misses += (*it)->missCount.load(memory_order_relaxed);
+    }
+}
+
+void FunctionCache::resetStatistics(){
+    lock_guard<mutex> lock(registryLock());
+    retiredHits = 0;
+    retiredMisses = 0;
+    // the owners may be counting; the counts restart from about zero
+    for (set<FunctionCache *>::iterator it = registry().begin(); it != registry().end(); ++it){
+        (*it)->hitCount.store(0, memory_order_relaxed);
+        (*it)->missCount.store(0, memory_order_relaxed);
+    }
+}
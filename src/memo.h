@@ -0,0 +1,112 @@
+/* File: memo.h
+ * -----------------------------------
+ *
+ * This file exports a per-thread cache of the results of expensive
+ * pure functions, so repeated arguments are not calculated again.
+ */
+
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+/* Functions whose results are cached */
+enum MemoFunction { MEMO_SIN, MEMO_COS, MEMO_TAN, MEMO_LOG, MEMO_FUNCTIONS };
+
+/* Class FunctionCache
+ * --------------------------------
+ * This class is a small direct-mapped table of function results for
+ * each thread. An argument is looked up by its exact bits, so a hit
+ * returns exactly what the function would, including for -0 and NaN.
+ * Every slot starts with the argument 0 and its result, so no slot is
+ * ever empty. Hits and misses are counted for the statistics of all
+ * threads.
+ */
+class FunctionCache {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Method: local
+     * Usage: FunctionCache & cache = FunctionCache::local();
+     * -----------------------------------------------------
+     * Returns the cache of the calling thread
+     */
+    static FunctionCache & local();
+
+    /* Method: call
+     * Usage: double res = cache.call(MEMO_SIN, x);
+     * -----------------------------------------------------
+     * Returns the value of a function, from the table if the argument
+     * was seen recently
+     */
+    double call(int function, double x);
+
+    /* Method: statistics / resetStatistics
+     * Usage: FunctionCache::statistics(hits, misses);
+     * -----------------------------------------------------
+     * Give or clear the numbers of hits and misses of all threads
+     */
+    static void statistics(long long & hits, long long & misses);
+    static void resetStatistics();
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Slots of the table of each function */
+    static const int SLOT_BITS = 10;
+    static const int SLOTS = 1 << SLOT_BITS;
+
+    struct Slot {
+        unsigned long long key;
+        double value;
+    };
+
+    Slot slots[MEMO_FUNCTIONS][SLOTS];
+
+    /* Written only by the owning thread, read by statistics */
+    std::atomic<long long> hitCount;
+    std::atomic<long long> missCount;
+
+    FunctionCache();
+    ~FunctionCache();
+
+    /* Method: calculate
+     * Usage: double res = calculate(function, x);
+     * ------------------------------------------------
+     * Calls the function itself
+     */
+    static double calculate(int function, double x);
+
+    /* Caches are per thread and not copied */
+    FunctionCache(const FunctionCache &);
+    FunctionCache & operator =(const FunctionCache &);
+};
+
+inline double FunctionCache::calculate(int function, double x){
+    switch (function){
+    case MEMO_SIN: return sin(x);
+    case MEMO_COS: return cos(x);
+    case MEMO_TAN: return tan(x);
+    default: return log(x);
+    }
+}
+
+inline double FunctionCache::call(int function, double x){
+    unsigned long long bits;
+    memcpy(&bits, &x, sizeof(bits));
+    // the high bits of a multiplicative hash mix the whole argument
+    Slot & slot = slots[function][(bits * 0x9E3779B97F4A7C15ULL) >> (64 - SLOT_BITS)];
+    if (slot.key == bits){
+        hitCount.store(hitCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return slot.value;
+    }
+    missCount.store(missCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    slot.key = bits;
+    slot.value = calculate(function, x);
+    return slot.value;
+}
+
+#endif // MEMO_H
@@ -0,0 +1,183 @@
+/* File: parser.cpp
+ * -----------------------------------
+ *
+ * Implementation of the PolishRecordParser class.
+ */
+
+#include "parser.h"
+#include <iostream>
+#include <utility>
+#include "budget.h"
+#include "calc.h"
+#include "error.h"
+#include "expression.h"
+#include "strlib.h"
+
+using namespace std;
+
+/*
+ * Function: opensOperand
+ * Usage: if (opensOperand(before))...
+ * ______________________________________________________
+ *
+ * Checks whether an operand starts after a character: at the start of
+ * the equation (0), after '(', ',', a comparison or a logical operator.
+ * A minus there is a sign.
+ */
+static bool opensOperand(char before){
+    switch (before){
+    case 0: case '(': case ',':
+    case '<': case '>': case '=': case '!': case '&': case '|':
+        return true;
+    default:
+        return false;
+    }
+}
+
+PolishRecordParser::PolishRecordParser(){
+    reset();
+}
+
+void PolishRecordParser::reset(){
+    stack.clear();
+    res.clear();
+    arguments.clear();
+    run.clear();
+    runKind = NO_RUN;
+    previous = 0;
+    stopped = false;
+    text.clear();
+}
+
+void PolishRecordParser::feed(const char * data, size_t length){
+    if (stopped || length == 0) return;
+    text.append(data, length);
+    parse(false);
+}
+
+void PolishRecordParser::feed(const string & chunk){
+    feed(chunk.data(), chunk.length());
+}
+
+VectorSHPP<string> PolishRecordParser::finish(){
+    const EvaluationLimits & limits = EvaluationBudget::limits();
+    if (!stopped) parse(true);
+    // Takes out remaining values from the stack
+    while(!stack.isEmpty()){
+        res.add(stack.pop());
+    }
+    if (limits.tokens > 0 && res.size() > limits.tokens){
+        error("Equation has more tokens than the limit of " + integerToString(limits.tokens));
+    }
+    VectorSHPP<string> record;
+    record.swap(res);
+    reset();
+    return record;
+}
+
+string PolishRecordParser::takeRun(size_t start, size_t end, RunKind kind, bool last){
+    if (end == text.length() && !last){
+        // the held character is the last of the run so far
+        run.append(text, start, end - 1 - start);
+        runKind = kind;
+        return "";
+    }
+    runKind = NO_RUN;
+    if (run.empty()) return text.substr(start, end - start);
+    string token = run + text.substr(start, end - start);
+    run.clear();
+    return token;
+}
+
+void PolishRecordParser::parse(bool last){
+    const EvaluationLimits & limits = EvaluationBudget::limits();
+    // classes of all characters of the chunk at once, so numbers and names are taken whole
+    classifyCharacters(text, masks);
+    size_t length = text.length();
+    // the character after the last one of a chunk is not known yet
+    size_t limit = last ? length : length - 1;
+    size_t i = 0;
+    for (; i < limit; i++){
+        // a minus where an operand starts is a sign
+        bool unaryMinus = runKind == NO_RUN && text[i] == '-' && opensOperand(i == 0 ? previous : text[i-1]);
+        if (unaryMinus && !isNumber(text[i + 1])){ // minus before a name or a bracket: -x is read as 0-x
+            res.add("0");
+            stack.push("-");
+        } else if (runKind == NUMBER_RUN || isMasked(masks.digits, i) || unaryMinus){ // a number with its sign, up to its last digit
+            size_t end = spanEnd(masks.digits, unaryMinus ? i + 1 : i, length);
+            string number = takeRun(i, end, NUMBER_RUN, last);
+            if (runKind != NO_RUN){
+                i = length - 1;
+                break;
+            }
+            res.add(move(number));
+            i = end - 1;
+        } else if (runKind == NAME_RUN || isMasked(masks.letters, i)){ // a name of a function or a variable
+            size_t end = spanEnd(masks.letters, i, length);
+            string name = takeRun(i, end, NAME_RUN, last);
+            if (runKind != NO_RUN){
+                i = length - 1;
+                break;
+            }
+            if(text[end] == '('){ // the name is followed by '(' - it is a function
+                // a call of a user function is written "f(n)" in the record,
+                // n is the number of arguments counted at its ')'
+                stack.push(Expression::isFunctionName(name) ? name : name + "()");
+            } else {
+                res.add(move(name));
+            }
+            i = end - 1;
+        } else if (text[i] == '(') {
+            stack.push("(");
+            arguments.push_back(text[i+1] == ')' ? 0 : 1);
+        } else if (text[i] == ',') { // the next argument of a function
+            while (!stack.isEmpty() && stack.peek() != "(") {
+                res.add(stack.pop());
+            }
+            if (!arguments.empty()) arguments.back()++;
+        } else if (text[i] == ')') {
+            while (!stack.isEmpty() && stack.peek() != "(") {
+                res.add(stack.pop());
+            }
+            if (stack.isEmpty()){
+                error("Incorrect data entered");
+            }
+            stack.pop();
+            int count = arguments.empty() ? 0 : arguments.back();
+            if (!arguments.empty()) arguments.pop_back();
+            string call = stack.isEmpty() ? "" : stack.peek();
+            if (endsWith(call, "()")){
+                stack.pop();
+                stack.push(call.substr(0, call.length() - 1) + integerToString(count) + ")");
+            }
+        } else if (isMasked(masks.operators, i)) {
+            // comparisons and logical operators: < > <= >= == != && ||
+            string op = charToString(text[i]);
+            if ((text[i+1] == '=' && string("<>=!").find(text[i]) != string::npos)
+                    || ((text[i] == '&' || text[i] == '|') && text[i+1] == text[i])){
+                op += text[++i];
+            } else if (op == "=" || op == "!" || op == "&" || op == "|"){
+                cout << "Error incoming data" << endl;
+                stopped = true;
+                break;
+            }
+            while (!stack.isEmpty() && (operatorPriority(stack.peek()[0]) >= operatorPriority(op[0]))) {
+                res.add(stack.pop());
+            }
+            stack.push(op);
+        } else {
+            cout << "Error incoming data" << endl;
+            stopped = true;
+            break;
+        }
+        if (limits.nesting > 0 && stack.size() > limits.nesting){
+            error("Equation is nested deeper than the limit of " + integerToString(limits.nesting));
+        }
+    }
+    if (limits.tokens > 0 && res.size() > limits.tokens){
+        error("Equation has more tokens than the limit of " + integerToString(limits.tokens));
+    }
+    // the characters not read wait for the next chunk
+    if (i > 0) previous = text[i - 1];
+    text.erase(0, i);
+}
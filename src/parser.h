@@ -0,0 +1,114 @@
+/* File: parser.h
+ * -----------------------------------
+ *
+ * This file exports the parser of equations that reads an equation in
+ * chunks, as it arrives, and builds its polish record on the way.
+ */
+
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "stackshpp.h"
+#include "tokenizer.h"
+#include "vectorshpp.h"
+
+/* Class PolishRecordParser
+ * --------------------------------
+ * A push parser of equations. The text of an equation is given to feed
+ * in chunks of any size, split anywhere, even inside a number or a
+ * name; the sorting station runs over each chunk as it comes, and
+ * finish gives the polish record once the text has ended. Between the
+ * chunks the parser keeps the stack of operators, the open brackets and
+ * the number or name not ended yet, and holds back the last character,
+ * which is read when the next one is known. The text is the same as
+ * for polishInvertedRecord: without spaces and in lower case. Calls of
+ * built-in functions are bound in the finished record (see
+ * bindBuiltins).
+ *
+ * The limits on tokens and nesting (see EvaluationBudget) are checked
+ * while reading, so an equation too big is rejected before it has all
+ * arrived. After an error the parser is reset before reading another
+ * equation.
+ */
+class PolishRecordParser {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: PolishRecordParser
+     * Usage: PolishRecordParser parser;
+     * -----------------------------------------------------
+     * Makes a parser ready for the first chunk of an equation
+     */
+    PolishRecordParser();
+
+    /* Method: feed
+     * Usage: parser.feed(data, length);
+     * -----------------------------------------------------
+     * Reads the next chunk of the equation. Signals an error for an
+     * incorrect equation or one over the limits.
+     */
+    void feed(const char * data, size_t length);
+    void feed(const std::string & chunk);
+
+    /* Method: finish
+     * Usage: VectorSHPP<string> polishRecord = parser.finish();
+     * -----------------------------------------------------
+     * Ends the equation and returns its polish record; the parser is
+     * then ready for the next equation
+     */
+    VectorSHPP<std::string> finish();
+
+    /* Method: reset
+     * Usage: parser.reset();
+     * -----------------------------------------------------
+     * Forgets the equation read so far
+     */
+    void reset();
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Kind of the number or name not ended at the end of a chunk */
+    enum RunKind { NO_RUN, NUMBER_RUN, NAME_RUN };
+
+    StackSHPP<std::string> stack;
+    VectorSHPP<std::string> res;
+    std::vector<int> arguments;  // arguments counted in each open bracket
+
+    std::string run;             // the number or the name read so far
+    RunKind runKind;
+    char previous;               // the character before the text, 0 at the start
+    bool stopped;                // the equation has an incorrect character
+
+    /* The character held back from the last chunk and the current one */
+    std::string text;
+    CharacterMasks masks;
+
+    /* Method: parse
+     * Usage: parse(last);
+     * ------------------------------------------------
+     * Runs the sorting station over the text. Unless it is the end of
+     * the equation, the last character and the number or name it ends
+     * are left for the next chunk.
+     */
+    void parse(bool last);
+
+    /* Method: takeRun
+     * Usage: string number = takeRun(start, end, NUMBER_RUN, last);
+     * ------------------------------------------------
+     * Returns a number or a name ending in the text, with its part from
+     * the chunks before. If it reaches the end of a chunk, so it may go
+     * on in the next one, keeps it in run and sets runKind instead.
+     */
+    std::string takeRun(size_t start, size_t end, RunKind kind, bool last);
+
+    /* The parser is not copied */
+    PolishRecordParser(const PolishRecordParser &);
+    PolishRecordParser & operator =(const PolishRecordParser &);
+};
+
+#endif // PARSER_H
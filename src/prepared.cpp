@@ -0,0 +1,77 @@
+/* File: prepared.cpp
+ * -----------------------------------
+ *
+ * Implementation of prepared equations.
+ */
+
+#include "prepared.h"
+#include <algorithm>
+#include <cctype>
+#include "builtins.h"
+#include "calc.h"
+#include "error.h"
+#include "functions.h"
+#include "strlib.h"
+#include "variables.h"
+
+using namespace std;
+
+PreparedExpression::PreparedExpression(){
+    // nothing to execute until an equation is assigned
+}
+
+PreparedExpression::PreparedExpression(const string & equation){
+    string text;
+    for (size_t i = 0; i < equation.length(); i++){
+        if (!isspace((unsigned char) equation[i])) text += equation[i];
+    }
+    VectorSHPP<string> polishRecord = polishInvertedRecord(toLowerCase(text));
+    bindBuiltins(polishRecord);
+    // the parameters, in the order they first appear
+    VectorSHPP<string> names;
+    vector<string> seen;
+    for (int i = 0; i < polishRecord.size(); i++){
+        string token = polishRecord.get(i);
+        if (!token.empty() && isFunction(token) && !Expression::isFunctionName(token)
+                && find(seen.begin(), seen.end(), token) == seen.end()){
+            names.add(token);
+            seen.push_back(token);
+        }
+    }
+    expr = compileEquation(polishRecord, names);
+    if (!expr.isComplete()){
+        error("Incorrect data entered");
+    }
+    parameters.assign(names.size() + 1, 0.0);
+    workspace.assign(expr.stackDepth() + expr.tempCount(), 0.0);
+}
+
+int PreparedExpression::parameterCount() const {
+    return expr.variableCount();
+}
+
+const string & PreparedExpression::parameterName(int index) const {
+    return expr.variableName(index);
+}
+
+int PreparedExpression::parameterIndex(const string & name) const {
+    for (int i = 0; i < expr.variableCount(); i++){
+        if (expr.variableName(i) == name) return i;
+    }
+    return -1;
+}
+
+void PreparedExpression::bind(int index, double value){
+    if (index < 0 || index >= expr.variableCount()){
+        error("Parameter index out of range");
+    }
+    parameters[index] = value;
+}
+
+double PreparedExpression::execute(){
+    return expr.evaluate(parameters.data(), workspace.data());
+}
+
+PreparedExpression prepare(const string & equation){
+    return PreparedExpression(equation);
+}
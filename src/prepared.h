@@ -0,0 +1,86 @@
+/* File: prepared.h
+ * -----------------------------------
+ *
+ * This file exports prepared equations: an equation is parsed and
+ * compiled once, then executed any number of times with new values of
+ * its parameters, like a prepared statement of a database.
+ */
+
+#ifndef PREPARED_H
+#define PREPARED_H
+
+#include <string>
+#include <vector>
+#include "expression.h"
+
+/* Class PreparedExpression
+ * --------------------------------
+ * This class holds a compiled equation together with the values of its
+ * parameters and the workspace of its evaluation. The parameters are
+ * the names of the equation that are not functions, numbered in the
+ * order they first appear. After prepare, bind and execute do no string
+ * work and no allocation. A prepared equation keeps its state between
+ * calls, so each thread needs its own copy.
+ */
+class PreparedExpression {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: PreparedExpression
+     * Usage: PreparedExpression prepared(equation);
+     * -----------------------------------------------------
+     * Parses and compiles an equation; spaces and case are ignored.
+     * Built-in functions may use the parameters; they allocate when
+     * executed. All parameters start at zero. Without an equation,
+     * the object is only a place to assign a prepared equation to.
+     */
+    PreparedExpression();
+    explicit PreparedExpression(const std::string & equation);
+
+    /* Method: parameterCount / parameterName / parameterIndex
+     * Usage: int index = prepared.parameterIndex("b");
+     * -----------------------------------------------------
+     * Give the parameters; parameterIndex returns -1 for an unknown name
+     */
+    int parameterCount() const;
+    const std::string & parameterName(int index) const;
+    int parameterIndex(const std::string & name) const;
+
+    /* Method: bind
+     * Usage: prepared.bind(index, value);
+     * -----------------------------------------------------
+     * Sets the value of a parameter for the next executions
+     */
+    void bind(int index, double value);
+
+    /* Method: execute
+     * Usage: double res = prepared.execute();
+     * -----------------------------------------------------
+     * Calculates the equation with the bound values
+     */
+    double execute();
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    Expression expr;
+    std::vector<double> parameters;
+
+    /* Stack and temporaries of the evaluation */
+    std::vector<double> workspace;
+};
+
+/*
+ * Function: prepare
+ * Usage: PreparedExpression prepared = prepare("a*sin(b)+c");
+ * ______________________________________________________
+ *
+ * Prepares an equation for repeated execution
+ *
+ * @param equation - equation with parameters
+ * @return - the prepared equation
+ */
+PreparedExpression prepare(const std::string & equation);
+
+#endif // PREPARED_H
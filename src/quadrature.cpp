@@ -0,0 +1,228 @@
+/* File: quadrature.cpp
+ * -----------------------------------
+ *
+ * Implementation of adaptive Gauss-Kronrod integration.
+ */
+
+#include "quadrature.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+#include "accumulator.h"
+#include "error.h"
+#include "threadpool.h"
+
+using namespace std;
+
+/* Nodes of the 15-point Kronrod rule on [-1, 1]: +-NODES[k], the odd k
+ * and the center are also the nodes of the 7-point Gauss rule */
+static const double NODES[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.0
+};
+
+static const double KRONROD_WEIGHTS[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+
+static const double GAUSS_WEIGHTS[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+};
+
+static const int RULE_POINTS = 15;
+
+/* Subintervals evaluated together; 16 * 15 rows fill most of a block */
+static const int INTERVALS_PER_TASK = 16;
+
+/* Subintervals of the first pass */
+static const int INITIAL_INTERVALS = 16;
+
+/* Halvings after which a subinterval is accepted as it is */
+static const int MAX_DEPTH = 40;
+
+static const double RELATIVE_TOLERANCE = 1e-10;
+static const double ABSOLUTE_TOLERANCE = 1e-14;
+
+/* One subinterval waiting for evaluation */
+struct Subinterval {
+    double left;
+    double right;
+    int depth;
+};
+
+/* State shared by the tasks of one integration */
+struct Integration {
+    const Expression * expr;
+    int variable;
+    vector<double> values;
+    double length;
+    double tolerance;
+    bool serial;     // run on the calling thread, inside a task of the pool
+    mutex lock;
+    ReproducibleSum sum;
+    ReproducibleSum errorSum;
+};
+
+/*
+ * Function: applyRule
+ * Usage: applyRule(integration, intervals, integrals, errors, absolutes);
+ * ______________________________________________________
+ *
+ * Evaluates the integrand at the Kronrod nodes of all subintervals in
+ * one batch and computes the Kronrod estimate of each subinterval, its
+ * difference to the Gauss estimate as the error, and the integral of
+ * the absolute value (absolutes may be NULL).
+ */
+static void applyRule(const Integration & integration, const vector<Subinterval> & intervals,
+                      double * integrals, double * errors, double * absolutes){
+    int count = intervals.size();
+    int rows = count * RULE_POINTS;
+    int variables = integration.expr->variableCount();
+    vector<double> points(rows), results(rows);
+    vector<vector<double> > constantColumns(variables);
+    vector<const double *> columns(variables + 1);
+    for (int v = 0; v < variables; v++){
+        if (v == integration.variable){
+            columns[v] = &points[0];
+        } else {
+            constantColumns[v].assign(rows, integration.values[v]);
+            columns[v] = &constantColumns[v][0];
+        }
+    }
+    for (int i = 0; i < count; i++){
+        double center = 0.5 * (intervals[i].left + intervals[i].right);
+        double halfWidth = 0.5 * (intervals[i].right - intervals[i].left);
+        double * x = &points[i * RULE_POINTS];
+        for (int k = 0; k < 7; k++){
+            x[k] = center - halfWidth * NODES[k];
+            x[RULE_POINTS - 1 - k] = center + halfWidth * NODES[k];
+        }
+        x[7] = center;
+    }
+    integration.expr->evaluateBatch(&columns[0], rows, &results[0]);
+    for (int i = 0; i < count; i++){
+        const double * f = &results[i * RULE_POINTS];
+        double halfWidth = 0.5 * (intervals[i].right - intervals[i].left);
+        double kronrod = KRONROD_WEIGHTS[7] * f[7];
+        double gauss = GAUSS_WEIGHTS[3] * f[7];
+        double absolute = KRONROD_WEIGHTS[7] * fabs(f[7]);
+        for (int k = 0; k < 7; k++){
+            double pair = f[k] + f[RULE_POINTS - 1 - k];
+            kronrod += KRONROD_WEIGHTS[k] * pair;
+            absolute += KRONROD_WEIGHTS[k] * (fabs(f[k]) + fabs(f[RULE_POINTS - 1 - k]));
+            if (k % 2 == 1) gauss += GAUSS_WEIGHTS[k / 2] * pair;
+        }
+        integrals[i] = kronrod * halfWidth;
+        errors[i] = fabs(kronrod - gauss) * halfWidth;
+        if (absolutes != NULL) absolutes[i] = absolute * halfWidth;
+    }
+}
+
+/*
+ * Function: refine
+ * Usage: refine(integration, intervals);
+ * ______________________________________________________
+ *
+ * Evaluates the subintervals, keeps those within their share of the
+ * tolerance and halves the others, until none is left. Groups of
+ * halves beyond one batch are submitted as new tasks for idle workers,
+ * unless the integration is serial.
+ */
+static void refine(Integration & integration, vector<Subinterval> intervals){
+    ThreadPool & pool = ThreadPool::shared();
+    vector<double> integrals, errors;
+    while (!intervals.empty()){
+        int count = intervals.size();
+        integrals.resize(count);
+        errors.resize(count);
+        applyRule(integration, intervals, &integrals[0], &errors[0], NULL);
+        vector<Subinterval> next;
+        ReproducibleSum sum, errorSum;
+        for (int i = 0; i < count; i++){
+            const Subinterval & interval = intervals[i];
+            double width = interval.right - interval.left;
+            double limit = integration.tolerance * width / integration.length;
+            double middle = 0.5 * (interval.left + interval.right);
+            // a NaN error is accepted too, the result is NaN anyway
+            if (!(errors[i] > limit) || interval.depth >= MAX_DEPTH
+                    || middle <= interval.left || middle >= interval.right){
+                sum.add(integrals[i]);
+                errorSum.add(errors[i]);
+            } else {
+                Subinterval left = { interval.left, middle, interval.depth + 1 };
+                Subinterval right = { middle, interval.right, interval.depth + 1 };
+                next.push_back(left);
+                next.push_back(right);
+            }
+        }
+        {
+            lock_guard<mutex> lock(integration.lock);
+            integration.sum.merge(sum);
+            integration.errorSum.merge(errorSum);
+        }
+        while (!integration.serial && (int) next.size() > INTERVALS_PER_TASK){
+            vector<Subinterval> part(next.end() - INTERVALS_PER_TASK, next.end());
+            next.resize(next.size() - INTERVALS_PER_TASK);
+            Integration * shared = &integration;
+            pool.submit([shared, part]{ refine(*shared, part); });
+        }
+        intervals.swap(next);
+    }
+}
+
+double integrate(const Expression & expr, int variable, const double * values,
+                 double a, double b, double * errorEstimate){
+    if (!isfinite(a) || !isfinite(b)){
+        error("integrate: limits must be finite");
+    }
+    if (a == b){
+        if (errorEstimate != NULL) *errorEstimate = 0;
+        return 0;
+    }
+    double sign = 1;
+    if (a > b){
+        swap(a, b);
+        sign = -1;
+    }
+    Integration integration;
+    integration.expr = &expr;
+    integration.variable = variable;
+    integration.values.assign(values, values + expr.variableCount());
+    integration.length = b - a;
+
+    // the first pass sets the tolerance from the integral of |f|, which
+    // stays meaningful when positive and negative parts cancel
+    vector<Subinterval> initial;
+    for (int i = 0; i < INITIAL_INTERVALS; i++){
+        Subinterval interval = { a + (b - a) * i / INITIAL_INTERVALS,
+                                 i + 1 == INITIAL_INTERVALS ? b : a + (b - a) * (i + 1) / INITIAL_INTERVALS, 0 };
+        initial.push_back(interval);
+    }
+    vector<double> integrals(INITIAL_INTERVALS), errors(INITIAL_INTERVALS), absolutes(INITIAL_INTERVALS);
+    applyRule(integration, initial, &integrals[0], &errors[0], &absolutes[0]);
+    double absoluteIntegral = 0;
+    for (int i = 0; i < INITIAL_INTERVALS; i++) absoluteIntegral += absolutes[i];
+    integration.tolerance = max(ABSOLUTE_TOLERANCE, RELATIVE_TOLERANCE * absoluteIntegral);
+
+    integration.serial = ThreadPool::isInTask();
+    if (integration.serial){
+        refine(integration, initial);
+    } else {
+        ThreadPool & pool = ThreadPool::shared();
+        Integration * shared = &integration;
+        pool.submit([shared, initial]{ refine(*shared, initial); });
+        pool.wait();
+    }
+
+    // the accepted subintervals do not depend on the scheduling, and
+    // their exact sum not on the order in which the tasks add them
+    if (errorEstimate != NULL) *errorEstimate = integration.errorSum.result();
+    return sign * integration.sum.result();
+}
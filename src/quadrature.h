@@ -0,0 +1,37 @@
+/* File: quadrature.h
+ * -----------------------------------
+ *
+ * This file exports numerical integration of compiled expressions.
+ */
+
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include "expression.h"
+
+/*
+ * Function: integrate
+ * Usage: double area = integrate(expr, variable, values, a, b);
+ * ______________________________________________________
+ *
+ * Integrates the expression over [a, b] by one variable with adaptive
+ * 15-point Gauss-Kronrod quadrature. Subintervals whose error estimate
+ * exceeds their share of the tolerance are halved, and the work is
+ * spread over the shared thread pool; the integrand is computed with
+ * batch evaluation, all nodes of a group of subintervals at once.
+ * Whether a subinterval is halved depends only on the subinterval, and
+ * the accepted ones are added with ReproducibleSum, so the result is
+ * bit-identical for any number of threads.
+ *
+ * @param expr - compiled integrand
+ * @param variable - index of the variable of integration
+ * @param values - values of the other variables of the expression
+ * @param a - lower limit
+ * @param b - upper limit
+ * @param errorEstimate - receives the estimated absolute error, if not NULL
+ * @return - value of the integral
+ */
+double integrate(const Expression & expr, int variable, const double * values,
+                 double a, double b, double * errorEstimate = NULL);
+
+#endif // QUADRATURE_H
@@ -0,0 +1,526 @@
+/* File: rational.cpp
+ * -----------------------------------
+ *
+ * Implementation of the Rational class.
+ */
+
+#include "rational.h"
+#include <climits>
+#include <cmath>
+#include "error.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* Largest number of decimal digits an exact integer power may produce
+ * before pow falls back to BigFloat */
+static const long long MAX_EXACT_POWER_DIGITS = 1000000;
+
+/* Largest decimal exponent accepted in a number literal */
+static const long long MAX_LITERAL_EXPONENT = 1000000;
+
+/*
+ * Function: countTrailingZeros
+ * Usage: int zeros = countTrailingZeros(value);
+ * ______________________________________________________
+ *
+ * Returns the number of trailing zero bits of a nonzero value
+ */
+static int countTrailingZeros(unsigned long long value){
+#if defined(__GNUC__)
+    return __builtin_ctzll(value);
+#else
+    int count = 0;
+    while ((value & 1) == 0){
+        value >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+/*
+ * Function: binaryGcd
+ * Usage: unsigned long long g = binaryGcd(a, b);
+ * ______________________________________________________
+ *
+ * Stein's algorithm: only shifts and subtractions, no divisions
+ */
+static unsigned long long binaryGcd(unsigned long long a, unsigned long long b){
+    if (a == 0) return b;
+    if (b == 0) return a;
+    int shift = countTrailingZeros(a | b);
+    a >>= countTrailingZeros(a);
+    do {
+        b >>= countTrailingZeros(b);
+        if (a > b){
+            unsigned long long t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+    } while (b != 0);
+    return a << shift;
+}
+
+/*
+ * Function: bigGcd
+ * Usage: BigInt g = bigGcd(a, b);
+ * ______________________________________________________
+ *
+ * Euclid's algorithm on non-negative BigInt values
+ */
+static BigInt bigGcd(BigInt a, BigInt b){
+    while (!b.isZero()){
+        BigInt r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/*
+ * Function: checkedAdd / checkedMultiply
+ * Usage: if (checkedAdd(a, b, res))...
+ * ______________________________________________________
+ *
+ * Compute a + b or a * b on long long values other than LLONG_MIN.
+ * Return false instead if the result would leave the range
+ * [-LLONG_MAX, LLONG_MAX], so the caller can switch to BigInt.
+ */
+static bool checkedAdd(long long a, long long b, long long & res){
+    if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < -LLONG_MAX - b)){
+        return false;
+    }
+    res = a + b;
+    return true;
+}
+
+static bool checkedMultiply(long long a, long long b, long long & res){
+    if (a == 0 || b == 0){
+        res = 0;
+        return true;
+    }
+    unsigned long long absA = a < 0 ? -a : a;
+    unsigned long long absB = b < 0 ? -b : b;
+    if (absA > (unsigned long long) LLONG_MAX / absB){
+        return false;
+    }
+    res = a * b;
+    return true;
+}
+
+/*
+ * Function: fitsSmall
+ * Usage: if (fitsSmall(n))...
+ * ______________________________________________________
+ *
+ * Returns true if the integer can be kept in the 64-bit form
+ */
+static bool fitsSmall(const BigInt & n){
+    return n.fitsLongLong() && n.toLongLong() != LLONG_MIN;
+}
+
+/*
+ * Function: powerOfTen
+ * Usage: BigInt p = powerOfTen(digits);
+ * ______________________________________________________
+ *
+ * Returns 10^digits
+ */
+static BigInt powerOfTen(long long digits){
+    BigInt res(1);
+    res.shiftLimbs(digits / BigInt::BASE_DIGITS);
+    for (long long i = 0; i < digits % BigInt::BASE_DIGITS; i++){
+        res.multiplySmall(10);
+    }
+    return res;
+}
+
+/*
+ * Function: integerSqrt
+ * Usage: BigInt root = integerSqrt(n);
+ * ______________________________________________________
+ *
+ * Returns floor(sqrt(n)) of a non-negative integer by Newton
+ * iteration, seeded from the leading digits so it starts just
+ * above the root
+ */
+static BigInt integerSqrt(const BigInt & n){
+    if (n.isZero()) return n;
+    string digits = n.toString();
+    long long dropped = digits.length() > 16 ? digits.length() - 16 : 0;
+    if (dropped % 2 != 0) dropped++;
+    double leading = stringToDouble(digits.substr(0, digits.length() - dropped));
+    BigInt x = BigInt((long long) sqrt(leading) + 2) * powerOfTen(dropped / 2);
+    while (true){
+        BigInt y = x + n / x;
+        y.divideSmall(2);
+        if (!(y < x)) break;
+        x = y;
+    }
+    return x;
+}
+
+Rational::Rational(){
+    small = true;
+    exact = true;
+    num = 0;
+    den = 1;
+}
+
+Rational::Rational(long long value){
+    exact = true;
+    if (value == LLONG_MIN){
+        *this = makeBig(BigInt(value), BigInt(1));
+    } else {
+        small = true;
+        num = value;
+        den = 1;
+    }
+}
+
+Rational::Rational(const BigInt & numerator, const BigInt & denominator){
+    *this = makeBig(numerator, denominator);
+}
+
+Rational::Rational(const string & str){
+    bool negative = false;
+    int i = 0;
+    int len = str.length();
+    if (i < len && (str[i] == '-' || str[i] == '+')){
+        negative = str[i] == '-';
+        i++;
+    }
+    string digits;
+    long long decimalExponent = 0;
+    bool seenPoint = false;
+    for (; i < len; i++){
+        char ch = str[i];
+        if (ch >= '0' && ch <= '9'){
+            digits += ch;
+            if (seenPoint) decimalExponent--;
+        } else if (ch == '.' && !seenPoint){
+            seenPoint = true;
+        } else if ((ch == 'e' || ch == 'E') && !digits.empty() && i + 1 < len){
+            BigInt shift(str.substr(i + 1));
+            if (BigInt::compare(shift.abs(), BigInt(MAX_LITERAL_EXPONENT)) > 0){
+                error("Rational: exponent out of range in \"" + str + "\"");
+            }
+            decimalExponent += shift.toLongLong();
+            break;
+        } else {
+            error("Rational: illegal number format \"" + str + "\"");
+        }
+    }
+    if (digits.empty()){
+        error("Rational: illegal number format \"" + str + "\"");
+    }
+    BigInt numerator(digits);
+    BigInt denominator(1);
+    if (decimalExponent >= 0){
+        numerator = numerator * powerOfTen(decimalExponent);
+    } else {
+        denominator = powerOfTen(-decimalExponent);
+    }
+    if (negative) numerator.negate();
+    *this = makeBig(numerator, denominator);
+}
+
+Rational Rational::fromBigFloat(const BigFloat & x){
+    BigInt mantissa = x.getMantissa();
+    long long exponent = x.getExponent();
+    BigInt scale(1);
+    if (exponent >= 0){
+        mantissa.shiftLimbs(exponent);
+    } else {
+        scale.shiftLimbs(-exponent);
+    }
+    return makeBig(mantissa, scale);
+}
+
+bool Rational::isZero() const {
+    return small ? num == 0 : bigNum.isZero();
+}
+
+bool Rational::isNegative() const {
+    return small ? num < 0 : bigNum.isNegative();
+}
+
+bool Rational::isInteger() const {
+    return small ? den == 1 : bigDen == BigInt(1);
+}
+
+bool Rational::isExact() const {
+    return exact;
+}
+
+BigInt Rational::numerator() const {
+    return small ? BigInt(num) : bigNum;
+}
+
+BigInt Rational::denominator() const {
+    return small ? BigInt(den) : bigDen;
+}
+
+double Rational::toDouble() const {
+    // both parts exact in a double: a single correctly rounded division
+    const long long EXACT_LIMIT = 1LL << 53;
+    if (small && num <= EXACT_LIMIT && num >= -EXACT_LIMIT && den <= EXACT_LIMIT){
+        return (double) num / (double) den;
+    }
+    return toBigFloat().toDouble();
+}
+
+BigFloat Rational::toBigFloat() const {
+    if (small){
+        return BigFloat(num) / BigFloat(den);
+    }
+    return BigFloat(bigNum) / BigFloat(bigDen);
+}
+
+string Rational::toString() const {
+    if (small){
+        // BigInt prints the full 64 bits also where long is 32 bits
+        string numText = BigInt(num).toString();
+        return den == 1 ? numText : numText + "/" + BigInt(den).toString();
+    }
+    return isInteger() ? bigNum.toString() : bigNum.toString() + "/" + bigDen.toString();
+}
+
+int Rational::compare(const Rational & a, const Rational & b){
+    if (a.small && b.small){
+        if (a.den == b.den){
+            return a.num < b.num ? -1 : (a.num > b.num ? 1 : 0);
+        }
+        long long left, right;
+        if (checkedMultiply(a.num, b.den, left) && checkedMultiply(b.num, a.den, right)){
+            return left < right ? -1 : (left > right ? 1 : 0);
+        }
+    }
+    return BigInt::compare(a.numerator() * b.denominator(), b.numerator() * a.denominator());
+}
+
+Rational Rational::operator-() const {
+    Rational res = *this;
+    if (small){
+        res.num = -num;
+    } else {
+        res.bigNum.negate();
+    }
+    return res;
+}
+
+Rational operator+(const Rational & a, const Rational & b){
+    Rational res;
+    bool done = false;
+    if (a.small && b.small){
+        // a/b + c/d = (a * (d/g) + c * (b/g)) / (b * (d/g)), g = gcd(b, d)
+        long long g = binaryGcd(a.den, b.den);
+        long long left, right, n, d;
+        if (checkedMultiply(a.num, b.den / g, left) && checkedMultiply(b.num, a.den / g, right)
+                && checkedAdd(left, right, n) && checkedMultiply(a.den, b.den / g, d)){
+            res = Rational::makeSmall(n, d);
+            done = true;
+        }
+    }
+    if (!done){
+        BigInt aDen = a.denominator();
+        BigInt bDen = b.denominator();
+        res = Rational::makeBig(a.numerator() * bDen + b.numerator() * aDen, aDen * bDen);
+    }
+    res.exact = a.exact && b.exact;
+    return res;
+}
+
+Rational operator-(const Rational & a, const Rational & b){
+    return a + (-b);
+}
+
+Rational operator*(const Rational & a, const Rational & b){
+    Rational res;
+    bool done = false;
+    if (a.small && b.small){
+        // cancel crosswise first, so the product is already reduced
+        long long g1 = binaryGcd(a.num < 0 ? -a.num : a.num, b.den);
+        long long g2 = binaryGcd(b.num < 0 ? -b.num : b.num, a.den);
+        if (g1 == 0) g1 = 1;
+        if (g2 == 0) g2 = 1;
+        long long n, d;
+        if (checkedMultiply(a.num / g1, b.num / g2, n) && checkedMultiply(a.den / g2, b.den / g1, d)){
+            res = Rational::makeSmall(n, d);
+            done = true;
+        }
+    }
+    if (!done){
+        res = Rational::makeBig(a.numerator() * b.numerator(), a.denominator() * b.denominator());
+    }
+    res.exact = a.exact && b.exact;
+    return res;
+}
+
+Rational operator/(const Rational & a, const Rational & b){
+    if (b.isZero()){
+        error("Division by zero");
+    }
+    Rational inverse;
+    if (b.small){
+        inverse = Rational::makeSmall(b.den, b.num);
+    } else {
+        inverse = Rational::makeBig(b.bigDen, b.bigNum);
+    }
+    inverse.exact = b.exact;
+    return a * inverse;
+}
+
+Rational sqrt(const Rational & x){
+    if (x.isNegative()){
+        error("sqrt: negative argument");
+    }
+    BigInt n = x.numerator();
+    BigInt d = x.denominator();
+    BigInt rootN = integerSqrt(n);
+    BigInt rootD = integerSqrt(d);
+    if (rootN * rootN == n && rootD * rootD == d){
+        Rational res(rootN, rootD);
+        res.exact = x.exact;
+        return res;
+    }
+    Rational res = Rational::fromBigFloat(sqrt(x.toBigFloat()));
+    res.exact = false;
+    return res;
+}
+
+Rational pow(const Rational & base, const Rational & exponent){
+    if (exponent.isInteger() && exponent.small){
+        long long n = exponent.num;
+        if (base.isZero() && n < 0){
+            error("Division by zero");
+        }
+        unsigned long long k = n < 0 ? -n : n;
+        double digits = (double) (base.numerator().toString().length() + base.denominator().toString().length()) * k;
+        if (base.isZero() || k == 0 || digits <= MAX_EXACT_POWER_DIGITS){
+            // exact power by repeated squaring
+            Rational res(1);
+            Rational factor = base;
+            while (k > 0){
+                if (k & 1) res = res * factor;
+                k >>= 1;
+                if (k > 0) factor = factor * factor;
+            }
+            if (n < 0) res = Rational(1) / res;
+            res.exact = base.exact && exponent.exact;
+            return res;
+        }
+    } else if (exponent.small && exponent.den == 2 && !base.isNegative()){
+        // x^(n/2) = sqrt(x)^n, exact whenever x is a perfect square
+        Rational root = sqrt(base);
+        if (root.exact){
+            Rational res = pow(root, Rational(exponent.num));
+            res.exact = res.exact && exponent.exact;
+            return res;
+        }
+    }
+    Rational res = Rational::fromBigFloat(pow(base.toBigFloat(), exponent.toBigFloat()));
+    res.exact = false;
+    return res;
+}
+
+Rational sin(const Rational & x){
+    if (x.isZero()) return x;
+    Rational res = Rational::fromBigFloat(sin(x.toBigFloat()));
+    res.exact = false;
+    return res;
+}
+
+Rational cos(const Rational & x){
+    if (x.isZero()){
+        Rational res(1);
+        res.exact = x.exact;
+        return res;
+    }
+    Rational res = Rational::fromBigFloat(cos(x.toBigFloat()));
+    res.exact = false;
+    return res;
+}
+
+Rational tan(const Rational & x){
+    if (x.isZero()) return x;
+    Rational res = Rational::fromBigFloat(tan(x.toBigFloat()));
+    res.exact = false;
+    return res;
+}
+
+Rational log(const Rational & x){
+    if (x == Rational(1)){
+        Rational res;
+        res.exact = x.exact;
+        return res;
+    }
+    Rational res = Rational::fromBigFloat(log(x.toBigFloat()));
+    res.exact = false;
+    return res;
+}
+
+bool operator==(const Rational & a, const Rational & b){
+    return Rational::compare(a, b) == 0;
+}
+
+bool operator!=(const Rational & a, const Rational & b){
+    return Rational::compare(a, b) != 0;
+}
+
+bool operator<(const Rational & a, const Rational & b){
+    return Rational::compare(a, b) < 0;
+}
+
+bool operator>(const Rational & a, const Rational & b){
+    return Rational::compare(a, b) > 0;
+}
+
+ostream & operator<<(ostream & os, const Rational & r){
+    return os << r.toString();
+}
+
+Rational Rational::makeSmall(long long n, long long d){
+    if (d == 0){
+        error("Division by zero");
+    }
+    if (d < 0){
+        n = -n;
+        d = -d;
+    }
+    Rational res;
+    unsigned long long g = binaryGcd(n < 0 ? -n : n, d);
+    res.num = n / (long long) g;
+    res.den = d / (long long) g;
+    return res;
+}
+
+Rational Rational::makeBig(BigInt n, BigInt d){
+    if (d.isZero()){
+        error("Division by zero");
+    }
+    if (d.isNegative()){
+        n.negate();
+        d.negate();
+    }
+    if (fitsSmall(n) && fitsSmall(d)){
+        return makeSmall(n.toLongLong(), d.toLongLong());
+    }
+    BigInt g = bigGcd(n.abs(), d);
+    if (g != BigInt(1)){
+        n = n / g;
+        d = d / g;
+    }
+    Rational res;
+    if (fitsSmall(n) && fitsSmall(d)){
+        res.num = n.toLongLong();
+        res.den = d.toLongLong();
+    } else {
+        res.small = false;
+        res.bigNum = n;
+        res.bigDen = d;
+    }
+    return res;
+}
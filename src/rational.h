@@ -0,0 +1,146 @@
+/* File: rational.h
+ * -----------------------------------
+ *
+ * This file exports an exact rational number used by
+ * the rational calculation mode.
+ */
+
+#ifndef RATIONAL_H
+#define RATIONAL_H
+
+#include <iostream>
+#include <string>
+#include "bigint.h"
+#include "bigfloat.h"
+
+/* Class Rational
+ * --------------------------------
+ * This class implements a fraction numerator / denominator kept in
+ * lowest terms with a positive denominator. While both parts fit in
+ * 64 bits the arithmetic runs on machine integers (with binary GCD)
+ * and only moves to BigInt when an operation would overflow.
+ * Functions with irrational results (sin, cos, tan, log, sqrt and
+ * fractional powers) are computed with BigFloat at its current
+ * precision, converted back to a fraction and marked as inexact.
+ */
+class Rational {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: Rational
+     * Usage: Rational zero;
+     *        Rational r(3);
+     *        Rational r(numerator, denominator);
+     *        Rational r("0.1");
+     * -----------------------------------------------------
+     * Initializes a new fraction; decimal strings are converted exactly
+     */
+    Rational();
+    Rational(long long value);
+    Rational(const BigInt & numerator, const BigInt & denominator);
+    explicit Rational(const std::string & str);
+
+    /* Method: fromBigFloat
+     * Usage: Rational r = Rational::fromBigFloat(x);
+     * -----------------------------------------------------
+     * Returns the exact value of a decimal floating-point number
+     */
+    static Rational fromBigFloat(const BigFloat & x);
+
+    /* Method: isZero / isNegative / isInteger
+     * Usage: if (r.isInteger())...
+     * -----------------------------------------------------
+     * Simple predicates on the value
+     */
+    bool isZero() const;
+    bool isNegative() const;
+    bool isInteger() const;
+
+    /* Method: isExact
+     * Usage: if (!r.isExact())...
+     * -----------------------------------------------------
+     * Returns false if the value went through a floating-point
+     * fallback and so is only an approximation
+     */
+    bool isExact() const;
+
+    /* Method: numerator / denominator
+     * Usage: BigInt n = r.numerator();
+     * -----------------------------------------------------
+     * Returns the parts of the reduced fraction
+     */
+    BigInt numerator() const;
+    BigInt denominator() const;
+
+    /* Method: toDouble / toBigFloat
+     * Usage: double value = r.toDouble();
+     * -----------------------------------------------------
+     * Returns the nearest value of the floating-point type
+     */
+    double toDouble() const;
+    BigFloat toBigFloat() const;
+
+    /* Method: toString
+     * Usage: string str = r.toString();
+     * -----------------------------------------------------
+     * Returns "numerator/denominator", or just the numerator
+     * for integers
+     */
+    std::string toString() const;
+
+    /* Method: compare
+     * Usage: int cmp = Rational::compare(a, b);
+     * -----------------------------------------------------
+     * Returns a negative number, zero or a positive number
+     * as a is less than, equal to or greater than b
+     */
+    static int compare(const Rational & a, const Rational & b);
+
+    Rational operator-() const;
+    friend Rational operator+(const Rational & a, const Rational & b);
+    friend Rational operator-(const Rational & a, const Rational & b);
+    friend Rational operator*(const Rational & a, const Rational & b);
+    friend Rational operator/(const Rational & a, const Rational & b);
+
+    friend Rational sqrt(const Rational & x);
+    friend Rational pow(const Rational & base, const Rational & exponent);
+    friend Rational sin(const Rational & x);
+    friend Rational cos(const Rational & x);
+    friend Rational tan(const Rational & x);
+    friend Rational log(const Rational & x);
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* True while the value is held in num / den */
+    bool small;
+
+    /* False once a floating-point fallback was involved */
+    bool exact;
+
+    /* Machine-integer representation (den > 0) */
+    long long num;
+    long long den;
+
+    /* BigInt representation, used when small is false */
+    BigInt bigNum;
+    BigInt bigDen;
+
+    /* Method: makeSmall / makeBig
+     * Usage: Rational r = makeSmall(n, d);
+     * ------------------------------------------------
+     * Build a reduced fraction; makeBig moves back to the
+     * machine-integer form when both parts fit
+     */
+    static Rational makeSmall(long long n, long long d);
+    static Rational makeBig(BigInt n, BigInt d);
+};
+
+bool operator==(const Rational & a, const Rational & b);
+bool operator!=(const Rational & a, const Rational & b);
+bool operator<(const Rational & a, const Rational & b);
+bool operator>(const Rational & a, const Rational & b);
+std::ostream & operator<<(std::ostream & os, const Rational & r);
+
+#endif // RATIONAL_H
@@ -0,0 +1,92 @@
+/* File: selftest.cpp
+ * -----------------------------------
+ *
+ * Implementation of the registry of checks and benchmarks.
+ */
+
+#include "selftest.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "error.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* A registered check or benchmark */
+struct SelfTest {
+    string name;
+    SelfTestFunction function;
+    bool benchmark;
+
+    bool operator <(const SelfTest & other) const {
+        return name < other.name;
+    }
+};
+
+/*
+ * Function: registry
+ * Usage: vector<SelfTest> & tests = registry();
+ * ______________________________________________________
+ *
+ * Returns the registered checks and benchmarks. The registry is made on
+ * first use, before main, and never destroyed, so the order of the static
+ * objects of the program does not matter.
+ */
+static vector<SelfTest> & registry(){
+    static vector<SelfTest> * tests = new vector<SelfTest>;
+    return *tests;
+}
+
+SelfTestRegistration::SelfTestRegistration(const char * name, SelfTestFunction function, bool benchmark){
+    SelfTest test = { name, function, benchmark };
+    registry().push_back(test);
+}
+
+int runSelfTests(const string & filter, bool benchmarks){
+    vector<SelfTest> tests = registry();
+    sort(tests.begin(), tests.end());
+    int passed = 0, failed = 0;
+    for (size_t i = 0; i < tests.size(); i++){
+        if (tests[i].benchmark != benchmarks || toLowerCase(tests[i].name).find(toLowerCase(filter)) == string::npos){
+            continue;
+        }
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        string failure;
+        try {
+            tests[i].function();
+        } catch (ErrorException & ex) {
+            failure = ex.getMessage();
+        } catch (exception & ex) {
+            failure = ex.what();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (failure.empty()){
+            passed++;
+            ostringstream time;
+            time << fixed << setprecision(2) << seconds;
+            cout << "PASS " << tests[i].name << " (" << time.str() << " s)" << endl;
+        } else {
+            failed++;
+            cout << "FAIL " << tests[i].name << ": " << failure << endl;
+        }
+    }
+    cout << passed << " passed, " << failed << " failed" << endl;
+    return failed;
+}
+
+void expect(bool condition, const string & what){
+    if (!condition){
+        error("expected " + what);
+    }
+}
+
+void expectEqual(const string & actual, const string & expected, const string & what){
+    if (actual != expected){
+        error(what + " is \"" + actual + "\", expected \"" + expected + "\"");
+    }
+}
@@ -0,0 +1,90 @@
+/* File: selftest.h
+ * -----------------------------------
+ *
+ * This file exports the registry of the checks and benchmarks of the
+ * calculator. They live in src/test, are built into the program and run
+ * with the :test and :bench commands, for example
+ *   printf ':test\n' | NOCONSOLE=true ./calc
+ */
+
+#ifndef SELFTEST_H
+#define SELFTEST_H
+
+#include <string>
+
+/* A check or a benchmark; a check signals its failure with error() */
+typedef void (*SelfTestFunction)();
+
+/* Class SelfTestRegistration
+ * --------------------------------
+ * Adds a check or a benchmark to the registry when the program starts.
+ * The objects are made by the SELF_TEST and SELF_BENCHMARK macros:
+ *
+ *   SELF_TEST(parserKeepsOrder){
+ *       expectEqual(record, "1 2 +", "record of 1+2");
+ *   }
+ */
+class SelfTestRegistration {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: SelfTestRegistration
+     * Usage: static SelfTestRegistration registration("name", function, false);
+     * -----------------------------------------------------
+     * Registers a check, or a benchmark if benchmark is true
+     */
+    SelfTestRegistration(const char * name, SelfTestFunction function, bool benchmark);
+};
+
+#define SELF_TEST(name) \
+    static void name(); \
+    static SelfTestRegistration name##Registration(#name, name, false); \
+    static void name()
+
+#define SELF_BENCHMARK(name) \
+    static void name(); \
+    static SelfTestRegistration name##Registration(#name, name, true); \
+    static void name()
+
+/*
+ * Function: runSelfTests
+ * Usage: int failures = runSelfTests(filter, false);
+ * ______________________________________________________
+ *
+ * Runs the checks, or the benchmarks, whose names contain the filter in
+ * any case, in the order of their names, and prints a line for each and
+ * the totals
+ *
+ * @param filter - part of the names to run; empty runs all
+ * @param benchmarks - true to run the benchmarks instead of the checks
+ * @return - number of failures
+ */
+int runSelfTests(const std::string & filter, bool benchmarks);
+
+/*
+ * Function: expect
+ * Usage: expect(count == 3, "count of the cells");
+ * ______________________________________________________
+ *
+ * Signals the failure of a check if the condition does not hold
+ *
+ * @param condition - what must hold
+ * @param what - description of the condition
+ */
+void expect(bool condition, const std::string & what);
+
+/*
+ * Function: expectEqual
+ * Usage: expectEqual(output, "Result: 3\n", "output of 1+2");
+ * ______________________________________________________
+ *
+ * Signals the failure of a check, with both texts, if they differ
+ *
+ * @param actual - text computed by the check
+ * @param expected - text it must be
+ * @param what - description of the text
+ */
+void expectEqual(const std::string & actual, const std::string & expected, const std::string & what);
+
+#endif // SELFTEST_H
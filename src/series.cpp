@@ -0,0 +1,158 @@
+/* File: series.cpp
+ * -----------------------------------
+ *
+ * Implementation of range sums and products.
+ */
+
+#include "series.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "accumulator.h"
+#include "threadpool.h"
+
+using namespace std;
+
+/* Indexes per chunk; fixed, so the order of multiplications never
+ * depends on the number of threads */
+static const long long CHUNK_SIZE = 16384;
+
+/* Chunks run at once; their results are merged before the next round,
+ * so the memory does not grow with the range */
+static const long long ROUND_CHUNKS = 1024;
+
+/* Partial products are renormalized beyond 2^+-500 */
+static const double RESCALE_LIMIT = ldexp(1.0, 500);
+
+/* A product kept as mantissa * 2^exponent */
+struct ScaledProduct {
+    double mantissa;
+    long long exponent;
+};
+
+/*
+ * Function: rescale
+ * Usage: rescale(product);
+ * ______________________________________________________
+ *
+ * Moves the binary exponent of the mantissa into the exponent field
+ */
+static void rescale(ScaledProduct & product){
+    // zero, infinity and NaN have no exponent to move
+    if (product.mantissa == 0 || !isfinite(product.mantissa)) return;
+    int exponent;
+    product.mantissa = frexp(product.mantissa, &exponent);
+    product.exponent += exponent;
+}
+
+/*
+ * Function: forEachBlock
+ * Usage: forEachBlock(expr, index, values, start, count, reduce);
+ * ______________________________________________________
+ *
+ * Evaluates the expression for index = start..start+count-1, one block
+ * of rows at a time, and passes each block of results to reduce
+ */
+template <typename Reduce>
+static void forEachBlock(const Expression & expr, int index, const double * values,
+                         long long start, long long count, Reduce reduce){
+    int variables = expr.variableCount();
+    int blockRows = min(count, (long long) Expression::BLOCK_ROWS);
+    vector<vector<double> > constantColumns(variables);
+    vector<double> indexes(blockRows), results(blockRows);
+    vector<const double *> columns(variables + 1);
+    for (int v = 0; v < variables; v++){
+        if (v == index){
+            columns[v] = &indexes[0];
+        } else {
+            constantColumns[v].assign(blockRows, values[v]);
+            columns[v] = &constantColumns[v][0];
+        }
+    }
+    for (long long offset = 0; offset < count; offset += blockRows){
+        int n = min((long long) blockRows, count - offset);
+        for (int r = 0; r < n; r++) indexes[r] = (double) (start + offset + r);
+        expr.evaluateBatch(&columns[0], n, &results[0]);
+        reduce(&results[0], n);
+    }
+}
+
+/*
+ * Function: runChunks
+ * Usage: runChunks(chunks, task, merge);
+ * ______________________________________________________
+ *
+ * Runs task(chunk, slot) for every chunk, in rounds of up to
+ * ROUND_CHUNKS chunks on the shared thread pool; slot is the place of
+ * the chunk in its round. After each round merge(count) takes the
+ * results of its count slots, in the order of the chunks. Inside a
+ * task of the pool the chunks run on the calling thread.
+ */
+template <typename Task, typename Merge>
+static void runChunks(long long chunks, Task task, Merge merge){
+    ThreadPool & pool = ThreadPool::shared();
+    for (long long first = 0; first < chunks; first += ROUND_CHUNKS){
+        long long count = min(ROUND_CHUNKS, chunks - first);
+        if (count == 1 || ThreadPool::isInTask()){
+            for (long long slot = 0; slot < count; slot++) task(first + slot, slot);
+        } else {
+            for (long long slot = 0; slot < count; slot++){
+                pool.submit([task, first, slot]{ task(first + slot, slot); });
+            }
+            pool.wait();
+        }
+        merge(count);
+    }
+}
+
+double sumRange(const Expression & expr, int index, const double * values, long long first, long long last){
+    if (last < first) return 0;
+    long long count = last - first + 1;
+    long long chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    vector<ReproducibleSum> sums(min(chunks, ROUND_CHUNKS));
+    ReproducibleSum sum;
+    runChunks(chunks, [&](long long chunk, long long slot){
+        long long start = first + chunk * CHUNK_SIZE;
+        sums[slot] = ReproducibleSum();
+        forEachBlock(expr, index, values, start, min(CHUNK_SIZE, last - start + 1),
+                     [&](const double * results, int n){
+            sums[slot].add(results, n);
+        });
+    }, [&](long long count){
+        for (long long slot = 0; slot < count; slot++){
+            sum.merge(sums[slot]);
+        }
+    });
+    return sum.result();
+}
+
+double productRange(const Expression & expr, int index, const double * values, long long first, long long last){
+    if (last < first) return 1;
+    long long count = last - first + 1;
+    long long chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    vector<ScaledProduct> products(min(chunks, ROUND_CHUNKS));
+    ScaledProduct res = { 1, 0 };
+    runChunks(chunks, [&](long long chunk, long long slot){
+        long long start = first + chunk * CHUNK_SIZE;
+        ScaledProduct product = { 1, 0 };
+        forEachBlock(expr, index, values, start, min(CHUNK_SIZE, last - start + 1),
+                     [&](const double * results, int n){
+            for (int r = 0; r < n; r++){
+                product.mantissa *= results[r];
+                double magnitude = fabs(product.mantissa);
+                if (magnitude > RESCALE_LIMIT || magnitude < 1 / RESCALE_LIMIT) rescale(product);
+            }
+        });
+        rescale(product);
+        products[slot] = product;
+    }, [&](long long count){
+        for (long long slot = 0; slot < count; slot++){
+            res.mantissa *= products[slot].mantissa;
+            res.exponent += products[slot].exponent;
+            rescale(res);
+        }
+    });
+    // ldexp saturates to 0 or infinity far before these bounds
+    long long exponent = max(-100000LL, min(100000LL, res.exponent));
+    return ldexp(res.mantissa, (int) exponent);
+}
@@ -0,0 +1,44 @@
+/* File: series.h
+ * -----------------------------------
+ *
+ * This file exports sums and products of an expression over a range
+ * of an integer index.
+ */
+
+#ifndef SERIES_H
+#define SERIES_H
+
+#include "expression.h"
+
+/*
+ * Function: sumRange
+ * Usage: double sum = sumRange(expr, index, values, first, last);
+ * ______________________________________________________
+ *
+ * Adds the values of the expression for index = first..last. The range
+ * is cut into chunks, evaluated with batch evaluation on the shared
+ * thread pool and added exactly with ReproducibleSum, so the result is
+ * bit-identical for any number of threads.
+ *
+ * @param expr - compiled expression
+ * @param index - index of the summation variable
+ * @param values - values of the other variables of the expression
+ * @param first - first value of the index
+ * @param last - last value of the index; an empty range gives 0
+ * @return - the sum
+ */
+double sumRange(const Expression & expr, int index, const double * values, long long first, long long last);
+
+/*
+ * Function: productRange
+ * Usage: double product = productRange(expr, index, values, first, last);
+ * ______________________________________________________
+ *
+ * Multiplies the values of the expression for index = first..last, in
+ * the same chunks as sumRange. Partial products keep their binary
+ * exponent apart, so they neither overflow nor underflow before the
+ * final result does. An empty range gives 1.
+ */
+double productRange(const Expression & expr, int index, const double * values, long long first, long long last);
+
+#endif // SERIES_H
@@ -0,0 +1,252 @@
+/* File: solver.cpp
+ * -----------------------------------
+ *
+ * Implementation of the EquationSolver class.
+ */
+
+#include "solver.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include "error.h"
+#include "threadpool.h"
+
+using namespace std;
+
+/* Newton steps before a row falls back to bracketing */
+static const int MAX_NEWTON_STEPS = 60;
+
+/* Ratios of successive Newton steps taken for a root of multiplicity
+ * 2 to 20, and how closely two of them must agree */
+static const double MIN_MULTIPLE_RATIO = 0.45;
+static const double MAX_MULTIPLE_RATIO = 0.95;
+static const double RATIO_AGREEMENT = 1e-3;
+
+/* Whether a row may take such a longer step: after one the next step
+ * must be shorter, or the row goes on with plain Newton steps */
+enum Acceleration { MAY_ACCELERATE, ACCELERATED, NEVER_ACCELERATE };
+
+/* Newton's method has converged when a step is this small relative to x */
+static const double STEP_TOLERANCE = 4 * DBL_EPSILON;
+
+/* First half-width of the search for a sign change, relative to the guess,
+ * and its growth per step */
+static const double INITIAL_BRACKET = 0.01;
+static const double BRACKET_GROWTH = 2;
+static const int MAX_BRACKET_STEPS = 100;
+
+static const int MAX_BRENT_STEPS = 200;
+
+EquationSolver::EquationSolver(const SymbolicExpression & equation, const string & variable)
+    : function(equation.compile()), derivative(equation.derivative(variable).compile()){
+    this->variable = -1;
+    for (int i = 0; i < function.variableCount(); i++){
+        if (function.variableName(i) == variable) this->variable = i;
+    }
+}
+
+double EquationSolver::solve(const double * values, double guess) const {
+    int variables = function.variableCount();
+    vector<const double *> columns(variables + 1);
+    for (int v = 0; v < variables; v++){
+        columns[v] = values + v;
+    }
+    double root;
+    solveBlock(&columns[0], 0, 1, &guess, &root);
+    if (isnan(root)){
+        error("solve: no root found near the guess");
+    }
+    return root;
+}
+
+void EquationSolver::solveBatch(const double * const * columns, int rows,
+                                const double * guesses, double * roots) const {
+    if (rows <= Expression::BLOCK_ROWS || ThreadPool::isInTask()){
+        solveBlock(columns, 0, rows, guesses, roots);
+        return;
+    }
+    // rows are independent, so blocks can be solved in any order
+    ThreadPool & pool = ThreadPool::shared();
+    for (int start = 0; start < rows; start += Expression::BLOCK_ROWS){
+        int count = min((int) Expression::BLOCK_ROWS, rows - start);
+        pool.submit([this, columns, start, count, guesses, roots]{
+            solveBlock(columns, start, count, guesses, roots);
+        });
+    }
+    pool.wait();
+}
+
+int EquationSolver::variableCount() const {
+    return function.variableCount();
+}
+
+void EquationSolver::solveBlock(const double * const * columns, int start, int count,
+                                const double * guesses, double * roots) const {
+    if (count <= 0) return;
+    int variables = function.variableCount();
+    // the rows still iterating; their parameters are packed in the same
+    // order, so every step evaluates exactly the active rows
+    vector<int> lanes(count);
+    vector<double> x(count), f(count), df(count);
+    vector<double> lastDelta(count, 0), lastRatio(count, 0);
+    vector<Acceleration> acceleration(count, MAY_ACCELERATE);
+    vector<vector<double> > packed(variables, vector<double>(count));
+    vector<const double *> packedColumns(variables + 1);
+    for (int k = 0; k < count; k++){
+        lanes[k] = k;
+        x[k] = guesses[start + k];
+    }
+    for (int v = 0; v < variables; v++){
+        if (v != variable){
+            for (int k = 0; k < count; k++) packed[v][k] = columns[v][start + k];
+        }
+        packedColumns[v] = &packed[v][0];
+    }
+    vector<int> failed;
+    for (int step = 0; step < MAX_NEWTON_STEPS && !lanes.empty(); step++){
+        int n = lanes.size();
+        for (int k = 0; k < n; k++) packed[variable][k] = x[lanes[k]];
+        function.evaluateBatch(&packedColumns[0], n, &f[0]);
+        derivative.evaluateBatch(&packedColumns[0], n, &df[0]);
+        int kept = 0;
+        for (int k = 0; k < n; k++){
+            int lane = lanes[k];
+            if (f[k] == 0){
+                roots[start + lane] = x[lane];
+                continue;
+            }
+            double delta = f[k] / df[k];
+            if (!isfinite(f[k]) || !isfinite(delta)){
+                failed.push_back(lane);
+                continue;
+            }
+            // near a root of multiplicity m the steps shrink by (m - 1) / m
+            // only, and an even m gives no sign change for the fallback;
+            // a step m times as long lands on the root
+            double ratio = delta / lastDelta[lane];
+            if (acceleration[lane] == ACCELERATED){
+                acceleration[lane] = fabs(delta) < fabs(lastDelta[lane]) ? MAY_ACCELERATE : NEVER_ACCELERATE;
+            } else if (acceleration[lane] == MAY_ACCELERATE && ratio >= MIN_MULTIPLE_RATIO
+                       && ratio <= MAX_MULTIPLE_RATIO && fabs(ratio - lastRatio[lane]) < RATIO_AGREEMENT){
+                delta *= floor(1 / (1 - ratio) + 0.5);
+                acceleration[lane] = ACCELERATED;
+            }
+            lastDelta[lane] = delta;
+            lastRatio[lane] = ratio;
+            x[lane] -= delta;
+            if (fabs(delta) <= STEP_TOLERANCE * fabs(x[lane])){
+                roots[start + lane] = x[lane];
+                continue;
+            }
+            if (kept != k){
+                for (int v = 0; v < variables; v++) packed[v][kept] = packed[v][k];
+            }
+            lanes[kept++] = lane;
+        }
+        lanes.resize(kept);
+    }
+    failed.insert(failed.end(), lanes.begin(), lanes.end());
+    vector<double> values(variables);
+    for (size_t i = 0; i < failed.size(); i++){
+        int row = start + failed[i];
+        for (int v = 0; v < variables; v++){
+            if (v != variable) values[v] = columns[v][row];
+        }
+        roots[row] = solveBracketed(&values[0], guesses[row]);
+    }
+}
+
+double EquationSolver::solveBracketed(double * values, double guess) const {
+    double fGuess = valueAt(values, guess);
+    if (fGuess == 0) return guess;
+    // walk away from the guess on both sides with growing steps until
+    // the sign changes; a step that leaves the domain of the equation
+    // (non-finite value) is halved instead, to approach its edge
+    double anchor[2] = { guess, guess };
+    double fAnchor[2] = { fGuess, fGuess };
+    double step[2] = { -INITIAL_BRACKET * max(1.0, fabs(guess)), INITIAL_BRACKET * max(1.0, fabs(guess)) };
+    for (int i = 0; i < MAX_BRACKET_STEPS; i++){
+        for (int side = 0; side < 2; side++){
+            double x = anchor[side] + step[side];
+            double fx = valueAt(values, x);
+            if (fx == 0) return x;
+            if (!isfinite(fx)){
+                step[side] *= isfinite(fAnchor[side]) ? 0.5 : BRACKET_GROWTH;
+                continue;
+            }
+            if (isfinite(fAnchor[side]) && (fx < 0) != (fAnchor[side] < 0)){
+                // a sign change across a pole gives NaN, the search goes on
+                double root = solveBrent(values, anchor[side], fAnchor[side], x, fx);
+                if (!isnan(root)) return root;
+            }
+            anchor[side] = x;
+            fAnchor[side] = fx;
+            step[side] *= BRACKET_GROWTH;
+        }
+    }
+    return NAN;
+}
+
+double EquationSolver::solveBrent(double * values, double a, double fa, double b, double fb) const {
+    double bound = min(fabs(fa), fabs(fb));
+    // Brent's method: inverse quadratic interpolation or secant steps,
+    // replaced by bisection whenever they would not shrink the bracket
+    double c = a, fc = fa;
+    double d = b - a, e = d;
+    for (int i = 0; i < MAX_BRENT_STEPS; i++){
+        if ((fb > 0) == (fc > 0)){
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (fabs(fc) < fabs(fb)){
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        double tolerance = 2 * DBL_EPSILON * fabs(b) + DBL_MIN;
+        double middle = 0.5 * (c - b);
+        if (fabs(middle) <= tolerance || fb == 0) break;
+        if (fabs(e) >= tolerance && fabs(fa) > fabs(fb)){
+            double s = fb / fa;
+            double p, q;
+            if (a == c){
+                p = 2 * middle * s;
+                q = 1 - s;
+            } else {
+                double r = fb / fc;
+                q = fa / fc;
+                p = s * (2 * middle * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0){
+                q = -q;
+            } else {
+                p = -p;
+            }
+            if (2 * p < min(3 * middle * q - fabs(tolerance * q), fabs(e * q))){
+                e = d;
+                d = p / q;
+            } else {
+                d = e = middle;
+            }
+        } else {
+            d = e = middle;
+        }
+        a = b;
+        fa = fb;
+        b += fabs(d) > tolerance ? d : (middle > 0 ? tolerance : -tolerance);
+        fb = valueAt(values, b);
+    }
+    // at a pole the values grow instead of going to zero
+    return fabs(fb) <= bound ? b : NAN;
+}
+
+double EquationSolver::valueAt(double * values, double x) const {
+    values[variable] = x;
+    return function.evaluate<double>(values);
+}
@@ -0,0 +1,111 @@
+/* File: solver.h
+ * -----------------------------------
+ *
+ * This file exports the solution of equations f(x) = 0 for one
+ * variable, singly or for many parameter sets at once.
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <string>
+#include "expression.h"
+#include "symbolic.h"
+
+/* Class EquationSolver
+ * --------------------------------
+ * This class finds a root of an equation by one of its variables; the
+ * other variables are parameters. It runs Newton's method with the
+ * symbolic derivative of the equation. A row for which Newton's method
+ * fails (zero or non-finite derivative, no convergence) falls back to
+ * searching a sign change around the guess and Brent's method, which
+ * needs no derivative and always converges on a bracket. Near a root
+ * of multiplicity m, where Newton's steps only shrink by (m - 1) / m and
+ * an even m leaves no sign change to bracket, the ratio of successive
+ * steps gives m and a row takes a step m times as long. The guess
+ * should lie where the equation is defined.
+ *
+ * The batch version runs Newton's method on a block of rows at a time:
+ * every step evaluates the equation and its derivative for all rows that
+ * have not converged yet with batch evaluation, then drops converged rows
+ * from the block, so each row does only the steps it needs. Blocks are
+ * solved in parallel on the shared thread pool.
+ */
+class EquationSolver {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: EquationSolver
+     * Usage: EquationSolver solver(symbolic, "x");
+     * -----------------------------------------------------
+     * Prepares the equation and its derivative by the variable
+     */
+    EquationSolver(const SymbolicExpression & equation, const std::string & variable);
+
+    /* Method: solve
+     * Usage: double root = solver.solve(values, guess);
+     * -----------------------------------------------------
+     * Returns a root near the guess, with the parameters taken from values
+     * (the value of the solved variable is ignored). Signals an error if
+     * no root is found.
+     */
+    double solve(const double * values, double guess) const;
+
+    /* Method: solveBatch
+     * Usage: solver.solveBatch(columns, rows, guesses, roots);
+     * -----------------------------------------------------
+     * Solves the equation for each row; columns[v][row] is the value of
+     * parameter v in that row (the column of the solved variable is not
+     * used). A row without a root found gets NaN.
+     */
+    void solveBatch(const double * const * columns, int rows, const double * guesses, double * roots) const;
+
+    /* Method: variableCount
+     * Usage: int count = solver.variableCount();
+     * -----------------------------------------------------
+     * Returns the number of variables, including the solved one
+     */
+    int variableCount() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    Expression function;
+    Expression derivative;
+    int variable;
+
+    /* Method: solveBlock
+     * Usage: solveBlock(columns, start, count, guesses, roots);
+     * ------------------------------------------------
+     * Solves rows start..start+count-1 of a batch
+     */
+    void solveBlock(const double * const * columns, int start, int count,
+                    const double * guesses, double * roots) const;
+
+    /* Method: solveBracketed
+     * Usage: double root = solveBracketed(values, guess);
+     * ------------------------------------------------
+     * The fallback: searches sign changes around the guess and narrows
+     * them with Brent's method. values must have room for the solved
+     * variable. Returns NaN if no root is found.
+     */
+    double solveBracketed(double * values, double guess) const;
+
+    /* Method: solveBrent
+     * Usage: double root = solveBrent(values, a, fa, b, fb);
+     * ------------------------------------------------
+     * Brent's method on a bracket [a, b] with values of opposite signs;
+     * returns NaN if the sign change turns out to be a pole
+     */
+    double solveBrent(double * values, double a, double fa, double b, double fb) const;
+
+    /* Method: valueAt
+     * Usage: double f = valueAt(values, x);
+     * ------------------------------------------------
+     * Evaluates the equation with the solved variable set to x
+     */
+    double valueAt(double * values, double x) const;
+};
+
+#endif // SOLVER_H
@@ -0,0 +1,313 @@
+/* File: spreadsheet.cpp
+ * -----------------------------------
+ *
+ * Implementation of the Spreadsheet class.
+ */
+
+#include "spreadsheet.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include "builtins.h"
+#include "calc.h"
+#include "error.h"
+#include "expression.h"
+#include "threadpool.h"
+
+using namespace std;
+
+Spreadsheet::Spreadsheet(){
+    search = 0;
+}
+
+int Spreadsheet::set(const string & name, const string & formula){
+    PreparedExpression prepared(formula);
+    if (prepared.parameterIndex(name) >= 0){
+        error("Circular reference: " + name + " -> " + name);
+    }
+    int index = cellIndex(name);
+    // a formula that refers to a cell downstream of this one closes a cycle
+    vector<int> dirty, order;
+    collectDownstream(vector<int>(1, index), dirty);
+    for (int i = 0; i < prepared.parameterCount(); i++){
+        unordered_map<string, int>::const_iterator it = indices.find(prepared.parameterName(i));
+        if (it != indices.end() && marks[it->second] == search){
+            string path = name;
+            for (int c = it->second; c != index; c = parents[c]){
+                path += " -> " + cells[c].name;
+            }
+            error("Circular reference: " + path + " -> " + name);
+        }
+    }
+    vector<int> inputs(prepared.parameterCount());
+    for (int i = 0; i < prepared.parameterCount(); i++){
+        inputs[i] = cellIndex(prepared.parameterName(i));
+    }
+    Cell & cell = cells[index];
+    cell.formula = formula;
+    cell.hasFormula = true;
+    cell.prepared = prepared;
+    setInputs(index, inputs);
+    sortCells(dirty, order);
+    recalculate(order);
+    return order.size();
+}
+
+int Spreadsheet::setValue(const string & name, double value){
+    int index = cellIndex(name);
+    vector<int> dirty, order;
+    collectDownstream(vector<int>(1, index), dirty);
+    Cell & cell = cells[index];
+    cell.formula.clear();
+    cell.hasFormula = false;
+    cell.prepared = PreparedExpression();
+    cell.value = value;
+    setInputs(index, vector<int>());
+    sortCells(dirty, order);
+    recalculate(order);
+    return order.size();
+}
+
+int Spreadsheet::setAll(const vector<string> & names, const vector<string> & formulas){
+    vector<PreparedExpression> prepared;
+    vector<int> targets;
+    for (size_t i = 0; i < names.size(); i++){
+        prepared.push_back(PreparedExpression(formulas[i]));
+    }
+    for (size_t i = 0; i < names.size(); i++){
+        targets.push_back(cellIndex(names[i]));
+    }
+    // the old contents, given back if the formulas close a cycle
+    vector<Cell> saved;
+    for (size_t i = 0; i < targets.size(); i++){
+        saved.push_back(cells[targets[i]]);
+    }
+    for (size_t i = 0; i < targets.size(); i++){
+        vector<int> inputs(prepared[i].parameterCount());
+        for (int k = 0; k < prepared[i].parameterCount(); k++){
+            inputs[k] = cellIndex(prepared[i].parameterName(k));
+        }
+        Cell & cell = cells[targets[i]];
+        cell.formula = formulas[i];
+        cell.hasFormula = true;
+        cell.prepared = prepared[i];
+        setInputs(targets[i], inputs);
+    }
+    vector<int> dirty, order;
+    collectDownstream(targets, dirty);
+    if (!sortCells(dirty, order)){
+        string cycle = describeCycle(dirty);
+        for (int i = targets.size() - 1; i >= 0; i--){
+            Cell & cell = cells[targets[i]];
+            cell.formula = saved[i].formula;
+            cell.hasFormula = saved[i].hasFormula;
+            cell.prepared = saved[i].prepared;
+            cell.value = saved[i].value;
+            setInputs(targets[i], saved[i].inputs);
+        }
+        error("Circular reference: " + cycle);
+    }
+    recalculate(order);
+    return order.size();
+}
+
+bool Spreadsheet::contains(const string & name) const {
+    return indices.count(name) > 0;
+}
+
+double Spreadsheet::value(const string & name) const {
+    return findCell(name).value;
+}
+
+const string & Spreadsheet::formula(const string & name) const {
+    return findCell(name).formula;
+}
+
+int Spreadsheet::cellCount() const {
+    return cells.size();
+}
+
+const string & Spreadsheet::cellName(int index) const {
+    return cells[index].name;
+}
+
+int Spreadsheet::cellIndex(const string & name){
+    unordered_map<string, int>::const_iterator it = indices.find(name);
+    if (it != indices.end()) return it->second;
+    if (name.empty() || !isFunction(name) || Expression::isFunctionName(name) || isBuiltinName(name)){
+        error("Invalid cell name: " + name);
+    }
+    Cell cell;
+    cell.name = name;
+    cell.hasFormula = false;
+    cell.value = 0;
+    cells.push_back(cell);
+    marks.push_back(0);
+    parents.push_back(-1);
+    pending.push_back(0);
+    positions.push_back(0);
+    indices[name] = cells.size() - 1;
+    return cells.size() - 1;
+}
+
+const Spreadsheet::Cell & Spreadsheet::findCell(const string & name) const {
+    unordered_map<string, int>::const_iterator it = indices.find(name);
+    if (it == indices.end()){
+        error("Unknown cell: " + name);
+    }
+    return cells[it->second];
+}
+
+void Spreadsheet::collectDownstream(const vector<int> & roots, vector<int> & dirty){
+    // a new search number unmarks every cell at once
+    search++;
+    vector<int> stack;
+    for (size_t i = 0; i < roots.size(); i++){
+        if (marks[roots[i]] != search){
+            marks[roots[i]] = search;
+            parents[roots[i]] = -1;
+            dirty.push_back(roots[i]);
+            stack.push_back(roots[i]);
+        }
+    }
+    while (!stack.empty()){
+        int c = stack.back();
+        stack.pop_back();
+        const vector<int> & dependents = cells[c].dependents;
+        for (size_t i = 0; i < dependents.size(); i++){
+            int d = dependents[i];
+            if (marks[d] != search){
+                marks[d] = search;
+                parents[d] = c;
+                dirty.push_back(d);
+                stack.push_back(d);
+            }
+        }
+    }
+}
+
+void Spreadsheet::setInputs(int index, const vector<int> & inputs){
+    const vector<int> & old = cells[index].inputs;
+    for (size_t i = 0; i < old.size(); i++){
+        vector<int> & dependents = cells[old[i]].dependents;
+        for (size_t k = 0; k < dependents.size(); k++){
+            if (dependents[k] == index){
+                dependents[k] = dependents.back();
+                dependents.pop_back();
+                break;
+            }
+        }
+    }
+    for (size_t i = 0; i < inputs.size(); i++){
+        cells[inputs[i]].dependents.push_back(index);
+    }
+    cells[index].inputs = inputs;
+}
+
+bool Spreadsheet::sortCells(const vector<int> & dirty, vector<int> & order){
+    // a cell is ready when all its marked inputs are in the order
+    for (size_t i = 0; i < dirty.size(); i++){
+        int c = dirty[i];
+        pending[c] = 0;
+        for (size_t k = 0; k < cells[c].inputs.size(); k++){
+            if (marks[cells[c].inputs[k]] == search) pending[c]++;
+        }
+        if (pending[c] == 0) order.push_back(c);
+    }
+    for (size_t next = 0; next < order.size(); next++){
+        const vector<int> & dependents = cells[order[next]].dependents;
+        for (size_t i = 0; i < dependents.size(); i++){
+            int d = dependents[i];
+            if (marks[d] == search && --pending[d] == 0) order.push_back(d);
+        }
+    }
+    return order.size() == dirty.size();
+}
+
+string Spreadsheet::describeCycle(const vector<int> & dirty){
+    // every cell left out has an input that is left out too
+    int c = -1;
+    for (size_t i = 0; i < dirty.size() && c < 0; i++){
+        if (pending[dirty[i]] > 0) c = dirty[i];
+    }
+    vector<int> walk;
+    unordered_map<int, int> steps;
+    while (steps.count(c) == 0){
+        steps[c] = walk.size();
+        walk.push_back(c);
+        const vector<int> & inputs = cells[c].inputs;
+        for (size_t k = 0; k < inputs.size(); k++){
+            if (marks[inputs[k]] == search && pending[inputs[k]] > 0){
+                c = inputs[k];
+                break;
+            }
+        }
+    }
+    string cycle;
+    for (size_t i = steps[c]; i < walk.size(); i++){
+        cycle += cells[walk[i]].name + " -> ";
+    }
+    return cycle + cells[c].name;
+}
+
+void Spreadsheet::recalculate(const vector<int> & order){
+    if ((int) order.size() >= PARALLEL_MIN_CELLS){
+        recalculateParallel(order);
+        return;
+    }
+    for (size_t i = 0; i < order.size(); i++){
+        evaluateCell(order[i]);
+    }
+}
+
+void Spreadsheet::recalculateParallel(const vector<int> & order){
+    vector<atomic<int> > counters(order.size());
+    vector<int> ready;
+    for (size_t i = 0; i < order.size(); i++){
+        int c = order[i];
+        positions[c] = i;
+        int count = 0;
+        for (size_t k = 0; k < cells[c].inputs.size(); k++){
+            if (marks[cells[c].inputs[k]] == search) count++;
+        }
+        counters[i].store(count, memory_order_relaxed);
+        if (count == 0) ready.push_back(c);
+    }
+    ThreadPool & pool = ThreadPool::shared();
+    // runs ready cells; the cells they make ready are run by the same
+    // task, which gives some away when it has more than enough
+    function<void(vector<int>)> run = [&](vector<int> cellsToRun){
+        while (!cellsToRun.empty()){
+            int c = cellsToRun.back();
+            cellsToRun.pop_back();
+            evaluateCell(c);
+            const vector<int> & dependents = cells[c].dependents;
+            for (size_t i = 0; i < dependents.size(); i++){
+                int d = dependents[i];
+                if (marks[d] == search && counters[positions[d]].fetch_sub(1, memory_order_acq_rel) == 1){
+                    cellsToRun.push_back(d);
+                }
+            }
+            if ((int) cellsToRun.size() >= 2 * CELLS_PER_TASK){
+                vector<int> part(cellsToRun.end() - CELLS_PER_TASK, cellsToRun.end());
+                cellsToRun.resize(cellsToRun.size() - CELLS_PER_TASK);
+                pool.submit([&run, part]{ run(part); });
+            }
+        }
+    };
+    for (size_t start = 0; start < ready.size(); start += CELLS_PER_TASK){
+        size_t end = min(ready.size(), start + CELLS_PER_TASK);
+        vector<int> part(ready.begin() + start, ready.begin() + end);
+        pool.submit([&run, part]{ run(part); });
+    }
+    pool.wait();
+}
+
+void Spreadsheet::evaluateCell(int index){
+    Cell & cell = cells[index];
+    if (!cell.hasFormula) return;
+    for (size_t i = 0; i < cell.inputs.size(); i++){
+        cell.prepared.bind(i, cells[cell.inputs[i]].value);
+    }
+    cell.value = cell.prepared.execute();
+}
@@ -0,0 +1,188 @@
+/* File: spreadsheet.h
+ * -----------------------------------
+ *
+ * This file exports a sheet of named cells holding numbers or formulas
+ * of other cells, recalculated incrementally when a cell changes.
+ */
+
+#ifndef SPREADSHEET_H
+#define SPREADSHEET_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "prepared.h"
+
+/* Class Spreadsheet
+ * --------------------------------
+ * This class keeps cells named by words. A cell holds a number or a
+ * formula whose names refer to other cells; a cell that is referred to
+ * before it is set is empty and worth 0. The cells and their references
+ * form a dependency graph stored as arrays of cell indices in both
+ * directions. When a cell changes, only the cells downstream of it are
+ * recalculated, each once, in topological order. A formula that would
+ * make a cell depend on itself is rejected and the sheet is unchanged.
+ *
+ * Large recalculations run on the thread pool without levels or a
+ * shared queue: every cell has an atomic count of its inputs still to
+ * be recalculated, and the thread that brings a count to zero takes
+ * the cell, so independent cells run in parallel as soon as their
+ * inputs are ready.
+ */
+class Spreadsheet {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: Spreadsheet
+     * Usage: Spreadsheet sheet;
+     * -----------------------------------------------------
+     * Initializes an empty sheet
+     */
+    Spreadsheet();
+
+    /* Method: set
+     * Usage: int recalculated = sheet.set("total", "price*qty");
+     * -----------------------------------------------------
+     * Sets the formula of a cell and recalculates the cells that depend
+     * on it. Signals an error for a malformed formula, a name that is not
+     * a word or a circular reference. Returns the number of cells
+     * recalculated, the cell included.
+     */
+    int set(const std::string & name, const std::string & formula);
+
+    /* Method: setValue
+     * Usage: int recalculated = sheet.setValue("price", 9.5);
+     * -----------------------------------------------------
+     * Sets a cell to a number, without parsing, and recalculates the
+     * cells that depend on it
+     */
+    int setValue(const std::string & name, double value);
+
+    /* Method: setAll
+     * Usage: int recalculated = sheet.setAll(names, formulas);
+     * -----------------------------------------------------
+     * Sets the formulas of many cells and recalculates once. If the new
+     * formulas close a cycle, it is found before anything is calculated,
+     * the cells get their old formulas back and an error names the cycle.
+     */
+    int setAll(const std::vector<std::string> & names, const std::vector<std::string> & formulas);
+
+    /* Method: contains / value / formula
+     * Usage: double total = sheet.value("total");
+     * -----------------------------------------------------
+     * Give a cell; the formula of a number or an empty cell is "".
+     * value and formula signal an error for an unknown cell.
+     */
+    bool contains(const std::string & name) const;
+    double value(const std::string & name) const;
+    const std::string & formula(const std::string & name) const;
+
+    /* Method: cellCount / cellName
+     * Usage: for (int i = 0; i < sheet.cellCount(); i++) sheet.cellName(i)...
+     * -----------------------------------------------------
+     * Give the cells in the order they were created
+     */
+    int cellCount() const;
+    const std::string & cellName(int index) const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* A cell; inputs are the cells its formula refers to, in the order
+     * of the parameters of the prepared formula, and dependents the
+     * cells whose formulas refer to it */
+    struct Cell {
+        std::string name;
+        std::string formula;
+        bool hasFormula;
+        PreparedExpression prepared;
+        std::vector<int> inputs;
+        std::vector<int> dependents;
+        double value;
+    };
+
+    std::vector<Cell> cells;
+    std::unordered_map<std::string, int> indices;
+
+    /* Recalculations of fewer cells stay on the calling thread */
+    static const int PARALLEL_MIN_CELLS = 2048;
+
+    /* Ready cells a task takes before it hands some to other threads */
+    static const int CELLS_PER_TASK = 64;
+
+    /* Marks of the current search, the search number and, for every
+     * cell of the search, its predecessor, its inputs not yet ordered
+     * and its position in the order */
+    std::vector<int> marks;
+    int search;
+    std::vector<int> parents;
+    std::vector<int> pending;
+    std::vector<int> positions;
+
+    /* Method: cellIndex
+     * Usage: int index = cellIndex(name);
+     * ------------------------------------------------
+     * Returns the index of a cell, creating an empty cell if needed
+     */
+    int cellIndex(const std::string & name);
+
+    /* Method: findCell
+     * Usage: const Cell & cell = findCell(name);
+     * ------------------------------------------------
+     * Returns a cell; signals an error if there is none
+     */
+    const Cell & findCell(const std::string & name) const;
+
+    /* Method: collectDownstream
+     * Usage: collectDownstream(roots, dirty);
+     * ------------------------------------------------
+     * Puts the cells and all cells that depend on them into dirty and
+     * marks them with a new search
+     */
+    void collectDownstream(const std::vector<int> & roots, std::vector<int> & dirty);
+
+    /* Method: sortCells
+     * Usage: if (sortCells(dirty, order))...
+     * ------------------------------------------------
+     * Puts the marked cells in topological order without calculating
+     * anything; returns false if they contain a cycle
+     */
+    bool sortCells(const std::vector<int> & dirty, std::vector<int> & order);
+
+    /* Method: describeCycle
+     * Usage: string cycle = describeCycle(dirty);
+     * ------------------------------------------------
+     * After sortCells failed, follows the inputs of the cells left out
+     * of the order until one repeats, and returns that cycle
+     */
+    std::string describeCycle(const std::vector<int> & dirty);
+
+    /* Method: setInputs
+     * Usage: setInputs(index, inputs);
+     * ------------------------------------------------
+     * Replaces the inputs of a cell and updates the dependents
+     */
+    void setInputs(int index, const std::vector<int> & inputs);
+
+    /* Method: recalculate / recalculateParallel
+     * Usage: recalculate(order);
+     * ------------------------------------------------
+     * Recalculate the marked cells, given in topological order
+     */
+    void recalculate(const std::vector<int> & order);
+    void recalculateParallel(const std::vector<int> & order);
+
+    /* Method: evaluateCell
+     * Usage: evaluateCell(index);
+     * ------------------------------------------------
+     * Recalculates the value of one cell from the values of its inputs
+     */
+    void evaluateCell(int index);
+
+    /* Sheets are not copied */
+    Spreadsheet(const Spreadsheet &);
+    Spreadsheet & operator =(const Spreadsheet &);
+};
+
+#endif // SPREADSHEET_H
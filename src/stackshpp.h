@@ -9,6 +9,7 @@
 #define STACKSHPP_H
 
 #include <iostream>
+#include <utility>
 
 /* Class StackSHPP<ValueType>
  * --------------------------------
@@ -172,7 +173,7 @@ void StackSHPP<ValueType>::extendArray(){
     array = new ValueType[currentSize];
 
     for (int i = 0; i < count; i++){
-        array[i] = oldArray[i];
+        array[i] = std::move(oldArray[i]); // the old array is deleted, its values are moved
     }
     delete[] oldArray;
 }
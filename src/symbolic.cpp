@@ -0,0 +1,964 @@
+/* File: symbolic.cpp
+ * -----------------------------------
+ *
+ * Implementation of the SymbolicExpression class.
+ */
+
+#include "symbolic.h"
+#include <algorithm>
+#include <sstream>
+#include "builtins.h"
+#include "error.h"
+#include "functions.h"
+#include "rational.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* Longest constant produced by folding */
+static const int MAX_FOLDED_DIGITS = 40;
+
+/* Largest exponent folded by the power rule */
+static const long long MAX_FOLDED_EXPONENT = 64;
+
+/* Shortest text of a shared subexpression written as a definition */
+static const long long SHARED_TEXT_MIN_LENGTH = 40;
+
+/*
+ * Function: decimalText
+ * Usage: if (decimalText(value, text))...
+ * ______________________________________________________
+ *
+ * Writes a fraction as a finite decimal. Returns false if it has no
+ * finite decimal form (the denominator has a prime factor other than
+ * 2 and 5) or the decimal is too long.
+ */
+static bool decimalText(const Rational & value, string & text){
+    BigInt den = value.denominator();
+    int twos = 0, fives = 0;
+    while (den.divideSmall(2) == 0) twos++;
+    den = value.denominator();
+    while (den.divideSmall(5) == 0) fives++;
+    int scale = max(twos, fives);
+    BigInt scaled = value.numerator().abs();
+    for (int i = 0; i < scale; i++) scaled.multiplySmall(10);
+    BigInt remainder;
+    BigInt::divMod(scaled, value.denominator(), scaled, remainder);
+    if (!remainder.isZero()) return false;
+    string digits = scaled.toString();
+    if ((int) digits.length() > MAX_FOLDED_DIGITS) return false;
+    if ((int) digits.length() <= scale){
+        digits = string(scale - digits.length() + 1, '0') + digits;
+    }
+    text = digits.substr(0, digits.length() - scale);
+    if (scale > 0) text += "." + digits.substr(digits.length() - scale);
+    if (value.isNegative()) text = "-" + text;
+    return true;
+}
+
+/*
+ * Function: operatorPrecedence
+ * Usage: int precedence = operatorPrecedence(op);
+ * ______________________________________________________
+ *
+ * Precedence of an operation in the calculator notation; atoms and
+ * function calls have 5, negative values and comparisons 0
+ */
+static int operatorPrecedence(OpCode op){
+    switch (op){
+    case LESS: case GREATER: case LESS_EQUAL: case GREATER_EQUAL: case EQUAL: case NOT_EQUAL: return 0;
+    case ADD: case SUBTRACT: return 1;
+    case MULTIPLY: case DIVIDE: return 2;
+    case POWER: return 3;
+    default: return 5;
+    }
+}
+
+/*
+ * Function: functionName
+ * Usage: string name = functionName(op);
+ * ______________________________________________________
+ *
+ * Name of a function operation, or its operator sign
+ */
+static string functionName(OpCode op){
+    switch (op){
+    case ADD: return "+";
+    case SUBTRACT: return "-";
+    case MULTIPLY: return "*";
+    case DIVIDE: return "/";
+    case POWER: return "^";
+    case LESS: return "<";
+    case GREATER: return ">";
+    case LESS_EQUAL: return "<=";
+    case GREATER_EQUAL: return ">=";
+    case EQUAL: return "==";
+    case NOT_EQUAL: return "!=";
+    case SIN: return "sin";
+    case COS: return "cos";
+    case SQRT: return "sqrt";
+    case TAN: return "tan";
+    default: return "log";
+    }
+}
+
+bool SymbolicExpression::Node::operator<(const Node & other) const {
+    if (op != other.op) return op < other.op;
+    if (operand != other.operand) return operand < other.operand;
+    if (left != other.left) return left < other.left;
+    return right < other.right;
+}
+
+SymbolicExpression::SymbolicExpression(VectorSHPP<string> & records, const VectorSHPP<string> & variables){
+    for (int i = 0; i < variables.size(); i++){
+        variableNames.push_back(variables.get(i));
+    }
+    vector<int> stack;
+    for (int i = 0; i < records.size(); i++){
+        string element = records[i];
+        OpCode op;
+        int builtin;
+        if (isBuiltinToken(element, builtin)){
+            int count = builtinArgumentCount(builtin);
+            if ((int) stack.size() < count) error("Incorrect data entered");
+            vector<int> args(stack.end() - count, stack.end());
+            stack.resize(stack.size() - count);
+            stack.push_back(makeBuiltin(builtin, args));
+        } else if (isNumber(element[0]) || isNumber(element[1])){
+            stack.push_back(makeConstant(element));
+        } else if (Expression::isFunctionName(element)){
+            if (stack.empty()) error("Incorrect data entered");
+            OpCode op = element == "sin" ? SIN : element == "cos" ? COS
+                      : element == "sqrt" ? SQRT : element == "tan" ? TAN : LOG;
+            stack.back() = make(op, stack.back());
+        } else if (isFunction(element)){
+            vector<string>::iterator it = find(variableNames.begin(), variableNames.end(), element);
+            if (it == variableNames.end()){
+                error("Unknown variable: " + element);
+            }
+            stack.push_back(makeVariable(it - variableNames.begin()));
+        } else if (isConditional(element)){
+            if (stack.size() < 3) error("Incorrect data entered");
+            int otherwise = stack.back();
+            stack.pop_back();
+            int then = stack.back();
+            stack.pop_back();
+            stack.back() = makeIf(stack.back(), then, otherwise);
+        } else if (element == "&&" || element == "||"){
+            // a && b is if(a, b != 0, 0), a || b is if(a, 1, b != 0)
+            if (stack.size() < 2) error("Incorrect data entered");
+            int right = make(NOT_EQUAL, stack.back(), makeConstant(0));
+            stack.pop_back();
+            if (element == "&&"){
+                stack.back() = makeIf(stack.back(), right, makeConstant(0));
+            } else {
+                stack.back() = makeIf(stack.back(), makeConstant(1), right);
+            }
+        } else if (element[element.length() - 1] == ')'){
+            int id = resolveCall(element);
+            int count = FunctionRegistry::shared().function(id).parameters.size();
+            if ((int) stack.size() < count) error("Incorrect data entered");
+            vector<int> args(stack.end() - count, stack.end());
+            stack.resize(stack.size() - count);
+            stack.push_back(makeCall(id, args));
+        } else if (Expression::isOperatorToken(element, op)){
+            if (stack.size() < 2) error("Incorrect data entered");
+            int right = stack.back();
+            stack.pop_back();
+            stack.back() = make(op, stack.back(), right);
+        } else {
+            error("Incorrect data entered");
+        }
+    }
+    if (stack.size() != 1){
+        error("Incorrect data entered");
+    }
+    root = stack[0];
+}
+
+SymbolicExpression::SymbolicExpression(const Expression & expr){
+    vector<int> args;
+    for (int i = 0; i < expr.variableCount(); i++){
+        variableNames.push_back(expr.variableName(i));
+        args.push_back(makeVariable(i));
+    }
+    root = inlineCode(expr, args);
+}
+
+SymbolicExpression SymbolicExpression::derivative(const string & variable) const {
+    vector<string>::const_iterator it = find(variableNames.begin(), variableNames.end(), variable);
+    if (it == variableNames.end()){
+        error("Unknown variable: " + variable);
+    }
+    SymbolicExpression res = *this;
+    vector<int> memo(nodes.size(), -1);
+    res.root = res.differentiate(root, it - variableNames.begin(), memo);
+    return res;
+}
+
+Expression SymbolicExpression::compile() const {
+    VectorSHPP<string> variables;
+    for (size_t i = 0; i < variableNames.size(); i++){
+        variables.add(variableNames[i]);
+    }
+    Expression expr(variables);
+    vector<int> uses;
+    countUses(uses);
+    emit(root, expr, uses);
+    return expr;
+}
+
+string SymbolicExpression::toString() const {
+    vector<string> definitions;
+    string res = toString(definitions);
+    for (size_t i = 0; i < definitions.size(); i++){
+        res += "\n  " + definitions[i];
+    }
+    return res;
+}
+
+string SymbolicExpression::toString(vector<string> & definitions) const {
+    vector<int> uses;
+    countUses(uses);
+    // the reachable nodes, children before parents
+    vector<int> order;
+    vector<bool> visited(nodes.size(), false);
+    vector<pair<int, bool> > pending(1, make_pair(root, false));
+    vector<int> list;
+    while (!pending.empty()){
+        pair<int, bool> top = pending.back();
+        pending.pop_back();
+        if (top.second){
+            order.push_back(top.first);
+            continue;
+        }
+        if (visited[top.first]) continue;
+        visited[top.first] = true;
+        pending.push_back(make_pair(top.first, true));
+        list.clear();
+        children(top.first, list);
+        for (size_t i = 0; i < list.size(); i++){
+            if (!visited[list[i]]) pending.push_back(make_pair(list[i], false));
+        }
+    }
+    // the length of the text of each node, where the shared nodes named
+    // so far count as their names; a shared node longer than a name by
+    // far is named
+    vector<int> names(nodes.size(), -1);
+    vector<long long> length(nodes.size(), 0);
+    int count = 0;
+    for (size_t i = 0; i < order.size(); i++){
+        int index = order[i];
+        const Node & node = nodes[index];
+        if (node.op == PUSH_CONSTANT){
+            length[index] = constantTexts[node.operand].length();
+            continue;
+        }
+        if (node.op == PUSH_VARIABLE){
+            length[index] = variableNames[node.operand].length();
+            continue;
+        }
+        list.clear();
+        children(index, list);
+        long long total = 6;  // an operator or a name, brackets and commas
+        for (size_t k = 0; k < list.size(); k++){
+            total += names[list[k]] >= 0 ? 4 : length[list[k]] + 1;
+        }
+        length[index] = total;
+        if (uses[index] > 1 && total > SHARED_TEXT_MIN_LENGTH){
+            names[index] = ++count;
+        }
+    }
+    for (size_t i = 0; i < order.size(); i++){
+        if (names[order[i]] >= 0 && order[i] != root){
+            definitions.push_back("#" + integerToString(names[order[i]]) + " = " + format(order[i], names));
+        }
+    }
+    return format(root, names);
+}
+
+int SymbolicExpression::nodeCount() const {
+    vector<bool> visited(nodes.size(), false);
+    vector<int> pending(1, root);
+    visited[root] = true;
+    int count = 0;
+    vector<int> list;
+    while (!pending.empty()){
+        int index = pending.back();
+        pending.pop_back();
+        count++;
+        list.clear();
+        children(index, list);
+        for (size_t i = 0; i < list.size(); i++){
+            if (!visited[list[i]]){
+                visited[list[i]] = true;
+                pending.push_back(list[i]);
+            }
+        }
+    }
+    return count;
+}
+
+int SymbolicExpression::makeConstant(const string & text){
+    map<string, int>::iterator it = constantIndex.find(text);
+    int index;
+    if (it == constantIndex.end()){
+        index = constantTexts.size();
+        constantTexts.push_back(text);
+        constantValues.push_back(stringToDouble(text));
+        constantIndex[text] = index;
+    } else {
+        index = it->second;
+    }
+    Node node = { PUSH_CONSTANT, index, -1, -1 };
+    return intern(node);
+}
+
+int SymbolicExpression::makeConstant(long long value){
+    ostringstream text;
+    text << value;
+    return makeConstant(text.str());
+}
+
+int SymbolicExpression::makeVariable(int index){
+    Node node = { PUSH_VARIABLE, index, -1, -1 };
+    return intern(node);
+}
+
+int SymbolicExpression::intern(const Node & node){
+    map<Node, int>::iterator it = nodeIndex.find(node);
+    if (it != nodeIndex.end()) return it->second;
+    int index = nodes.size();
+    nodes.push_back(node);
+    nodeIndex[node] = index;
+    return index;
+}
+
+int SymbolicExpression::makeCall(int id, const vector<int> & args){
+    const UserFunction & function = FunctionRegistry::shared().function(id);
+    if (!function.inlined){
+        Node node = { CALL, id, argumentList(args), -1 };
+        return intern(node);
+    }
+    return inlineCode(function.code, args);
+}
+
+int SymbolicExpression::makeBuiltin(int id, const vector<int> & args){
+    Node node = { BUILTIN, id, argumentList(args), -1 };
+    return intern(node);
+}
+
+int SymbolicExpression::inlineCode(const Expression & code, const vector<int> & args){
+    // conditionals being rebuilt keep where they end, their condition
+    // and first branch
+    vector<int> stack;
+    vector<int> temps(code.tempCount(), -1);
+    struct Conditional {
+        int end;
+        OpCode jump;
+        int condition;
+        int first;
+    };
+    vector<Conditional> conditionals;
+    for (int i = 0; i <= code.size(); i++){
+        while (!conditionals.empty() && conditionals.back().end == i){
+            const Conditional & conditional = conditionals.back();
+            if (conditional.jump == JUMP_IF_FALSE){
+                stack.back() = makeIf(conditional.condition, conditional.first, stack.back());
+            } else {
+                stack.back() = makeIf(conditional.condition, stack.back(), conditional.first);
+            }
+            conditionals.pop_back();
+        }
+        if (i == code.size()) break;
+        const Instruction & ins = code.instruction(i);
+        if (ins.op == JUMP_IF_FALSE || ins.op == JUMP_IF_TRUE){
+            int second = i + ins.operand;
+            Conditional conditional = { second - 1 + code.instruction(second - 1).operand, ins.op, stack.back(), -1 };
+            stack.pop_back();
+            conditionals.push_back(conditional);
+        } else if (ins.op == JUMP){
+            conditionals.back().first = stack.back();
+            stack.pop_back();
+        } else if (ins.op == PUSH_CONSTANT){
+            stack.push_back(makeConstant(code.constantText(ins.operand)));
+        } else if (ins.op == PUSH_VARIABLE){
+            stack.push_back(args[ins.operand]);
+        } else if (ins.op == STORE_TEMP){
+            temps[ins.operand] = stack.back();
+        } else if (ins.op == LOAD_TEMP){
+            stack.push_back(temps[ins.operand]);
+        } else if (ins.op == CALL){
+            int count = userFunctionCode(ins.operand).variableCount();
+            vector<int> inner(stack.end() - count, stack.end());
+            stack.resize(stack.size() - count);
+            stack.push_back(makeCall(ins.operand, inner));
+        } else if (ins.op == BUILTIN){
+            int count = builtinArgumentCount(ins.operand);
+            vector<int> inner(stack.end() - count, stack.end());
+            stack.resize(stack.size() - count);
+            stack.push_back(makeBuiltin(ins.operand, inner));
+        } else if (Expression::isBinary(ins.op)){
+            int right = stack.back();
+            stack.pop_back();
+            stack.back() = make(ins.op, stack.back(), right);
+        } else {
+            stack.back() = make(ins.op, stack.back());
+        }
+    }
+    return stack.back();
+}
+
+int SymbolicExpression::makeIf(int condition, int then, int otherwise){
+    if (isConstant(condition)){
+        return constantValues[nodes[condition].operand] != 0 ? then : otherwise;
+    }
+    if (then == otherwise) return then;
+    vector<int> args;
+    args.push_back(condition);
+    args.push_back(then);
+    args.push_back(otherwise);
+    Node node = { JUMP_IF_FALSE, 0, argumentList(args), -1 };
+    return intern(node);
+}
+
+int SymbolicExpression::argumentList(const vector<int> & args){
+    map<vector<int>, int>::iterator it = argumentIndex.find(args);
+    if (it != argumentIndex.end()) return it->second;
+    int list = argumentLists.size();
+    argumentLists.push_back(args);
+    argumentIndex[args] = list;
+    return list;
+}
+
+void SymbolicExpression::children(int index, vector<int> & list) const {
+    const Node & node = nodes[index];
+    if (node.op == CALL || node.op == BUILTIN || node.op == JUMP_IF_FALSE){
+        const vector<int> & args = argumentLists[node.left];
+        list.insert(list.end(), args.begin(), args.end());
+        return;
+    }
+    if (node.left >= 0) list.push_back(node.left);
+    if (node.right >= 0) list.push_back(node.right);
+}
+
+int SymbolicExpression::make(OpCode op, int left, int right){
+    int folded;
+    switch (op){
+    case ADD:
+        if (isConstant(left, 0)) return right;
+        if (isConstant(right, 0)) return left;
+        if (fold(op, left, right, folded)) return folded;
+        if (left == right) return make(MULTIPLY, makeConstant(2), left);
+        // canonical order of the operands: constants first, then by node
+        if ((isConstant(right) && !isConstant(left))
+                || (isConstant(left) == isConstant(right) && left > right)){
+            swap(left, right);
+        }
+        break;
+    case SUBTRACT:
+        if (isConstant(right, 0)) return left;
+        if (left == right) return makeConstant(0);
+        if (fold(op, left, right, folded)) return folded;
+        if (isConstant(left, 0)) return make(MULTIPLY, makeConstant(-1), right);
+        break;
+    case MULTIPLY:
+        if (isConstant(left, 0) || isConstant(right, 0)) return makeConstant(0);
+        if (isConstant(left, 1)) return right;
+        if (isConstant(right, 1)) return left;
+        if (fold(op, left, right, folded)) return folded;
+        if ((isConstant(right) && !isConstant(left))
+                || (isConstant(left) == isConstant(right) && left > right)){
+            swap(left, right);
+        }
+        // c1 * (c2 * x) = (c1 * c2) * x
+        if (isConstant(left) && nodes[right].op == MULTIPLY && isConstant(nodes[right].left)
+                && fold(MULTIPLY, left, nodes[right].left, folded)){
+            return make(MULTIPLY, folded, nodes[right].right);
+        }
+        // x * (1 / y) = x / y
+        if (nodes[right].op == DIVIDE && isConstant(nodes[right].left, 1)){
+            return make(DIVIDE, left, nodes[right].right);
+        }
+        break;
+    case DIVIDE:
+        if (isConstant(left, 0) && !isConstant(right, 0)) return left;
+        if (isConstant(right, 1)) return left;
+        if (left == right) return makeConstant(1);
+        if (fold(op, left, right, folded)) return folded;
+        // (c1 * x) / c2 = (c1 / c2) * x
+        if (nodes[left].op == MULTIPLY && isConstant(nodes[left].left)
+                && fold(DIVIDE, nodes[left].left, right, folded)){
+            return make(MULTIPLY, folded, nodes[left].right);
+        }
+        break;
+    case POWER:
+        if (isConstant(right, 1)) return left;
+        if (isConstant(right, 0) || isConstant(left, 1)) return makeConstant(1);
+        if (fold(op, left, right, folded)) return folded;
+        break;
+    case SIN:
+    case TAN:
+        if (isConstant(left, 0)) return left;
+        break;
+    case COS:
+        if (isConstant(left, 0)) return makeConstant(1);
+        break;
+    case SQRT:
+        if (isConstant(left, 0) || isConstant(left, 1)) return left;
+        break;
+    case LOG:
+        if (isConstant(left, 1)) return makeConstant(0);
+        break;
+    case LESS:
+    case GREATER:
+    case LESS_EQUAL:
+    case GREATER_EQUAL:
+    case EQUAL:
+    case NOT_EQUAL:
+        if (fold(op, left, right, folded)) return folded;
+        break;
+    default:
+        break;
+    }
+    Node node = { op, 0, left, right };
+    return intern(node);
+}
+
+bool SymbolicExpression::isConstant(int node) const {
+    return nodes[node].op == PUSH_CONSTANT;
+}
+
+bool SymbolicExpression::isConstant(int node, double value) const {
+    return nodes[node].op == PUSH_CONSTANT && constantValues[nodes[node].operand] == value;
+}
+
+bool SymbolicExpression::fold(OpCode op, int left, int right, int & res){
+    if (!isConstant(left) || !isConstant(right)) return false;
+    Rational a(constantTexts[nodes[left].operand]);
+    Rational b(constantTexts[nodes[right].operand]);
+    Rational value;
+    switch (op){
+    case ADD:
+        value = a + b;
+        break;
+    case SUBTRACT:
+        value = a - b;
+        break;
+    case MULTIPLY:
+        value = a * b;
+        break;
+    case DIVIDE:
+        if (b.isZero()) return false;
+        value = a / b;
+        break;
+    case POWER:
+        if (!b.isInteger() || BigInt::compare(b.numerator().abs(), BigInt(MAX_FOLDED_EXPONENT)) > 0
+                || (a.isZero() && b.isNegative())){
+            return false;
+        }
+        value = pow(a, b);
+        break;
+    case LESS:
+    case GREATER:
+    case LESS_EQUAL:
+    case GREATER_EQUAL:
+    case EQUAL:
+    case NOT_EQUAL:
+        res = makeConstant(Expression::compare(op, a, b) ? 1 : 0);
+        return true;
+    default:
+        return false;
+    }
+    string text;
+    if (!decimalText(value, text)) return false;
+    res = makeConstant(text);
+    return true;
+}
+
+int SymbolicExpression::differentiate(int index, int variable, vector<int> & memo){
+    // a node is differentiated after its children: it is pushed again,
+    // marked ready, below the children it still needs
+    vector<pair<int, bool> > pending(1, make_pair(index, false));
+    vector<int> list;
+    while (!pending.empty()){
+        int current = pending.back().first;
+        bool ready = pending.back().second;
+        pending.pop_back();
+        if (memo[current] >= 0) continue;
+        if (ready){
+            memo[current] = differentiateNode(current, variable, memo);
+            continue;
+        }
+        pending.push_back(make_pair(current, true));
+        const Node & node = nodes[current];
+        list.clear();
+        if (node.op == JUMP_IF_FALSE){
+            // the condition is not differentiated
+            list.push_back(argumentLists[node.left][1]);
+            list.push_back(argumentLists[node.left][2]);
+        } else if (node.op != CALL && !Expression::isComparison(node.op)){
+            children(current, list);
+        }
+        // the first child on top, so nodes are made in the same order
+        // as by a recursive walk
+        for (int i = list.size() - 1; i >= 0; i--){
+            if (memo[list[i]] < 0) pending.push_back(make_pair(list[i], false));
+        }
+    }
+    return memo[index];
+}
+
+int SymbolicExpression::differentiateNode(int index, int variable, const vector<int> & memo){
+    // copy: nodes may be reallocated while the derivative is built
+    Node node = nodes[index];
+    int res = -1;
+    if (node.op == PUSH_CONSTANT){
+        res = makeConstant(0);
+    } else if (node.op == PUSH_VARIABLE){
+        res = makeConstant(node.operand == variable ? 1 : 0);
+    } else if (node.op == CALL){
+        error("The function " + FunctionRegistry::shared().function(node.operand).name
+              + " calls itself or is too large to differentiate");
+    } else if (node.op == BUILTIN){
+        // chain rule over the arguments the variable reaches
+        vector<int> args = argumentLists[node.left];
+        res = makeConstant(0);
+        for (size_t k = 0; k < args.size(); k++){
+            if (!isConstant(memo[args[k]], 0)){
+                res = make(ADD, res, make(MULTIPLY, builtinPartial(index, k), memo[args[k]]));
+            }
+        }
+    } else if (Expression::isComparison(node.op)){
+        // a comparison is constant where it is differentiable
+        res = makeConstant(0);
+    } else if (node.op == JUMP_IF_FALSE){
+        vector<int> args = argumentLists[node.left];
+        res = makeIf(args[0], memo[args[1]], memo[args[2]]);
+    } else {
+        int u = node.left;
+        int du = memo[u];
+        int v = node.right;
+        int dv = v >= 0 ? memo[v] : -1;
+        switch (node.op){
+        case ADD:
+            res = make(ADD, du, dv);
+            break;
+        case SUBTRACT:
+            res = make(SUBTRACT, du, dv);
+            break;
+        case MULTIPLY:
+            // (u v)' = u' v + u v'
+            res = make(ADD, make(MULTIPLY, du, v), make(MULTIPLY, u, dv));
+            break;
+        case DIVIDE:
+            // (u / v)' = (u' v - u v') / v^2, or u' / v for a constant v
+            if (isConstant(dv, 0)){
+                res = make(DIVIDE, du, v);
+                break;
+            }
+            res = make(DIVIDE, make(SUBTRACT, make(MULTIPLY, du, v), make(MULTIPLY, u, dv)),
+                       make(POWER, v, makeConstant(2)));
+            break;
+        case POWER:
+            if (isConstant(dv, 0)){
+                // (u^c)' = c u^(c-1) u'
+                res = make(MULTIPLY, make(MULTIPLY, v, make(POWER, u, make(SUBTRACT, v, makeConstant(1)))), du);
+            } else {
+                // (u^v)' = u^v (v' ln u + v u' / u)
+                res = make(MULTIPLY, index, make(ADD, make(MULTIPLY, dv, make(LOG, u)),
+                                                 make(DIVIDE, make(MULTIPLY, v, du), u)));
+            }
+            break;
+        case SIN:
+            res = make(MULTIPLY, make(COS, u), du);
+            break;
+        case COS:
+            res = make(MULTIPLY, make(MULTIPLY, makeConstant(-1), make(SIN, u)), du);
+            break;
+        case SQRT:
+            // (sqrt u)' = u' / (2 sqrt u), reusing the node of sqrt u
+            res = make(DIVIDE, du, make(MULTIPLY, makeConstant(2), index));
+            break;
+        case TAN:
+            // (tan u)' = (1 + tan^2 u) u'
+            res = make(MULTIPLY, make(ADD, makeConstant(1), make(POWER, index, makeConstant(2))), du);
+            break;
+        default:
+            res = make(DIVIDE, du, u);
+            break;
+        }
+    }
+    return res;
+}
+
+int SymbolicExpression::builtinPartial(int index, int argument){
+    BuiltinRegistry & registry = BuiltinRegistry::shared();
+    int id = nodes[index].operand;
+    vector<int> args = argumentLists[nodes[index].left];
+    const BuiltinCall & call = registry.call(id);
+    int bound = call.code.variableCount() - 1;
+    vector<int> at(args.begin(), args.begin() + bound);
+    if (argument >= bound){
+        if (call.name != "integrate") return makeConstant(0);
+        // the integrand at the limit, negative for the lower one
+        at.push_back(args[argument]);
+        int value = inlineCode(call.code, at);
+        return argument == bound ? make(MULTIPLY, makeConstant(-1), value) : value;
+    }
+    SymbolicExpression body = call.body;
+    vector<int> memo(body.nodes.size(), -1);
+    int d = body.differentiate(body.root, argument, memo);
+    if (body.isConstant(d, 0)) return makeConstant(0);
+    if (call.name == "solve"){
+        // -(dg/dv) / (dg/dy) at the root
+        memo.assign(body.nodes.size(), -1);
+        int dy = body.differentiate(body.root, bound, memo);
+        body.root = body.make(DIVIDE, body.make(MULTIPLY, body.makeConstant(-1), d), dy);
+        at.push_back(index);
+        return inlineCode(body.compile(), at);
+    }
+    if (call.name == "prod"){
+        body.root = body.make(DIVIDE, d, body.root);
+        return make(MULTIPLY, index, makeBuiltin(registry.define("sum", body), args));
+    }
+    body.root = d;
+    return makeBuiltin(registry.define(call.name, body), args);
+}
+
+void SymbolicExpression::countUses(vector<int> & uses) const {
+    uses.assign(nodes.size(), 0);
+    vector<bool> visited(nodes.size(), false);
+    vector<int> pending(1, root);
+    visited[root] = true;
+    vector<int> list;
+    while (!pending.empty()){
+        int index = pending.back();
+        pending.pop_back();
+        list.clear();
+        children(index, list);
+        for (size_t i = 0; i < list.size(); i++){
+            uses[list[i]]++;
+            if (!visited[list[i]]){
+                visited[list[i]] = true;
+                pending.push_back(list[i]);
+            }
+        }
+    }
+}
+
+string SymbolicExpression::format(int index, const vector<int> & names, const vector<string> * variableTexts) const {
+    // pieces are written from left to right: a node, or a text where
+    // the node is -1; the pieces of a node replace it on the stack
+    struct Piece {
+        int node;
+        string text;
+    };
+    string res;
+    vector<Piece> pending;
+    vector<Piece> parts;
+    Piece first = { index, "" };
+    pending.push_back(first);
+    while (!pending.empty()){
+        Piece piece = pending.back();
+        pending.pop_back();
+        if (piece.node < 0){
+            res += piece.text;
+            continue;
+        }
+        if (piece.node != index && names[piece.node] >= 0){
+            res += "#" + integerToString(names[piece.node]);
+            continue;
+        }
+        const Node & node = nodes[piece.node];
+        if (node.op == PUSH_CONSTANT){
+            res += constantTexts[node.operand];
+            continue;
+        }
+        if (node.op == PUSH_VARIABLE){
+            res += variableTexts == NULL ? variableNames[node.operand] : (*variableTexts)[node.operand];
+            continue;
+        }
+        if (node.op == BUILTIN){
+            res += formatBuiltin(piece.node, names, variableTexts);
+            continue;
+        }
+        parts.clear();
+        Piece open = { -1, "(" }, close = { -1, ")" };
+        if (node.op == CALL || node.op == JUMP_IF_FALSE){
+            const vector<int> & args = argumentLists[node.left];
+            Piece name = { -1, (node.op == CALL ? FunctionRegistry::shared().function(node.operand).name : "if") + "(" };
+            parts.push_back(name);
+            for (size_t i = 0; i < args.size(); i++){
+                Piece comma = { -1, "," }, arg = { args[i], "" };
+                if (i > 0) parts.push_back(comma);
+                parts.push_back(arg);
+            }
+            parts.push_back(close);
+        } else if (node.right < 0){
+            Piece name = { -1, functionName(node.op) + "(" }, arg = { node.left, "" };
+            parts.push_back(name);
+            parts.push_back(arg);
+            parts.push_back(close);
+        } else {
+            Piece left = { node.left, "" }, sign = { -1, functionName(node.op) }, right = { node.right, "" };
+            // a name is written like a variable
+            int leftPrecedence = names[node.left] >= 0 ? 5 : precedence(node.left);
+            int rightPrecedence = names[node.right] >= 0 ? 5 : precedence(node.right);
+            int own = operatorPrecedence(node.op);
+            bool commutative = node.op == ADD || node.op == MULTIPLY;
+            bool bracketLeft = leftPrecedence < own;
+            bool bracketRight = rightPrecedence < own || (!commutative && rightPrecedence == own);
+            if (node.op == MULTIPLY && isConstant(node.left, -1)){
+                // -1 * x is written as -x; like a negative number it needs
+                // brackets inside other operations
+                sign.text = "-";
+                bracketRight = rightPrecedence < 2;
+            } else {
+                if (bracketLeft) parts.push_back(open);
+                parts.push_back(left);
+                if (bracketLeft) parts.push_back(close);
+            }
+            parts.push_back(sign);
+            if (bracketRight) parts.push_back(open);
+            parts.push_back(right);
+            if (bracketRight) parts.push_back(close);
+        }
+        pending.insert(pending.end(), parts.rbegin(), parts.rend());
+    }
+    return res;
+}
+
+int SymbolicExpression::precedence(int index) const {
+    const Node & node = nodes[index];
+    if (node.op == PUSH_CONSTANT){
+        return constantTexts[node.operand][0] == '-' ? 0 : 5;
+    }
+    if (node.op == PUSH_VARIABLE || node.op == CALL || node.op == BUILTIN || node.op == JUMP_IF_FALSE || node.right < 0){
+        return 5;
+    }
+    if (node.op == MULTIPLY && isConstant(node.left, -1)){
+        return 0;
+    }
+    return operatorPrecedence(node.op);
+}
+
+string SymbolicExpression::formatBuiltin(int index, const vector<int> & names, const vector<string> * variableTexts) const {
+    const vector<int> & args = argumentLists[nodes[index].left];
+    const BuiltinCall & call = BuiltinRegistry::shared().call(nodes[index].operand);
+    int bound = call.code.variableCount() - 1;
+    vector<string> texts;
+    for (size_t k = 0; k < args.size(); k++){
+        if (names[args[k]] >= 0){
+            texts.push_back("#" + integerToString(names[args[k]]));
+        } else {
+            texts.push_back(format(args[k], names, variableTexts));
+            // a free variable of the equation is replaced by its text
+            if ((int) k < bound && precedence(args[k]) < 5) texts.back() = "(" + texts.back() + ")";
+        }
+    }
+    vector<string> bodyTexts(texts.begin(), texts.begin() + bound);
+    bodyTexts.push_back(call.body.variableNames[bound]);
+    string equation = call.body.format(call.body.root, vector<int>(call.body.nodes.size(), -1), &bodyTexts);
+    if (call.name == "integrate"){
+        return "integrate(" + equation + "," + bodyTexts[bound] + "," + texts[bound] + "," + texts[bound + 1] + ")";
+    }
+    if (call.name == "solve"){
+        return "solve(" + equation + "," + bodyTexts[bound] + "," + texts[bound] + ")";
+    }
+    return call.name + "(" + bodyTexts[bound] + "," + texts[bound] + "," + texts[bound + 1] + "," + equation + ")";
+}
+
+void SymbolicExpression::emit(int index, Expression & expr, const vector<int> & uses) const {
+    // steps of the nodes being emitted: a node is visited, and after the
+    // code of its children its operation is appended; an if node has a
+    // step before each branch and one after them
+    enum Stage { VISIT, APPEND, THEN, ELSE, BRANCH };
+    struct Step {
+        int node;
+        Stage stage;
+        int test;
+        int skip;
+        size_t mark;
+    };
+    vector<int> temps(nodes.size(), -1);
+    vector<int> constants(constantTexts.size(), -1);
+    // nodes given a temporary, in order, so a branch can forget its own
+    vector<int> kept;
+    int tempCount = 0;
+    vector<Step> pending;
+    vector<int> list;
+    Step first = { index, VISIT, 0, 0, 0 };
+    pending.push_back(first);
+    while (!pending.empty()){
+        Step step = pending.back();
+        pending.pop_back();
+        const Node & node = nodes[step.node];
+        if (step.stage == VISIT){
+            if (temps[step.node] >= 0){
+                expr.append(LOAD_TEMP, temps[step.node]);
+                continue;
+            }
+            if (node.op == PUSH_CONSTANT){
+                if (constants[node.operand] < 0){
+                    constants[node.operand] = expr.addConstant(constantTexts[node.operand]);
+                }
+                expr.append(PUSH_CONSTANT, constants[node.operand]);
+                continue;
+            }
+            if (node.op == PUSH_VARIABLE){
+                expr.append(PUSH_VARIABLE, node.operand);
+                continue;
+            }
+            // the children are pushed last, so they are emitted first, in order
+            list.clear();
+            Step next = { step.node, APPEND, 0, 0, 0 };
+            if (node.op == JUMP_IF_FALSE){
+                next.stage = THEN;
+                list.push_back(argumentLists[node.left][0]);
+            } else {
+                children(step.node, list);
+            }
+            pending.push_back(next);
+            for (int i = list.size() - 1; i >= 0; i--){
+                Step child = { list[i], VISIT, 0, 0, 0 };
+                pending.push_back(child);
+            }
+            continue;
+        }
+        if (step.stage == ELSE || step.stage == BRANCH){
+            // values kept inside a branch are forgotten after it
+            for (size_t i = step.mark; i < kept.size(); i++) temps[kept[i]] = -1;
+            kept.resize(step.mark);
+        }
+        if (step.stage == THEN || step.stage == ELSE){
+            Step next = step;
+            if (step.stage == THEN){
+                next.stage = ELSE;
+                next.test = expr.appendJump(JUMP_IF_FALSE);
+                next.mark = kept.size();
+            } else {
+                next.stage = BRANCH;
+                next.skip = expr.appendJump(JUMP);
+                expr.landJump(step.test);
+            }
+            pending.push_back(next);
+            Step child = { argumentLists[node.left][step.stage == THEN ? 1 : 2], VISIT, 0, 0, 0 };
+            pending.push_back(child);
+            continue;
+        }
+        if (step.stage == BRANCH){
+            expr.landJump(step.skip);
+        } else if (node.op == CALL || node.op == BUILTIN){
+            expr.append(node.op, node.operand);
+        } else {
+            expr.append(node.op);
+        }
+        if (uses[step.node] > 1){
+            // shared node: keep the value for the later uses
+            temps[step.node] = tempCount++;
+            kept.push_back(step.node);
+            expr.append(STORE_TEMP, temps[step.node]);
+        }
+    }
+}
@@ -0,0 +1,260 @@
+/* File: symbolic.h
+ * -----------------------------------
+ *
+ * This file exports the symbolic form of an equation, which
+ * supports exact transformations such as differentiation.
+ */
+
+#ifndef SYMBOLIC_H
+#define SYMBOLIC_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "expression.h"
+#include "vectorshpp.h"
+
+/* Class SymbolicExpression
+ * --------------------------------
+ * This class holds an equation as a graph of operations built from its
+ * polish record. Nodes are created through a table of existing nodes,
+ * so equal subexpressions are always one shared node (common
+ * subexpression elimination), and every new node is simplified on
+ * creation (0 + x = x, 1 * x = x, x - x = 0, exact folding of
+ * constants and so on). Compiling the graph computes each shared node
+ * once and keeps it in a temporary of the compiled Expression.
+ *
+ * A call of a small user function is replaced by the body of the
+ * function on the nodes of its arguments, so it is simplified and
+ * shared together with the caller. Other calls stay call nodes. A call
+ * of a built-in function is a node too, whose derivative is made of
+ * calls of built-ins (see BuiltinRegistry).
+ *
+ * Conditionals (if, && and ||) are if nodes; a constant condition
+ * selects its branch. A value computed inside a branch is never
+ * reused outside it, since the branch may not run.
+ *
+ * Every walk of the graph keeps its own stack of pending nodes instead
+ * of recursing, so equations nested millions of levels deep take time
+ * and memory in proportion to their size.
+ */
+class SymbolicExpression {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: SymbolicExpression
+     * Usage: SymbolicExpression symbolic(polishRecord, variableNames);
+     * -----------------------------------------------------
+     * Builds the graph of a polish record; names that are not functions
+     * must be in the variable list
+     */
+    SymbolicExpression(VectorSHPP<std::string> & records, const VectorSHPP<std::string> & variables);
+
+    /* Constructor: SymbolicExpression
+     * Usage: SymbolicExpression symbolic(expr);
+     * -----------------------------------------------------
+     * Builds the graph of compiled code, with its variables
+     */
+    explicit SymbolicExpression(const Expression & expr);
+
+    /* Method: derivative
+     * Usage: SymbolicExpression dx = symbolic.derivative("x");
+     * -----------------------------------------------------
+     * Returns the simplified derivative by the variable
+     */
+    SymbolicExpression derivative(const std::string & variable) const;
+
+    /* Method: compile
+     * Usage: Expression expr = symbolic.compile();
+     * -----------------------------------------------------
+     * Returns the expression compiled for evaluation, with the same
+     * variables as this one
+     */
+    Expression compile() const;
+
+    /* Method: toString
+     * Usage: string str = symbolic.toString();
+     *        string str = symbolic.toString(definitions);
+     * -----------------------------------------------------
+     * Returns the expression in the notation of the calculator. A long
+     * subexpression used more than once is written once, as a definition
+     * "#1 = ..." that the text refers to by its name, so the text grows
+     * with the number of operations and not with the number of paths to
+     * them. The definitions are given in order, each after those it
+     * refers to; the first form puts them on lines after the expression.
+     */
+    std::string toString() const;
+    std::string toString(std::vector<std::string> & definitions) const;
+
+    /* Method: nodeCount
+     * Usage: int count = symbolic.nodeCount();
+     * -----------------------------------------------------
+     * Returns the number of distinct operations of the expression
+     */
+    int nodeCount() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* One operation; children are node indexes, -1 if absent.
+     * operand is the constant or variable index of a leaf. A call, of a
+     * user or a built-in function, has the id as operand and its left
+     * is the index of the list of its arguments. An if node has the operation JUMP_IF_FALSE and
+     * its left is the index of the list of the condition and the two
+     * branches */
+    struct Node {
+        OpCode op;
+        int operand;
+        int left;
+        int right;
+
+        bool operator<(const Node & other) const;
+    };
+
+    std::vector<Node> nodes;
+    std::map<Node, int> nodeIndex;
+    std::vector<std::string> constantTexts;
+    std::vector<double> constantValues;
+    std::map<std::string, int> constantIndex;
+    std::vector<std::string> variableNames;
+    std::vector<std::vector<int> > argumentLists;
+    std::map<std::vector<int>, int> argumentIndex;
+    int root;
+
+    /* Method: makeConstant / makeVariable / make
+     * Usage: int node = make(ADD, left, right);
+     * ------------------------------------------------
+     * Return the node of a constant, a variable or a simplified
+     * operation, reusing an equal node if there is one
+     */
+    int makeConstant(const std::string & text);
+    int makeConstant(long long value);
+    int makeVariable(int index);
+    int make(OpCode op, int left, int right = -1);
+    int intern(const Node & node);
+
+    /* Method: makeCall
+     * Usage: int node = makeCall(id, args);
+     * ------------------------------------------------
+     * Returns the node of a call of a user function: the inlined body
+     * of the function, or a call node
+     */
+    int makeCall(int id, const std::vector<int> & args);
+
+    /* Method: makeBuiltin
+     * Usage: int node = makeBuiltin(id, args);
+     * ------------------------------------------------
+     * Returns the node of a call of a built-in function
+     */
+    int makeBuiltin(int id, const std::vector<int> & args);
+
+    /* Method: inlineCode
+     * Usage: int node = inlineCode(code, args);
+     * ------------------------------------------------
+     * Returns the node of compiled code rebuilt on the nodes of its
+     * variables
+     */
+    int inlineCode(const Expression & code, const std::vector<int> & args);
+
+    /* Method: makeIf
+     * Usage: int node = makeIf(condition, then, otherwise);
+     * ------------------------------------------------
+     * Returns the node of a conditional, or of its branch if the
+     * condition is constant or both branches are the same
+     */
+    int makeIf(int condition, int then, int otherwise);
+
+    /* Method: argumentList
+     * Usage: int list = argumentList(args);
+     * ------------------------------------------------
+     * Returns the index of a list of nodes, reusing an equal list
+     */
+    int argumentList(const std::vector<int> & args);
+
+    /* Method: children
+     * Usage: children(node, list);
+     * ------------------------------------------------
+     * Puts the child nodes of a node, the arguments of a call included,
+     * into the list
+     */
+    void children(int node, std::vector<int> & list) const;
+
+    /* Method: isConstant
+     * Usage: if (isConstant(node, 1))...
+     * ------------------------------------------------
+     * Checks for a constant node, or a constant node of the value
+     */
+    bool isConstant(int node) const;
+    bool isConstant(int node, double value) const;
+
+    /* Method: fold
+     * Usage: if (fold(op, left, right, res))...
+     * ------------------------------------------------
+     * Computes an operation on two constants in exact arithmetic;
+     * fails if the result has no short finite decimal form
+     */
+    bool fold(OpCode op, int left, int right, int & res);
+
+    /* Method: differentiate
+     * Usage: int d = differentiate(node, variable, memo);
+     * ------------------------------------------------
+     * Returns the node of the derivative; memo keeps the derivative of
+     * nodes already visited, so shared nodes are differentiated once
+     */
+    int differentiate(int node, int variable, std::vector<int> & memo);
+
+    /* Method: differentiateNode
+     * Usage: memo[node] = differentiateNode(node, variable, memo);
+     * ------------------------------------------------
+     * Returns the derivative of one node from the derivatives of its
+     * children, which must be in memo
+     */
+    int differentiateNode(int node, int variable, const std::vector<int> & memo);
+
+    /* Method: builtinPartial
+     * Usage: int d = builtinPartial(node, argument);
+     * ------------------------------------------------
+     * Returns the node of the derivative of a call of a built-in
+     * function by one of its arguments
+     */
+    int builtinPartial(int node, int argument);
+
+    /* Method: countUses
+     * Usage: countUses(uses);
+     * ------------------------------------------------
+     * Sets uses to the numbers of parents of the nodes reachable from
+     * the root
+     */
+    void countUses(std::vector<int> & uses) const;
+
+    /* Method: format / precedence
+     * Usage: string str = format(node, names);
+     * ------------------------------------------------
+     * Return the text of a node and the precedence of its text; the
+     * nodes below it with a number in names are written as #number.
+     * The variables are written as variableTexts if it is given.
+     */
+    std::string format(int node, const std::vector<int> & names,
+                       const std::vector<std::string> * variableTexts = NULL) const;
+    int precedence(int node) const;
+
+    /* Method: formatBuiltin
+     * Usage: string str = formatBuiltin(node, names, variableTexts);
+     * ------------------------------------------------
+     * Returns the text of a call of a built-in function, with its
+     * equation written on the texts of its arguments
+     */
+    std::string formatBuiltin(int node, const std::vector<int> & names,
+                              const std::vector<std::string> * variableTexts) const;
+
+    /* Method: emit
+     * Usage: emit(node, expr, uses);
+     * ------------------------------------------------
+     * Appends the code of a node to expr; uses are the numbers of
+     * parents of the nodes
+     */
+    void emit(int node, Expression & expr, const std::vector<int> & uses) const;
+};
+
+#endif // SYMBOLIC_H
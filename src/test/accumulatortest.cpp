@@ -0,0 +1,85 @@
+/* File: accumulatortest.cpp
+ * -----------------------------------
+ *
+ * Check and benchmark of the reproducible sums of accumulator.h.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "accumulator.h"
+#include "selftest.h"
+
+using namespace std;
+
+/*
+ * Function: mixedValues
+ * Usage: vector<double> values = mixedValues(count);
+ * ______________________________________________________
+ *
+ * Returns values of both signs and of magnitudes from 1e-10 to 1e10,
+ * whose naive sum depends on the order of the additions
+ */
+static vector<double> mixedValues(int count){
+    mt19937_64 random(37);
+    uniform_real_distribution<double> mantissa(-1, 1);
+    uniform_int_distribution<int> exponent(-10, 10);
+    vector<double> values(count);
+    for (int i = 0; i < count; i++){
+        values[i] = mantissa(random) * pow(10.0, exponent(random));
+    }
+    return values;
+}
+
+SELF_TEST(reproducibleSumIgnoresOrderAndSplit){
+    vector<double> values = mixedValues(100000);
+    ReproducibleSum whole;
+    whole.add(&values[0], values.size());
+    double expected = whole.result();
+    mt19937_64 random(42);
+    for (int round = 0; round < 5; round++){
+        shuffle(values.begin(), values.end(), random);
+        // the values split between parts as between threads
+        int parts = round + 2;
+        ReproducibleSum total;
+        for (int p = 0; p < parts; p++){
+            int first = (long long) values.size() * p / parts;
+            int last = (long long) values.size() * (p + 1) / parts;
+            ReproducibleSum part;
+            part.add(&values[first], last - first);
+            total.merge(part);
+        }
+        expect(total.result() == expected, "the same sum in any order and split in any number of parts");
+    }
+    ReproducibleSum cancelled;
+    cancelled.add(1e100);
+    cancelled.add(1.0);
+    cancelled.add(-1e100);
+    expect(cancelled.result() == 1.0, "1 to survive 1e100 - 1e100, which naive sums lose");
+}
+
+SELF_BENCHMARK(reproducibleSum){
+    const int count = 1 << 22;
+    const int rounds = 10;
+    vector<double> values = mixedValues(count);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double naive = 0;
+    for (int round = 0; round < rounds; round++){
+        for (int i = 0; i < count; i++) naive += values[i];
+    }
+    double naiveSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    ReproducibleSum sum;
+    for (int round = 0; round < rounds; round++){
+        sum.add(&values[0], count);
+    }
+    double exact = sum.result();
+    double reproducibleSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    double added = (double) count * rounds;
+    cout << "naive sum: " << naiveSeconds / added * 1e9 << " ns per value (" << naive << ")" << endl;
+    cout << "reproducible sum: " << reproducibleSeconds / added * 1e9 << " ns per value (" << exact << ", "
+         << reproducibleSeconds / naiveSeconds << " times slower)" << endl;
+}
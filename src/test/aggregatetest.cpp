@@ -0,0 +1,127 @@
+/* File: aggregatetest.cpp
+ * -----------------------------------
+ *
+ * Checks of the aggregates of columns of aggregate.h.
+ */
+
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "accumulator.h"
+#include "aggregate.h"
+#include "columnfile.h"
+#include "filelib.h"
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+#include "variables.h"
+
+using namespace std;
+
+/*
+ * Function: splitAggregate
+ * Usage: ColumnAggregate aggregate = splitAggregate(values, parts);
+ * ______________________________________________________
+ *
+ * Returns the aggregate of the values added in the given number of
+ * arrays of uneven lengths and merged in order, as by the threads of
+ * aggregateFile
+ */
+static ColumnAggregate splitAggregate(const vector<double> & values, int parts){
+    ColumnAggregate res;
+    int first = 0;
+    for (int p = 0; p < parts; p++){
+        int last = p == parts - 1 ? values.size() : first + (int) values.size() / parts + p % 3;
+        ColumnAggregate part;
+        part.add(&values[first], last - first);
+        res.merge(part);
+        first = last;
+    }
+    return res;
+}
+
+SELF_TEST(aggregatesMatchTwoPasses){
+    // a length that is not a multiple of the accumulators, and gaps
+    mt19937_64 random(40);
+    normal_distribution<double> value(1000, 3);
+    vector<double> values(100003);
+    for (size_t i = 0; i < values.size(); i++) values[i] = i % 101 == 7 ? NAN : value(random);
+    long long count = 0;
+    double minimum = INFINITY, maximum = -INFINITY;
+    ReproducibleSum sum;
+    long double plainSum = 0;
+    for (size_t i = 0; i < values.size(); i++){
+        if (isnan(values[i])) continue;
+        count++;
+        minimum = min(minimum, values[i]);
+        maximum = max(maximum, values[i]);
+        sum.add(values[i]);
+        plainSum += values[i];
+    }
+    long double mean = plainSum / count, squares = 0;
+    for (size_t i = 0; i < values.size(); i++){
+        if (!isnan(values[i])) squares += (values[i] - mean) * (values[i] - mean);
+    }
+    double variance = squares / (count - 1);
+    ColumnAggregate whole = splitAggregate(values, 1);
+    for (int parts = 1; parts <= 64; parts *= 4){
+        ColumnAggregate aggregate = splitAggregate(values, parts);
+        string what = " of " + integerToString(parts) + " parts";
+        expect(aggregate.count() == count && aggregate.min() == minimum && aggregate.max() == maximum,
+               "the count, minimum and maximum" + what);
+        expect(aggregate.sum() == sum.result(), "the exact sum" + what);
+        expect(fabs(aggregate.mean() - (double) mean) <= 1e-15 * mean, "the mean" + what);
+        expect(fabs(aggregate.variance() - variance) <= 1e-10 * variance,
+               "the variance" + what + " " + realToString(aggregate.variance()) + " to be " + realToString(variance));
+        expect(splitAggregate(values, parts).variance() == aggregate.variance(), "the same variance every time");
+        expect(aggregate.sum() == whole.sum(), "the same sum for any split");
+    }
+    ColumnAggregate empty;
+    double nothing = NAN;
+    empty.add(&nothing, 1);
+    expect(empty.count() == 0 && isnan(empty.mean()) && isnan(empty.min()) && isnan(empty.variance()),
+           "the aggregates of no values to be NaN");
+}
+
+SELF_TEST(aggregatesOfFiles){
+    // enough rows for blocks on several threads
+    const int rows = 200000;
+    ostringstream text;
+    text << "a,b\n";
+    for (int r = 1; r <= rows; r++){
+        text << r << ",";
+        if (r % 1000 != 0) text << r % 7;
+        text << "\n";
+    }
+    string csv = scratchFile("aggregate.csv");
+    string columns = scratchFile("aggregate.col");
+    writeEntireFile(csv, text.str());
+    csvToColumnFile(csv, columns);
+    VariableTable variables;
+    variables.set("k", "2");
+    const string paths[] = { csv, columns };
+    for (int p = 0; p < 2; p++){
+        long long invalid = 0;
+        ColumnAggregate column = aggregateFile(paths[p], "a", variables, invalid);
+        expect(column.count() == rows && column.sum() == (double) rows * (rows + 1) / 2 && column.min() == 1
+               && column.max() == rows, "the aggregates of the column a of " + paths[p]);
+        ColumnAggregate equation = aggregateFile(paths[p], "a*b+k", variables, invalid);
+        double expected = 0;
+        for (int r = 1; r <= rows; r++){
+            if (r % 1000 != 0) expected += (double) r * (r % 7) + 2;
+        }
+        expect(equation.count() == rows - rows / 1000 && equation.sum() == expected,
+               "the sum of an equation over " + paths[p] + " to be " + realToString(expected) + ", not "
+               + realToString(equation.sum()));
+        if (p == 0){
+            expect(invalid == rows / 1000, "the missing fields of the CSV file");
+        }
+    }
+    CalculatorSession session;
+    expectEqual(session.run(":max " + csv + " b"), "max = 6\nMissing or non-numeric fields: 200\n",
+                "the output of :max");
+    deleteFile(columns);
+    deleteFile(csv);
+}
@@ -0,0 +1,134 @@
+/* File: bignumbertest.cpp
+ * -----------------------------------
+ *
+ * Checks of the arbitrary precision numbers of bigint.h and bigfloat.h:
+ * the multiplication around the sizes where Karatsuba and the NTT take
+ * over, the long division, and functions at known digits.
+ */
+
+#include <random>
+#include <string>
+#include "bigfloat.h"
+#include "bigint.h"
+#include "error.h"
+#include "selftest.h"
+#include "strlib.h"
+
+using namespace std;
+
+/*
+ * Function: randomBigInt
+ * Usage: BigInt n = randomBigInt(random, 1024);
+ * ______________________________________________________
+ *
+ * Returns a random number of the given number of limbs
+ */
+static BigInt randomBigInt(mt19937_64 & random, int limbs){
+    uniform_int_distribution<int> digit(0, 9);
+    string digits(1, (char) ('1' + digit(random) % 9));
+    for (int i = 1; i < limbs * BigInt::BASE_DIGITS; i++){
+        digits += (char) ('0' + digit(random));
+    }
+    return BigInt(digits);
+}
+
+/*
+ * Function: schoolbookProduct
+ * Usage: BigInt product = schoolbookProduct(a, b);
+ * ______________________________________________________
+ *
+ * Returns a * b as the sum of b times each limb of a, shifted in place,
+ * which only takes products by one limb
+ */
+static BigInt schoolbookProduct(const BigInt & a, const BigInt & b){
+    BigInt res;
+    for (int i = 0; i < a.limbCount(); i++){
+        BigInt term = b.abs();
+        term.multiplySmall(a.limb(i));
+        term.shiftLimbs(i);
+        res += term;
+    }
+    if (a.isNegative() != b.isNegative()) res.negate();
+    return res;
+}
+
+/*
+ * Function: expectDigits
+ * Usage: expectDigits(sqrt(BigFloat(2)), "1.41421356", "sqrt(2)");
+ * ______________________________________________________
+ *
+ * Signals the failure of a check unless the number starts with the digits
+ */
+static void expectDigits(const BigFloat & x, const string & digits, const string & what){
+    string text = x.toString();
+    expect(startsWith(text, digits), what + " = " + text.substr(0, digits.length() + 5) + "... to start with " + digits);
+}
+
+SELF_TEST(bigIntMultipliesAroundThresholds){
+    mt19937_64 random(28);
+    // limbs of the operands at the Karatsuba (32) and NTT (1024) cutoffs,
+    // and unbalanced products
+    const int sizes[][2] = { { 31, 31 }, { 32, 32 }, { 33, 40 }, { 31, 500 }, { 64, 65 },
+                             { 1023, 1023 }, { 1024, 1024 }, { 1025, 1100 }, { 40, 3000 }, { 1024, 2100 } };
+    for (size_t k = 0; k < sizeof sizes / sizeof sizes[0]; k++){
+        BigInt a = randomBigInt(random, sizes[k][0]);
+        BigInt b = randomBigInt(random, sizes[k][1]);
+        if (k % 2 == 1) a.negate();
+        BigInt product = a * b;
+        expect(BigInt::compare(product, schoolbookProduct(a, b)) == 0,
+               "the product of " + integerToString(sizes[k][0]) + " and " + integerToString(sizes[k][1])
+               + " limbs to be that of the schoolbook method");
+    }
+    BigInt nines(string(9 * 1500, '9'));
+    expectEqual((nines * nines).toString(), string(9 * 1500 - 1, '9') + "8" + string(9 * 1500 - 1, '0') + "1",
+                "(10^13500 - 1)^2");
+}
+
+SELF_TEST(bigIntDividesBack){
+    mt19937_64 random(29);
+    BigInt a = randomBigInt(random, 2000);
+    const int divisorSizes[] = { 1, 2, 31, 33, 700, 1999, 2000 };
+    for (size_t k = 0; k < sizeof divisorSizes / sizeof divisorSizes[0]; k++){
+        BigInt b = randomBigInt(random, divisorSizes[k]);
+        if (k % 3 == 1) b.negate();
+        if (k % 3 == 2) a.negate();
+        BigInt quotient, remainder;
+        BigInt::divMod(a, b, quotient, remainder);
+        string what = "the division of 2000 limbs by " + integerToString(divisorSizes[k]);
+        expect(BigInt::compare(quotient * b + remainder, a) == 0, what + " to multiply back");
+        expect(BigInt::compare(remainder.abs(), b.abs()) < 0, what + " to leave a remainder below the divisor");
+        expect(remainder.isZero() || remainder.isNegative() == a.isNegative(), what + " to give the remainder the sign of a");
+    }
+    BigInt exact = BigInt("123456789123456789123456789") * BigInt("987654321987654321");
+    expectEqual((exact / BigInt("987654321987654321")).toString(), "123456789123456789123456789", "an exact quotient");
+    bool failed = false;
+    try {
+        exact / BigInt(0);
+    } catch (ErrorException &) {
+        failed = true;
+    }
+    expect(failed, "an error for a division by zero");
+}
+
+SELF_TEST(bigFloatGivesKnownDigits){
+    int saved = BigFloat::getPrecision();
+    BigFloat::setPrecision(60);
+    expectDigits(sqrt(BigFloat(2)), "1.414213562373095048801688724209698078569671875376948073176", "sqrt(2)");
+    expectDigits(log(BigFloat(2)), "0.693147180559945309417232121458176568075500134360255254120", "log(2)");
+    expectDigits(log(BigFloat(10)), "2.302585092994045684017991454684364207601101488628772976033", "log(10)");
+    expectDigits(pow(BigFloat(10), BigFloat("0.5")), "3.162277660168379331998893544432718533719555139325216826857",
+                 "10^0.5");
+    expectDigits(pow(BigFloat(2), BigFloat("-0.5")), "0.707106781186547524400844362104849039284835937688474036588",
+                 "2^-0.5");
+    expectDigits(BigFloat::pi(), "3.141592653589793238462643383279502884197169399375105820974", "pi");
+    expectEqual(pow(BigFloat(2), BigFloat(100)).toString(), "1267650600228229401496703205376", "2^100");
+    expectEqual(pow(BigFloat(3), BigFloat(-2)).toString().substr(0, 20), "0.111111111111111111", "3^-2");
+    // enough digits for the NTT in every multiplication of the roots
+    BigFloat::setPrecision(20000);
+    BigFloat root = sqrt(BigFloat(2));
+    BigFloat error = root * root - BigFloat(2);
+    BigFloat tolerance = BigFloat(1) / BigFloat(BigInt("1" + string(19990, '0')));
+    BigFloat::setPrecision(saved);
+    expect(BigFloat::compare(error, tolerance) < 0 && BigFloat::compare(-error, tolerance) < 0,
+           "sqrt(2)^2 at 20000 digits to be 2 within 1e-19990");
+}
@@ -0,0 +1,71 @@
+/* File: budgettest.cpp
+ * -----------------------------------
+ *
+ * Checks of the limits on the work for one line of input.
+ */
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include "bigfloat.h"
+#include "budget.h"
+#include "error.h"
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+
+using namespace std;
+
+SELF_TEST(budgetEndsLongBigNumberInstructions){
+    EvaluationLimits saved = EvaluationBudget::limits();
+    CalculatorSession session;
+    session.run(":limits time 1\n:mode big");
+    // one sin of a number with 89000 digits runs for many seconds
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    string output = session.run("sin(10^89000)");
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    EvaluationBudget::setLimits(saved);
+    expectEqual(output, "Error: Evaluation exceeded the time limit of 1 s\n", "the output of a sin too long");
+    expect(seconds < 5, "the sin to end soon after the deadline, not after " + realToString(seconds) + " s");
+}
+
+SELF_TEST(budgetCapsThePrecision){
+    CalculatorSession session;
+    int saved = BigFloat::getPrecision();
+    expectEqual(session.run(":precision " + integerToString(BigFloat::MAX_PRECISION + 1)),
+                "Error: BigFloat: precision must be at most " + integerToString(BigFloat::MAX_PRECISION) + " digits\n",
+                "the output of a precision too large");
+    expect(BigFloat::getPrecision() == saved, "the precision to stay as it was");
+}
+
+SELF_TEST(budgetDropsSlicesOfEarlierBudgets){
+    EvaluationLimits saved = EvaluationBudget::limits();
+    EvaluationLimits none = { 0, 0, 0, 0 };
+    EvaluationLimits few = { 1000, 0, 0, 0 };
+    promise<void> charged, started;
+    bool stopped = false;
+    EvaluationBudget::setLimits(none);
+    EvaluationBudget * budget = new EvaluationBudget;
+    // a thread takes a slice of a budget without limits, then charges
+    // the next budget more than its limit
+    thread worker([&]{
+        EvaluationBudget::charge(1);
+        charged.set_value();
+        started.get_future().wait();
+        try {
+            EvaluationBudget::charge(5000);
+        } catch (ErrorException &) {
+            stopped = true;
+        }
+    });
+    charged.get_future().wait();
+    delete budget;
+    EvaluationBudget::setLimits(few);
+    budget = new EvaluationBudget;
+    started.set_value();
+    worker.join();
+    delete budget;
+    EvaluationBudget::setLimits(saved);
+    expect(stopped, "the step limit of the new budget to stop the thread");
+}
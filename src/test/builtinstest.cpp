@@ -0,0 +1,63 @@
+/* File: builtinstest.cpp
+ * -----------------------------------
+ *
+ * Checks of the built-in functions integrate, solve, sum and prod as
+ * parts of equations: their derivatives, the gradient mode and the
+ * variables their equations may use.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "selftest.h"
+#include "session.h"
+
+using namespace std;
+
+SELF_TEST(builtinDerivativesFollowTheirEquations){
+    CalculatorSession session;
+    session.run(":var x = 4");
+    expectEqual(session.run(":d/dx integrate(x*t,t,0,1)"), "d/dx = integrate(t,t,0,1)\nResult: 0.5\n",
+                "the derivative of an integral by a parameter");
+    expectEqual(session.run(":d/dx x*sum(i,1,3,x*i)"), "d/dx = sum(i,1,3,x*i)+x*sum(i,1,3,i)\nResult: 48\n",
+                "the derivative of a product with a sum");
+    expectEqual(session.run(":d/dx integrate(t^2,t,0,x)"), "d/dx = x^2\nResult: 16\n",
+                "the derivative of an integral by its upper limit");
+    expectEqual(session.run(":d/dx solve(y^2-x,y,1)"), "d/dx = 1/(2*solve(y^2-x,y,1))\nResult: 0.25\n",
+                "the derivative of a root by a parameter");
+    expectEqual(session.run(":d/dx prod(i,1,3,x+i)"), "d/dx = prod(i,1,3,x+i)*sum(i,1,3,1/(x+i))\nResult: 107\n",
+                "the derivative of a product");
+}
+
+SELF_TEST(builtinGradients){
+    CalculatorSession session;
+    session.run(":var x = 4\n:mode gradient");
+    expectEqual(session.run("integrate(x*t,t,0,1)"), "Result: 2\n  d/dx = 0.5\n", "the gradient of an integral");
+    expectEqual(session.run("solve(y^2-x,y,1)"), "Result: 2\n  d/dx = 0.25\n", "the gradient of a root");
+    expectEqual(session.run("x*sum(i,1,3,x*i)"), "Result: 96\n  d/dx = 48\n", "the gradient of a sum");
+}
+
+SELF_TEST(builtinEquationsUseVariablesOfTheirCaller){
+    CalculatorSession session;
+    expectEqual(session.run("sum(i,1,3,sum(j,1,i,j))"), "Result: 10\n", "a sum with the index of an outer sum");
+    expectEqual(session.run("sum(i,1,3,integrate(x^i,x,0,1))"), "Result: 1.08333\n",
+                "integrals with the index of a sum");
+    session.run(":cell p = 3");
+    expectEqual(session.run(":cell q = sum(i,1,p,i)"), "q = 6, cells recalculated: 1\n", "a sum up to a cell");
+    expectEqual(session.run(":cell p = 4"), "p = 4, cells recalculated: 2\n", "the sum recalculated with its cell");
+
+    string input = "builtinstest-input.csv", output = "builtinstest-output.csv";
+    ofstream file(input.c_str());
+    file << "n,w\n1,2\n3,4\n";
+    file.close();
+    session.run(":csv " + input + " " + output + " n-sum(i,1,n,i*w)");
+    ifstream result(output.c_str());
+    string header, first, second;
+    getline(result, header);
+    getline(result, first);
+    getline(result, second);
+    result.close();
+    remove(input.c_str());
+    remove(output.c_str());
+    expectEqual(first + " " + second, "-1 -21", "sums up to a column");
+}
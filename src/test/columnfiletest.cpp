@@ -0,0 +1,70 @@
+/* File: columnfiletest.cpp
+ * -----------------------------------
+ *
+ * Checks of the columnar files of columnfile.h and their converters.
+ */
+
+#include <string>
+#include "columnfile.h"
+#include "error.h"
+#include "filelib.h"
+#include "selftest.h"
+#include "session.h"
+
+using namespace std;
+
+SELF_TEST(columnFilesConvertBothWays){
+    string csv = scratchFile("table.csv");
+    string columns = scratchFile("table.col");
+    string result = scratchFile("result.col");
+    string back = scratchFile("result.csv");
+    writeEntireFile(csv, "a,b\n1,2\n3,4\n");
+    CalculatorSession session;
+    expectEqual(session.run(":tocolumns " + csv + " " + columns), "Rows: 2, written to " + columns + "\n",
+                "the output of :tocolumns");
+    ColumnFile file(columns);
+    expect(file.rowCount() == 2 && file.columnCount() == 2 && file.columnName(1) == "b", "the shape of the file");
+    expect(file.column(0)[1] == 3 && file.column(1)[0] == 2, "the values of the columns");
+    expect((size_t) file.column(1) % 64 == 0, "the columns to be aligned");
+    session.run(":columns " + columns + " " + result + " a*b");
+    session.run(":tocsv " + result + " " + back);
+    expectEqual(readEntireFile(back), "result\n2\n12\n", "the results of :columns");
+    deleteFile(back);
+    deleteFile(result);
+    deleteFile(columns);
+    deleteFile(csv);
+}
+
+SELF_TEST(columnFilesKeepInputGivenAsOutput){
+    string csv = scratchFile("same.csv");
+    string columns = scratchFile("same.col");
+    writeEntireFile(csv, "a\n1\n2\n");
+    CalculatorSession session;
+    session.run(":tocolumns " + csv + " " + columns);
+    string contents = readEntireFile(columns);
+    string refused = "Error: Output file is the input file: " + columns + "\n";
+    expectEqual(session.run(":tocsv " + columns + " " + columns), refused, "the output of :tocsv into its input");
+    expectEqual(session.run(":columns " + columns + " " + columns + " a+1"), refused,
+                "the output of :columns into its input");
+    expectEqual(session.run(":tocolumns " + csv + " " + csv), "Error: Output file is the input file: " + csv + "\n",
+                "the output of :tocolumns into its input");
+    expect(readEntireFile(columns) == contents && readEntireFile(csv) == "a\n1\n2\n", "the inputs to stay as they were");
+    deleteFile(columns);
+    deleteFile(csv);
+}
+
+SELF_TEST(columnFilesRejectMisalignedColumns){
+    string path = scratchFile("misaligned.col");
+    // one row of one column "a" at offset 36, not a multiple of 64
+    string header("CALCCOL1\1\0\0\0\0\0\0\0\1\0\0\0\44\0\0\0\1\0\0\0a", 29);
+    header.resize(36 + 64, '\0');
+    writeEntireFile(path, header);
+    string message;
+    try {
+        ColumnFile file(path);
+    } catch (ErrorException & ex) {
+        message = ex.getMessage();
+    }
+    expectEqual(message, "Column file has misaligned columns: " + path, "the error of a misaligned column");
+    deleteFile(path);
+}
@@ -0,0 +1,34 @@
+/* File: csvtest.cpp
+ * -----------------------------------
+ *
+ * Checks of the evaluation of equations over CSV files of csv.h.
+ */
+
+#include <string>
+#include "filelib.h"
+#include "selftest.h"
+#include "session.h"
+
+using namespace std;
+
+SELF_TEST(csvEvaluatesColumns){
+    string input = scratchFile("input.csv");
+    string output = scratchFile("output.csv");
+    writeEntireFile(input, "a,b\n1,2\n3,x\n");
+    CalculatorSession session;
+    expectEqual(session.run(":csv " + input + " " + output + " a*10+b"),
+                "Rows: 2, written to " + output + "\nMissing or non-numeric fields: 1\n", "the output of :csv");
+    expectEqual(readEntireFile(output), "result\n12\nnan\n", "the results of :csv");
+    deleteFile(output);
+    deleteFile(input);
+}
+
+SELF_TEST(csvKeepsInputGivenAsOutput){
+    string input = scratchFile("same.csv");
+    writeEntireFile(input, "a,b\n1,2\n3,4\n");
+    CalculatorSession session;
+    expectEqual(session.run(":csv " + input + " " + input + " a+b"),
+                "Error: Output file is the input file: " + input + "\n", "the output of :csv into its input");
+    expectEqual(readEntireFile(input), "a,b\n1,2\n3,4\n", "the input to stay as it was");
+    deleteFile(input);
+}
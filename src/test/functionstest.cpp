@@ -0,0 +1,106 @@
+/* File: functionstest.cpp
+ * -----------------------------------
+ *
+ * Checks of the functions defined by the user of functions.h: inlined,
+ * recursive and called through frames.
+ */
+
+#include <cmath>
+#include <string>
+#include "calc.h"
+#include "error.h"
+#include "functions.h"
+#include "prepared.h"
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+#include "vectorshpp.h"
+
+using namespace std;
+
+/*
+ * Function: compileX
+ * Usage: Expression expr = compileX("f(x,2)");
+ * ______________________________________________________
+ *
+ * Compiles an equation of the variable x
+ */
+static Expression compileX(const string & equation){
+    VectorSHPP<string> names;
+    names.add("x");
+    VectorSHPP<string> record = polishInvertedRecord(equation);
+    return compileEquation(record, names);
+}
+
+/*
+ * Function: callCount
+ * Usage: int calls = callCount(expr);
+ * ______________________________________________________
+ *
+ * Returns the number of calls of user functions in compiled code
+ */
+static int callCount(const Expression & expr){
+    int calls = 0;
+    for (int i = 0; i < expr.size(); i++){
+        if (expr.instruction(i).op == CALL) calls++;
+    }
+    return calls;
+}
+
+SELF_TEST(functionsInlineSmallBodies){
+    FunctionRegistry & registry = FunctionRegistry::shared();
+    registry.define("checkf(x,y)=x^2+y*sin(x)");
+    const UserFunction & f = registry.function(registry.find("checkf"));
+    expect(f.inlined && !f.recursive, "a small function to be inlined");
+    Expression expr = compileX("checkf(x,2)-checkf(x,2)*0");
+    double x = 0.7;
+    expect(callCount(expr) == 0, "no call left in the code of an inlined function");
+    expect(expr.evaluate<double>(&x) == x * x + 2 * sin(x), "the value of an inlined function");
+    CalculatorSession session;
+    session.run(":var x = 2");
+    expectEqual(session.run(":d/dx checkf(x,3)"), "d/dx = 2*x+3*cos(x)\nResult: 2.75156\n",
+                "the derivative through an inlined function");
+}
+
+SELF_TEST(functionsCallLargeAndRecursiveBodies){
+    FunctionRegistry & registry = FunctionRegistry::shared();
+    registry.define("checkfact(n)=if(n<=1,1,n*checkfact(n-1))");
+    string body = "x+x*x+x*x*x+x*x*x*x+x*x*x*x*x+x*x*x*x*x*x+sin(x)+cos(x)+tan(x)+log(x)";
+    registry.define("checkbig(x)=" + body);
+    expect(registry.function(registry.find("checkfact")).recursive, "checkfact to be recursive");
+    expect(!registry.function(registry.find("checkbig")).inlined, "a large function to be called");
+    Expression big = compileX("checkbig(x)+checkbig(x+1)");
+    double x = 0.5, next = 1.5;
+    expect(callCount(big) == 2, "two calls of the large function");
+    expect(fabs(big.evaluate<double>(&x) - (compileX(body).evaluate<double>(&x) + compileX(body).evaluate<double>(&next)))
+           < 1e-12, "the value of calls of a large function");
+    CalculatorSession session;
+    expectEqual(session.run("checkfact(10)"), "Result: 3.6288e+06\n", "the output of a recursive function");
+    expectEqual(session.run("checkfact(3)+checkbig(0.5)"), "Result: 8.19454\n", "the output of both kinds of call");
+}
+
+SELF_TEST(functionsKeepTheirVersions){
+    FunctionRegistry & registry = FunctionRegistry::shared();
+    registry.define("checkv(x)=x+1");
+    PreparedExpression before = prepare("checkv(a)*10");
+    before.bind(0, 2);
+    registry.define("checkv(x)=x+100");
+    PreparedExpression after = prepare("checkv(a)*10");
+    after.bind(0, 2);
+    expect(before.execute() == 30 && after.execute() == 1020, "code compiled before a redefinition to keep the old version");
+    // errors leave the registry as it was
+    int id = registry.find("checkv");
+    const char * const malformed[] = { "checkv(x=1", "checkv(x,x)=x", "checkv(x)=", "checkv(x)=y+1" };
+    for (size_t i = 0; i < sizeof malformed / sizeof malformed[0]; i++){
+        bool failed = false;
+        try {
+            registry.define(malformed[i]);
+        } catch (ErrorException &) {
+            failed = true;
+        }
+        expect(failed && registry.find("checkv") == id, string("an error for ") + malformed[i] + " and no new version");
+    }
+    CalculatorSession session;
+    expectEqual(session.run("checkv(1,2)"), "Error: Function checkv takes 1 argument\n", "the error of two arguments");
+    expectEqual(session.run("checknone(1)"), "Error: Unknown function: checknone\n", "the error of an unknown function");
+}
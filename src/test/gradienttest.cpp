@@ -0,0 +1,150 @@
+/* File: gradienttest.cpp
+ * -----------------------------------
+ *
+ * Checks of the gradients of dual.h and adjoint.h against finite
+ * differences and each other.
+ */
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "adjoint.h"
+#include "calc.h"
+#include "dual.h"
+#include "functions.h"
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+#include "vectorshpp.h"
+
+using namespace std;
+
+/* An equation with every operator and function of the calculator */
+static const char * const EQUATION =
+        "x*y-z/(x+1)+x^y+sin(x)*cos(y)+sqrt(z)+tan(x/3)+log(y)+if(x>y,x*z,y-z)";
+
+/*
+ * Function: compileXyz
+ * Usage: Expression expr = compileXyz(equation);
+ * ______________________________________________________
+ *
+ * Compiles an equation of the variables x, y and z
+ */
+static Expression compileXyz(const string & equation){
+    VectorSHPP<string> names;
+    names.add("x");
+    names.add("y");
+    names.add("z");
+    VectorSHPP<string> record = polishInvertedRecord(equation);
+    return compileEquation(record, names);
+}
+
+/*
+ * Function: expectNearDifference
+ * Usage: expectNearDifference(expr, values, v, derivative, "d/dx");
+ * ______________________________________________________
+ *
+ * Signals the failure of a check unless the derivative by variable v
+ * agrees with the central difference of the expression at the values
+ */
+static void expectNearDifference(const Expression & expr, const double * values, int v, double derivative,
+                                 const string & what){
+    vector<double> shifted(values, values + expr.variableCount());
+    double step = 1e-6 * max(1.0, fabs(values[v]));
+    shifted[v] = values[v] + step;
+    double upper = expr.evaluate<double>(&shifted[0]);
+    shifted[v] = values[v] - step;
+    double lower = expr.evaluate<double>(&shifted[0]);
+    double difference = (upper - lower) / (2 * step);
+    expect(fabs(derivative - difference) <= 1e-5 * max(1.0, fabs(difference)),
+           what + " = " + realToString(derivative) + " to be near the difference " + realToString(difference));
+}
+
+SELF_TEST(forwardGradientMatchesDifferences){
+    Expression expr = compileXyz(EQUATION);
+    mt19937_64 random(31);
+    uniform_real_distribution<double> value(0.5, 2.5);
+    const int rows = 600;
+    vector<double> columns[3];
+    for (int v = 0; v < 3; v++){
+        for (int r = 0; r < rows; r++) columns[v].push_back(value(random));
+    }
+    const double * columnPointers[] = { &columns[0][0], &columns[1][0], &columns[2][0] };
+    vector<double> results(rows), gradients[3];
+    for (int v = 0; v < 3; v++) gradients[v].resize(rows);
+    double * gradientPointers[] = { &gradients[0][0], &gradients[1][0], &gradients[2][0] };
+    evaluateGradientBatch(expr, columnPointers, rows, &results[0], gradientPointers);
+    const char * names[] = { "d/dx", "d/dy", "d/dz" };
+    for (int r = 0; r < rows; r++){
+        double values[] = { columns[0][r], columns[1][r], columns[2][r] };
+        double gradient[3];
+        double single = evaluateGradient(expr, values, gradient);
+        expect(single == expr.evaluate<double>(values) && results[r] == single,
+               "the value of row " + integerToString(r) + " to be that of the equation");
+        for (int v = 0; v < 3; v++){
+            string what = string(names[v]) + " of row " + integerToString(r);
+            expectNearDifference(expr, values, v, gradient[v], what);
+            expect(gradients[v][r] == gradient[v], what + " of the batch to be that of one row");
+        }
+    }
+}
+
+SELF_TEST(reverseGradientMatchesForward){
+    Expression expr = compileXyz(EQUATION);
+    ReverseGradient reverse(expr);
+    mt19937_64 random(32);
+    uniform_real_distribution<double> value(0.5, 2.5);
+    for (int round = 0; round < 100; round++){
+        double values[] = { value(random), value(random), value(random) };
+        double forward[3], backward[3];
+        double expected = evaluateGradient(expr, values, forward);
+        expect(reverse.evaluate(values, backward) == expected, "the value of the reverse mode");
+        for (int v = 0; v < 3; v++){
+            expect(fabs(backward[v] - forward[v]) <= 1e-12 * max(1.0, fabs(forward[v])),
+                   "derivative " + integerToString(v) + " of the reverse mode " + realToString(backward[v])
+                   + " to be that of the forward mode " + realToString(forward[v]));
+        }
+    }
+}
+
+SELF_TEST(reverseGradientStopsAllocating){
+    // a product of neighbours of 300 variables
+    const int count = 300;
+    VectorSHPP<string> names;
+    string equation;
+    for (int i = 0; i < count; i++){
+        string name = "v";
+        for (int k = i; k > 0 || name.length() == 1; k /= 26) name += (char) ('a' + k % 26);
+        names.add(name);
+        if (i > 1) equation += "+";
+        if (i > 0) equation += names.get(i - 1) + "*sin(" + name + ")";
+    }
+    VectorSHPP<string> record = polishInvertedRecord(equation);
+    Expression expr = compileEquation(record, names);
+    vector<double> values(count), derivatives(count);
+    for (int i = 0; i < count; i++) values[i] = 0.001 * i;
+    const int rows = 1000;
+    vector<vector<double> > columns(count, vector<double>(rows, 0.5)), gradients(count, vector<double>(rows));
+    vector<const double *> columnPointers(count);
+    vector<double *> gradientPointers(count);
+    for (int i = 0; i < count; i++){
+        columnPointers[i] = &columns[i][0];
+        gradientPointers[i] = &gradients[i][0];
+    }
+    vector<double> results(rows);
+    ReverseGradient reverse(expr);
+    reverse.evaluate(&values[0], &derivatives[0]);
+    reverse.evaluateBatch(&columnPointers[0], rows, &results[0], &gradientPointers[0]);
+    long long before = heapAllocations();
+    for (int round = 0; round < 10; round++){
+        reverse.evaluate(&values[0], &derivatives[0]);
+        reverse.evaluateBatch(&columnPointers[0], rows, &results[0], &gradientPointers[0]);
+    }
+    long long allocations = heapAllocations() - before;
+    expect(allocations == 0, integerToString(allocations) + " allocations to be none once the tape has grown");
+    for (int i = 0; i < count; i++){
+        expectNearDifference(expr, &values[0], i, derivatives[i], "the derivative by " + names.get(i));
+    }
+    expect(fabs(gradients[count - 1][rows - 1] - 0.5 * cos(0.5)) < 1e-15, "the derivative of the last row");
+}
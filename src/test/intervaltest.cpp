@@ -0,0 +1,261 @@
+/* File: intervaltest.cpp
+ * -----------------------------------
+ *
+ * Checks and benchmark of the interval calculation mode.
+ */
+
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "calc.h"
+#include "error.h"
+#include "functions.h"
+#include "interval.h"
+#include "selftest.h"
+#include "session.h"
+#include "vectorshpp.h"
+
+using namespace std;
+
+/*
+ * Function: expectPoint
+ * Usage: expectPoint(Interval(5) - Interval(1), 4, "5-1");
+ * ______________________________________________________
+ *
+ * Signals the failure of a check unless the interval is exactly the value
+ */
+static void expectPoint(const Interval & x, double value, const string & what){
+    expect(x.getLower() == value && x.getUpper() == value, what + " to be exactly " + x.toString());
+}
+
+/*
+ * Function: expectEnclosure
+ * Usage: expectEnclosure(Interval(1) / Interval(3), 1.0L / 3, "1/3");
+ * ______________________________________________________
+ *
+ * Signals the failure of a check unless the interval is wider than a
+ * point and contains the exact value, given in long double
+ */
+static void expectEnclosure(const Interval & x, long double exact, const string & what){
+    expect(x.getLower() < x.getUpper(), what + " " + x.toString() + " to be wider than a point");
+    expect(x.getLower() <= exact && exact <= x.getUpper(), what + " " + x.toString() + " to contain the exact value");
+}
+
+SELF_TEST(intervalExactResultsArePoints){
+    expectPoint(Interval(5) - Interval(1), 4, "5-1");
+    expectPoint(Interval(2) * Interval(3), 6, "2*3");
+    expectPoint(Interval(1) / Interval(4), 0.25, "1/4");
+    expectPoint(Interval(-1) / Interval(-8), 0.125, "-1/-8");
+    expectPoint(sqrt(Interval(4)), 2, "sqrt(4)");
+    expectPoint(pow(Interval(2), Interval(10)), 1024, "2^10");
+    expectPoint(pow(Interval(-3), Interval(3)), -27, "(-3)^3");
+    expectPoint(Interval::fromDecimal("1.5") * Interval::fromDecimal("1.5"), 2.25, "1.5*1.5");
+    expectPoint(Interval(1e300) * Interval(0), 0, "1e300*0");
+}
+
+SELF_TEST(intervalInexactResultsAreWidened){
+    expectEnclosure(Interval::fromDecimal("0.1") + Interval::fromDecimal("0.2"), 0.3L, "0.1+0.2");
+    expectEnclosure(Interval(1e16) + Interval(1), 1e16L + 1, "1e16+1");
+    expectEnclosure(Interval(1e16) - Interval(-3), 1e16L + 3, "1e16-(-3)");
+    expectEnclosure(Interval(1) / Interval(3), 1.0L / 3, "1/3");
+    expectEnclosure(Interval(-2) / Interval(3), -2.0L / 3, "-2/3");
+    long double near = 1 + 1e-15;
+    expectEnclosure(Interval(1 + 1e-15) * Interval(1 + 1e-15), near * near, "(1+1e-15)^2");
+    expectEnclosure(Interval(1e-200) * Interval(1e-200), 1e-400L, "an underflowed product");
+    expectEnclosure(Interval(1e-300) / Interval(1e10), 1e-310L, "a subnormal quotient");
+    expectEnclosure(sqrt(Interval(2)), sqrtl(2), "sqrt(2)");
+    Interval huge = Interval(1e308) * Interval(10);
+    expect(huge.getLower() == DBL_MAX && huge.getUpper() > DBL_MAX, "an overflowed product to be [DBL_MAX, inf]");
+}
+
+SELF_TEST(intervalRecursionCompares){
+    CalculatorSession session;
+    string output = session.run(":mode interval\n"
+                                ":def intervalfact(n) = if(n<2, 1, n*intervalfact(n-1))\n");
+    expectEqual(session.run("intervalfact(5)"), "Result: [120, 120]\n", "intervalfact(5)");
+    expectEqual(session.run("5-1"), "Result: [4, 4]\n", "5-1");
+}
+
+/*
+ * Function: batchOf
+ * Usage: Interval res = batchOf("x*3", Interval(1));
+ * ______________________________________________________
+ *
+ * Returns the equation of x for one value by the batch evaluation
+ */
+static Interval batchOf(const string & equation, const Interval & x){
+    VectorSHPP<string> names;
+    names.add("x");
+    VectorSHPP<string> record = polishInvertedRecord(equation);
+    Expression expr = compileEquation(record, names);
+    double xLower = x.getLower(), xUpper = x.getUpper();
+    const double * lowerColumn = &xLower;
+    const double * upperColumn = &xUpper;
+    double lower, upper;
+    expr.evaluateBatch(&lowerColumn, &upperColumn, 1, &lower, &upper);
+    return Interval(lower, upper);
+}
+
+SELF_TEST(intervalBatchRoundsOutward){
+    expectPoint(batchOf("5-x", Interval(1)), 4, "5-1 in a batch");
+    expectPoint(batchOf("x*3/4", Interval(2)), 1.5, "2*3/4 in a batch");
+    expectPoint(batchOf("sqrt(x)", Interval(2.25)), 1.5, "sqrt(2.25) in a batch");
+    expectPoint(batchOf("(x-3)*(x+1)", Interval(-3)), 12, "(-3-3)*(-3+1) in a batch");
+    expectEnclosure(batchOf("x+0.2", Interval::fromDecimal("0.1")), 0.3L, "0.1+0.2 in a batch");
+    expectEnclosure(batchOf("1/x", Interval(3)), 1.0L / 3, "1/3 in a batch");
+    expectEnclosure(batchOf("-2/x", Interval(3)), -2.0L / 3, "-2/3 in a batch");
+    expectEnclosure(batchOf("x-10000000000000000", Interval(-3)), -1e16L - 3, "-3-1e16 in a batch");
+    expectEnclosure(batchOf("sqrt(x)", Interval(2)), sqrtl(2), "sqrt(2) in a batch");
+    long double near = 1 + 1e-15;
+    expectEnclosure(batchOf("x*x", Interval(1 + 1e-15)), near * near, "(1+1e-15)^2 in a batch");
+    Interval signs = batchOf("x*(x-1)", Interval(-2, 3));
+    expect(signs.getLower() == -9 && signs.getUpper() == 6, "[-2,3]*[-3,2] in a batch to be " + signs.toString());
+    expectPoint(batchOf("if(x>1,x*2,x)", Interval(3)), 6, "a conditional in a batch");
+    expectPoint(batchOf("x^3-x", Interval(3)), 24, "a power in a batch");
+    expectEnclosure(batchOf("sin(x)", Interval(1)), sinl(1), "a sine in a batch");
+    string message;
+    try {
+        batchOf("1/(x-1)", Interval(0, 2));
+    } catch (ErrorException & ex) {
+        message = ex.getMessage();
+    }
+    expectEqual(message, "Division by an interval containing zero", "the error of a division in a batch");
+    expect(batchOf("x*0.1", Interval(3)).width() > 0, "the rounding to nearest to be restored after an error");
+}
+
+SELF_TEST(intervalBatchIsInsideOperators){
+    // upward rounding gives the tightest bounds, never wider than those
+    // of the operators of Interval
+    const int rows = 10000;
+    mt19937_64 random(30);
+    uniform_real_distribution<double> value(-100, 100);
+    vector<double> lower[2], upper[2];
+    for (int v = 0; v < 2; v++){
+        for (int r = 0; r < rows; r++){
+            double a = value(random), b = r % 3 == 0 ? a : value(random);
+            lower[v].push_back(min(a, b));
+            upper[v].push_back(max(a, b));
+        }
+    }
+    VectorSHPP<string> names;
+    names.add("a");
+    names.add("b");
+    VectorSHPP<string> record = polishInvertedRecord("(a*b+a-b*0.1)/(b+101)+sqrt(a+100)");
+    Expression expr = compileEquation(record, names);
+    const double * lowerColumns[] = { &lower[0][0], &lower[1][0] };
+    const double * upperColumns[] = { &upper[0][0], &upper[1][0] };
+    vector<double> resLower(rows), resUpper(rows);
+    expr.evaluateBatch(lowerColumns, upperColumns, rows, &resLower[0], &resUpper[0]);
+    for (int r = 0; r < rows; r++){
+        Interval values[] = { Interval(lower[0][r], upper[0][r]), Interval(lower[1][r], upper[1][r]) };
+        Interval expected = expr.evaluate(values);
+        if (!(expected.getLower() <= resLower[r] && resLower[r] <= resUpper[r] && resUpper[r] <= expected.getUpper())){
+            error("row " + integerToString(r) + ": [" + realToString(resLower[r]) + ", " + realToString(resUpper[r])
+                  + "] is not inside " + expected.toString());
+        }
+    }
+}
+
+SELF_TEST(intervalComparesOnBounds){
+    Interval a(1, 2), b(2, 2), c(1.5, 3);
+    expect(Expression::compare(LESS_EQUAL, a, b) && Expression::compare(GREATER_EQUAL, b, a),
+           "[1, 2] <= [2, 2] and [2, 2] >= [1, 2]");
+    expect(!Expression::compare(GREATER_EQUAL, Interval(0, 0.5), a), "not [0, 0.5] >= [1, 2]");
+    const OpCode uncertain[] = { LESS, EQUAL, LESS_EQUAL };
+    const Interval left[] = { a, a, c };
+    for (int i = 0; i < 3; i++){
+        string message;
+        try {
+            Expression::compare(uncertain[i], left[i], b);
+        } catch (ErrorException & ex) {
+            message = ex.getMessage();
+        }
+        expectEqual(message, "Comparison of overlapping intervals is uncertain",
+                    "the error of comparison " + integerToString(i) + " with [2, 2]");
+    }
+    expectPoint(batchOf("if(x<=2,1,0)", a), 1, "if(x<=2,1,0) for [1, 2] in a batch");
+    expectPoint(batchOf("(x>=1)+(2>=x)", a), 2, "(x>=1)+(2>=x) for [1, 2] in a batch");
+}
+
+SELF_BENCHMARK(intervalOverhead){
+    const int rows = 1000000;
+    VectorSHPP<string> names;
+    names.add("x");
+    VectorSHPP<string> record = polishInvertedRecord("x*x-3*x/(x+1)+sqrt(x)*2-x^3");
+    Expression expr = compileEquation(record, names);
+
+    double doubleSum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < rows; i++){
+        double x = 1 + i * 1e-6;
+        doubleSum += expr.evaluate<double>(&x);
+    }
+    double doubleTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    Interval intervalSum;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < rows; i++){
+        Interval x(1 + i * 1e-6);
+        intervalSum = intervalSum + expr.evaluate<Interval>(&x);
+    }
+    double intervalTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    expect(intervalSum.contains(doubleSum) || intervalSum.width() > 0, "the intervals to be calculated");
+    cout << "x*x-3*x/(x+1)+sqrt(x)*2-x^3 for " << rows << " values: double "
+         << doubleTime << " s, interval " << intervalTime << " s ("
+         << intervalTime / doubleTime << " times)" << endl;
+
+    // the arithmetic alone, on arrays
+    vector<double> a(rows), b(rows), c(rows);
+    vector<Interval> ia(rows), ib(rows), ic(rows);
+    for (int i = 0; i < rows; i++){
+        a[i] = 1 + i * 1e-6;
+        b[i] = 3 - i * 1e-7;
+        ia[i] = Interval::fromDecimal("0.1") + Interval(a[i]);
+        ib[i] = Interval(b[i]);
+    }
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < 10; round++){
+        for (int i = 0; i < rows; i++) c[i] = a[i] * b[i] + a[i] - b[i];
+    }
+    doubleTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < 10; round++){
+        for (int i = 0; i < rows; i++) ic[i] = ia[i] * ib[i] + ia[i] - ib[i];
+    }
+    intervalTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    expect(ic[rows / 2].contains(c[rows / 2]) || ic[rows / 2].width() > 0, "the arrays to be calculated");
+    cout << "a*b+a-b on arrays of " << rows << " values: double "
+         << doubleTime / 10 << " s, interval " << intervalTime / 10 << " s ("
+         << intervalTime / doubleTime << " times)" << endl;
+
+    // the batch evaluation of both, in blocks of rows
+    const char * const equations[] = { "x*x-3*x/(x+1)+sqrt(x)*2-x*x*x", "x*y+x-y" };
+    names.add("y");
+    vector<double> upperA(rows), upperB(rows);
+    for (int i = 0; i < rows; i++){
+        upperA[i] = ia[i].getUpper();
+        upperB[i] = ib[i].getUpper();
+        a[i] = ia[i].getLower();
+    }
+    const double * lowerColumns[] = { &a[0], &b[0] };
+    const double * upperColumns[] = { &upperA[0], &upperB[0] };
+    vector<double> upperC(rows);
+    for (int e = 0; e < 2; e++){
+        record = polishInvertedRecord(equations[e]);
+        expr = compileEquation(record, names);
+        start = chrono::steady_clock::now();
+        for (int round = 0; round < 10; round++) expr.evaluateBatch(lowerColumns, rows, &c[0]);
+        doubleTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        for (int round = 0; round < 10; round++){
+            expr.evaluateBatch(lowerColumns, upperColumns, rows, &c[0], &upperC[0]);
+        }
+        intervalTime = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        expect(c[rows / 2] <= upperC[rows / 2], "the batch to be calculated");
+        cout << equations[e] << " in batches of " << rows << " rows: double "
+             << doubleTime / 10 << " s, interval " << intervalTime / 10 << " s ("
+             << intervalTime / doubleTime << " times)" << endl;
+    }
+}
@@ -0,0 +1,83 @@
+/* File: memotest.cpp
+ * -----------------------------------
+ *
+ * Checks of the cache of function results of memo.h.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "filelib.h"
+#include "memo.h"
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+#include "threadpool.h"
+
+using namespace std;
+
+/*
+ * Function: sameBits
+ * Usage: if (sameBits(x, y))...
+ * ______________________________________________________
+ *
+ * Returns true if two numbers have the same bits, which tells -0 from 0
+ * and compares NaN
+ */
+static bool sameBits(double x, double y){
+    return memcmp(&x, &y, sizeof(double)) == 0;
+}
+
+SELF_TEST(memoCountsHitsAndMisses){
+    FunctionCache::resetStatistics();
+    bool exact = true;
+    // a new thread has a new cache, whose counts stay after it ends
+    thread worker([&]{
+        FunctionCache & cache = FunctionCache::local();
+        for (int round = 0; round < 100; round++){
+            for (int angle = 1; angle <= 16; angle++){
+                double x = angle * 0.25;
+                exact = exact && sameBits(cache.call(MEMO_SIN, x), sin(x)) && sameBits(cache.call(MEMO_LOG, x), log(x));
+            }
+        }
+        // 0 is in every slot from the start, -0 is another argument
+        exact = exact && sameBits(cache.call(MEMO_SIN, 0.0), 0.0) && sameBits(cache.call(MEMO_SIN, -0.0), -0.0);
+        exact = exact && isnan(cache.call(MEMO_LOG, NAN)) && isnan(cache.call(MEMO_LOG, NAN));
+    });
+    worker.join();
+    long long hits, misses;
+    FunctionCache::statistics(hits, misses);
+    expect(exact, "the cache to give the bits of the functions");
+    expectEqual(integerToString(hits) + " hits, " + integerToString(misses) + " misses", "3170 hits, 34 misses",
+                "the statistics of 16 arguments of sin and log 100 times, 0, -0 and NaN twice");
+    FunctionCache::resetStatistics();
+    FunctionCache::statistics(hits, misses);
+    expect(hits == 0 && misses == 0, "the statistics to be reset");
+}
+
+SELF_TEST(memoCachesRowsOfFiles){
+    // 10 angles repeated over 5000 rows, on the threads of the pool
+    ostringstream text;
+    text << "a\n";
+    for (int r = 0; r < 5000; r++) text << r % 10 << "\n";
+    string input = scratchFile("memo.csv");
+    string output = scratchFile("memo-output.csv");
+    writeEntireFile(input, text.str());
+    CalculatorSession session;
+    expectEqual(session.run(":memo on\nsin(1)+sin(1)+cos(2)\n:memo"),
+                "Memo: on, hits: 0, misses: 0\nResult: 1.2668\nMemo: on, hits: 1, misses: 2, hit rate: 33.3333%\n",
+                "the output of :memo");
+    session.run(":memo on\n:csv " + input + " " + output + " sin(a)*cos(a)");
+    string statistics = session.run(":memo\n:memo off");
+    deleteFile(output);
+    deleteFile(input);
+    long long hits = 0, misses = 0;
+    istringstream(statistics.substr(statistics.find("hits: ") + 6)) >> hits;
+    istringstream(statistics.substr(statistics.find("misses: ") + 8)) >> misses;
+    int threads = ThreadPool::shared().threadCount() + 1;
+    expect(hits + misses == 10000, "a lookup for each sin and cos of the rows, not " + integerToString(hits + misses));
+    expect(misses <= 2 * 10 * threads, integerToString(misses) + " misses to be at most two functions of 10 angles "
+           "for each of " + integerToString(threads) + " threads");
+}
@@ -0,0 +1,126 @@
+/* File: nestingtest.cpp
+ * -----------------------------------
+ *
+ * Stress checks of equations nested far deeper than the call stack
+ * would allow a recursive walk: parsing, evaluation, derivatives and
+ * their simplification, and a benchmark of the time and memory per
+ * level up to a depth of 10^7.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* Nesting depth of the equations of the checks */
+static const int DEPTH = 100000;
+
+/*
+ * Function: nested
+ * Usage: string equation = nested("sin(", "x", ")", 1000);
+ * ______________________________________________________
+ *
+ * Returns the core wrapped in the given number of openings and closings
+ */
+static string nested(const string & opening, const string & core, const string & closing, int depth){
+    string res;
+    res.reserve(depth * (opening.length() + closing.length()) + core.length());
+    for (int i = 0; i < depth; i++) res += opening;
+    res += core;
+    for (int i = 0; i < depth; i++) res += closing;
+    return res;
+}
+
+/*
+ * Function: peakMemory
+ * Usage: double bytes = peakMemory();
+ * ______________________________________________________
+ *
+ * Returns the largest resident size of the process so far in bytes, or
+ * 0 where it is not known
+ */
+static double peakMemory(){
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024.0;
+#endif
+#endif
+}
+
+SELF_TEST(nestingParsesAndEvaluates){
+    CalculatorSession session;
+    session.run(":var x = 0.5");
+    expectEqual(session.run(nested("(", "x", ")", DEPTH)), "Result: 0.5\n", "x in deep brackets");
+    // sin applied n times to 0.5 is about sqrt(3 / n)
+    expectEqual(session.run(nested("sin(", "x", ")", DEPTH)), "Result: 0.00547675\n", "deeply nested sines");
+    expectEqual(session.run(nested("if(x>0,", "x", ",0)", DEPTH)), "Result: 0.5\n", "deeply nested conditionals");
+    expectEqual(session.run(nested("(", "x", "-1)", DEPTH)), "Result: -99999.5\n", "a deep chain of differences");
+}
+
+SELF_TEST(nestingDifferentiates){
+    CalculatorSession session;
+    session.run(":var x = 0.5");
+    string output = session.run(":d/dx " + nested("sin(", "x", ")", DEPTH));
+    expect(startsWith(output, "d/dx = cos(x)*cos(sin(x))*"), "the derivative of deeply nested sines");
+    expect(endsWith(output, "\nResult: 1.24626e-06\n"), "the value of the derivative of deeply nested sines");
+    output = session.run(":d/dx " + nested("(", "x", "*x)", DEPTH / 10));
+    expect(endsWith(output, "\nResult: 0\n"), "the value of the derivative of x^" + integerToString(DEPTH / 10 + 1)
+           + " at 0.5, which underflows");
+}
+
+SELF_TEST(nestingSimplifies){
+    CalculatorSession session;
+    session.run(":var x = 0.5");
+    expectEqual(session.run(":d/dx " + nested("(", "x", "*1+0)", DEPTH)), "d/dx = 1\nResult: 1\n",
+                "the derivative of x under deep neutral operations");
+    expectEqual(session.run(":d/dx " + nested("(", "x", "+x)", DEPTH)), "d/dx = 100001\nResult: 100001\n",
+                "the derivative of a deep chain of sums of x");
+    expectEqual(session.run(":d/dx " + nested("(", "x", "+1)-1", DEPTH)), "d/dx = 1\nResult: 1\n",
+                "the derivative of a deep chain of constants");
+}
+
+SELF_BENCHMARK(nestingCost){
+    // the runs go from the least to the most memory, so that each one
+    // raises the peak and the growth of the peak is its own memory
+    const int depths[] = { 100000, 1000000, 10000000 };
+    CalculatorSession session;
+    session.run(":var x = 0.5");
+    double baseline = peakMemory();
+    double lastNanoseconds[2] = { 0, 0 }, lastBytes[2] = { 0, 0 };
+    for (size_t k = 0; k < sizeof depths / sizeof depths[0]; k++){
+        for (int chain = 0; chain < 2; chain++){
+            int depth = depths[k];
+            string equation = chain ? nested("(", "x", "-1)", depth) : nested("(", "x", ")", depth);
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            string output = session.run(equation);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            expect(startsWith(output, "Result: "), "a result at depth " + integerToString(depth));
+            double nanoseconds = seconds / depth * 1e9;
+            double bytes = (peakMemory() - baseline) / depth;
+            cout << (chain ? "(x-1) " : "(x) ") << depth << " deep: " << seconds << " s, "
+                 << nanoseconds << " ns and " << bytes << " bytes per level" << endl;
+            // linear time and memory: the cost per level stays about the same
+            if (k > 0){
+                expect(nanoseconds < 4 * lastNanoseconds[chain], "the time per level to stay the same at depth "
+                       + integerToString(depth));
+                expect(bytes < 2 * lastBytes[chain], "the memory per level to stay the same at depth "
+                       + integerToString(depth));
+            }
+            lastNanoseconds[chain] = nanoseconds;
+            lastBytes[chain] = bytes;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+/* File: parsertest.cpp
+ * -----------------------------------
+ *
+ * Checks of the push parser of parser.h, which reads equations in
+ * chunks.
+ */
+
+#include <algorithm>
+#include <string>
+#include "calc.h"
+#include "budget.h"
+#include "error.h"
+#include "parser.h"
+#include "selftest.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* Equations with numbers, names, calls and operators of every length */
+static const char * const EQUATIONS[] = {
+    "1+2*3",
+    "-12.5e-3*(x+y)^2/7",
+    "sin(cos(x))+sqrt(2)-log(10)",
+    "if(x>=1,f(x,2,y),0)&&x!=3||y<=2",
+    "sum(i,1,100,1/i^2)+integrate(t^2,t,0,1)"
+};
+
+/*
+ * Function: recordText
+ * Usage: string text = recordText(record);
+ * ______________________________________________________
+ *
+ * Returns the tokens of a polish record separated by spaces
+ */
+static string recordText(const VectorSHPP<string> & record){
+    string res;
+    for (int i = 0; i < record.size(); i++){
+        if (i > 0) res += " ";
+        res += record.get(i);
+    }
+    return res;
+}
+
+SELF_TEST(parserKeepsRecordForAnyChunks){
+    PolishRecordParser parser;
+    for (size_t e = 0; e < sizeof EQUATIONS / sizeof EQUATIONS[0]; e++){
+        string equation = EQUATIONS[e];
+        parser.feed(equation);
+        string expected = recordText(parser.finish());
+        // every chunk size, so numbers and names are split everywhere
+        for (size_t size = 1; size <= equation.length(); size++){
+            for (size_t start = 0; start < equation.length(); start += size){
+                parser.feed(equation.data() + start, min(size, equation.length() - start));
+            }
+            expectEqual(recordText(parser.finish()), expected,
+                        "the record of " + equation + " in chunks of " + integerToString(size));
+        }
+    }
+    expectEqual(recordText(polishInvertedRecord("1+2*3")), "1 2 3 * +", "the record of 1+2*3");
+}
+
+SELF_TEST(parserStopsEquationsOverTheLimits){
+    EvaluationLimits saved = EvaluationBudget::limits();
+    EvaluationLimits limits = saved;
+    limits.tokens = 5;
+    EvaluationBudget::setLimits(limits);
+    PolishRecordParser parser;
+    string message;
+    bool finished = false;
+    try {
+        // the error comes while the chunks arrive, before the end
+        parser.feed("1+2+");
+        parser.feed("3+4");
+        parser.feed("+5");
+        finished = true;
+    } catch (ErrorException & ex) {
+        message = ex.getMessage();
+    }
+    EvaluationBudget::setLimits(saved);
+    expect(!finished, "an error before the last chunk");
+    expectEqual(message, "Equation has more tokens than the limit of 5", "the error of too many tokens");
+    parser.reset();
+    parser.feed("4");
+    parser.feed("2-1");
+    expectEqual(recordText(parser.finish()), "42 1 -", "the record of the next equation");
+}
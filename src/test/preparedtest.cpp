@@ -0,0 +1,58 @@
+/* File: preparedtest.cpp
+ * -----------------------------------
+ *
+ * Checks of the prepared equations of prepared.h.
+ */
+
+#include <cmath>
+#include <string>
+#include "error.h"
+#include "prepared.h"
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+
+using namespace std;
+
+SELF_TEST(preparedBindsParameters){
+    PreparedExpression prepared = prepare("A * sin(b) + c");
+    expect(prepared.parameterCount() == 3 && prepared.parameterName(0) == "a" && prepared.parameterName(2) == "c",
+           "the parameters a, b and c in order");
+    expect(prepared.parameterIndex("b") == 1 && prepared.parameterIndex("x") == -1, "the indexes of b and x");
+    expect(prepared.execute() == 0, "every parameter to start at 0");
+    prepared.bind(0, 2);
+    prepared.bind(1, 0.5);
+    prepared.bind(2, -1);
+    expect(prepared.execute() == 2 * sin(0.5) - 1, "a*sin(b)+c with the bound values");
+    prepared.bind(2, 3);
+    expect(prepared.execute() == 2 * sin(0.5) + 3, "the other values to stay bound");
+    PreparedExpression copy = prepared;
+    copy.bind(0, 0);
+    expect(copy.execute() == 3 && prepared.execute() == 2 * sin(0.5) + 3, "a copy to bind its own values");
+    string message;
+    try {
+        prepared.bind(3, 1);
+    } catch (ErrorException & ex) {
+        message = ex.getMessage();
+    }
+    expectEqual(message, "Parameter index out of range", "the error of a parameter that does not exist");
+}
+
+SELF_TEST(preparedExecutesWithoutAllocating){
+    PreparedExpression prepared = prepare("if(x>y,x*x-sqrt(y),log(y+1)/(x+2))+tan(x)*cos(y)");
+    prepared.bind(0, 1);
+    prepared.bind(1, 2);
+    double expected = prepared.execute();
+    long long before = heapAllocations();
+    double sum = 0;
+    for (int i = 0; i < 100000; i++){
+        prepared.bind(0, i * 0.001);
+        prepared.bind(1, 2);
+        sum += prepared.execute();
+    }
+    prepared.bind(0, 1);
+    double again = prepared.execute();
+    long long allocations = heapAllocations() - before;
+    expect(allocations == 0, integerToString(allocations) + " allocations to be none in bind and execute");
+    expect(again == expected && isfinite(sum), "the same result for the same values");
+}
@@ -0,0 +1,90 @@
+/* File: rationaltest.cpp
+ * -----------------------------------
+ *
+ * Checks of the exact fractions of rational.h and of the rational mode.
+ */
+
+#include <string>
+#include "bigint.h"
+#include "error.h"
+#include "rational.h"
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+
+using namespace std;
+
+/*
+ * Function: divisionError
+ * Usage: string message = divisionError(a, b);
+ * ______________________________________________________
+ *
+ * Returns the message of the error of a / b, or "" if there is none
+ */
+static string divisionError(const Rational & a, const Rational & b){
+    try {
+        a / b;
+    } catch (ErrorException & ex) {
+        return ex.getMessage();
+    }
+    return "";
+}
+
+SELF_TEST(rationalKeepsLowestTerms){
+    expectEqual(Rational(6, -4).toString(), "-3/2", "6/-4");
+    expectEqual(Rational(-6, -4).toString(), "3/2", "-6/-4");
+    expectEqual(Rational(0, -7).toString(), "0", "0/-7");
+    expectEqual(Rational(BigInt("123456789012345678901234567890"), BigInt("-246913578024691357802469135780")).toString(),
+                "-1/2", "a fraction of BigInts");
+    expect(Rational(6, -4).isNegative() && !Rational(0, -7).isNegative(), "the signs of -3/2 and 0");
+    expect(Rational(8, 4).isInteger() && !Rational(8, 3).isInteger(), "8/4 but not 8/3 to be an integer");
+    expect(Rational(1, 3) == Rational(2, 6) && Rational(-1, 2) < Rational(1, -3), "comparisons of fractions");
+    // past 64 bits and back
+    Rational large = Rational(9000000000000000000LL) * Rational(10);
+    expectEqual(large.toString(), "90000000000000000000", "a product past 64 bits");
+    expectEqual((large / Rational(9000000000000000000LL)).toString(), "10", "a quotient back below 64 bits");
+    expectEqual((Rational(1, 9000000000000000000LL) - Rational(1, 9000000000000000001LL)).toString(),
+                "1/81000000000000000009000000000000000000", "a difference with a denominator past 64 bits");
+}
+
+SELF_TEST(rationalIsExact){
+    expect(Rational("0.1") + Rational("0.2") == Rational(3, 10), "0.1 + 0.2 = 3/10");
+    expectEqual(Rational("-1.25e-2").toString(), "-1/80", "-1.25e-2");
+    expectEqual(pow(Rational(2, 3), Rational(10)).toString(), "1024/59049", "(2/3)^10");
+    expectEqual(pow(Rational(-2, 3), Rational(-3)).toString(), "-27/8", "(-2/3)^-3");
+    expectEqual(pow(Rational(7, 5), Rational(0)).toString(), "1", "(7/5)^0");
+    expectEqual(pow(Rational(2), Rational(100)).toString(), "1267650600228229401496703205376", "2^100");
+    Rational root = pow(Rational(4, 9), Rational(3, 2));
+    expect(root.isExact() && root == Rational(8, 27), "(4/9)^(3/2) = 8/27 exactly");
+    expect(!sqrt(Rational(2)).isExact(), "sqrt(2) to be marked as approximate");
+    expect(!(sqrt(Rational(2)) + Rational(1)).isExact(), "a sum with sqrt(2) to stay approximate");
+}
+
+SELF_TEST(rationalRefusesDivisionByZero){
+    expectEqual(divisionError(Rational(1), Rational(0)), "Division by zero", "the error of 1 / 0");
+    expectEqual(divisionError(Rational(BigInt("100000000000000000000"), BigInt(3)), Rational(0, 5)), "Division by zero",
+                "the error of a BigInt fraction / 0");
+    bool failed = false;
+    try {
+        Rational(1, 0);
+    } catch (ErrorException &) {
+        failed = true;
+    }
+    expect(failed, "an error for the fraction 1/0");
+    failed = false;
+    try {
+        pow(Rational(0), Rational(-1));
+    } catch (ErrorException &) {
+        failed = true;
+    }
+    expect(failed, "an error for 0^-1");
+}
+
+SELF_TEST(rationalModePrintsFractions){
+    CalculatorSession session;
+    session.run(":mode rational");
+    expectEqual(session.run("0.1+0.2"), "Result: 3/10 = 0.3\n", "the output of 0.1+0.2");
+    expectEqual(session.run("(2/3)^3*27"), "Result: 8\n", "the output of an integer");
+    expectEqual(session.run("1/0"), "Error: Division by zero\n", "the output of 1/0");
+    expect(startsWith(session.run("sqrt(2)"), "Result: ~1.41421356237309504880"), "the output of sqrt(2)");
+}
@@ -0,0 +1,111 @@
+/* File: regextest.cpp
+ * -----------------------------------
+ *
+ * Checks and benchmark of the in-process regular expressions of
+ * regexpr.h.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "error.h"
+#include "platform.h"
+#include "regexpr.h"
+#include "selftest.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* Pattern of the input validation: numbers joined by operators */
+static const char * const VALIDATION_PATTERN = "^-?\\d+(\\.\\d+)?([-+*/^]-?\\d+(\\.\\d+)?)*$";
+
+SELF_TEST(regexMatchesLikeJava){
+    expect(regexMatch("x=12", "\\d+"), "a match of \\d+ in x=12");
+    expect(!regexMatch("abc", "^b"), "no match of ^b in abc");
+    expect(regexMatch("-1.5*2+3", VALIDATION_PATTERN), "a valid equation to match");
+    expect(!regexMatch("1.5**2", VALIDATION_PATTERN), "an invalid equation not to match");
+    expect(regexMatchCount("a1b22c333", "\\d+") == 3, "3 runs of digits");
+    expect(regexMatchCount("abc", "x*") == 4, "4 empty matches, as in Java");
+    expectEqual(regexReplace("2014-10-31", "(\\d+)-(\\d+)-(\\d+)", "$3.$2.$1"), "31.10.2014", "groups in a replacement");
+}
+
+SELF_TEST(regexReplaceHonoursLimit){
+    expectEqual(regexReplace("aaaa", "a", "b", 2), "bbaa", "replacement of 2 matches");
+    expectEqual(regexReplace("aaaa", "a", "b", 0), "aaaa", "replacement of 0 matches");
+    expectEqual(regexReplace("aaaa", "a", "b"), "bbbb", "replacement of all matches");
+    // the Java back-end cannot stop after a number of matches
+    bool failed = false;
+    try {
+        regexReplace("aaaa", "(?i)a", "b", 1);
+    } catch (ErrorException &) {
+        failed = true;
+    }
+    expect(failed, "an error for a limit with a pattern of the Java back-end");
+}
+
+SELF_TEST(regexMachineIsReused){
+    // a large program, then a small one, then the large one again on the
+    // buffers of the same machine
+    string large = "(ab|cd)*e{1,40}f";
+    string text = "abcdab" + string(40, 'e') + "f";
+    for (int round = 0; round < 3; round++){
+        expect(regexMatch(text, large), "a match of the large pattern");
+        expect(regexMatchCount("a.b.c", "\\.") == 2, "2 points");
+        expect(!regexMatch("abcd" + string(41, 'e') + "g", large), "no match of the large pattern");
+    }
+}
+
+SELF_TEST(regexCacheServesThreads){
+    // every thread compiles more patterns than a cache keeps, so caches
+    // are emptied while the other threads match
+    vector<thread> threads;
+    vector<int> failures(4, 0);
+    for (int t = 0; t < 4; t++){
+        threads.push_back(thread([t, &failures]{
+            for (int i = 0; i < 600; i++){
+                string digits = integerToString(i % 300);
+                if (!regexMatch("x" + digits + "y", "x" + digits + "y$")
+                        || regexMatchCount("a1b22", "\\d+") != 2){
+                    failures[t]++;
+                }
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) threads[t].join();
+    for (int t = 0; t < 4; t++){
+        expect(failures[t] == 0, "every match on thread " + integerToString(t));
+    }
+}
+
+SELF_BENCHMARK(regexValidation){
+    string equation = "-19.5+3*7^4/5-2.25";
+    for (int i = 0; i < 20; i++) equation += "+" + integerToString(i) + ".5*2";
+    const int calls = 100000;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int matches = 0;
+    for (int i = 0; i < calls; i++){
+        matches += regexMatch(equation, VALIDATION_PATTERN);
+    }
+    double native = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    expect(matches == calls, "every call to match");
+    cout << "regexMatch of a " << equation.length() << "-character equation: "
+         << native / calls * 1e6 << " us per call in process" << endl;
+
+    // the Java back-end is only started with the graphical console
+    const char * noConsole = getenv("NOCONSOLE");
+    if (noConsole != NULL && startsWith(string(noConsole), "t")){
+        cout << "Java back-end not running (NOCONSOLE); pipe path not timed" << endl;
+        return;
+    }
+    const int pipeCalls = 200;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < pipeCalls; i++){
+        getPlatform()->regex_match(equation, VALIDATION_PATTERN);
+    }
+    double pipe = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "same call through the Java pipe: " << pipe / pipeCalls * 1e6 << " us per call ("
+         << (pipe / pipeCalls) / (native / calls) << " times slower)" << endl;
+}
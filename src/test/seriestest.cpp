@@ -0,0 +1,86 @@
+/* File: seriestest.cpp
+ * -----------------------------------
+ *
+ * Checks of the sums and products over ranges of series.h.
+ */
+
+#include <cmath>
+#include <string>
+#include "accumulator.h"
+#include "calc.h"
+#include "functions.h"
+#include "selftest.h"
+#include "series.h"
+#include "session.h"
+#include "strlib.h"
+#include "threadpool.h"
+#include "vectorshpp.h"
+
+using namespace std;
+
+/* pi^2 / 6, the sum of 1/i^2 for all i */
+static const double BASEL_SUM = 1.64493406684822643647;
+
+/*
+ * Function: compileSeries
+ * Usage: Expression term = compileSeries("x/i^2");
+ * ______________________________________________________
+ *
+ * Compiles a term of the index i and the parameter x
+ */
+static Expression compileSeries(const string & equation){
+    VectorSHPP<string> names;
+    names.add("i");
+    names.add("x");
+    VectorSHPP<string> record = polishInvertedRecord(equation);
+    return compileEquation(record, names);
+}
+
+SELF_TEST(seriesGiveTheSameResultOnAnyThreads){
+    Expression term = compileSeries("x*sin(i)/i");
+    double values[] = { 0, 1e6 };
+    const long long last = 1000000;
+    // on the pool, and on one thread inside a task of the pool
+    double sum = sumRange(term, 0, values, 1, last);
+    double product = productRange(term, 0, values, 1, last);
+    double serialSum, serialProduct;
+    ThreadPool::shared().submit([&]{
+        serialSum = sumRange(term, 0, values, 1, last);
+        serialProduct = productRange(term, 0, values, 1, last);
+    });
+    ThreadPool::shared().wait();
+    expect(sum == serialSum, "the same sum on the pool and on one thread");
+    expect(product == serialProduct, "the same product on the pool and on one thread");
+    for (int round = 0; round < 3; round++){
+        expect(sumRange(term, 0, values, 1, last) == sum, "the same sum every time");
+        expect(productRange(term, 0, values, 1, last) == product, "the same product every time");
+    }
+    // the exact sum of the terms one by one
+    ReproducibleSum expected;
+    for (long long i = 1; i <= last; i++){
+        values[0] = (double) i;
+        expected.add(term.evaluate<double>(values));
+    }
+    expect(sum == expected.result(), "the sum " + realToString(sum) + " to be the exact sum of the terms");
+}
+
+SELF_TEST(seriesAreAccurate){
+    Expression inverseSquare = compileSeries("1/i^2");
+    double values[] = { 0, 0 };
+    // pi^2 / 6 - 1 / n + 1 / (2 n^2) - ...
+    double sum = sumRange(inverseSquare, 0, values, 1, 10000000);
+    double expected = BASEL_SUM - 1e-7 + 0.5e-14;
+    expect(fabs(sum - expected) < 1e-15, "the sum of 1/i^2 " + realToString(sum) + " to be near pi^2/6 - 1e-7");
+    // 1000 factors of 1e-3 and 1000 of 1e3: the partial products would
+    // underflow without their separate exponents
+    double product = productRange(compileSeries("if(i<=1000,0.001,1000)"), 0, values, 1, 2000);
+    expect(fabs(product - 1) < 1e-12, "the product of 1e-3^1000 and 1e3^1000 to be 1, not " + realToString(product));
+    // (1 + 1/i) telescopes to n + 1
+    product = productRange(compileSeries("1+1/i"), 0, values, 1, 1000000);
+    expect(fabs(product - 1000001) < 1e-6, "the product of 1+1/i to be 1000001, not " + realToString(product));
+    expect(sumRange(inverseSquare, 0, values, 5, 4) == 0 && productRange(inverseSquare, 0, values, 5, 4) == 1,
+           "an empty sum to be 0 and an empty product 1");
+    CalculatorSession session;
+    expectEqual(session.run("sum(i,1,100,i)"), "Result: 5050\n", "the output of sum");
+    expectEqual(session.run("prod(i,1,10,i)"), "Result: 3.6288e+06\n", "the output of prod");
+}
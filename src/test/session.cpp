@@ -0,0 +1,62 @@
+/* File: session.cpp
+ * -----------------------------------
+ *
+ * Implementation of the CalculatorSession class.
+ */
+
+#include "session.h"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include "filelib.h"
+#include "strlib.h"
+
+using namespace std;
+
+/* Calls of operator new by each thread */
+static thread_local long long allocations = 0;
+
+/* The operators of the whole program count the allocations; the other
+ * forms of new and delete of the library call these */
+void * operator new(size_t size){
+    allocations++;
+    void * memory = malloc(size == 0 ? 1 : size);
+    if (memory == NULL) throw bad_alloc();
+    return memory;
+}
+
+void operator delete(void * memory) noexcept {
+    free(memory);
+}
+
+CalculatorSession::CalculatorSession(){
+    mode = DOUBLE_MODE;
+}
+
+string CalculatorSession::run(const string & lines){
+    ostringstream output;
+    streambuf * console = cout.rdbuf(output.rdbuf());
+    istringstream input(lines);
+    string line;
+    while (getline(input, line)){
+        line = trim(line);
+        if (!line.empty()){
+            handleLine(line, mode, variables, sheet);
+        }
+    }
+    cout.rdbuf(console);
+    return output.str();
+}
+
+string scratchFile(const string & name){
+    string directory = getTempDirectory();
+    if (!endsWith(directory, "/") && !endsWith(directory, "\\")){
+        directory += getDirectoryPathSeparator();
+    }
+    return directory + "calc-check-" + name;
+}
+
+long long heapAllocations(){
+    return allocations;
+}
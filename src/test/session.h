@@ -0,0 +1,73 @@
+/* File: session.h
+ * -----------------------------------
+ *
+ * This file exports a session of the calculator for the checks: lines
+ * of input are run as the program runs them, and what it prints is
+ * returned.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <string>
+#include "calc.h"
+#include "spreadsheet.h"
+#include "variables.h"
+
+/* Class CalculatorSession
+ * --------------------------------
+ * The mode, the variables and the cells of one run of the calculator;
+ * the functions defined with :def are shared by all sessions. A session
+ * starts in the double mode with no variables and no cells.
+ */
+class CalculatorSession {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: CalculatorSession
+     * Usage: CalculatorSession session;
+     * -----------------------------------------------------
+     * Makes a new session
+     */
+    CalculatorSession();
+
+    /* Method: run
+     * Usage: string output = session.run(":mode interval\n5-1");
+     * -----------------------------------------------------
+     * Runs the lines of input one after the other and returns what they
+     * print; empty lines are skipped, as by the program
+     */
+    std::string run(const std::string & lines);
+
+    /* Private methods prototypes and instase variables*/
+private:
+    CalcMode mode;
+    VariableTable variables;
+    Spreadsheet sheet;
+
+    /* The session is not copied */
+    CalculatorSession(const CalculatorSession &);
+    CalculatorSession & operator =(const CalculatorSession &);
+};
+
+/*
+ * Function: scratchFile
+ * Usage: string path = scratchFile("input.csv");
+ * ______________________________________________________
+ *
+ * Returns the path of a file for a check in the temporary folder
+ */
+std::string scratchFile(const std::string & name);
+
+/*
+ * Function: heapAllocations
+ * Usage: long long before = heapAllocations();
+ * ______________________________________________________
+ *
+ * Returns the number of calls of operator new made by the calling
+ * thread so far, for the checks of code that must not allocate
+ */
+long long heapAllocations();
+
+#endif // SESSION_H
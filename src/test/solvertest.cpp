@@ -0,0 +1,107 @@
+/* File: solvertest.cpp
+ * -----------------------------------
+ *
+ * Checks of the solution of equations of solver.h, where Newton's
+ * method works, where it needs the fallback and at multiple roots.
+ */
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include "calc.h"
+#include "error.h"
+#include "selftest.h"
+#include "session.h"
+#include "solver.h"
+#include "strlib.h"
+#include "symbolic.h"
+#include "vectorshpp.h"
+
+using namespace std;
+
+/*
+ * Function: solverOf
+ * Usage: EquationSolver solver = solverOf("x^2-a");
+ * ______________________________________________________
+ *
+ * Returns the solver by x of an equation of x and the parameter a
+ */
+static EquationSolver solverOf(const string & equation){
+    VectorSHPP<string> names;
+    names.add("x");
+    names.add("a");
+    VectorSHPP<string> record = polishInvertedRecord(equation);
+    return EquationSolver(SymbolicExpression(record, names), "x");
+}
+
+/*
+ * Function: solveError
+ * Usage: string message = solveError(solver, guess);
+ * ______________________________________________________
+ *
+ * Returns the message of the error of a solution with a = 0, or "" if
+ * there is none
+ */
+static string solveError(const EquationSolver & solver, double guess){
+    double values[] = { 0, 0 };
+    try {
+        solver.solve(values, guess);
+    } catch (ErrorException & ex) {
+        return ex.getMessage();
+    }
+    return "";
+}
+
+SELF_TEST(solverFallsBackFromNewton){
+    double values[] = { 0, 0 };
+    // Newton's method goes round 0, 1, 0... and the derivative of x^2-4
+    // is 0 at the guess: both need the search for a sign change
+    double root = solverOf("x^3-2*x+2").solve(values, 0);
+    expect(fabs(root + 1.7692923542386314) < 1e-12, "the root of x^3-2x+2 from 0, not " + realToString(root));
+    root = solverOf("x^2-4").solve(values, 0);
+    expect(fabs(root) == 2, "a root of x^2-4 from 0, not " + realToString(root));
+    // a root of multiplicity three, where Newton's method is slow
+    root = solverOf("x^3").solve(values, 1);
+    expect(fabs(root) < 1e-9, "the root 0 of x^3, not " + realToString(root));
+    // roots of even multiplicity, with no sign change to fall back on
+    root = solverOf("x^2").solve(values, 1);
+    expect(root == 0, "the root 0 of x^2, not " + realToString(root));
+    root = solverOf("sin(x)^2").solve(values, 0.5);
+    expect(fabs(root) < 1e-9, "the root 0 of sin(x)^2, not " + realToString(root));
+    root = solverOf("(x-1)^2").solve(values, 3);
+    expect(fabs(root - 1) < 1e-7, "the root 1 of (x-1)^2, not " + realToString(root));
+    // far from the root x^2-4 looks like x^2 and its steps halve too
+    root = solverOf("x^2-4").solve(values, 1e8);
+    expect(root == 2, "the root of x^2-4 from 1e8, not " + realToString(root));
+    root = solverOf("1/(x-2)+1").solve(values, 1.9);
+    expect(fabs(root - 1) < 1e-12, "the root of 1/(x-2)+1 beside its pole, not " + realToString(root));
+    // the sign change of a pole is not a root
+    expectEqual(solveError(solverOf("1/(x-2)"), 1.5), "solve: no root found near the guess",
+                "the error of an equation with a pole and no root");
+    expectEqual(solveError(solverOf("x^2+1"), 1), "solve: no root found near the guess",
+                "the error of an equation without a root");
+    CalculatorSession session;
+    expectEqual(session.run("solve(x^3-2*x+2,x,0)"), "Result: -1.76929\n", "the output of solve");
+}
+
+SELF_TEST(solverBatchMatchesSingle){
+    EquationSolver solver = solverOf("x^2-a");
+    // more rows than one block, and rows without a root
+    const int rows = 5000;
+    vector<double> unused(rows), parameters(rows), guesses(rows, 1), roots(rows);
+    for (int r = 0; r < rows; r++) parameters[r] = r % 7 == 3 ? -r : r * 0.37;
+    const double * columns[] = { &unused[0], &parameters[0] };
+    solver.solveBatch(columns, rows, &guesses[0], &roots[0]);
+    for (int r = 0; r < rows; r++){
+        string row = "the root of row " + integerToString(r);
+        if (parameters[r] < 0){
+            expect(isnan(roots[r]), row + " to be NaN");
+            continue;
+        }
+        double values[] = { 0, parameters[r] };
+        double single = solver.solve(values, 1);
+        expect(roots[r] == single, row + " to be that of one solution");
+        expect(fabs(roots[r] - sqrt(parameters[r])) <= 1e-14 * max(1.0, roots[r]),
+               row + " " + realToString(roots[r]) + " to be the square root");
+    }
+}
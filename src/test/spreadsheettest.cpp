@@ -0,0 +1,105 @@
+/* File: spreadsheettest.cpp
+ * -----------------------------------
+ *
+ * Checks of the incremental recalculation of the cells of
+ * spreadsheet.h.
+ */
+
+#include <string>
+#include <vector>
+#include "error.h"
+#include "selftest.h"
+#include "spreadsheet.h"
+#include "strlib.h"
+
+using namespace std;
+
+/*
+ * Function: cellWord
+ * Usage: string name = cellWord("w", 27);
+ * ______________________________________________________
+ *
+ * Returns a name of letters for a numbered cell
+ */
+static string cellWord(const string & prefix, int number){
+    string res = prefix;
+    for (int i = 0; i < 4; i++){
+        res += (char) ('a' + number % 26);
+        number /= 26;
+    }
+    return res;
+}
+
+SELF_TEST(sheetRecalculatesOnlyDownstream){
+    Spreadsheet sheet;
+    sheet.set("a", "1");
+    sheet.set("b", "a*2");
+    sheet.set("c", "b+a");
+    sheet.set("d", "5");
+    expect(sheet.value("c") == 3, "c = 2a + a");
+    expect(sheet.setValue("a", 3) == 3, "a, b and c recalculated, not d");
+    expect(sheet.value("b") == 6 && sheet.value("c") == 9, "b and c to follow a");
+    expect(sheet.set("d", "c-1") == 1, "only d recalculated for its own formula");
+    expect(sheet.value("d") == 8, "d = c - 1");
+    // a cell referred to before it is set is empty and worth 0
+    sheet.set("e", "f+1");
+    expect(sheet.value("e") == 1, "an empty cell to be worth 0");
+    expect(sheet.set("f", "2") == 2, "f and e recalculated");
+    expect(sheet.value("e") == 3, "e to follow f");
+}
+
+SELF_TEST(sheetRejectsCycles){
+    Spreadsheet sheet;
+    sheet.set("a", "1");
+    sheet.set("b", "a*2");
+    sheet.set("c", "b+a");
+    string message;
+    try {
+        sheet.set("a", "c+1");
+    } catch (ErrorException & ex) {
+        message = ex.getMessage();
+    }
+    expectEqual(message, "Circular reference: a -> c -> a", "the error of a cycle");
+    expect(sheet.formula("a") == "1" && sheet.value("c") == 3, "the sheet to be unchanged");
+}
+
+SELF_TEST(sheetRecalculatesWideSheetsInParallel){
+    // more cells than are recalculated on the calling thread: one input,
+    // a wide level of cells on it and a level of sums of pairs of them
+    const int width = 4000;
+    Spreadsheet sheet;
+    vector<string> names, formulas;
+    names.push_back("x");
+    formulas.push_back("1");
+    for (int i = 0; i < width; i++){
+        names.push_back(cellWord("w", i));
+        formulas.push_back("x*" + integerToString(i));
+    }
+    for (int i = 0; i < width; i += 2){
+        names.push_back(cellWord("s", i));
+        formulas.push_back(cellWord("w", i) + "+" + cellWord("w", i + 1));
+    }
+    expect(sheet.setAll(names, formulas) == (int) names.size(), "every cell calculated once");
+    expect(sheet.setValue("x", 3) == (int) names.size(), "every cell recalculated once for x");
+    for (int i = 0; i < width; i += 2){
+        if (sheet.value(cellWord("s", i)) != 3.0 * (2 * i + 1)){
+            error("the sum " + cellWord("s", i) + " is " + realToString(sheet.value(cellWord("s", i))));
+        }
+    }
+    // a cycle among many new formulas is found before any is calculated
+    vector<string> cycleNames, cycleFormulas;
+    for (int i = 0; i < width; i++){
+        cycleNames.push_back(cellWord("w", i));
+        cycleFormulas.push_back(i == 0 ? cellWord("s", 0) + "+1" : "x+" + integerToString(i));
+    }
+    string message;
+    try {
+        sheet.setAll(cycleNames, cycleFormulas);
+    } catch (ErrorException & ex) {
+        message = ex.getMessage();
+    }
+    expectEqual(message, "Circular reference: " + cellWord("w", 0) + " -> " + cellWord("s", 0) + " -> " + cellWord("w", 0),
+                "the error of a cycle among many formulas");
+    expect(sheet.formula(cellWord("w", 5)) == "x*5" && sheet.value(cellWord("w", 5)) == 15,
+           "the cells to keep their old formulas and values");
+}
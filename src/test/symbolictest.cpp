@@ -0,0 +1,47 @@
+/* File: symbolictest.cpp
+ * -----------------------------------
+ *
+ * Checks of the symbolic derivatives of the :d/dx command.
+ */
+
+#include <string>
+#include "selftest.h"
+#include "session.h"
+#include "strlib.h"
+
+using namespace std;
+
+/*
+ * Function: nestedSines
+ * Usage: string equation = nestedSines(1000);
+ * ______________________________________________________
+ *
+ * Returns sin(sin(...sin(x)...)) with the given number of sines
+ */
+static string nestedSines(int depth){
+    string res;
+    for (int i = 0; i < depth; i++) res += "sin(";
+    res += "x";
+    for (int i = 0; i < depth; i++) res += ")";
+    return res;
+}
+
+SELF_TEST(derivativeTextIsUnchangedWhenShort){
+    CalculatorSession session;
+    session.run(":var x = 1");
+    expectEqual(session.run(":d/dx x^2*sin(x)"), "d/dx = x^2*cos(x)+sin(x)*2*x\nResult: 2.22324\n", "the derivative of x^2*sin(x)");
+    expectEqual(session.run(":d/dx sin(sin(x))"), "d/dx = cos(x)*cos(sin(x))\nResult: 0.360039\n", "the derivative of sin(sin(x))");
+}
+
+SELF_TEST(derivativeTextGrowsLinearly){
+    CalculatorSession session;
+    session.run(":var x = 1");
+    // the derivative shares sin^k(x) between its factors, so written as
+    // a tree it would take about depth^2 / 2 sines
+    int depth = 4000;
+    string output = session.run(":d/dx " + nestedSines(depth));
+    expect(output.length() < 40 * (size_t) depth, "a text of the derivative in proportion to the depth, not of "
+           + integerToString(output.length()) + " characters");
+    expect(output.find("\n  #1 = ") != string::npos, "the shared sines to be defined once");
+    expect(output.find("Result: 1.56486e-05\n") != string::npos, "the value of the derivative");
+}
@@ -0,0 +1,59 @@
+/* File: tokenizertest.cpp
+ * -----------------------------------
+ *
+ * Checks of the classification of characters of tokenizer.h.
+ */
+
+#include <random>
+#include <string>
+#include "selftest.h"
+#include "strlib.h"
+#include "tokenizer.h"
+
+using namespace std;
+
+/* Characters of every class and a few of none, for texts like equations */
+static const string ALPHABET = "0123456789.abcxyz+-*/^<>=!&|(), AZ_~#\x7f\x80\xe9\xff";
+
+/*
+ * Function: expectSameMasks
+ * Usage: expectSameMasks(text, "random bytes");
+ * ______________________________________________________
+ *
+ * Signals the failure of a check unless the classification of the text
+ * gives the masks of the scalar path
+ */
+static void expectSameMasks(const string & text, const string & what){
+    CharacterMasks masks, expected;
+    classifyCharacters(text, masks);
+    classifyCharactersScalar(text, expected);
+    string where = what + " of length " + integerToString(text.length());
+    expect(masks.digits == expected.digits, "the digits of " + where);
+    expect(masks.letters == expected.letters, "the letters of " + where);
+    expect(masks.operators == expected.operators, "the operators of " + where);
+    expect(masks.punctuation == expected.punctuation, "the punctuation of " + where);
+}
+
+SELF_TEST(tokenizerVectorMatchesScalar){
+    mt19937 random(49);
+    uniform_int_distribution<int> byte(0, 255);
+    uniform_int_distribution<int> letter(0, ALPHABET.length() - 1);
+    // whole blocks of 64, tails after them and texts shorter than a block
+    for (int length = 0; length <= 300; length++){
+        string bytes(length, ' '), equation(length, ' ');
+        for (int i = 0; i < length; i++){
+            bytes[i] = (char) byte(random);
+            equation[i] = ALPHABET[letter(random)];
+        }
+        expectSameMasks(bytes, "random bytes");
+        expectSameMasks(equation, "random characters of equations");
+    }
+    string all;
+    for (int c = 0; c < 256; c++) all += (char) c;
+    expectSameMasks(all + all + "1", "every byte twice");
+    CharacterMasks masks;
+    classifyCharacters(all, masks);
+    expect(isMasked(masks.digits, '.') && isMasked(masks.letters, 'q') && isMasked(masks.operators, '|')
+           && isMasked(masks.punctuation, ',') && !isMasked(masks.letters, 'Q') && !isMasked(masks.operators, '~'),
+           "the classes of single bytes");
+}
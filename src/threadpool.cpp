@@ -0,0 +1,135 @@
+/* File: threadpool.cpp
+ * -----------------------------------
+ *
+ * Implementation of the ThreadPool class.
+ */
+
+#include "threadpool.h"
+
+using namespace std;
+
+/* Pool and queue of the current thread, if it is a worker */
+static thread_local const ThreadPool * currentPool = NULL;
+static thread_local int currentIndex = -1;
+
+/* Tasks being run by the current thread, nested ones included */
+static thread_local int runningTasks = 0;
+
+ThreadPool::ThreadPool(int threads){
+    if (threads <= 0){
+        threads = max(1, (int) thread::hardware_concurrency());
+    }
+    stopping = false;
+    queued = 0;
+    pending = 0;
+    for (int i = 0; i <= threads; i++){
+        queues.push_back(new WorkQueue);
+    }
+    for (int i = 0; i < threads; i++){
+        workers.push_back(thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        lock_guard<mutex> lock(sleepLock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (size_t i = 0; i < workers.size(); i++){
+        workers[i].join();
+    }
+    for (size_t i = 0; i < queues.size(); i++){
+        delete queues[i];
+    }
+}
+
+void ThreadPool::submit(const function<void()> & task){
+    // counted before it is visible, so wait never misses it
+    pending++;
+    WorkQueue * queue = queues[queueIndex()];
+    {
+        lock_guard<mutex> lock(queue->lock);
+        queue->tasks.push_back(task);
+    }
+    queued++;
+    {
+        // taking the lock orders the notification after the check of a
+        // worker that is going to sleep
+        lock_guard<mutex> lock(sleepLock);
+    }
+    wakeUp.notify_one();
+}
+
+void ThreadPool::wait(){
+    int index = queueIndex();
+    while (pending > 0){
+        if (!runOne(index)){
+            this_thread::yield();
+        }
+    }
+    lock_guard<mutex> lock(failureLock);
+    if (failure){
+        exception_ptr res = failure;
+        failure = exception_ptr();
+        rethrow_exception(res);
+    }
+}
+
+bool ThreadPool::isInTask(){
+    return runningTasks > 0;
+}
+
+int ThreadPool::threadCount() const {
+    return workers.size();
+}
+
+ThreadPool & ThreadPool::shared(){
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop(int index){
+    currentPool = this;
+    currentIndex = index;
+    while (true){
+        if (runOne(index)) continue;
+        unique_lock<mutex> lock(sleepLock);
+        wakeUp.wait(lock, [this]{ return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+bool ThreadPool::runOne(int index){
+    function<void()> task;
+    int count = queues.size();
+    // the newest task of the own queue, else the oldest of another
+    for (int k = 0; k < count && !task; k++){
+        WorkQueue * queue = queues[(index + k) % count];
+        lock_guard<mutex> lock(queue->lock);
+        if (queue->tasks.empty()) continue;
+        if (k == 0){
+            task = queue->tasks.back();
+            queue->tasks.pop_back();
+        } else {
+            task = queue->tasks.front();
+            queue->tasks.pop_front();
+        }
+    }
+    if (!task) return false;
+    queued--;
+    runningTasks++;
+    try {
+        task();
+    } catch (...) {
+        lock_guard<mutex> lock(failureLock);
+        if (!failure) failure = current_exception();
+    }
+    runningTasks--;
+    pending--;
+    return true;
+}
+
+int ThreadPool::queueIndex() const {
+    return currentPool == this ? currentIndex : workers.size();
+}
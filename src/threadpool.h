@@ -0,0 +1,140 @@
+/* File: threadpool.h
+ * -----------------------------------
+ *
+ * This file exports a work-stealing thread pool for the parallel
+ * parts of the calculator.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Class ThreadPool
+ * --------------------------------
+ * This class runs tasks on a fixed set of worker threads. Every worker
+ * has its own queue: a task submitted from inside a task goes to the
+ * queue of its worker, which takes its newest task first, while idle
+ * workers steal the oldest tasks of the others. Large tasks that split
+ * themselves into smaller ones thus spread over all threads without a
+ * central queue. Threads outside the pool submit to one more queue and
+ * help running tasks while they wait.
+ */
+class ThreadPool {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Constructor: ThreadPool
+     * Usage: ThreadPool pool(threads);
+     * -----------------------------------------------------
+     * Starts the worker threads; 0 means one per hardware thread
+     */
+    explicit ThreadPool(int threads = 0);
+
+    /* Destructor: ~ThreadPool
+     * -----------------------------------------------------
+     * Finishes the queued tasks and stops the workers
+     */
+    ~ThreadPool();
+
+    /* Method: submit
+     * Usage: pool.submit(task);
+     * -----------------------------------------------------
+     * Queues a task; it may be called from inside other tasks
+     */
+    void submit(const std::function<void()> & task);
+
+    /* Method: wait
+     * Usage: pool.wait();
+     * -----------------------------------------------------
+     * Runs tasks until every submitted task has finished, including
+     * the tasks they submitted. If a task threw an exception, the first
+     * one is thrown again here. It is not called from inside a task,
+     * which is itself still to finish (see isInTask).
+     */
+    void wait();
+
+    /* Method: isInTask
+     * Usage: if (ThreadPool::isInTask())...
+     * -----------------------------------------------------
+     * Returns true while the calling thread runs a task of a pool; work
+     * nested in a task, such as an integral inside a sum, then runs on
+     * the calling thread
+     */
+    static bool isInTask();
+
+    /* Method: threadCount
+     * Usage: int threads = pool.threadCount();
+     * -----------------------------------------------------
+     * Returns the number of worker threads
+     */
+    int threadCount() const;
+
+    /* Method: shared
+     * Usage: ThreadPool & pool = ThreadPool::shared();
+     * -----------------------------------------------------
+     * Returns the pool used by the calculator, started on first use
+     */
+    static ThreadPool & shared();
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    /* Tasks of one thread, guarded by its own lock */
+    struct WorkQueue {
+        std::mutex lock;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    std::vector<std::thread> workers;
+
+    /* One queue per worker, the last one for threads outside the pool */
+    std::vector<WorkQueue *> queues;
+
+    std::mutex sleepLock;
+    std::condition_variable wakeUp;
+    bool stopping;
+
+    /* Tasks in the queues, and tasks submitted but not finished */
+    std::atomic<int> queued;
+    std::atomic<int> pending;
+
+    std::mutex failureLock;
+    std::exception_ptr failure;
+
+    /* Method: workerLoop
+     * Usage: workers.push_back(std::thread(&ThreadPool::workerLoop, this, index));
+     * ------------------------------------------------
+     * Body of a worker thread
+     */
+    void workerLoop(int index);
+
+    /* Method: runOne
+     * Usage: if (runOne(index))...
+     * ------------------------------------------------
+     * Takes a task from the queue of the thread, or steals one, and
+     * runs it. Returns false if all queues are empty.
+     */
+    bool runOne(int index);
+
+    /* Method: queueIndex
+     * Usage: int index = queueIndex();
+     * ------------------------------------------------
+     * Returns the queue of the calling thread
+     */
+    int queueIndex() const;
+
+    /* The pool owns its threads and cannot be copied */
+    ThreadPool(const ThreadPool & src);
+    ThreadPool & operator=(const ThreadPool & src);
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,198 @@
+/* File: tokenizer.cpp
+ * -----------------------------------
+ *
+ * Implementation of the classification of characters.
+ */
+
+#include "tokenizer.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TOKENIZER_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/* Classes of a byte in the table of the scalar path */
+enum CharacterClass {
+    OTHER_CLASS = 0,
+    DIGIT_CLASS = 1,
+    LETTER_CLASS = 2,
+    OPERATOR_CLASS = 4,
+    PUNCTUATION_CLASS = 8
+};
+
+/* Class of each of the 256 bytes */
+struct ClassTable {
+    unsigned char classes[256];
+
+    ClassTable(){
+        for (int c = 0; c < 256; c++) classes[c] = OTHER_CLASS;
+        for (int c = '0'; c <= '9'; c++) classes[c] = DIGIT_CLASS;
+        classes[(unsigned char)'.'] = DIGIT_CLASS;
+        for (int c = 'a'; c <= 'z'; c++) classes[c] = LETTER_CLASS;
+        for (const char * c = "+-*/^<>=!&|"; *c; c++) classes[(unsigned char)*c] = OPERATOR_CLASS;
+        for (const char * c = "(),"; *c; c++) classes[(unsigned char)*c] = PUNCTUATION_CLASS;
+    }
+};
+
+/*
+ * Function: countTrailingZeros
+ * Usage: int zeros = countTrailingZeros(value);
+ * ______________________________________________________
+ *
+ * Returns the number of trailing zero bits of a nonzero value
+ */
+static int countTrailingZeros(uint64_t value){
+#if defined(__GNUC__)
+    return __builtin_ctzll(value);
+#else
+    int count = 0;
+    while ((value & 1) == 0){
+        value >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+/*
+ * Function: classifyScalar
+ * Usage: classifyScalar(text, from, length, masks);
+ * ______________________________________________________
+ *
+ * Sets the masks of the characters from a multiple of 64 to the end
+ */
+static void classifyScalar(const char * text, size_t from, size_t length, CharacterMasks & masks){
+    static const ClassTable table;
+    for (size_t i = from; i < length; i++){
+        uint64_t bit = uint64_t(1) << (i & 63);
+        switch (table.classes[(unsigned char)text[i]]){
+        case DIGIT_CLASS: masks.digits[i >> 6] |= bit; break;
+        case LETTER_CLASS: masks.letters[i >> 6] |= bit; break;
+        case OPERATOR_CLASS: masks.operators[i >> 6] |= bit; break;
+        case PUNCTUATION_CLASS: masks.punctuation[i >> 6] |= bit; break;
+        default: break;
+        }
+    }
+}
+
+#ifdef TOKENIZER_AVX2
+
+/*
+ * Function: classifyAvx2
+ * Usage: size_t done = classifyAvx2(text, length, masks);
+ * ______________________________________________________
+ *
+ * Sets the masks of the whole blocks of 64 characters. Digits and
+ * letters are ranges of bytes; the symbols are found with a table of
+ * the high half of each byte and a table of the low half, whose bits
+ * agree only for the symbols:
+ *   bit 0 - ! & * + - /   (0x2?, low half 1 6 A B D F)
+ *   bit 1 - ( ) ,         (0x2?, low half 8 9 C)
+ *   bit 2 - < = >         (0x3?, low half C D E)
+ *   bit 3 - ^             (0x5E)
+ *   bit 4 - |             (0x7C)
+ *   bit 5 - .             (0x2E)
+ * Returns the number of characters done.
+ */
+__attribute__((target("avx2")))
+static size_t classifyAvx2(const char * text, size_t length, CharacterMasks & masks){
+    const __m256i highTable = _mm256_setr_epi8(
+            0, 0, 0x23, 0x04, 0, 0x08, 0, 0x10, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0x23, 0x04, 0, 0x08, 0, 0x10, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i lowTable = _mm256_setr_epi8(
+            0, 0x01, 0, 0, 0, 0, 0x01, 0, 0x02, 0x02, 0x01, 0x01, 0x16, 0x05, 0x2C, 0x01,
+            0, 0x01, 0, 0, 0, 0, 0x01, 0, 0x02, 0x02, 0x01, 0x01, 0x16, 0x05, 0x2C, 0x01);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i operatorBits = _mm256_set1_epi8(0x1D);
+    const __m256i punctuationBits = _mm256_set1_epi8(0x02);
+    const __m256i pointBits = _mm256_set1_epi8(0x20);
+    size_t blocks = length / 64;
+    for (size_t block = 0; block < blocks; block++){
+        uint64_t digits = 0, letters = 0, operators = 0, punctuation = 0;
+        for (int half = 0; half < 2; half++){
+            __m256i bytes = _mm256_loadu_si256((const __m256i *)(text + block * 64 + half * 32));
+            // c - '0' <= 9 and c - 'a' <= 25, as unsigned bytes
+            __m256i fromZero = _mm256_sub_epi8(bytes, _mm256_set1_epi8('0'));
+            __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(fromZero, _mm256_set1_epi8(9)), fromZero);
+            __m256i fromA = _mm256_sub_epi8(bytes, _mm256_set1_epi8('a'));
+            __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(fromA, _mm256_set1_epi8(25)), fromA);
+            __m256i high = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble);
+            __m256i low = _mm256_and_si256(bytes, nibble);
+            __m256i symbol = _mm256_and_si256(_mm256_shuffle_epi8(highTable, high),
+                                              _mm256_shuffle_epi8(lowTable, low));
+            __m256i isPoint = _mm256_cmpgt_epi8(_mm256_and_si256(symbol, pointBits), zero);
+            __m256i isOperator = _mm256_cmpgt_epi8(_mm256_and_si256(symbol, operatorBits), zero);
+            __m256i isPunctuation = _mm256_cmpgt_epi8(_mm256_and_si256(symbol, punctuationBits), zero);
+            int shift = half * 32;
+            digits |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_or_si256(isDigit, isPoint)))) << shift;
+            letters |= uint64_t(uint32_t(_mm256_movemask_epi8(isLetter))) << shift;
+            operators |= uint64_t(uint32_t(_mm256_movemask_epi8(isOperator))) << shift;
+            punctuation |= uint64_t(uint32_t(_mm256_movemask_epi8(isPunctuation))) << shift;
+        }
+        masks.digits[block] = digits;
+        masks.letters[block] = letters;
+        masks.operators[block] = operators;
+        masks.punctuation[block] = punctuation;
+    }
+    return blocks * 64;
+}
+
+/*
+ * Function: hasAvx2
+ * Usage: if (hasAvx2())...
+ * ______________________________________________________
+ *
+ * Checks once whether the processor runs AVX2
+ */
+static bool hasAvx2(){
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif // TOKENIZER_AVX2
+
+/*
+ * Function: clearMasks
+ * Usage: clearMasks(length, masks);
+ * ______________________________________________________
+ *
+ * Sizes the masks for a text of the given length, with no bit set
+ */
+static void clearMasks(size_t length, CharacterMasks & masks){
+    size_t words = length / 64 + 1;
+    masks.digits.assign(words, 0);
+    masks.letters.assign(words, 0);
+    masks.operators.assign(words, 0);
+    masks.punctuation.assign(words, 0);
+}
+
+void classifyCharacters(const string & text, CharacterMasks & masks){
+    size_t length = text.length();
+    clearMasks(length, masks);
+    size_t done = 0;
+#ifdef TOKENIZER_AVX2
+    if (hasAvx2()){
+        done = classifyAvx2(text.data(), length, masks);
+    }
+#endif
+    classifyScalar(text.data(), done, length, masks);
+}
+
+void classifyCharactersScalar(const string & text, CharacterMasks & masks){
+    clearMasks(text.length(), masks);
+    classifyScalar(text.data(), 0, text.length(), masks);
+}
+
+size_t spanEnd(const vector<uint64_t> & mask, size_t start, size_t length){
+    size_t word = start >> 6;
+    // the run ends at the first clear bit from the start
+    uint64_t clear = ~mask[word] & (~uint64_t(0) << (start & 63));
+    while (clear == 0){
+        clear = ~mask[++word];
+    }
+    size_t end = (word << 6) + countTrailingZeros(clear);
+    return end < length ? end : length;
+}
@@ -0,0 +1,90 @@
+/* File: tokenizer.h
+ * -----------------------------------
+ *
+ * This file exports the classification of the characters of an
+ * equation in bulk, which lets the parser take whole numbers and
+ * names at once instead of looking at every character.
+ */
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Struct CharacterMasks
+ * --------------------------------
+ * Bitmasks of the classes of the characters of a text: bit i % 64 of
+ * word i / 64 is set if character i is in the class. Every character
+ * is in at most one class.
+ *   digits      - '0'..'9' and '.'
+ *   letters     - 'a'..'z'
+ *   operators   - + - * / ^ < > = ! & |
+ *   punctuation - ( ) ,
+ */
+struct CharacterMasks {
+    std::vector<uint64_t> digits;
+    std::vector<uint64_t> letters;
+    std::vector<uint64_t> operators;
+    std::vector<uint64_t> punctuation;
+};
+
+/*
+ * Function: classifyCharacters
+ * Usage: classifyCharacters(equation, masks);
+ * ______________________________________________________
+ *
+ * Fills the masks of a text. On processors with AVX2 it classifies 32
+ * characters at a time with two lookup tables indexed by the low and
+ * the high half of each byte, otherwise one character at a time with
+ * a table of all bytes; both give the same masks.
+ *
+ * @param text - text to classify
+ * @param masks - set to the masks of the text
+ */
+void classifyCharacters(const std::string & text, CharacterMasks & masks);
+
+/*
+ * Function: classifyCharactersScalar
+ * Usage: classifyCharactersScalar(equation, masks);
+ * ______________________________________________________
+ *
+ * Fills the masks of a text one character at a time on any processor,
+ * the reference for the vector path
+ *
+ * @param text - text to classify
+ * @param masks - set to the masks of the text
+ */
+void classifyCharactersScalar(const std::string & text, CharacterMasks & masks);
+
+/*
+ * Function: spanEnd
+ * Usage: size_t end = spanEnd(masks.digits, start, equation.length());
+ * ______________________________________________________
+ *
+ * Finds the end of a run of characters of one class, skipping up to
+ * 64 characters at a time
+ *
+ * @param mask - mask of the class
+ * @param start - position of the first character of the run
+ * @param length - length of the text
+ * @return - position of the first character after the run
+ */
+size_t spanEnd(const std::vector<uint64_t> & mask, size_t start, size_t length);
+
+/*
+ * Function: isMasked
+ * Usage: if (isMasked(masks.letters, i))...
+ * ______________________________________________________
+ *
+ * @param mask - mask of a class
+ * @param index - position of a character
+ * @return - true if the character is in the class
+ */
+inline bool isMasked(const std::vector<uint64_t> & mask, size_t index){
+    return (mask[index >> 6] >> (index & 63)) & 1;
+}
+
+#endif // TOKENIZER_H
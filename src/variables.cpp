@@ -0,0 +1,52 @@
+/* File: variables.cpp
+ * -----------------------------------
+ *
+ * Implementation of the VariableTable class.
+ */
+
+#include "variables.h"
+#include "builtins.h"
+#include "error.h"
+#include "expression.h"
+
+using namespace std;
+
+void VariableTable::set(const string & name, const string & value){
+    if (name.empty() || !isFunction(name) || Expression::isFunctionName(name) || isBuiltinName(name)){
+        error("Illegal variable name: " + name);
+    }
+    int index = indexOf(name);
+    if (index < 0){
+        variableNames.add(name);
+        variableValues.add(value);
+    } else {
+        variableValues.set(index, value);
+    }
+}
+
+bool VariableTable::contains(const string & name) const {
+    return indexOf(name) >= 0;
+}
+
+string VariableTable::get(const string & name) const {
+    int index = indexOf(name);
+    if (index < 0){
+        error("Unknown variable: " + name);
+    }
+    return variableValues.get(index);
+}
+
+const VectorSHPP<string> & VariableTable::names() const {
+    return variableNames;
+}
+
+int VariableTable::size() const {
+    return variableNames.size();
+}
+
+int VariableTable::indexOf(const string & name) const {
+    for (int i = 0; i < variableNames.size(); i++){
+        if (variableNames.get(i) == name) return i;
+    }
+    return -1;
+}
@@ -0,0 +1,75 @@
+/* File: variables.h
+ * -----------------------------------
+ *
+ * This file exports the table of variables declared with
+ * the ':var' command.
+ */
+
+#ifndef VARIABLES_H
+#define VARIABLES_H
+
+#include <string>
+#include "vectorshpp.h"
+
+/* Class VariableTable
+ * --------------------------------
+ * This class keeps the declared variables in declaration order.
+ * Values are stored as written, so each calculation mode can convert
+ * them exactly (for example 0.1 stays 1/10 in the rational mode).
+ */
+class VariableTable {
+
+    /* Public methods prototypes*/
+public:
+
+    /* Method: set
+     * Usage: variables.set("x", "0.5");
+     * -----------------------------------------------------
+     * Declares the variable or changes its value. Signals an error
+     * if the name is not a word or is the name of a function.
+     */
+    void set(const std::string & name, const std::string & value);
+
+    /* Method: contains
+     * Usage: if (variables.contains(name))...
+     * -----------------------------------------------------
+     * Returns true if the variable is declared
+     */
+    bool contains(const std::string & name) const;
+
+    /* Method: get
+     * Usage: string value = variables.get(name);
+     * -----------------------------------------------------
+     * Returns the value of the variable as written
+     */
+    std::string get(const std::string & name) const;
+
+    /* Method: names
+     * Usage: VectorSHPP<string> names = variables.names();
+     * -----------------------------------------------------
+     * Returns the names of all variables in declaration order
+     */
+    const VectorSHPP<std::string> & names() const;
+
+    /* Method: size
+     * Usage: int count = variables.size();
+     * -----------------------------------------------------
+     * Returns the number of declared variables
+     */
+    int size() const;
+
+    /* Private methods prototypes and instase variables*/
+private:
+
+    VectorSHPP<std::string> variableNames;
+    VectorSHPP<std::string> variableValues;
+
+    /* Method: indexOf
+     * Usage: int index = indexOf(name);
+     * ------------------------------------------------
+     * Returns the position of the variable, or -1
+     */
+    int indexOf(const std::string & name) const;
+};
+
+#endif // VARIABLES_H
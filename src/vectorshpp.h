@@ -10,6 +10,7 @@
 #define VECTORSHPP_H
 
 #include <iostream>
+#include <utility>
 #include <stdlib.h>
 
 /* Class VectorSHPP<ValueType>
@@ -97,6 +98,13 @@ public:
      * Overloads [] to select elements from this vector.
      */
     ValueType & operator[](int);
+
+    /* Method: swap
+     * Usage: vec.swap(other);
+     * -----------------------------------------------------
+     * Exchanges the elements of two vectors without copying them.
+     */
+    void swap(VectorSHPP<ValueType> & other);
 	
 	/* Copy constructor*/
     VectorSHPP(const VectorSHPP<ValueType> & src);
@@ -244,11 +252,18 @@ void VectorSHPP<ValueType>::extendArray(){
     array = new ValueType[currentSize];
 
     for (int i = 0; i < count; i++){
-        array[i] = oldArray[i];
+        array[i] = std::move(oldArray[i]); // the old array is deleted, its values are moved
     }
     delete[] oldArray;
 }
 
+template<typename ValueType>
+void VectorSHPP<ValueType>::swap(VectorSHPP<ValueType> & other){
+    std::swap(array, other.array);
+    std::swap(currentSize, other.currentSize);
+    std::swap(count, other.count);
+}
+
 template<typename ValueType>
 void VectorSHPP<ValueType>::deepCoping(const VectorSHPP<ValueType> &src){
     this->array = new ValueType[src.currentSize];